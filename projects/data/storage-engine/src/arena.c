@@ -0,0 +1,126 @@
+#include "arena.h"
+#include <stdlib.h>
+
+#define ARENA_ALIGN (sizeof(void*) > 8 ? sizeof(void*) : 8)
+
+// Helper: create an arena (the first block is allocated lazily)
+static arena_t* arena_new(bool concurrent) {
+    arena_t* arena = malloc(sizeof(arena_t));
+    if (!arena) return NULL;
+
+    arena->blocks = NULL;
+    arena->alloc_ptr = NULL;
+    arena->alloc_remaining = 0;
+    arena->memory_usage = sizeof(arena_t);
+    arena->concurrent = concurrent;
+
+    if (concurrent && pthread_mutex_init(&arena->lock, NULL) != 0) {
+        free(arena);
+        return NULL;
+    }
+
+    return arena;
+}
+
+// Create a single-threaded arena
+arena_t* arena_create(void) {
+    return arena_new(false);
+}
+
+// Create an arena that several threads may allocate from
+arena_t* arena_create_concurrent(void) {
+    return arena_new(true);
+}
+
+// Destroy arena and every allocation made from it
+void arena_destroy(arena_t* arena) {
+    if (!arena) return;
+
+    arena_block_t* block = arena->blocks;
+    while (block) {
+        arena_block_t* next = block->next;
+        free(block);
+        block = next;
+    }
+    if (arena->concurrent) {
+        pthread_mutex_destroy(&arena->lock);
+    }
+    free(arena);
+}
+
+// Helper: malloc a new block with room for bytes of data
+static char* new_block(arena_t* arena, size_t bytes) {
+    arena_block_t* block = malloc(sizeof(arena_block_t) + bytes);
+    if (!block) return NULL;
+
+    block->size = bytes;
+    block->next = arena->blocks;
+    arena->blocks = block;
+    __atomic_add_fetch(&arena->memory_usage, sizeof(arena_block_t) + bytes,
+                       __ATOMIC_RELAXED);
+
+    return (char*)(block + 1);
+}
+
+// Helper: allocate when the current block is too small
+static void* alloc_fallback(arena_t* arena, size_t bytes) {
+    if (bytes > ARENA_BLOCK_SIZE / 4) {
+        // Large allocation: give it its own block so the rest of the
+        // current block isn't wasted
+        return new_block(arena, bytes);
+    }
+
+    // Start a new block; the tail of the old one is abandoned
+    char* block = new_block(arena, ARENA_BLOCK_SIZE);
+    if (!block) return NULL;
+
+    arena->alloc_ptr = block + bytes;
+    arena->alloc_remaining = ARENA_BLOCK_SIZE - bytes;
+    return block;
+}
+
+// Helper: bump-allocate bytes after skipping slop bytes for alignment
+static void* alloc_locked(arena_t* arena, size_t bytes, bool aligned) {
+    size_t slop = 0;
+    if (aligned) {
+        size_t mod = (uintptr_t)arena->alloc_ptr & (ARENA_ALIGN - 1);
+        slop = mod == 0 ? 0 : ARENA_ALIGN - mod;
+    }
+    size_t needed = bytes + slop;
+
+    if (needed <= arena->alloc_remaining) {
+        void* result = arena->alloc_ptr + slop;
+        arena->alloc_ptr += needed;
+        arena->alloc_remaining -= needed;
+        return result;
+    }
+
+    // Block starts come from malloc and are always aligned
+    return alloc_fallback(arena, bytes);
+}
+
+// Helper: allocate, taking the lock for concurrent arenas
+static void* alloc(arena_t* arena, size_t bytes, bool aligned) {
+    if (!arena || bytes == 0) return NULL;
+    if (!arena->concurrent) return alloc_locked(arena, bytes, aligned);
+
+    pthread_mutex_lock(&arena->lock);
+    void* result = alloc_locked(arena, bytes, aligned);
+    pthread_mutex_unlock(&arena->lock);
+    return result;
+}
+
+// Allocate bytes with no alignment guarantee (keys and values)
+void* arena_alloc(arena_t* arena, size_t bytes) {
+    return alloc(arena, bytes, false);
+}
+
+// Allocate bytes aligned for pointers (nodes)
+void* arena_alloc_aligned(arena_t* arena, size_t bytes) {
+    return alloc(arena, bytes, true);
+}
+
+// Get memory usage
+size_t arena_memory_usage(arena_t* arena) {
+    return arena ? __atomic_load_n(&arena->memory_usage, __ATOMIC_RELAXED) : 0;
+}
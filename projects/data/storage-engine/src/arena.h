@@ -0,0 +1,39 @@
+#ifndef STORAGE_ARENA_H
+#define STORAGE_ARENA_H
+
+#include "types.h"
+#include "param.h"
+#include <pthread.h>
+
+// Arena block (internal)
+typedef struct arena_block {
+    struct arena_block* next;
+    size_t size;
+    // Data follows the header
+} arena_block_t;
+
+// Bump allocator: memory is carved out of large blocks and released all
+// at once by arena_destroy. Only arenas made by arena_create_concurrent may
+// be allocated from by several threads at once.
+typedef struct arena {
+    arena_block_t* blocks;      // Most recent block first
+    char* alloc_ptr;            // Free space in the current block
+    size_t alloc_remaining;
+    size_t memory_usage;        // Bytes obtained from malloc, headers included
+    bool concurrent;
+    pthread_mutex_t lock;       // Held around allocations if concurrent
+} arena_t;
+
+// Lifecycle
+arena_t* arena_create(void);
+arena_t* arena_create_concurrent(void);
+void arena_destroy(arena_t* arena);
+
+// Allocation (returns NULL on out of memory)
+void* arena_alloc(arena_t* arena, size_t bytes);
+void* arena_alloc_aligned(arena_t* arena, size_t bytes);  // Pointer aligned
+
+// Statistics (safe to call during concurrent allocation)
+size_t arena_memory_usage(arena_t* arena);
+
+#endif // STORAGE_ARENA_H
@@ -0,0 +1,192 @@
+#include "blob.h"
+#include "crc32.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Helper: write all bytes to fd
+static ssize_t write_all(int fd, const void* buf, size_t len) {
+    const uint8_t* p = buf;
+    size_t remaining = len;
+    while (remaining > 0) {
+        ssize_t n = write(fd, p, remaining);
+        if (n <= 0) return -1;
+        p += n;
+        remaining -= n;
+    }
+    return (ssize_t)len;
+}
+
+// Helper: read all bytes at offset
+static ssize_t pread_all(int fd, void* buf, size_t len, uint64_t offset) {
+    uint8_t* p = buf;
+    size_t remaining = len;
+    while (remaining > 0) {
+        ssize_t n = pread(fd, p, remaining, (off_t)offset);
+        if (n <= 0) return n == 0 ? (ssize_t)(len - remaining) : -1;
+        p += n;
+        offset += n;
+        remaining -= n;
+    }
+    return (ssize_t)len;
+}
+
+// Helper: encode varint
+static size_t encode_varint(uint8_t* buf, uint64_t value) {
+    size_t i = 0;
+    while (value >= 0x80) {
+        buf[i++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    buf[i++] = (uint8_t)value;
+    return i;
+}
+
+// Helper: decode varint
+static size_t decode_varint(const uint8_t* buf, size_t len, uint64_t* value) {
+    *value = 0;
+    size_t i = 0;
+    int shift = 0;
+    while (i < len && i < 10) {
+        uint64_t byte = buf[i++];
+        *value |= (byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return i;
+        shift += 7;
+    }
+    return 0;
+}
+
+size_t blob_ref_encode(const blob_ref_t* ref, char* buf) {
+    uint8_t* p = (uint8_t*)buf;
+    size_t n = encode_varint(p, ref->file_number);
+    n += encode_varint(p + n, ref->offset);
+    n += encode_varint(p + n, ref->size);
+    return n;
+}
+
+bool blob_ref_decode(const char* buf, size_t len, blob_ref_t* ref) {
+    if (!buf || !ref) return false;
+    const uint8_t* p = (const uint8_t*)buf;
+    size_t pos = 0;
+    uint64_t* fields[3] = { &ref->file_number, &ref->offset, &ref->size };
+    for (int i = 0; i < 3; i++) {
+        size_t n = decode_varint(p + pos, len - pos, fields[i]);
+        if (n == 0) return false;
+        pos += n;
+    }
+    return pos == len && ref->size >= BLOB_RECORD_HEADER_SIZE;
+}
+
+void blob_file_path(char* buf, size_t cap, const char* db_path, uint64_t file_number) {
+    snprintf(buf, cap, "%s/%06llu.blob", db_path, (unsigned long long)file_number);
+}
+
+// Create blob file writer
+blob_writer_t* blob_writer_create(const char* db_path, uint64_t file_number) {
+    if (!db_path) return NULL;
+
+    blob_writer_t* w = calloc(1, sizeof(blob_writer_t));
+    if (!w) return NULL;
+
+    char path[512];
+    blob_file_path(path, sizeof(path), db_path, file_number);
+    w->path = strdup(path);
+    if (!w->path) {
+        free(w);
+        return NULL;
+    }
+
+    w->fd = open(w->path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (w->fd < 0) {
+        free(w->path);
+        free(w);
+        return NULL;
+    }
+    w->file_number = file_number;
+    return w;
+}
+
+// Append one value; ref receives its location
+status_t blob_writer_add(blob_writer_t* w, const char* value, size_t value_len,
+                         blob_ref_t* ref) {
+    if (!w || (!value && value_len > 0) || !ref) return STATUS_INVALID_ARG;
+    if (value_len > UINT32_MAX) return STATUS_INVALID_ARG;
+
+    size_t record_size = BLOB_RECORD_HEADER_SIZE + value_len;
+    if (record_size > w->buf_cap) {
+        char* buf = realloc(w->buf, record_size);
+        if (!buf) return STATUS_NO_MEMORY;
+        w->buf = buf;
+        w->buf_cap = record_size;
+    }
+
+    uint32_t len32 = (uint32_t)value_len;
+    memcpy(w->buf + 4, &len32, 4);
+    if (value_len > 0) memcpy(w->buf + BLOB_RECORD_HEADER_SIZE, value, value_len);
+    uint32_t crc = crc32c(w->buf + 4, 4 + value_len);
+    memcpy(w->buf, &crc, 4);
+
+    if (write_all(w->fd, w->buf, record_size) != (ssize_t)record_size) {
+        return STATUS_IO_ERROR;
+    }
+
+    ref->file_number = w->file_number;
+    ref->offset = w->offset;
+    ref->size = record_size;
+    w->offset += record_size;
+    return STATUS_OK;
+}
+
+// Helper: free the writer (file already closed)
+static void blob_writer_free(blob_writer_t* w) {
+    free(w->path);
+    free(w->buf);
+    free(w);
+}
+
+status_t blob_writer_finish(blob_writer_t* w) {
+    if (!w) return STATUS_INVALID_ARG;
+    status_t status = close(w->fd) == 0 ? STATUS_OK : STATUS_IO_ERROR;
+    blob_writer_free(w);
+    return status;
+}
+
+void blob_writer_abort(blob_writer_t* w) {
+    if (!w) return;
+    close(w->fd);
+    unlink(w->path);
+    blob_writer_free(w);
+}
+
+// Read one record
+status_t blob_read(int fd, const blob_ref_t* ref, char** value, size_t* value_len) {
+    if (fd < 0 || !ref || !value || !value_len) return STATUS_INVALID_ARG;
+    if (ref->size < BLOB_RECORD_HEADER_SIZE) return STATUS_CORRUPTION;
+
+    *value = NULL;
+    *value_len = 0;
+
+    uint8_t* record = malloc(ref->size);
+    if (!record) return STATUS_NO_MEMORY;
+    if (pread_all(fd, record, ref->size, ref->offset) != (ssize_t)ref->size) {
+        free(record);
+        return STATUS_IO_ERROR;
+    }
+
+    uint32_t stored_crc, len32;
+    memcpy(&stored_crc, record, 4);
+    memcpy(&len32, record + 4, 4);
+    if ((uint64_t)len32 + BLOB_RECORD_HEADER_SIZE != ref->size ||
+        crc32c(record + 4, 4 + len32) != stored_crc) {
+        free(record);
+        return STATUS_CORRUPTION;
+    }
+
+    // Shift the value to the front and hand the buffer over
+    memmove(record, record + BLOB_RECORD_HEADER_SIZE, len32);
+    *value = (char*)record;
+    *value_len = len32;
+    return STATUS_OK;
+}
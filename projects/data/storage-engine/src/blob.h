@@ -0,0 +1,55 @@
+#ifndef STORAGE_BLOB_H
+#define STORAGE_BLOB_H
+
+#include "types.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Blob files hold large values outside the SSTables (key-value separation),
+// so compaction moves a small reference instead of rewriting the value.
+//
+// File "<db>/NNNNNN.blob": append-only records
+//   crc32c(4) | value_len(4) | value
+// The checksum covers value_len and value. An SSTable entry of type
+// SSTABLE_ENTRY_BLOB holds the encoded reference to one record.
+
+#define BLOB_RECORD_HEADER_SIZE 8
+#define BLOB_REF_MAX_SIZE       30      // Three varints
+
+// Location of one value: the whole record, header included
+typedef struct {
+    uint64_t file_number;
+    uint64_t offset;
+    uint64_t size;
+} blob_ref_t;
+
+// Encode into buf (at least BLOB_REF_MAX_SIZE bytes); returns the length
+size_t blob_ref_encode(const blob_ref_t* ref, char* buf);
+bool blob_ref_decode(const char* buf, size_t len, blob_ref_t* ref);
+
+// Path of a blob file
+void blob_file_path(char* buf, size_t cap, const char* db_path, uint64_t file_number);
+
+// Writer for one new blob file
+typedef struct {
+    int fd;
+    uint64_t file_number;
+    char* path;
+    uint64_t offset;        // Bytes written so far
+    char* buf;              // Record encoding buffer, reused
+    size_t buf_cap;
+} blob_writer_t;
+
+blob_writer_t* blob_writer_create(const char* db_path, uint64_t file_number);
+status_t blob_writer_add(blob_writer_t* w, const char* value, size_t value_len,
+                         blob_ref_t* ref);
+// Close the file (no fsync, like sstable_writer_finish) and free the writer
+status_t blob_writer_finish(blob_writer_t* w);
+// Close, delete the file and free the writer
+void blob_writer_abort(blob_writer_t* w);
+
+// Read and verify the record ref points at; *value is malloc'd
+status_t blob_read(int fd, const blob_ref_t* ref, char** value, size_t* value_len);
+
+#endif // STORAGE_BLOB_H
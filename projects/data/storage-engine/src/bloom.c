@@ -1,4 +1,5 @@
 #include "bloom.h"
+#include "cpu.h"
 #include "param.h"
 #include <stdlib.h>
 #include <string.h>
@@ -52,27 +53,208 @@ static uint32_t murmur_hash3_32(const void* key, size_t len, uint32_t seed) {
     return h1;
 }
 
-// Create bloom filter
-bloom_filter_t* bloom_create(size_t estimated_keys) {
-    if (estimated_keys == 0) {
-        estimated_keys = 1;
+uint32_t bloom_hash(const char* key, size_t key_len, uint32_t seed) {
+    return murmur_hash3_32(key, key_len, seed);
+}
+
+// MurmurHash64A: one 64-bit hash feeds every probe of a blocked filter
+static uint64_t murmur_hash64a(const void* key, size_t len, uint64_t seed) {
+    const uint64_t m = 0xc6a4a7935bd1e995ULL;
+    const int r = 47;
+    const uint8_t* data = (const uint8_t*)key;
+    const uint8_t* end = data + (len / 8) * 8;
+
+    uint64_t h = seed ^ (len * m);
+
+    for (; data != end; data += 8) {
+        uint64_t k;
+        memcpy(&k, data, sizeof(k));
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        h ^= k;
+        h *= m;
     }
 
-    bloom_filter_t* bf = malloc(sizeof(bloom_filter_t));
-    if (!bf) return NULL;
+    switch (len & 7) {
+        case 7: h ^= (uint64_t)data[6] << 48; // fallthrough
+        case 6: h ^= (uint64_t)data[5] << 40; // fallthrough
+        case 5: h ^= (uint64_t)data[4] << 32; // fallthrough
+        case 4: h ^= (uint64_t)data[3] << 24; // fallthrough
+        case 3: h ^= (uint64_t)data[2] << 16; // fallthrough
+        case 2: h ^= (uint64_t)data[1] << 8;  // fallthrough
+        case 1: h ^= (uint64_t)data[0];
+                h *= m;
+    }
 
-    // Calculate number of bits (BLOOM_BITS_PER_KEY bits per key)
-    bf->num_bits = estimated_keys * BLOOM_BITS_PER_KEY;
-    // Round up to nearest byte
-    size_t num_bytes = (bf->num_bits + 7) / 8;
-    bf->num_bits = num_bytes * 8;
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
+}
+
+// Blocked layout: the high half of the hash picks the 64-byte block, then
+// probe i sets bit ((h1 + i * h2) >> 23), i.e. bit 0..511 of that block.
+// Bits are numbered within little-endian 32-bit words.
+typedef struct {
+    const uint8_t* block;
+    uint32_t h1;
+    uint32_t h2;
+} blocked_probe_t;
+
+static blocked_probe_t blocked_probe(const uint8_t* bits, size_t num_blocks, uint64_t h) {
+    uint32_t hi = (uint32_t)(h >> 32);
+    size_t block = (size_t)(((uint64_t)hi * num_blocks) >> 32);
+
+    blocked_probe_t p;
+    p.block = bits + block * BLOOM_BLOCK_BYTES;
+    p.h1 = (uint32_t)h;
+    p.h2 = (hi * 0x9E3779B9u) | 1;
+    return p;
+}
+
+// The probes below don't assume alignment: serialized filters are probed
+// in place inside cached or mapped blocks.
+static bool blocked_check_scalar(const blocked_probe_t* p, int k) {
+    uint32_t h = p->h1;
+    for (int i = 0; i < k; i++) {
+        uint32_t bit = h >> 23;
+        uint32_t word;
+        memcpy(&word, p->block + (bit >> 5) * 4, 4);
+        if (!(word & (1u << (bit & 31)))) return false;
+        h += p->h2;
+    }
+    return true;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+// AVX2: all (up to 8) probes at once. Each lane gathers its 32-bit word
+// from the two halves of the block and tests its bit.
+__attribute__((target("avx2")))
+static bool blocked_check_avx2(const blocked_probe_t* p, int k) {
+    __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256i h = _mm256_add_epi32(_mm256_set1_epi32((int)p->h1),
+                                 _mm256_mullo_epi32(lane, _mm256_set1_epi32((int)p->h2)));
+    __m256i bit = _mm256_srli_epi32(h, 23);
+    __m256i word = _mm256_srli_epi32(bit, 5);
+
+    __m256i lo = _mm256_loadu_si256((const __m256i*)p->block);
+    __m256i hi = _mm256_loadu_si256((const __m256i*)(p->block + 32));
+    __m256i from_lo = _mm256_permutevar8x32_epi32(lo, word);
+    __m256i from_hi = _mm256_permutevar8x32_epi32(hi, word);
+    // Word index bit 3 (upper half) moved into the sign bit selects hi
+    __m256 select = _mm256_castsi256_ps(_mm256_slli_epi32(word, 28));
+    __m256i words = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(from_lo),
+                                                         _mm256_castsi256_ps(from_hi), select));
+
+    __m256i mask = _mm256_sllv_epi32(_mm256_set1_epi32(1),
+                                     _mm256_and_si256(bit, _mm256_set1_epi32(31)));
+    __m256i hit = _mm256_cmpeq_epi32(_mm256_and_si256(words, mask), mask);
+    int hits = _mm256_movemask_ps(_mm256_castsi256_ps(hit));
+    int need = (1 << k) - 1;
+    return (hits & need) == need;
+}
+
+// SSE2 (x86-64 baseline): build the key's 512-bit mask, then compare the
+// whole block against it 128 bits at a time
+static bool blocked_check_sse2(const blocked_probe_t* p, int k) {
+    uint32_t mask[BLOOM_BLOCK_BYTES / 4] __attribute__((aligned(16))) = {0};
+    uint32_t h = p->h1;
+    for (int i = 0; i < k; i++) {
+        uint32_t bit = h >> 23;
+        mask[bit >> 5] |= 1u << (bit & 31);
+        h += p->h2;
+    }
+
+    __m128i all = _mm_set1_epi32(-1);
+    for (int i = 0; i < 4; i++) {
+        __m128i m = _mm_load_si128((const __m128i*)mask + i);
+        __m128i b = _mm_loadu_si128((const __m128i*)p->block + i);
+        __m128i eq = _mm_cmpeq_epi32(_mm_and_si128(b, m), m);
+        all = _mm_and_si128(all, eq);
+    }
+    return _mm_movemask_epi8(all) == 0xFFFF;
+}
+#endif
+
+typedef bool (*blocked_check_fn)(const blocked_probe_t* p, int k);
 
-    bf->bits = calloc(num_bytes, 1);
+// Helper: the widest probe this CPU supports, and its name
+static blocked_check_fn blocked_check_impl(const char** name) {
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned features = cpu_features();
+    if (features & CPU_AVX2) {
+        if (name) *name = "avx2";
+        return blocked_check_avx2;
+    }
+    if (features & CPU_SSE2) {
+        if (name) *name = "sse2";
+        return blocked_check_sse2;
+    }
+#endif
+    if (name) *name = "scalar";
+    return blocked_check_scalar;
+}
+
+const char* bloom_probe_impl(void) {
+    const char* name;
+    blocked_check_impl(&name);
+    return name;
+}
+
+// Helper: allocate a bloom filter with an allocated, zeroed bit array
+static bloom_filter_t* bloom_alloc(uint8_t format, size_t num_bytes) {
+    bloom_filter_t* bf = calloc(1, sizeof(bloom_filter_t));
+    if (!bf) return NULL;
+
+    bf->format = format;
+    if (format == BLOOM_FORMAT_BLOCKED) {
+        // Blocks must not straddle cache lines; the SIMD loads rely on it
+        void* bits = NULL;
+        if (posix_memalign(&bits, BLOOM_BLOCK_BYTES, num_bytes) != 0) bits = NULL;
+        bf->bits = bits;
+        if (bf->bits) memset(bf->bits, 0, num_bytes);
+    } else {
+        bf->bits = calloc(num_bytes > 0 ? num_bytes : 1, 1);
+    }
     if (!bf->bits) {
         free(bf);
         return NULL;
     }
+    return bf;
+}
+
+// Create bloom filter
+bloom_filter_t* bloom_create(size_t estimated_keys) {
+    return bloom_create_format(estimated_keys,
+                               BLOOM_BLOCKED ? BLOOM_FORMAT_BLOCKED : BLOOM_FORMAT_LEGACY);
+}
+
+bloom_filter_t* bloom_create_format(size_t estimated_keys, uint8_t format) {
+    if (estimated_keys == 0) {
+        estimated_keys = 1;
+    }
+    if (format != BLOOM_FORMAT_LEGACY && format != BLOOM_FORMAT_BLOCKED) return NULL;
+
+    // Calculate number of bits (BLOOM_BITS_PER_KEY bits per key), rounded
+    // up to whole bytes (legacy) or whole 512-bit blocks (blocked)
+    size_t num_bits = estimated_keys * BLOOM_BITS_PER_KEY;
+    size_t num_bytes;
+    size_t num_blocks = 0;
+    if (format == BLOOM_FORMAT_BLOCKED) {
+        num_blocks = (num_bits + BLOOM_BLOCK_BYTES * 8 - 1) / (BLOOM_BLOCK_BYTES * 8);
+        num_bytes = num_blocks * BLOOM_BLOCK_BYTES;
+    } else {
+        num_bytes = (num_bits + 7) / 8;
+    }
 
+    bloom_filter_t* bf = bloom_alloc(format, num_bytes);
+    if (!bf) return NULL;
+
+    bf->num_bits = num_bytes * 8;
+    bf->num_blocks = num_blocks;
     bf->num_keys = 0;
     // Optimal k = (m/n) * ln(2) ≈ 0.693 * bits_per_key
     // For 10 bits/key: k ≈ 6.93, round to 7
@@ -93,6 +275,11 @@ void bloom_destroy(bloom_filter_t* bf) {
 void bloom_add(bloom_filter_t* bf, const char* key, size_t key_len) {
     if (!bf || !key) return;
 
+    if (bf->format == BLOOM_FORMAT_BLOCKED) {
+        bloom_add_hash64(bf, bloom_key_hash64(key, key_len));
+        return;
+    }
+
     // Double hashing: h(i) = h1 + i * h2
     uint32_t h1 = murmur_hash3_32(key, key_len, 0);
     uint32_t h2 = murmur_hash3_32(key, key_len, h1);
@@ -105,16 +292,33 @@ void bloom_add(bloom_filter_t* bf, const char* key, size_t key_len) {
     bf->num_keys++;
 }
 
-// Check if key may be in the set
-bool bloom_may_contain(bloom_filter_t* bf, const char* key, size_t key_len) {
-    if (!bf || !key) return false;
+uint64_t bloom_key_hash64(const char* key, size_t key_len) {
+    return murmur_hash64a(key, key_len, 0);
+}
+
+void bloom_add_hash64(bloom_filter_t* bf, uint64_t hash) {
+    if (!bf || bf->format != BLOOM_FORMAT_BLOCKED) return;
 
+    blocked_probe_t p = blocked_probe(bf->bits, bf->num_blocks, hash);
+    uint8_t* block = (uint8_t*)p.block;
+    uint32_t h = p.h1;
+    for (uint8_t i = 0; i < bf->num_hashes; i++) {
+        uint32_t bit = h >> 23;
+        block[bit >> 3] |= (uint8_t)(1u << (bit & 7));
+        h += p.h2;
+    }
+    bf->num_keys++;
+}
+
+// Helper: legacy probe over the whole bit array
+static bool legacy_may_contain(const uint8_t* bits, uint64_t num_bits, uint8_t num_hashes,
+                               const char* key, size_t key_len) {
     uint32_t h1 = murmur_hash3_32(key, key_len, 0);
     uint32_t h2 = murmur_hash3_32(key, key_len, h1);
 
-    for (uint8_t i = 0; i < bf->num_hashes; i++) {
-        uint32_t bit_pos = (h1 + i * h2) % bf->num_bits;
-        if (!(bf->bits[bit_pos / 8] & (1 << (bit_pos % 8)))) {
+    for (uint8_t i = 0; i < num_hashes; i++) {
+        uint32_t bit_pos = (h1 + i * h2) % num_bits;
+        if (!(bits[bit_pos / 8] & (1 << (bit_pos % 8)))) {
             return false;
         }
     }
@@ -122,10 +326,37 @@ bool bloom_may_contain(bloom_filter_t* bf, const char* key, size_t key_len) {
     return true;
 }
 
+// Check if key may be in the set
+bool bloom_may_contain(bloom_filter_t* bf, const char* key, size_t key_len) {
+    if (!bf || !key) return false;
+
+    if (bf->format == BLOOM_FORMAT_BLOCKED) {
+        blocked_probe_t p = blocked_probe(bf->bits, bf->num_blocks, bloom_key_hash64(key, key_len));
+        return blocked_check_impl(NULL)(&p, bf->num_hashes);
+    }
+    return legacy_may_contain(bf->bits, bf->num_bits, bf->num_hashes, key, key_len);
+}
+
+bool bloom_may_contain_scalar(bloom_filter_t* bf, const char* key, size_t key_len) {
+    if (!bf || !key) return false;
+
+    if (bf->format == BLOOM_FORMAT_BLOCKED) {
+        blocked_probe_t p = blocked_probe(bf->bits, bf->num_blocks, bloom_key_hash64(key, key_len));
+        return blocked_check_scalar(&p, bf->num_hashes);
+    }
+    return legacy_may_contain(bf->bits, bf->num_bits, bf->num_hashes, key, key_len);
+}
+
 // Get serialized size
-// Format: num_bits(8) + num_hashes(1) + bits(variable)
+// Legacy:  num_bits(8) + num_hashes(1) + bits(variable)
+// Blocked: magic(8) + version(1) + num_hashes(1) + num_blocks(4) + bits
+#define BLOOM_BLOCKED_HEADER_SIZE 14
+
 size_t bloom_serialized_size(bloom_filter_t* bf) {
     if (!bf) return 0;
+    if (bf->format == BLOOM_FORMAT_BLOCKED) {
+        return BLOOM_BLOCKED_HEADER_SIZE + bf->num_blocks * BLOOM_BLOCK_BYTES;
+    }
     size_t num_bytes = (bf->num_bits + 7) / 8;
     return 8 + 1 + num_bytes;  // num_bits + num_hashes + bit array
 }
@@ -137,6 +368,17 @@ status_t bloom_serialize(bloom_filter_t* bf, uint8_t* buf, size_t len) {
     size_t required = bloom_serialized_size(bf);
     if (len < required) return STATUS_INVALID_ARG;
 
+    if (bf->format == BLOOM_FORMAT_BLOCKED) {
+        uint64_t magic = BLOOM_BLOCKED_MAGIC;
+        uint32_t num_blocks = (uint32_t)bf->num_blocks;
+        memcpy(buf, &magic, 8);
+        buf[8] = BLOOM_BLOCKED_VERSION;
+        buf[9] = bf->num_hashes;
+        memcpy(buf + 10, &num_blocks, 4);
+        memcpy(buf + BLOOM_BLOCKED_HEADER_SIZE, bf->bits, bf->num_blocks * BLOOM_BLOCK_BYTES);
+        return STATUS_OK;
+    }
+
     size_t num_bytes = (bf->num_bits + 7) / 8;
 
     // Write num_bits (8 bytes, little-endian)
@@ -153,32 +395,55 @@ status_t bloom_serialize(bloom_filter_t* bf, uint8_t* buf, size_t len) {
     return STATUS_OK;
 }
 
+// Helper: deserialize the blocked format (header already identified)
+static bloom_filter_t* deserialize_blocked(const uint8_t* buf, size_t len) {
+    if (len < BLOOM_BLOCKED_HEADER_SIZE) return NULL;
+    if (buf[8] != BLOOM_BLOCKED_VERSION) return NULL;
+
+    uint8_t num_hashes = buf[9];
+    if (num_hashes == 0 || num_hashes > BLOOM_BLOCKED_MAX_HASHES) return NULL;
+
+    uint32_t num_blocks;
+    memcpy(&num_blocks, buf + 10, 4);
+    if (num_blocks == 0) return NULL;
+    size_t num_bytes = (size_t)num_blocks * BLOOM_BLOCK_BYTES;
+    if (len - BLOOM_BLOCKED_HEADER_SIZE < num_bytes) return NULL;
+
+    bloom_filter_t* bf = bloom_alloc(BLOOM_FORMAT_BLOCKED, num_bytes);
+    if (!bf) return NULL;
+
+    bf->num_blocks = num_blocks;
+    bf->num_bits = num_bytes * 8;
+    bf->num_hashes = num_hashes;
+    bf->num_keys = 0;  // Unknown after deserialization
+    memcpy(bf->bits, buf + BLOOM_BLOCKED_HEADER_SIZE, num_bytes);
+    return bf;
+}
+
 // Deserialize bloom filter from buffer
 bloom_filter_t* bloom_deserialize(const uint8_t* buf, size_t len) {
     if (!buf || len < 9) return NULL;  // Minimum: 8 + 1 bytes
 
-    // Read num_bits
+    // Read num_bits, or the blocked format's magic in its place
     uint64_t num_bits;
     memcpy(&num_bits, buf, 8);
+    if (num_bits == BLOOM_BLOCKED_MAGIC) {
+        return deserialize_blocked(buf, len);
+    }
     buf += 8;
 
     // Read num_hashes
     uint8_t num_hashes = *buf++;
 
     // Calculate expected size
+    if (num_bits == 0) return NULL;
     size_t num_bytes = (num_bits + 7) / 8;
-    if (len < 9 + num_bytes) return NULL;
+    if (len - 9 < num_bytes) return NULL;
 
     // Allocate bloom filter
-    bloom_filter_t* bf = malloc(sizeof(bloom_filter_t));
+    bloom_filter_t* bf = bloom_alloc(BLOOM_FORMAT_LEGACY, num_bytes);
     if (!bf) return NULL;
 
-    bf->bits = malloc(num_bytes);
-    if (!bf->bits) {
-        free(bf);
-        return NULL;
-    }
-
     bf->num_bits = num_bits;
     bf->num_hashes = num_hashes;
     bf->num_keys = 0;  // Unknown after deserialization
@@ -188,3 +453,29 @@ bloom_filter_t* bloom_deserialize(const uint8_t* buf, size_t len) {
 
     return bf;
 }
+
+// Probe a serialized filter in place. Malformed filters answer "maybe",
+// which only costs a data block read.
+bool bloom_may_contain_serialized(const uint8_t* buf, size_t len,
+                                  const char* key, size_t key_len) {
+    if (!buf || !key || len < 9) return true;
+
+    uint64_t num_bits;
+    memcpy(&num_bits, buf, 8);
+    if (num_bits == BLOOM_BLOCKED_MAGIC) {
+        if (len < BLOOM_BLOCKED_HEADER_SIZE || buf[8] != BLOOM_BLOCKED_VERSION) return true;
+        uint8_t num_hashes = buf[9];
+        uint32_t num_blocks;
+        memcpy(&num_blocks, buf + 10, 4);
+        if (num_hashes == 0 || num_hashes > BLOOM_BLOCKED_MAX_HASHES || num_blocks == 0 ||
+            len - BLOOM_BLOCKED_HEADER_SIZE < (size_t)num_blocks * BLOOM_BLOCK_BYTES) {
+            return true;
+        }
+        blocked_probe_t p = blocked_probe(buf + BLOOM_BLOCKED_HEADER_SIZE, num_blocks,
+                                          bloom_key_hash64(key, key_len));
+        return blocked_check_impl(NULL)(&p, num_hashes);
+    }
+
+    if (num_bits == 0 || len - 9 < (num_bits + 7) / 8) return true;
+    return legacy_may_contain(buf + 9, num_bits, buf[8], key, key_len);
+}
@@ -6,17 +6,31 @@
 #include <stddef.h>
 #include <stdbool.h>
 
+// Filter formats
+#define BLOOM_FORMAT_LEGACY     0   // k probes spread over the whole bit array
+#define BLOOM_FORMAT_BLOCKED    1   // All k probes inside one 64-byte block
+
+#define BLOOM_BLOCK_BYTES       64
+#define BLOOM_BLOCKED_MAX_HASHES 8  // One SIMD lane per probe
+// Leads the serialized blocked format ("BLOOMBLK"); far too large to be a
+// legacy num_bits, so the two formats can't be confused
+#define BLOOM_BLOCKED_MAGIC     0x4B4C424D4F4F4C42ULL
+#define BLOOM_BLOCKED_VERSION   1
+
 // Bloom filter structure
 struct bloom_filter {
-    uint8_t* bits;          // Bit array
+    uint8_t* bits;          // Bit array (64-byte aligned when blocked)
     size_t num_bits;        // Number of bits
     size_t num_keys;        // Number of keys added
     uint8_t num_hashes;     // Number of hash functions (k)
+    uint8_t format;         // BLOOM_FORMAT_*
+    size_t num_blocks;      // Number of 64-byte blocks (blocked format)
 };
 
 // Create a bloom filter for estimated number of keys
-// Uses BLOOM_BITS_PER_KEY from param.h
+// Uses BLOOM_BITS_PER_KEY and BLOOM_BLOCKED from param.h
 bloom_filter_t* bloom_create(size_t estimated_keys);
+bloom_filter_t* bloom_create_format(size_t estimated_keys, uint8_t format);
 
 // Destroy bloom filter
 void bloom_destroy(bloom_filter_t* bf);
@@ -25,7 +39,22 @@ void bloom_destroy(bloom_filter_t* bf);
 void bloom_add(bloom_filter_t* bf, const char* key, size_t key_len);
 
 // Check if key may be in the set (false = definitely not, true = maybe)
+// Blocked filters use AVX2 or SSE2 when the CPU has them
 bool bloom_may_contain(bloom_filter_t* bf, const char* key, size_t key_len);
+// Portable probe; the SIMD paths must agree with it
+bool bloom_may_contain_scalar(bloom_filter_t* bf, const char* key, size_t key_len);
+// Probe a serialized filter without deserializing it (no alignment needed)
+bool bloom_may_contain_serialized(const uint8_t* buf, size_t len,
+                                  const char* key, size_t key_len);
+// Blocked filters only: add a key by its bloom_key_hash64() value, for
+// callers that collect hashes before sizing the filter
+uint64_t bloom_key_hash64(const char* key, size_t key_len);
+void bloom_add_hash64(bloom_filter_t* bf, uint64_t hash);
+// Probe implementation picked for blocked filters: "avx2", "sse2" or "scalar"
+const char* bloom_probe_impl(void);
+
+// MurmurHash3 of a key (also used by the data block hash index)
+uint32_t bloom_hash(const char* key, size_t key_len, uint32_t seed);
 
 // Serialization
 size_t bloom_serialized_size(bloom_filter_t* bf);
@@ -1,9 +1,13 @@
 #include "cache.h"
+#include "param.h"
 #include <stdlib.h>
 #include <string.h>
 
 #define INITIAL_BUCKETS 256
 
+// Block cache keys are file_number(8) + offset(8)
+#define BLOCK_KEY_SIZE 16
+
 // Hash function (FNV-1a)
 static uint32_t hash_key(const char* key, size_t len) {
     uint32_t hash = 2166136261u;
@@ -14,9 +18,21 @@ static uint32_t hash_key(const char* key, size_t len) {
     return hash;
 }
 
-// Create a new cache entry
+// Helper: pick shard by the high bits of the hash
+// (the low bits already select the bucket inside the shard)
+static cache_shard_t* shard_for(block_cache_t* cache, uint32_t hash) {
+    return &cache->shards[(hash >> 16) & (cache->num_shards - 1)];
+}
+
+// Helper: encode a block key
+static void encode_block_key(char* buf, uint64_t file_number, uint64_t offset) {
+    memcpy(buf, &file_number, 8);
+    memcpy(buf + 8, &offset, 8);
+}
+
+// Create a new cache entry (takes ownership of data)
 static cache_entry_t* entry_create(const char* key, size_t key_len,
-                                   const uint8_t* data, size_t data_len,
+                                   uint8_t* data, size_t data_len,
                                    uint32_t hash) {
     cache_entry_t* entry = malloc(sizeof(cache_entry_t));
     if (!entry) return NULL;
@@ -29,19 +45,15 @@ static cache_entry_t* entry_create(const char* key, size_t key_len,
     memcpy(entry->key, key, key_len);
     entry->key_len = key_len;
 
-    entry->data = malloc(data_len);
-    if (!entry->data) {
-        free(entry->key);
-        free(entry);
-        return NULL;
-    }
-    memcpy(entry->data, data, data_len);
+    entry->data = data;
     entry->data_len = data_len;
 
     entry->prev = NULL;
     entry->next = NULL;
     entry->hash_next = NULL;
     entry->hash = hash;
+    entry->refs = 1;  // Reference held by the cache
+    entry->in_cache = true;
 
     return entry;
 }
@@ -55,77 +67,130 @@ static void entry_destroy(cache_entry_t* entry) {
     }
 }
 
-// Create cache
-block_cache_t* cache_create(size_t capacity) {
+// Drop one reference (shard lock must be held)
+static void entry_unref(cache_entry_t* entry) {
+    if (--entry->refs == 0) {
+        entry_destroy(entry);
+    }
+}
+
+// Initialize a shard
+static bool shard_init(cache_shard_t* shard, size_t capacity) {
+    shard->bucket_count = INITIAL_BUCKETS;
+    shard->buckets = calloc(shard->bucket_count, sizeof(cache_entry_t*));
+    if (!shard->buckets) return false;
+
+    if (pthread_mutex_init(&shard->lock, NULL) != 0) {
+        free(shard->buckets);
+        return false;
+    }
+
+    shard->head = NULL;
+    shard->tail = NULL;
+    shard->capacity = capacity;
+    shard->usage = 0;
+    shard->count = 0;
+    shard->hits = 0;
+    shard->misses = 0;
+    return true;
+}
+
+// Create cache with 2^num_shard_bits shards
+block_cache_t* cache_create_sharded(size_t capacity, int num_shard_bits) {
+    if (num_shard_bits < 0) num_shard_bits = 0;
+    if (num_shard_bits > CACHE_MAX_SHARD_BITS) num_shard_bits = CACHE_MAX_SHARD_BITS;
+
     block_cache_t* cache = malloc(sizeof(block_cache_t));
     if (!cache) return NULL;
 
-    cache->bucket_count = INITIAL_BUCKETS;
-    cache->buckets = calloc(cache->bucket_count, sizeof(cache_entry_t*));
-    if (!cache->buckets) {
+    cache->num_shards = (size_t)1 << num_shard_bits;
+    cache->capacity = capacity;
+    cache->shards = calloc(cache->num_shards, sizeof(cache_shard_t));
+    if (!cache->shards) {
         free(cache);
         return NULL;
     }
 
-    cache->head = NULL;
-    cache->tail = NULL;
-    cache->capacity = capacity;
-    cache->usage = 0;
-    cache->hits = 0;
-    cache->misses = 0;
+    size_t per_shard = (capacity + cache->num_shards - 1) / cache->num_shards;
+    for (size_t i = 0; i < cache->num_shards; i++) {
+        if (!shard_init(&cache->shards[i], per_shard)) {
+            for (size_t j = 0; j < i; j++) {
+                pthread_mutex_destroy(&cache->shards[j].lock);
+                free(cache->shards[j].buckets);
+            }
+            free(cache->shards);
+            free(cache);
+            return NULL;
+        }
+    }
 
     return cache;
 }
 
-// Destroy cache
+// Create cache, using as many shards as the capacity allows
+block_cache_t* cache_create(size_t capacity) {
+    int bits = 0;
+    while (bits < CACHE_MAX_SHARD_BITS &&
+           (capacity >> (bits + 1)) >= CACHE_MIN_SHARD_SIZE) {
+        bits++;
+    }
+    return cache_create_sharded(capacity, bits);
+}
+
+// Destroy cache (all pinned entries must have been released)
 void cache_destroy(block_cache_t* cache) {
     if (!cache) return;
 
-    cache_entry_t* entry = cache->head;
-    while (entry) {
-        cache_entry_t* next = entry->next;
-        entry_destroy(entry);
-        entry = next;
+    for (size_t i = 0; i < cache->num_shards; i++) {
+        cache_shard_t* shard = &cache->shards[i];
+        cache_entry_t* entry = shard->head;
+        while (entry) {
+            cache_entry_t* next = entry->next;
+            entry_destroy(entry);
+            entry = next;
+        }
+        free(shard->buckets);
+        pthread_mutex_destroy(&shard->lock);
     }
 
-    free(cache->buckets);
+    free(cache->shards);
     free(cache);
 }
 
 // Remove entry from LRU list
-static void lru_remove(block_cache_t* cache, cache_entry_t* entry) {
+static void lru_remove(cache_shard_t* shard, cache_entry_t* entry) {
     if (entry->prev) {
         entry->prev->next = entry->next;
     } else {
-        cache->head = entry->next;
+        shard->head = entry->next;
     }
     if (entry->next) {
         entry->next->prev = entry->prev;
     } else {
-        cache->tail = entry->prev;
+        shard->tail = entry->prev;
     }
     entry->prev = NULL;
     entry->next = NULL;
 }
 
 // Insert entry at head of LRU list (most recently used)
-static void lru_insert_head(block_cache_t* cache, cache_entry_t* entry) {
+static void lru_insert_head(cache_shard_t* shard, cache_entry_t* entry) {
     entry->prev = NULL;
-    entry->next = cache->head;
-    if (cache->head) {
-        cache->head->prev = entry;
+    entry->next = shard->head;
+    if (shard->head) {
+        shard->head->prev = entry;
     }
-    cache->head = entry;
-    if (!cache->tail) {
-        cache->tail = entry;
+    shard->head = entry;
+    if (!shard->tail) {
+        shard->tail = entry;
     }
 }
 
 // Find entry in hash table
-static cache_entry_t* hash_find(block_cache_t* cache, const char* key,
+static cache_entry_t* hash_find(cache_shard_t* shard, const char* key,
                                  size_t key_len, uint32_t hash) {
-    size_t bucket = hash % cache->bucket_count;
-    cache_entry_t* entry = cache->buckets[bucket];
+    size_t bucket = hash % shard->bucket_count;
+    cache_entry_t* entry = shard->buckets[bucket];
     while (entry) {
         if (entry->hash == hash && entry->key_len == key_len &&
             memcmp(entry->key, key, key_len) == 0) {
@@ -137,16 +202,16 @@ static cache_entry_t* hash_find(block_cache_t* cache, const char* key,
 }
 
 // Insert entry into hash table
-static void hash_insert(block_cache_t* cache, cache_entry_t* entry) {
-    size_t bucket = entry->hash % cache->bucket_count;
-    entry->hash_next = cache->buckets[bucket];
-    cache->buckets[bucket] = entry;
+static void hash_insert(cache_shard_t* shard, cache_entry_t* entry) {
+    size_t bucket = entry->hash % shard->bucket_count;
+    entry->hash_next = shard->buckets[bucket];
+    shard->buckets[bucket] = entry;
 }
 
 // Remove entry from hash table
-static void hash_remove(block_cache_t* cache, cache_entry_t* entry) {
-    size_t bucket = entry->hash % cache->bucket_count;
-    cache_entry_t** pp = &cache->buckets[bucket];
+static void hash_remove(cache_shard_t* shard, cache_entry_t* entry) {
+    size_t bucket = entry->hash % shard->bucket_count;
+    cache_entry_t** pp = &shard->buckets[bucket];
     while (*pp) {
         if (*pp == entry) {
             *pp = entry->hash_next;
@@ -157,15 +222,65 @@ static void hash_remove(block_cache_t* cache, cache_entry_t* entry) {
     }
 }
 
+// Detach entry from the shard and drop the cache's reference
+static void shard_remove(cache_shard_t* shard, cache_entry_t* entry) {
+    lru_remove(shard, entry);
+    hash_remove(shard, entry);
+    shard->usage -= (entry->key_len + entry->data_len);
+    shard->count--;
+    entry->in_cache = false;
+    entry_unref(entry);
+}
+
 // Evict entries until we have enough space
-static void evict_if_needed(block_cache_t* cache, size_t needed) {
-    while (cache->usage + needed > cache->capacity && cache->tail) {
-        cache_entry_t* victim = cache->tail;
-        lru_remove(cache, victim);
-        hash_remove(cache, victim);
-        cache->usage -= (victim->key_len + victim->data_len);
-        entry_destroy(victim);
+static void evict_if_needed(cache_shard_t* shard, size_t needed) {
+    while (shard->usage + needed > shard->capacity && shard->tail) {
+        shard_remove(shard, shard->tail);
+    }
+}
+
+// Helper: insert an owned buffer into a locked shard
+// Returns the new entry (still holding only the cache reference) or NULL.
+static cache_entry_t* shard_insert(cache_shard_t* shard, const char* key,
+                                   size_t key_len, uint8_t* data,
+                                   size_t data_len, uint32_t hash) {
+    // Replace existing entry
+    cache_entry_t* existing = hash_find(shard, key, key_len, hash);
+    if (existing) {
+        shard_remove(shard, existing);
     }
+
+    size_t entry_size = key_len + data_len;
+
+    // Don't cache if larger than shard capacity
+    if (entry_size > shard->capacity) return NULL;
+
+    // Evict if needed
+    evict_if_needed(shard, entry_size);
+
+    cache_entry_t* entry = entry_create(key, key_len, data, data_len, hash);
+    if (!entry) return NULL;
+
+    hash_insert(shard, entry);
+    lru_insert_head(shard, entry);
+    shard->usage += entry_size;
+    shard->count++;
+    return entry;
+}
+
+// Helper: find entry in a locked shard and update LRU/statistics
+static cache_entry_t* shard_lookup(cache_shard_t* shard, const char* key,
+                                   size_t key_len, uint32_t hash) {
+    cache_entry_t* entry = hash_find(shard, key, key_len, hash);
+    if (entry) {
+        shard->hits++;
+        // Move to head (most recently used)
+        lru_remove(shard, entry);
+        lru_insert_head(shard, entry);
+    } else {
+        shard->misses++;
+    }
+    return entry;
 }
 
 // Get data from cache (returns copy, caller must free)
@@ -174,24 +289,21 @@ uint8_t* cache_get(block_cache_t* cache, const char* key, size_t key_len,
     if (!cache || !key) return NULL;
 
     uint32_t hash = hash_key(key, key_len);
-    cache_entry_t* entry = hash_find(cache, key, key_len, hash);
+    cache_shard_t* shard = shard_for(cache, hash);
 
+    pthread_mutex_lock(&shard->lock);
+    uint8_t* copy = NULL;
+    cache_entry_t* entry = shard_lookup(shard, key, key_len, hash);
     if (entry) {
-        cache->hits++;
-        // Move to head (most recently used)
-        lru_remove(cache, entry);
-        lru_insert_head(cache, entry);
-        // Return copy of data
-        uint8_t* copy = malloc(entry->data_len);
+        copy = malloc(entry->data_len);
         if (copy) {
             memcpy(copy, entry->data, entry->data_len);
             if (data_len) *data_len = entry->data_len;
         }
-        return copy;
     }
+    pthread_mutex_unlock(&shard->lock);
 
-    cache->misses++;
-    return NULL;
+    return copy;
 }
 
 // Put data into cache
@@ -199,34 +311,18 @@ void cache_put(block_cache_t* cache, const char* key, size_t key_len,
                const uint8_t* data, size_t data_len) {
     if (!cache || !key || !data) return;
 
-    uint32_t hash = hash_key(key, key_len);
-
-    // Check if key already exists
-    cache_entry_t* existing = hash_find(cache, key, key_len, hash);
-    if (existing) {
-        // Update existing entry
-        lru_remove(cache, existing);
-        hash_remove(cache, existing);
-        cache->usage -= (existing->key_len + existing->data_len);
-        entry_destroy(existing);
-    }
-
-    size_t entry_size = key_len + data_len;
-
-    // Don't cache if larger than capacity
-    if (entry_size > cache->capacity) return;
+    uint8_t* copy = malloc(data_len);
+    if (!copy) return;
+    memcpy(copy, data, data_len);
 
-    // Evict if needed
-    evict_if_needed(cache, entry_size);
+    uint32_t hash = hash_key(key, key_len);
+    cache_shard_t* shard = shard_for(cache, hash);
 
-    // Create new entry
-    cache_entry_t* entry = entry_create(key, key_len, data, data_len, hash);
-    if (!entry) return;
+    pthread_mutex_lock(&shard->lock);
+    cache_entry_t* entry = shard_insert(shard, key, key_len, copy, data_len, hash);
+    pthread_mutex_unlock(&shard->lock);
 
-    // Insert into hash table and LRU list
-    hash_insert(cache, entry);
-    lru_insert_head(cache, entry);
-    cache->usage += entry_size;
+    if (!entry) free(copy);
 }
 
 // Invalidate a cache entry
@@ -234,57 +330,146 @@ void cache_invalidate(block_cache_t* cache, const char* key, size_t key_len) {
     if (!cache || !key) return;
 
     uint32_t hash = hash_key(key, key_len);
-    cache_entry_t* entry = hash_find(cache, key, key_len, hash);
+    cache_shard_t* shard = shard_for(cache, hash);
 
+    pthread_mutex_lock(&shard->lock);
+    cache_entry_t* entry = hash_find(shard, key, key_len, hash);
     if (entry) {
-        lru_remove(cache, entry);
-        hash_remove(cache, entry);
-        cache->usage -= (entry->key_len + entry->data_len);
-        entry_destroy(entry);
+        shard_remove(shard, entry);
     }
+    pthread_mutex_unlock(&shard->lock);
 }
 
 // Clear all entries
 void cache_clear(block_cache_t* cache) {
     if (!cache) return;
 
-    cache_entry_t* entry = cache->head;
-    while (entry) {
-        cache_entry_t* next = entry->next;
-        entry_destroy(entry);
-        entry = next;
+    for (size_t i = 0; i < cache->num_shards; i++) {
+        cache_shard_t* shard = &cache->shards[i];
+        pthread_mutex_lock(&shard->lock);
+
+        cache_entry_t* entry = shard->head;
+        while (entry) {
+            cache_entry_t* next = entry->next;
+            entry->in_cache = false;
+            entry_unref(entry);
+            entry = next;
+        }
+
+        // Reset buckets
+        memset(shard->buckets, 0, shard->bucket_count * sizeof(cache_entry_t*));
+
+        shard->head = NULL;
+        shard->tail = NULL;
+        shard->usage = 0;
+        shard->count = 0;
+        // Keep hit/miss stats
+        pthread_mutex_unlock(&shard->lock);
     }
+}
+
+// Look up a pinned block
+cache_entry_t* cache_lookup_block(block_cache_t* cache, uint64_t file_number,
+                                  uint64_t offset) {
+    if (!cache) return NULL;
+
+    char key[BLOCK_KEY_SIZE];
+    encode_block_key(key, file_number, offset);
+    uint32_t hash = hash_key(key, BLOCK_KEY_SIZE);
+    cache_shard_t* shard = shard_for(cache, hash);
+
+    pthread_mutex_lock(&shard->lock);
+    cache_entry_t* entry = shard_lookup(shard, key, BLOCK_KEY_SIZE, hash);
+    if (entry) entry->refs++;
+    pthread_mutex_unlock(&shard->lock);
 
-    // Reset buckets
-    memset(cache->buckets, 0, cache->bucket_count * sizeof(cache_entry_t*));
+    return entry;
+}
+
+// Insert a block and return it pinned
+cache_entry_t* cache_insert_block(block_cache_t* cache, uint64_t file_number,
+                                  uint64_t offset, uint8_t* data, size_t data_len) {
+    if (!cache || !data) return NULL;
 
-    cache->head = NULL;
-    cache->tail = NULL;
-    cache->usage = 0;
-    // Keep hit/miss stats
+    char key[BLOCK_KEY_SIZE];
+    encode_block_key(key, file_number, offset);
+    uint32_t hash = hash_key(key, BLOCK_KEY_SIZE);
+    cache_shard_t* shard = shard_for(cache, hash);
+
+    pthread_mutex_lock(&shard->lock);
+    cache_entry_t* entry = shard_insert(shard, key, BLOCK_KEY_SIZE, data, data_len, hash);
+    if (entry) entry->refs++;
+    pthread_mutex_unlock(&shard->lock);
+
+    return entry;
 }
 
-// Get hit rate
+// Release a pinned entry
+void cache_release(block_cache_t* cache, cache_entry_t* entry) {
+    if (!cache || !entry) return;
+
+    cache_shard_t* shard = shard_for(cache, entry->hash);
+    pthread_mutex_lock(&shard->lock);
+    entry_unref(entry);
+    pthread_mutex_unlock(&shard->lock);
+}
+
+// Get hit rate (aggregated over all shards)
 double cache_hit_rate(block_cache_t* cache) {
     if (!cache) return 0.0;
-    size_t total = cache->hits + cache->misses;
+    size_t hits = 0, misses = 0;
+    for (size_t i = 0; i < cache->num_shards; i++) {
+        size_t h, m;
+        cache_shard_stats(cache, i, &h, &m);
+        hits += h;
+        misses += m;
+    }
+    size_t total = hits + misses;
     if (total == 0) return 0.0;
-    return (double)cache->hits / (double)total;
+    return (double)hits / (double)total;
 }
 
 // Get current usage
 size_t cache_usage(block_cache_t* cache) {
-    return cache ? cache->usage : 0;
+    if (!cache) return 0;
+    size_t usage = 0;
+    for (size_t i = 0; i < cache->num_shards; i++) {
+        cache_shard_t* shard = &cache->shards[i];
+        pthread_mutex_lock(&shard->lock);
+        usage += shard->usage;
+        pthread_mutex_unlock(&shard->lock);
+    }
+    return usage;
 }
 
 // Get entry count
 size_t cache_count(block_cache_t* cache) {
     if (!cache) return 0;
     size_t count = 0;
-    cache_entry_t* entry = cache->head;
-    while (entry) {
-        count++;
-        entry = entry->next;
+    for (size_t i = 0; i < cache->num_shards; i++) {
+        cache_shard_t* shard = &cache->shards[i];
+        pthread_mutex_lock(&shard->lock);
+        count += shard->count;
+        pthread_mutex_unlock(&shard->lock);
     }
     return count;
 }
+
+// Get number of shards
+size_t cache_num_shards(block_cache_t* cache) {
+    return cache ? cache->num_shards : 0;
+}
+
+// Get hit/miss counters of one shard
+void cache_shard_stats(block_cache_t* cache, size_t shard,
+                       size_t* hits, size_t* misses) {
+    if (hits) *hits = 0;
+    if (misses) *misses = 0;
+    if (!cache || shard >= cache->num_shards) return;
+
+    cache_shard_t* s = &cache->shards[shard];
+    pthread_mutex_lock(&s->lock);
+    if (hits) *hits = s->hits;
+    if (misses) *misses = s->misses;
+    pthread_mutex_unlock(&s->lock);
+}
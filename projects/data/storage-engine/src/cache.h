@@ -4,8 +4,12 @@
 #include "types.h"
 #include <stdint.h>
 #include <stddef.h>
+#include <pthread.h>
 
 // Cache entry (internal)
+// An entry is reference counted: the cache holds one reference while the
+// entry is resident, and every pinned handle holds one more. The entry is
+// freed when the last reference is dropped.
 typedef struct cache_entry {
     char* key;
     size_t key_len;
@@ -15,25 +19,38 @@ typedef struct cache_entry {
     struct cache_entry* next;
     struct cache_entry* hash_next;  // Hash chain
     uint32_t hash;
+    uint32_t refs;
+    bool in_cache;
 } cache_entry_t;
 
-// LRU Block Cache
-struct block_cache {
+// One LRU shard, protected by its own mutex
+typedef struct {
+    pthread_mutex_t lock;
     cache_entry_t** buckets;
     size_t bucket_count;
     cache_entry_t* head;  // Most recently used
     cache_entry_t* tail;  // Least recently used
     size_t capacity;
     size_t usage;
+    size_t count;
     size_t hits;
     size_t misses;
+} cache_shard_t;
+
+// Sharded LRU Block Cache
+struct block_cache {
+    cache_shard_t* shards;
+    size_t num_shards;     // Always a power of two
+    size_t capacity;
 };
 
 // Create/destroy
+// cache_create picks the shard count from the capacity (see CACHE_MIN_SHARD_SIZE)
 block_cache_t* cache_create(size_t capacity);
+block_cache_t* cache_create_sharded(size_t capacity, int num_shard_bits);
 void cache_destroy(block_cache_t* cache);
 
-// Operations
+// Operations (data is copied in and out)
 uint8_t* cache_get(block_cache_t* cache, const char* key, size_t key_len,
                    size_t* data_len);
 void cache_put(block_cache_t* cache, const char* key, size_t key_len,
@@ -41,9 +58,22 @@ void cache_put(block_cache_t* cache, const char* key, size_t key_len,
 void cache_invalidate(block_cache_t* cache, const char* key, size_t key_len);
 void cache_clear(block_cache_t* cache);
 
+// Block operations, keyed by (file_number, block offset)
+// Returned entries are pinned and must be released with cache_release.
+cache_entry_t* cache_lookup_block(block_cache_t* cache, uint64_t file_number,
+                                  uint64_t offset);
+// Takes ownership of data (a malloc'd buffer) on success.
+// Returns NULL and leaves data with the caller if the block cannot be cached.
+cache_entry_t* cache_insert_block(block_cache_t* cache, uint64_t file_number,
+                                  uint64_t offset, uint8_t* data, size_t data_len);
+void cache_release(block_cache_t* cache, cache_entry_t* entry);
+
 // Statistics
 double cache_hit_rate(block_cache_t* cache);
 size_t cache_usage(block_cache_t* cache);
 size_t cache_count(block_cache_t* cache);
+size_t cache_num_shards(block_cache_t* cache);
+void cache_shard_stats(block_cache_t* cache, size_t shard,
+                       size_t* hits, size_t* misses);
 
 #endif // STORAGE_CACHE_H
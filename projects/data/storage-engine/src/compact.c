@@ -1,10 +1,13 @@
 #include "compact.h"
 #include "manifest.h"
+#include "iterator.h"
+#include "blob.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <pthread.h>
 
 // Helper: decode varint
 static size_t decode_varint(const uint8_t* buf, size_t len, uint64_t* value) {
@@ -20,32 +23,21 @@ static size_t decode_varint(const uint8_t* buf, size_t len, uint64_t* value) {
     return 0;
 }
 
-// Helper: read all bytes
-static ssize_t read_all(int fd, void* buf, size_t len) {
-    uint8_t* p = buf;
-    size_t remaining = len;
-    while (remaining > 0) {
-        ssize_t n = read(fd, p, remaining);
-        if (n <= 0) return n == 0 ? (ssize_t)(len - remaining) : -1;
-        p += n;
-        remaining -= n;
-    }
-    return (ssize_t)len;
-}
-
 // SSTable iterator structure
 struct sstable_iter {
     sstable_reader_t* reader;
     size_t current_block;
-    uint8_t* block_data;
+    sstable_block_t block;      // Current block (pinned in cache or owned)
+    const uint8_t* block_data;
     size_t block_size;
     size_t pos;
     size_t data_end;
-    char* current_key;
+    char* current_key;          // Reused across entries; grows as needed
     size_t current_key_len;
-    char* current_value;
+    size_t current_key_cap;
+    const char* current_value;  // Points into the current block
     size_t current_value_len;
-    bool current_deleted;
+    uint8_t current_type;       // SSTABLE_ENTRY_*
     bool valid;
 };
 
@@ -57,6 +49,7 @@ sstable_iter_t* sstable_iter_create(sstable_reader_t* reader) {
     if (!iter) return NULL;
 
     iter->reader = reader;
+    sstable_reader_ref(reader);
     iter->current_block = 0;
     iter->block_data = NULL;
     iter->valid = false;
@@ -67,9 +60,9 @@ sstable_iter_t* sstable_iter_create(sstable_reader_t* reader) {
 // Destroy SSTable iterator
 void sstable_iter_destroy(sstable_iter_t* iter) {
     if (!iter) return;
-    free(iter->block_data);
+    sstable_block_release(&iter->block);
+    sstable_reader_close(iter->reader);
     free(iter->current_key);
-    free(iter->current_value);
     free(iter);
 }
 
@@ -80,44 +73,28 @@ static bool load_block(sstable_iter_t* iter, size_t block_idx) {
         return false;
     }
 
-    sstable_index_entry_t* entry = &iter->reader->index[block_idx];
-
-    // Allocate/reallocate block buffer
-    if (iter->block_data == NULL || iter->block_size < entry->size) {
-        free(iter->block_data);
-        iter->block_data = malloc(entry->size);
-        if (!iter->block_data) {
-            iter->valid = false;
-            return false;
-        }
-    }
-    iter->block_size = entry->size;
-
-    // Read block from file
-    if (lseek(iter->reader->fd, entry->offset, SEEK_SET) < 0) {
-        iter->valid = false;
-        return false;
-    }
-    if (read_all(iter->reader->fd, iter->block_data, entry->size) != (ssize_t)entry->size) {
+    // Drop previous block, then fetch through the block cache
+    sstable_block_release(&iter->block);
+    iter->block_data = NULL;
+    iter->block_size = 0;
+    if (sstable_reader_read_block(iter->reader, block_idx, &iter->block) != STATUS_OK) {
         iter->valid = false;
         return false;
     }
+    iter->block_data = iter->block.data;
+    iter->block_size = iter->block.size;
 
     // Parse block trailer
-    if (entry->size < 8) {
+    sstable_block_layout_t layout;
+    if (sstable_block_layout(iter->block_data, iter->block_size, &layout) != STATUS_OK) {
         iter->valid = false;
         return false;
     }
-
-    uint32_t num_restarts;
-    memcpy(&num_restarts, iter->block_data + entry->size - 8, 4);
-    iter->data_end = entry->size - 8 - num_restarts * 4;
+    iter->data_end = layout.data_end;
     iter->pos = 0;
     iter->current_block = block_idx;
 
-    // Clear previous key for new block
-    free(iter->current_key);
-    iter->current_key = NULL;
+    // New block: keys start from scratch (buffer kept for reuse)
     iter->current_key_len = 0;
 
     return true;
@@ -145,36 +122,30 @@ static bool parse_next_entry(sstable_iter_t* iter) {
     iter->pos += n;
 
     if (iter->pos >= iter->data_end) return false;
-    iter->current_deleted = (iter->block_data[iter->pos++] != 0);
+    iter->current_type = iter->block_data[iter->pos++];
 
     if (iter->pos + unshared + val_len > iter->data_end) return false;
 
-    // Reconstruct full key
-    size_t full_key_len = shared + unshared;
-    char* new_key = malloc(full_key_len);
-    if (!new_key) return false;
+    if (shared > iter->current_key_len) return false;
 
-    if (shared > 0 && iter->current_key) {
-        memcpy(new_key, iter->current_key, shared);
+    // Reconstruct full key in place: the shared prefix is already there
+    size_t full_key_len = shared + unshared;
+    if (full_key_len > iter->current_key_cap) {
+        size_t new_cap = iter->current_key_cap * 2;
+        if (new_cap < full_key_len) new_cap = full_key_len;
+        if (new_cap < 64) new_cap = 64;
+        char* new_key = realloc(iter->current_key, new_cap);
+        if (!new_key) return false;
+        iter->current_key = new_key;
+        iter->current_key_cap = new_cap;
     }
-    memcpy(new_key + shared, iter->block_data + iter->pos, unshared);
-    iter->pos += unshared;
-
-    free(iter->current_key);
-    iter->current_key = new_key;
+    memcpy(iter->current_key + shared, iter->block_data + iter->pos, unshared);
     iter->current_key_len = full_key_len;
+    iter->pos += unshared;
 
-    // Copy value
-    free(iter->current_value);
-    if (val_len > 0) {
-        iter->current_value = malloc(val_len);
-        if (!iter->current_value) return false;
-        memcpy(iter->current_value, iter->block_data + iter->pos, val_len);
-        iter->current_value_len = val_len;
-    } else {
-        iter->current_value = NULL;
-        iter->current_value_len = 0;
-    }
+    // Value stays in the block, which the iterator keeps pinned
+    iter->current_value = val_len > 0 ? (const char*)(iter->block_data + iter->pos) : NULL;
+    iter->current_value_len = val_len;
     iter->pos += val_len;
 
     return true;
@@ -194,6 +165,27 @@ void sstable_iter_seek_to_first(sstable_iter_t* iter) {
     iter->valid = parse_next_entry(iter);
 }
 
+// Seek to first entry with key >= target
+void sstable_iter_seek(sstable_iter_t* iter, const char* key, size_t key_len) {
+    if (!iter) return;
+    sstable_reader_t* r = iter->reader;
+
+    // First block whose last_key >= key
+    size_t block_idx;
+    if (sstable_reader_seek_block(r, key, key_len, &block_idx) != STATUS_OK ||
+        !load_block(iter, block_idx)) {
+        iter->valid = false;
+        return;
+    }
+
+    // Linear scan within the block
+    iter->valid = parse_next_entry(iter);
+    while (iter->valid &&
+           r->cmp(iter->current_key, iter->current_key_len, key, key_len) < 0) {
+        sstable_iter_next(iter);
+    }
+}
+
 // Check if iterator is valid
 bool sstable_iter_valid(sstable_iter_t* iter) {
     return iter && iter->valid;
@@ -235,203 +227,552 @@ const char* sstable_iter_value(sstable_iter_t* iter, size_t* len) {
 
 // Check if current entry is deleted
 bool sstable_iter_is_deleted(sstable_iter_t* iter) {
-    return iter && iter->valid && iter->current_deleted;
+    return iter && iter->valid && iter->current_type == SSTABLE_ENTRY_DELETION;
+}
+
+// Check if current value is a blob reference
+bool sstable_iter_is_blob(sstable_iter_t* iter) {
+    return iter && iter->valid && iter->current_type == SSTABLE_ENTRY_BLOB;
 }
 
 // ============================================================
-// Merge Iterator (min-heap based)
+// Compaction
 // ============================================================
 
-typedef struct {
-    sstable_iter_t** iters;
-    size_t* heap;       // Indices into iters array
-    size_t heap_size;
-    size_t iter_count;
-    compare_fn cmp;
-} merge_iter_t;
-
-// Helper: compare two iterators by their current key
-static int merge_compare(merge_iter_t* mi, size_t a, size_t b) {
-    sstable_iter_t* iter_a = mi->iters[a];
-    sstable_iter_t* iter_b = mi->iters[b];
-
-    size_t key_a_len, key_b_len;
-    const char* key_a = sstable_iter_key(iter_a, &key_a_len);
-    const char* key_b = sstable_iter_key(iter_b, &key_b_len);
-
-    int cmp = mi->cmp(key_a, key_a_len, key_b, key_b_len);
-    if (cmp != 0) return cmp;
-
-    // Same key: prefer higher index (newer file in L0)
-    return (a < b) ? 1 : -1;
-}
-
-// Helper: sift down in min-heap
-static void heap_sift_down(merge_iter_t* mi, size_t idx) {
-    while (true) {
-        size_t smallest = idx;
-        size_t left = 2 * idx + 1;
-        size_t right = 2 * idx + 2;
+// Pick which level needs compaction: the one furthest over its limit
+int compact_pick_level(level_manager_t* lm) {
+    if (!lm) return -1;
 
-        if (left < mi->heap_size &&
-            merge_compare(mi, mi->heap[left], mi->heap[smallest]) < 0) {
-            smallest = left;
-        }
-        if (right < mi->heap_size &&
-            merge_compare(mi, mi->heap[right], mi->heap[smallest]) < 0) {
-            smallest = right;
+    int best = -1;
+    double best_score = 0.0;
+    for (int level = 0; level < MAX_LEVELS - 1; level++) {
+        if (!level_needs_compaction(lm, level)) continue;
+        double score = level_compaction_score(lm, level);
+        if (best < 0 || score > best_score) {
+            best = level;
+            best_score = score;
         }
+    }
 
-        if (smallest == idx) break;
+    return best;  // -1: no compaction needed
+}
 
-        size_t tmp = mi->heap[idx];
-        mi->heap[idx] = mi->heap[smallest];
-        mi->heap[smallest] = tmp;
-        idx = smallest;
+// Helper: get metadata for a file number
+static sstable_meta_t* find_meta(level_manager_t* lm, int level, uint64_t file_num) {
+    level_t* lvl = &lm->levels[level];
+    for (size_t i = 0; i < lvl->file_count; i++) {
+        if (lvl->files[i].file_number == file_num) {
+            return &lvl->files[i];
+        }
     }
+    return NULL;
 }
 
-// Create merge iterator
-static merge_iter_t* merge_iter_create(sstable_iter_t** iters, size_t count, compare_fn cmp) {
-    merge_iter_t* mi = calloc(1, sizeof(merge_iter_t));
-    if (!mi) return NULL;
+// One finished compaction output file
+typedef struct {
+    uint64_t file_number;
+    char path[512];
+    sstable_reader_t* reader;
+} compaction_output_t;
 
-    mi->iters = iters;
-    mi->iter_count = count;
-    mi->cmp = cmp;
-    mi->heap = malloc(count * sizeof(size_t));
-    if (!mi->heap) {
-        free(mi);
-        return NULL;
-    }
+// Blob bytes a compaction stopped referencing, per blob file
+typedef struct {
+    uint64_t file_number;
+    uint64_t bytes;
+} blob_garbage_t;
 
-    // Initialize heap with valid iterators
-    mi->heap_size = 0;
-    for (size_t i = 0; i < count; i++) {
-        if (sstable_iter_valid(iters[i])) {
-            mi->heap[mi->heap_size++] = i;
+typedef struct {
+    blob_garbage_t* items;
+    size_t count;
+    size_t capacity;
+} blob_garbage_list_t;
+
+// Helper: add bytes to a file's garbage (a compaction touches few blob files)
+static status_t garbage_add(blob_garbage_list_t* list, uint64_t file_number, uint64_t bytes) {
+    for (size_t i = 0; i < list->count; i++) {
+        if (list->items[i].file_number == file_number) {
+            list->items[i].bytes += bytes;
+            return STATUS_OK;
         }
     }
-
-    // Build min-heap
-    for (size_t i = mi->heap_size / 2; i > 0; i--) {
-        heap_sift_down(mi, i - 1);
+    if (list->count >= list->capacity) {
+        size_t new_cap = list->capacity ? list->capacity * 2 : 4;
+        blob_garbage_t* items = realloc(list->items, new_cap * sizeof(blob_garbage_t));
+        if (!items) return STATUS_NO_MEMORY;
+        list->items = items;
+        list->capacity = new_cap;
     }
-    if (mi->heap_size > 0) {
-        heap_sift_down(mi, 0);
+    list->items[list->count].file_number = file_number;
+    list->items[list->count].bytes = bytes;
+    list->count++;
+    return STATUS_OK;
+}
+
+// One key range [start, end) of a compaction, merged on its own thread into
+// its own output files
+typedef struct {
+    level_manager_t* lm;
+    sstable_reader_t** inputs;      // Newest first
+    size_t input_count;
+    const char* start;              // NULL: from the first key
+    size_t start_len;
+    const char* end;                // NULL: to the last key
+    size_t end_len;
+    bool drop_tombstones;
+    uint64_t target_file_size;      // Start a new output past this size
+    size_t estimated_entries;       // Per output file, for filter sizing
+    compaction_output_t* outputs;   // In key order
+    size_t output_count;
+    size_t output_capacity;
+    blob_writer_t* blob_writer;     // Values separated or relocated here
+    blob_garbage_list_t garbage;    // Blob records dropped or relocated
+    status_t garbage_status;        // First failure recording garbage
+    status_t status;
+} subcompaction_t;
+
+// Helper: start the next output file of a range
+static sstable_writer_t* open_output(subcompaction_t* sub) {
+    level_manager_t* lm = sub->lm;
+    if (sub->output_count >= sub->output_capacity) {
+        size_t new_cap = sub->output_capacity ? sub->output_capacity * 2 : 4;
+        compaction_output_t* outputs = realloc(sub->outputs,
+                                               new_cap * sizeof(compaction_output_t));
+        if (!outputs) return NULL;
+        sub->outputs = outputs;
+        sub->output_capacity = new_cap;
     }
 
-    return mi;
+    compaction_output_t* out = &sub->outputs[sub->output_count];
+    out->file_number = level_new_file_number(lm);
+    out->reader = NULL;
+    snprintf(out->path, sizeof(out->path), "%s/%06llu.sst",
+             lm->db_path, (unsigned long long)out->file_number);
+
+    sstable_writer_t* writer = sstable_writer_create(out->path, sub->estimated_entries, lm->cmp);
+    if (!writer) return NULL;
+    sstable_writer_set_compression(writer, lm->compression);
+    sstable_writer_set_prefix_extractor(writer, lm->prefix_extractor, lm->prefix_name);
+    sub->output_count++;
+    return writer;
 }
 
-// Destroy merge iterator
-static void merge_iter_destroy(merge_iter_t* mi) {
-    if (!mi) return;
-    free(mi->heap);
-    free(mi);
+// Helper: finish the current output file and open it for reading
+static status_t finish_output(subcompaction_t* sub, sstable_writer_t* writer) {
+    compaction_output_t* out = &sub->outputs[sub->output_count - 1];
+    status_t status = sstable_writer_finish(writer);
+    if (status != STATUS_OK) return status;
+    out->reader = level_open_sstable(sub->lm, out->path);
+    return out->reader ? STATUS_OK : STATUS_IO_ERROR;
 }
 
-// Check if merge iterator is valid
-static bool merge_iter_valid(merge_iter_t* mi) {
-    return mi && mi->heap_size > 0;
+// Helper: store a value in the range's blob file and add a reference to it
+static status_t add_blob_value(subcompaction_t* sub, sstable_writer_t* writer,
+                               const char* key, size_t key_len,
+                               const char* value, size_t value_len) {
+    if (!sub->blob_writer) {
+        sub->blob_writer = blob_writer_create(sub->lm->db_path,
+                                              level_new_file_number(sub->lm));
+        if (!sub->blob_writer) return STATUS_IO_ERROR;
+    }
+
+    blob_ref_t ref;
+    status_t status = blob_writer_add(sub->blob_writer, value, value_len, &ref);
+    if (status != STATUS_OK) return status;
+
+    char buf[BLOB_REF_MAX_SIZE];
+    size_t len = blob_ref_encode(&ref, buf);
+    return sstable_writer_add_blob(writer, key, key_len, buf, len);
 }
 
-// Get current entry from merge iterator
-static void merge_iter_current(merge_iter_t* mi,
-                               const char** key, size_t* key_len,
-                               const char** value, size_t* value_len,
-                               bool* deleted) {
-    if (!merge_iter_valid(mi)) return;
+// Helper: carry a blob reference over. References into files that are
+// mostly garbage are relocated, so those files can eventually be deleted.
+static status_t add_blob_ref(subcompaction_t* sub, sstable_writer_t* writer,
+                             const char* key, size_t key_len,
+                             const char* ref, size_t ref_len) {
+    blob_ref_t br;
+    if (!blob_ref_decode(ref, ref_len, &br)) return STATUS_CORRUPTION;
 
-    size_t top_idx = mi->heap[0];
-    sstable_iter_t* iter = mi->iters[top_idx];
+    if (level_blob_garbage_ratio(sub->lm, br.file_number) < BLOB_GC_RATIO) {
+        return sstable_writer_add_blob(writer, key, key_len, ref, ref_len);
+    }
 
-    *key = sstable_iter_key(iter, key_len);
-    *value = sstable_iter_value(iter, value_len);
-    *deleted = sstable_iter_is_deleted(iter);
+    char* value;
+    size_t value_len;
+    status_t status = level_read_blob(sub->lm, ref, ref_len, &value, &value_len);
+    if (status != STATUS_OK) return status;
+    status = add_blob_value(sub, writer, key, key_len, value, value_len);
+    free(value);
+    if (status != STATUS_OK) return status;
+    return garbage_add(&sub->garbage, br.file_number, br.size);
 }
 
-// Advance merge iterator (skip duplicates)
-static void merge_iter_next(merge_iter_t* mi) {
-    if (!merge_iter_valid(mi)) return;
+// Merge drop hook: a hidden blob version is garbage once the output is installed
+static void count_dropped(void* ctx, iterator_t* child) {
+    subcompaction_t* sub = ctx;
+    if (!iterator_is_blob(child)) return;
+
+    size_t ref_len;
+    const char* ref = iterator_value(child, &ref_len);
+    blob_ref_t br;
+    status_t status = STATUS_CORRUPTION;
+    if (blob_ref_decode(ref, ref_len, &br)) {
+        status = garbage_add(&sub->garbage, br.file_number, br.size);
+    }
+    if (status != STATUS_OK && sub->garbage_status == STATUS_OK) {
+        sub->garbage_status = status;
+    }
+}
 
-    // Get current key for duplicate detection
-    size_t top_idx = mi->heap[0];
-    sstable_iter_t* top_iter = mi->iters[top_idx];
-    size_t cur_key_len;
-    const char* cur_key = sstable_iter_key(top_iter, &cur_key_len);
+// Range tombstones carried into the outputs, sorted by begin key
+typedef struct {
+    range_del_list_t list;
+    size_t next;                // First one not written yet
+    const char* end;            // Largest end written to the current file
+    size_t end_len;
+} tombstone_carry_t;
+
+// Helper: sort tombstones by begin key (insertion sort: there are few)
+static void sort_tombstones(compare_fn cmp, range_del_list_t* list) {
+    for (size_t i = 1; i < list->count; i++) {
+        range_tombstone_t t = list->items[i];
+        size_t j = i;
+        while (j > 0 && cmp(t.begin, t.begin_len,
+                            list->items[j - 1].begin, list->items[j - 1].begin_len) < 0) {
+            list->items[j] = list->items[j - 1];
+            j--;
+        }
+        list->items[j] = t;
+    }
+}
 
-    // Save current key for comparison
-    char* saved_key = malloc(cur_key_len);
-    if (!saved_key) return;
-    memcpy(saved_key, cur_key, cur_key_len);
-    size_t saved_key_len = cur_key_len;
+// Helper: write the carried tombstones that begin before key (all of them
+// if key is NULL) to the current output file
+static status_t write_tombstones(compare_fn cmp, sstable_writer_t* writer,
+                                 tombstone_carry_t* carry,
+                                 const char* key, size_t key_len) {
+    while (carry->next < carry->list.count) {
+        const range_tombstone_t* t = &carry->list.items[carry->next];
+        if (key && cmp(t->begin, t->begin_len, key, key_len) >= 0) break;
+
+        status_t status = sstable_writer_add_range_tombstone(writer, t);
+        if (status != STATUS_OK) return status;
+        if (!carry->end || cmp(t->end, t->end_len, carry->end, carry->end_len) > 0) {
+            carry->end = t->end;
+            carry->end_len = t->end_len;
+        }
+        carry->next++;
+    }
+    return STATUS_OK;
+}
 
-    // Advance all iterators with the same key
-    while (mi->heap_size > 0) {
-        top_idx = mi->heap[0];
-        top_iter = mi->iters[top_idx];
+// Helper: merge one range. Output files are created on demand and cut at
+// the target size, so ranges with nothing to write leave no file behind.
+// Range tombstones are only supported in a range covering the whole key
+// space (compact_level doesn't split compactions that have them).
+static void run_subcompaction(subcompaction_t* sub) {
+    level_manager_t* lm = sub->lm;
 
-        size_t key_len;
-        const char* key = sstable_iter_key(top_iter, &key_len);
+    iterator_t** iters = calloc(sub->input_count > 0 ? sub->input_count : 1,
+                                sizeof(iterator_t*));
+    if (!iters) {
+        sub->status = STATUS_NO_MEMORY;
+        return;
+    }
 
-        if (mi->cmp(key, key_len, saved_key, saved_key_len) != 0) {
-            break;  // Different key, stop
+    // Each input is filtered by the range tombstones of the newer ones; the
+    // entries they hide are dropped like overwritten versions
+    tombstone_carry_t carry = {0};
+    status_t status = STATUS_OK;
+    size_t iter_count = 0;
+    for (size_t i = 0; i < sub->input_count && status == STATUS_OK; i++) {
+        iterator_t* it = iterator_from_sstable(sub->inputs[i]);
+        if (it && carry.list.count > 0) {
+            it = range_del_iter_create(it, &carry.list, lm->cmp, count_dropped, sub);
         }
+        // Merging a subset would drop the missing input's entries
+        if (!it) {
+            status = STATUS_NO_MEMORY;
+            break;
+        }
+        iters[iter_count++] = it;
+        status = range_del_list_append(&carry.list, sstable_reader_range_dels(sub->inputs[i]));
+    }
+    if (status != STATUS_OK) {
+        for (size_t i = 0; i < iter_count; i++) {
+            iterator_destroy(iters[i]);
+        }
+        free(iters);
+        range_del_list_free(&carry.list);
+        sub->status = status;
+        return;
+    }
 
-        // Advance this iterator
-        sstable_iter_next(top_iter);
+    // Create merge iterator (takes ownership of the children)
+    iterator_t* merge = merge_iter_create_with_drop(iters, iter_count, lm->cmp,
+                                                    count_dropped, sub);
+    free(iters);
+    if (!merge) {
+        range_del_list_free(&carry.list);
+        sub->status = STATUS_NO_MEMORY;
+        return;
+    }
+    if (sub->start) {
+        iterator_seek(merge, sub->start, sub->start_len);
+    } else {
+        iterator_seek_to_first(merge);
+    }
 
-        if (sstable_iter_valid(top_iter)) {
-            // Re-heapify
-            heap_sift_down(mi, 0);
-        } else {
-            // Remove from heap
-            mi->heap[0] = mi->heap[--mi->heap_size];
-            if (mi->heap_size > 0) {
-                heap_sift_down(mi, 0);
+    // Tombstones still cover older data below the output level
+    if (sub->drop_tombstones) {
+        carry.list.count = 0;
+    } else {
+        sort_tombstones(lm->cmp, &carry.list);
+    }
+
+    sstable_writer_t* writer = NULL;
+    while (iterator_valid(merge)) {
+        size_t key_len, value_len;
+        const char* key = iterator_key(merge, &key_len);
+        if (sub->end && lm->cmp(key, key_len, sub->end, sub->end_len) >= 0) {
+            break;
+        }
+        const char* value = iterator_value(merge, &value_len);
+        bool deleted = iterator_is_deleted(merge);
+
+        // Skip tombstones at bottommost level
+        if (!(deleted && sub->drop_tombstones)) {
+            // Merged keys are unique, so any entry may start a new file,
+            // unless a range tombstone of the current file reaches it
+            if (writer) {
+                status = write_tombstones(lm->cmp, writer, &carry, key, key_len);
+                if (status != STATUS_OK) break;
+            }
+            if (writer && sstable_writer_file_size(writer) >= sub->target_file_size &&
+                (!carry.end || lm->cmp(carry.end, carry.end_len, key, key_len) < 0)) {
+                status = finish_output(sub, writer);
+                writer = NULL;
+                carry.end = NULL;
+                if (status != STATUS_OK) break;
+            }
+            if (!writer) {
+                writer = open_output(sub);
+                if (!writer) {
+                    status = STATUS_IO_ERROR;
+                    break;
+                }
+                status = write_tombstones(lm->cmp, writer, &carry, key, key_len);
+                if (status != STATUS_OK) break;
             }
+            if (iterator_is_blob(merge)) {
+                status = add_blob_ref(sub, writer, key, key_len, value, value_len);
+            } else if (!deleted && lm->blob_min_size > 0 && lm->db_path &&
+                       value_len >= lm->blob_min_size) {
+                status = add_blob_value(sub, writer, key, key_len, value, value_len);
+            } else {
+                status = sstable_writer_add(writer, key, key_len, value, value_len, deleted);
+            }
+            if (status != STATUS_OK) break;
         }
+
+        iterator_next(merge);
+    }
+    iterator_destroy(merge);
+
+    // Tombstones past the last entry go to the last file
+    if (status == STATUS_OK && carry.next < carry.list.count) {
+        if (!writer) writer = open_output(sub);
+        status = writer ? write_tombstones(lm->cmp, writer, &carry, NULL, 0) : STATUS_IO_ERROR;
     }
+    range_del_list_free(&carry.list);
 
-    free(saved_key);
+    if (status == STATUS_OK && writer) {
+        status = finish_output(sub, writer);
+    } else {
+        sstable_writer_abort(writer);
+    }
+    if (status == STATUS_OK) status = sub->garbage_status;
+    sub->status = status;
 }
 
-// ============================================================
-// Compaction
-// ============================================================
+static void* subcompaction_main(void* arg) {
+    run_subcompaction(arg);
+    return NULL;
+}
 
-// Pick which level needs compaction
-int compact_pick_level(level_manager_t* lm) {
-    if (!lm) return -1;
+// Boundary key of an input: the last key of a data block or index partition
+typedef struct {
+    const char* key;
+    size_t len;
+} split_key_t;
+
+// Helper: merge sort with the manager's comparator (qsort has no context)
+static void sort_split_keys(compare_fn cmp, split_key_t* keys, split_key_t* tmp, size_t n) {
+    if (n < 2) return;
+    size_t mid = n / 2;
+    sort_split_keys(cmp, keys, tmp, mid);
+    sort_split_keys(cmp, keys + mid, tmp, n - mid);
+
+    size_t i = 0, j = mid, k = 0;
+    while (i < mid && j < n) {
+        if (cmp(keys[j].key, keys[j].len, keys[i].key, keys[i].len) < 0) {
+            tmp[k++] = keys[j++];
+        } else {
+            tmp[k++] = keys[i++];
+        }
+    }
+    while (i < mid) tmp[k++] = keys[i++];
+    while (j < n) tmp[k++] = keys[j++];
+    memcpy(keys, tmp, n * sizeof(split_key_t));
+}
+
+// Helper: choose up to max_ranges - 1 split keys from the inputs' index.
+// Every index key ends about one block of data, so evenly spaced keys in
+// sorted order give ranges of about the same size. Returns the number of
+// split keys; they point into the readers' indexes.
+static size_t pick_split_keys(level_manager_t* lm, sstable_reader_t** inputs,
+                              size_t input_count, size_t max_ranges,
+                              split_key_t** out) {
+    *out = NULL;
+
+    // Not worth a thread unless each range gets enough blocks
+    size_t total_blocks = 0;
+    size_t key_count = 0;
+    for (size_t i = 0; i < input_count; i++) {
+        total_blocks += inputs[i]->index_count;
+        key_count += inputs[i]->index ? inputs[i]->index_count : inputs[i]->part_count;
+    }
+    size_t ranges = total_blocks / SUBCOMPACTION_MIN_BLOCKS;
+    if (ranges > max_ranges) ranges = max_ranges;
+    if (ranges > key_count) ranges = key_count;
+    if (ranges < 2) return 0;
+
+    split_key_t* keys = malloc(key_count * sizeof(split_key_t));
+    split_key_t* tmp = malloc(key_count * sizeof(split_key_t));
+    if (!keys || !tmp) {
+        free(keys);
+        free(tmp);
+        return 0;
+    }
+    size_t n = 0;
+    for (size_t i = 0; i < input_count; i++) {
+        sstable_reader_t* r = inputs[i];
+        if (r->index) {
+            for (size_t b = 0; b < r->index_count; b++) {
+                keys[n].key = r->index[b].last_key;
+                keys[n++].len = r->index[b].last_key_len;
+            }
+        } else {
+            for (size_t p = 0; p < r->part_count; p++) {
+                keys[n].key = r->parts[p].last_key;
+                keys[n++].len = r->parts[p].last_key_len;
+            }
+        }
+    }
+    sort_split_keys(lm->cmp, keys, tmp, n);
+
+    // Evenly spaced, strictly increasing split keys (tmp is reused)
+    size_t count = 0;
+    for (size_t r = 1; r < ranges; r++) {
+        split_key_t* k = &keys[r * n / ranges];
+        if (count > 0 && lm->cmp(k->key, k->len, tmp[count - 1].key,
+                                 tmp[count - 1].len) <= 0) {
+            continue;
+        }
+        tmp[count++] = *k;
+    }
+    free(keys);
 
-    // Check L0 first (highest priority)
-    if (level_needs_compaction(lm, 0)) {
+    if (count == 0) {
+        free(tmp);
         return 0;
     }
+    *out = tmp;
+    return count;
+}
+
+// Helper: check that input files don't overlap each other (always true for
+// one file; L0 files from sequential writes often qualify too)
+static bool inputs_disjoint(level_manager_t* lm, int level,
+                            const uint64_t* files, size_t count) {
+    if (count <= 1) return true;
+
+    sstable_meta_t** metas = malloc(count * sizeof(sstable_meta_t*));
+    if (!metas) return false;
+    for (size_t i = 0; i < count; i++) {
+        metas[i] = find_meta(lm, level, files[i]);
+        if (!metas[i]) {
+            free(metas);
+            return false;
+        }
+    }
 
-    // Check other levels
-    for (int level = 1; level < MAX_LEVELS - 1; level++) {
-        if (level_needs_compaction(lm, level)) {
-            return level;
+    // Insertion sort by min_key (L0 holds a handful of files)
+    for (size_t i = 1; i < count; i++) {
+        sstable_meta_t* m = metas[i];
+        size_t j = i;
+        while (j > 0 && lm->cmp(metas[j - 1]->min_key, metas[j - 1]->min_key_len,
+                                m->min_key, m->min_key_len) > 0) {
+            metas[j] = metas[j - 1];
+            j--;
         }
+        metas[j] = m;
     }
 
-    return -1;  // No compaction needed
+    bool disjoint = true;
+    for (size_t i = 1; i < count && disjoint; i++) {
+        disjoint = lm->cmp(metas[i - 1]->max_key, metas[i - 1]->max_key_len,
+                           metas[i]->min_key, metas[i]->min_key_len) < 0;
+    }
+    free(metas);
+    return disjoint;
 }
 
-// Helper: get metadata for a file number
-static sstable_meta_t* find_meta(level_manager_t* lm, int level, uint64_t file_num) {
-    level_t* lvl = &lm->levels[level];
-    for (size_t i = 0; i < lvl->file_count; i++) {
-        if (lvl->files[i].file_number == file_num) {
-            return &lvl->files[i];
+// Helper: move input files to the next level with manifest edits only.
+// The adds and removes are one edit, so a file is never listed in both
+// levels after a crash.
+static status_t trivial_move(level_manager_t* lm, int level,
+                             const uint64_t* files, size_t count) {
+    status_t status = STATUS_OK;
+    if (lm->db_path) {
+        manifest_edit_t edit = {0};
+        for (size_t i = 0; i < count; i++) {
+            manifest_edit_add_file(&edit, level + 1, files[i]);
+            manifest_edit_remove_file(&edit, level, files[i]);
         }
+        status = manifest_log_edit(lm->db_path, &edit);
+        manifest_edit_free(&edit);
+        if (status != STATUS_OK) return status;
+    }
+
+    level_lock_exclusive(lm);
+    for (size_t i = 0; i < count && status == STATUS_OK; i++) {
+        status = level_move_sstable(lm, level, level + 1, files[i]);
+    }
+    level_unlock(lm);
+    return status;
+}
+
+// Blob file written by a compaction
+typedef struct {
+    uint64_t file_number;
+    uint64_t size;
+} compaction_blob_t;
+
+// Helper: forget and delete blob files of a failed compaction
+static void discard_blob_files(level_manager_t* lm, const compaction_blob_t* blobs,
+                               size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        char path[512];
+        blob_file_path(path, sizeof(path), lm->db_path, blobs[i].file_number);
+        level_remove_blob_file(lm, blobs[i].file_number);
+        unlink(path);
     }
-    return NULL;
 }
 
 // Compact a level
+// The inputs are split into key ranges that are merged in parallel (see
+// level_set_max_subcompactions), each into files of about
+// level_target_file_size; all outputs are installed in one step.
 status_t compact_level(level_manager_t* lm, int level) {
     if (!lm || level < 0 || level >= MAX_LEVELS - 1) {
         return STATUS_INVALID_ARG;
@@ -475,13 +816,13 @@ status_t compact_level(level_manager_t* lm, int level) {
             }
         }
     } else {
-        // L1+: pick first file
+        // L1+: one file, taken round-robin from the level's cursor
         input_count = 1;
         input_files = malloc(sizeof(uint64_t));
         if (!input_files) return STATUS_NO_MEMORY;
-        input_files[0] = src_level->files[0].file_number;
+        sstable_meta_t* meta = &src_level->files[level_pick_compaction_file(lm, level)];
+        input_files[0] = meta->file_number;
 
-        sstable_meta_t* meta = &src_level->files[0];
         min_key = meta->min_key;
         min_key_len = meta->min_key_len;
         max_key = meta->max_key;
@@ -495,175 +836,306 @@ status_t compact_level(level_manager_t* lm, int level) {
                                                   max_key, max_key_len,
                                                   &target_files);
 
-    // Create iterators for all input files
-    size_t total_iters = input_count + target_count;
-    sstable_iter_t** iters = calloc(total_iters, sizeof(sstable_iter_t*));
-    if (!iters) {
-        free(input_files);
-        free(target_files);
-        return STATUS_NO_MEMORY;
-    }
-
-    size_t iter_idx = 0;
-
-    // Add source level iterators
-    for (size_t i = 0; i < input_count; i++) {
-        sstable_meta_t* meta = find_meta(lm, level, input_files[i]);
-        if (meta && meta->reader) {
-            iters[iter_idx] = sstable_iter_create(meta->reader);
-            if (iters[iter_idx]) {
-                sstable_iter_seek_to_first(iters[iter_idx]);
-                iter_idx++;
-            }
-        }
-    }
-
-    // Add target level iterators
-    for (size_t i = 0; i < target_count; i++) {
-        sstable_meta_t* meta = find_meta(lm, target_level, target_files[i]);
-        if (meta && meta->reader) {
-            iters[iter_idx] = sstable_iter_create(meta->reader);
-            if (iters[iter_idx]) {
-                sstable_iter_seek_to_first(iters[iter_idx]);
-                iter_idx++;
+    // Nothing to merge with: move the inputs down instead of rewriting them
+    if (target_count == 0 && inputs_disjoint(lm, level, input_files, input_count)) {
+        if (level > 0) {
+            status_t status = level_set_compact_cursor(lm, level, max_key, max_key_len);
+            if (status != STATUS_OK) {
+                free(input_files);
+                return status;
             }
         }
+        status_t status = trivial_move(lm, level, input_files, input_count);
+        free(input_files);
+        return status;
     }
 
-    // Create merge iterator
-    merge_iter_t* merge = merge_iter_create(iters, iter_idx, lm->cmp);
-    if (!merge) {
-        for (size_t i = 0; i < iter_idx; i++) {
-            sstable_iter_destroy(iters[i]);
-        }
-        free(iters);
+    // Readers of all input files, newest first:
+    // L0 files newest to oldest, then the source file, then the target level
+    size_t total_inputs = input_count + target_count;
+    sstable_reader_t** readers = calloc(total_inputs, sizeof(sstable_reader_t*));
+    if (!readers) {
         free(input_files);
         free(target_files);
         return STATUS_NO_MEMORY;
     }
 
-    // Generate output file path
-    uint64_t output_file_num = level_next_file_number(lm);
-    char output_path[512];
-    snprintf(output_path, sizeof(output_path), "%s/%06llu.sst",
-             lm->db_path, (unsigned long long)output_file_num);
-
-    // Count entries for bloom filter sizing
+    size_t reader_count = 0;
     size_t estimated_entries = 0;
-    for (size_t i = 0; i < input_count; i++) {
-        sstable_meta_t* meta = find_meta(lm, level, input_files[i]);
-        if (meta && meta->reader) {
-            estimated_entries += sstable_reader_num_entries(meta->reader);
-        }
+    for (size_t i = input_count; i > 0; i--) {
+        sstable_meta_t* meta = find_meta(lm, level, input_files[i - 1]);
+        if (meta && meta->reader) readers[reader_count++] = meta->reader;
     }
     for (size_t i = 0; i < target_count; i++) {
         sstable_meta_t* meta = find_meta(lm, target_level, target_files[i]);
-        if (meta && meta->reader) {
-            estimated_entries += sstable_reader_num_entries(meta->reader);
-        }
+        if (meta && meta->reader) readers[reader_count++] = meta->reader;
+    }
+    uint64_t input_bytes = 0;
+    for (size_t i = 0; i < reader_count; i++) {
+        estimated_entries += sstable_reader_num_entries(readers[i]);
+        input_bytes += readers[i]->file_size;
     }
 
-    // Create output SSTable
-    sstable_writer_t* writer = sstable_writer_create(output_path, estimated_entries, lm->cmp);
-    if (!writer) {
-        merge_iter_destroy(merge);
-        for (size_t i = 0; i < iter_idx; i++) {
-            sstable_iter_destroy(iters[i]);
-        }
-        free(iters);
+    // Filters are sized for a full output file, not the whole compaction
+    uint64_t target_file_size = level_target_file_size(lm, target_level);
+    size_t entries_per_file = estimated_entries + 1;
+    if (estimated_entries > 0 && input_bytes / estimated_entries > 0) {
+        uint64_t per_file = target_file_size / (input_bytes / estimated_entries) + 1;
+        if (per_file < entries_per_file) entries_per_file = (size_t)per_file;
+    }
+
+    // Split the key space; one range per split key plus one
+    // Range tombstones would have to be cut at the range boundaries, so
+    // compactions that carry any run as a single range
+    bool has_range_dels = false;
+    for (size_t i = 0; i < reader_count; i++) {
+        if (sstable_reader_range_dels(readers[i])->count > 0) has_range_dels = true;
+    }
+    split_key_t* splits = NULL;
+    size_t split_count = 0;
+    if (lm->max_subcompactions > 1 && !has_range_dels) {
+        split_count = pick_split_keys(lm, readers, reader_count,
+                                      (size_t)lm->max_subcompactions, &splits);
+    }
+    size_t sub_count = split_count + 1;
+
+    subcompaction_t* subs = calloc(sub_count, sizeof(subcompaction_t));
+    pthread_t* threads = calloc(sub_count, sizeof(pthread_t));
+    bool* started = calloc(sub_count, sizeof(bool));
+    if (!subs || !threads || !started) {
+        free(subs);
+        free(threads);
+        free(started);
+        free(splits);
+        free(readers);
         free(input_files);
         free(target_files);
-        return STATUS_IO_ERROR;
+        return STATUS_NO_MEMORY;
     }
 
-    // Merge and write entries
     bool is_bottommost = (target_level == MAX_LEVELS - 1);
-    while (merge_iter_valid(merge)) {
-        const char* key;
-        const char* value;
-        size_t key_len, value_len;
-        bool deleted;
-
-        merge_iter_current(merge, &key, &key_len, &value, &value_len, &deleted);
+    for (size_t i = 0; i < sub_count; i++) {
+        subcompaction_t* sub = &subs[i];
+        sub->lm = lm;
+        sub->inputs = readers;
+        sub->input_count = reader_count;
+        if (i > 0) {
+            sub->start = splits[i - 1].key;
+            sub->start_len = splits[i - 1].len;
+        }
+        if (i < split_count) {
+            sub->end = splits[i].key;
+            sub->end_len = splits[i].len;
+        }
+        sub->drop_tombstones = is_bottommost;
+        sub->target_file_size = target_file_size;
+        sub->estimated_entries = entries_per_file;
+    }
 
-        // Skip tombstones at bottommost level
-        if (!(deleted && is_bottommost)) {
-            status_t status = sstable_writer_add(writer, key, key_len,
-                                                  value, value_len, deleted);
-            if (status != STATUS_OK) {
-                sstable_writer_abort(writer);
-                merge_iter_destroy(merge);
-                for (size_t i = 0; i < iter_idx; i++) {
-                    sstable_iter_destroy(iters[i]);
-                }
-                free(iters);
-                free(input_files);
-                free(target_files);
-                return status;
+    // The first range runs here; if a thread can't be started, its range
+    // runs here too
+    for (size_t i = 1; i < sub_count; i++) {
+        started[i] = pthread_create(&threads[i], NULL, subcompaction_main, &subs[i]) == 0;
+    }
+    run_subcompaction(&subs[0]);
+    for (size_t i = 1; i < sub_count; i++) {
+        if (started[i]) {
+            pthread_join(threads[i], NULL);
+        } else {
+            run_subcompaction(&subs[i]);
+        }
+    }
+    free(threads);
+    free(started);
+    free(splits);
+    free(readers);
+
+    // Gather the outputs in key order, the new blob files and the garbage
+    status_t status = STATUS_OK;
+    size_t output_count = 0;
+    size_t blob_capacity = 0;
+    for (size_t i = 0; i < sub_count; i++) {
+        if (subs[i].status != STATUS_OK && status == STATUS_OK) status = subs[i].status;
+        output_count += subs[i].output_count;
+        if (subs[i].blob_writer) blob_capacity++;
+    }
+    compaction_output_t* outputs = calloc(output_count > 0 ? output_count : 1,
+                                          sizeof(compaction_output_t));
+    compaction_blob_t* blobs = calloc(blob_capacity > 0 ? blob_capacity : 1,
+                                      sizeof(compaction_blob_t));
+    if ((!outputs || !blobs) && status == STATUS_OK) status = STATUS_NO_MEMORY;
+    blob_garbage_list_t garbage = {0};
+    size_t n = 0;
+    size_t blob_count = 0;
+    for (size_t i = 0; i < sub_count; i++) {
+        for (size_t j = 0; j < subs[i].output_count; j++) {
+            if (outputs) {
+                outputs[n++] = subs[i].outputs[j];
+            } else {
+                // No room to gather: clean up in place
+                sstable_reader_close(subs[i].outputs[j].reader);
+                unlink(subs[i].outputs[j].path);
+            }
+        }
+        free(subs[i].outputs);
+
+        blob_writer_t* bw = subs[i].blob_writer;
+        if (bw && status == STATUS_OK) {
+            compaction_blob_t* blob = &blobs[blob_count];
+            blob->file_number = bw->file_number;
+            blob->size = bw->offset;
+            status = blob_writer_finish(bw);
+            if (status == STATUS_OK) {
+                blob_count++;
+            } else {
+                discard_blob_files(lm, blob, 1);
             }
+        } else if (bw) {
+            blob_writer_abort(bw);
+        }
+
+        for (size_t j = 0; j < subs[i].garbage.count && status == STATUS_OK; j++) {
+            status = garbage_add(&garbage, subs[i].garbage.items[j].file_number,
+                                 subs[i].garbage.items[j].bytes);
         }
+        free(subs[i].garbage.items);
+    }
+    free(subs);
 
-        merge_iter_next(merge);
+    // New blob files must be readable before the outputs are installed
+    for (size_t i = 0; i < blob_count && status == STATUS_OK; i++) {
+        status = level_add_blob_file(lm, blobs[i].file_number, blobs[i].size);
     }
 
-    // Finish writing
-    status_t status = sstable_writer_finish(writer);
+    // A failed range discards the whole compaction
     if (status != STATUS_OK) {
-        merge_iter_destroy(merge);
-        for (size_t i = 0; i < iter_idx; i++) {
-            sstable_iter_destroy(iters[i]);
+        for (size_t i = 0; i < n; i++) {
+            sstable_reader_close(outputs[i].reader);
+            unlink(outputs[i].path);
         }
-        free(iters);
+        discard_blob_files(lm, blobs, blob_count);
+        free(blobs);
+        free(garbage.items);
+        free(outputs);
         free(input_files);
         free(target_files);
         return status;
     }
 
-    // Cleanup iterators
-    merge_iter_destroy(merge);
-    for (size_t i = 0; i < iter_idx; i++) {
-        sstable_iter_destroy(iters[i]);
+    // Log the edit as one record: a crash must not leave both the inputs and
+    // the outputs listed, or the next merge would count the duplicate blob
+    // references as garbage and could collect a live blob file.
+    if (lm->db_path) {
+        manifest_edit_t edit = {0};
+        for (size_t i = 0; i < blob_count; i++) {
+            manifest_edit_add_blob(&edit, blobs[i].file_number, blobs[i].size);
+        }
+        for (size_t i = 0; i < output_count; i++) {
+            manifest_edit_add_file(&edit, target_level, outputs[i].file_number);
+        }
+        for (size_t i = 0; i < input_count; i++) {
+            manifest_edit_remove_file(&edit, level, input_files[i]);
+        }
+        for (size_t i = 0; i < target_count; i++) {
+            manifest_edit_remove_file(&edit, target_level, target_files[i]);
+        }
+        for (size_t i = 0; i < garbage.count; i++) {
+            manifest_edit_blob_garbage(&edit, garbage.items[i].file_number,
+                                       garbage.items[i].bytes);
+        }
+        manifest_edit_next_file_num(&edit, level_next_file_number(lm));
+        status = manifest_log_edit(lm->db_path, &edit);
+        manifest_edit_free(&edit);
+    }
+    free(blobs);
+
+    // Collect the old paths; the files are unlinked once they are unreachable
+    size_t old_count = input_count + target_count;
+    char** old_paths = NULL;
+    if (status == STATUS_OK) {
+        old_paths = calloc(old_count > 0 ? old_count : 1, sizeof(char*));
+        if (!old_paths) status = STATUS_NO_MEMORY;
+    }
+    if (status != STATUS_OK) {
+        for (size_t i = 0; i < output_count; i++) {
+            sstable_reader_close(outputs[i].reader);
+        }
+        free(garbage.items);
+        free(outputs);
+        free(input_files);
+        free(target_files);
+        return status;
     }
-    free(iters);
 
-    // Remove old files from level manager
     for (size_t i = 0; i < input_count; i++) {
         sstable_meta_t* meta = find_meta(lm, level, input_files[i]);
-        if (meta) {
-            char* old_path = strdup(meta->path);
-            level_remove_sstable(lm, level, input_files[i]);
-            if (old_path) {
-                unlink(old_path);
-                free(old_path);
-            }
-        }
+        if (meta) old_paths[i] = strdup(meta->path);
     }
     for (size_t i = 0; i < target_count; i++) {
         sstable_meta_t* meta = find_meta(lm, target_level, target_files[i]);
-        if (meta) {
-            char* old_path = strdup(meta->path);
+        if (meta) old_paths[input_count + i] = strdup(meta->path);
+    }
+
+    // The next compaction out of this level starts after this file
+    if (level > 0) {
+        level_set_compact_cursor(lm, level, max_key, max_key_len);
+    }
+
+    // Install: add the outputs and remove the inputs in one step for readers
+    level_lock_exclusive(lm);
+    size_t added = 0;
+    for (; added < output_count; added++) {
+        status = level_add_sstable(lm, target_level, outputs[added].file_number,
+                                   outputs[added].path, outputs[added].reader);
+        if (status != STATUS_OK) break;
+    }
+    if (status == STATUS_OK) {
+        for (size_t i = 0; i < input_count; i++) {
+            level_remove_sstable(lm, level, input_files[i]);
+        }
+        for (size_t i = 0; i < target_count; i++) {
             level_remove_sstable(lm, target_level, target_files[i]);
-            if (old_path) {
-                unlink(old_path);
-                free(old_path);
-            }
+        }
+    } else {
+        // Back out the outputs added so far (this closes their readers)
+        for (size_t i = 0; i < added; i++) {
+            level_remove_sstable(lm, target_level, outputs[i].file_number);
         }
     }
+    level_unlock(lm);
 
-    free(input_files);
-    free(target_files);
+    if (status != STATUS_OK) {
+        for (size_t i = added; i < output_count; i++) {
+            sstable_reader_close(outputs[i].reader);
+        }
+    }
 
-    // Add new file to target level
-    sstable_reader_t* new_reader = sstable_reader_open(output_path, lm->cmp);
-    if (!new_reader) {
-        return STATUS_IO_ERROR;
+    for (size_t i = 0; i < old_count; i++) {
+        if (old_paths[i]) {
+            if (status == STATUS_OK) unlink(old_paths[i]);
+            free(old_paths[i]);
+        }
     }
+    free(old_paths);
+    free(outputs);
+    free(input_files);
+    free(target_files);
 
-    status = level_add_sstable(lm, target_level, output_file_num, output_path, new_reader);
-    if (status != STATUS_OK) {
-        sstable_reader_close(new_reader);
-        return status;
+    // Count the blob garbage; files without a live record left are deleted.
+    // Iterators created before this compaction pin them, so the last of
+    // those closes the descriptor.
+    for (size_t i = 0; i < garbage.count && status == STATUS_OK; i++) {
+        uint64_t file_number = garbage.items[i].file_number;
+        if (!level_add_blob_garbage(lm, file_number, garbage.items[i].bytes)) continue;
+        status = manifest_log_remove_blob(lm->db_path, file_number);
+        if (status == STATUS_OK) {
+            char path[512];
+            blob_file_path(path, sizeof(path), lm->db_path, file_number);
+            level_set_blob_obsolete(lm, file_number);
+            unlink(path);
+        }
     }
+    free(garbage.items);
 
-    return STATUS_OK;
+    return status;
 }
@@ -12,11 +12,16 @@ typedef struct sstable_iter sstable_iter_t;
 sstable_iter_t* sstable_iter_create(sstable_reader_t* reader);
 void sstable_iter_destroy(sstable_iter_t* iter);
 void sstable_iter_seek_to_first(sstable_iter_t* iter);
+void sstable_iter_seek(sstable_iter_t* iter, const char* key, size_t key_len);
 bool sstable_iter_valid(sstable_iter_t* iter);
 void sstable_iter_next(sstable_iter_t* iter);
+// Key and value point into iterator-owned memory and stay valid until the
+// iterator moves
 const char* sstable_iter_key(sstable_iter_t* iter, size_t* len);
 const char* sstable_iter_value(sstable_iter_t* iter, size_t* len);
 bool sstable_iter_is_deleted(sstable_iter_t* iter);
+// The value is an encoded blob reference (blob.h), not the value itself
+bool sstable_iter_is_blob(sstable_iter_t* iter);
 
 // Compaction API
 status_t compact_level(level_manager_t* lm, int level);
@@ -0,0 +1,22 @@
+#include "cpu.h"
+
+#define CPU_PROBED  0x80000000u
+
+unsigned cpu_features(void) {
+    // CPUID gives every caller the same bits, so threads racing on the
+    // first call store the same value and relaxed atomics are enough
+    static unsigned features = 0;
+
+    unsigned bits = __atomic_load_n(&features, __ATOMIC_RELAXED);
+    if (bits & CPU_PROBED) return bits & ~CPU_PROBED;
+
+    bits = CPU_PROBED;
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) bits |= CPU_SSE2;
+    if (__builtin_cpu_supports("sse4.2")) bits |= CPU_SSE42;
+    if (__builtin_cpu_supports("avx2")) bits |= CPU_AVX2;
+#endif
+    __atomic_store_n(&features, bits, __ATOMIC_RELAXED);
+    return bits & ~CPU_PROBED;
+}
@@ -0,0 +1,12 @@
+#ifndef STORAGE_CPU_H
+#define STORAGE_CPU_H
+
+// Instruction set extensions the hand-written kernels can use
+#define CPU_SSE2    0x1
+#define CPU_SSE42   0x2
+#define CPU_AVX2    0x4
+
+// CPU_* bits of the running CPU (none off x86), probed on the first call
+unsigned cpu_features(void);
+
+#endif // STORAGE_CPU_H
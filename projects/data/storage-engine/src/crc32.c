@@ -1,39 +1,127 @@
 #include "crc32.h"
+#include "cpu.h"
+#include <pthread.h>
+#include <string.h>
 
-// CRC32 lookup table (polynomial 0xEDB88320)
-static uint32_t crc32_table[256];
-static int table_initialized = 0;
-
-static void init_crc32_table(void) {
-    if (table_initialized) return;
+// Slicing-by-8 tables: table[0] is the classic byte table, table[k] advances
+// a byte through k more zero bytes, so 8 input bytes take 8 lookups
+static uint32_t crc32_tables[8][256];     // Polynomial 0xEDB88320
+static uint32_t crc32c_tables[8][256];    // Polynomial 0x82F63B78
+static pthread_once_t tables_once = PTHREAD_ONCE_INIT;
 
+// Helper: fill one set of slicing tables for a reflected polynomial
+static void init_slicing_tables(uint32_t tables[8][256], uint32_t poly) {
     for (uint32_t i = 0; i < 256; i++) {
         uint32_t crc = i;
         for (int j = 0; j < 8; j++) {
             if (crc & 1) {
-                crc = (crc >> 1) ^ 0xEDB88320;
+                crc = (crc >> 1) ^ poly;
             } else {
                 crc = crc >> 1;
             }
         }
-        crc32_table[i] = crc;
+        tables[0][i] = crc;
+    }
+    for (uint32_t i = 0; i < 256; i++) {
+        for (int k = 1; k < 8; k++) {
+            uint32_t prev = tables[k - 1][i];
+            tables[k][i] = (prev >> 8) ^ tables[0][prev & 0xFF];
+        }
     }
-    table_initialized = 1;
+}
+
+static void init_tables(void) {
+    init_slicing_tables(crc32_tables, 0xEDB88320);
+    init_slicing_tables(crc32c_tables, 0x82F63B78);
+}
+
+// Helper: slicing-by-8 over a pre-inverted crc
+static uint32_t slice8(uint32_t tables[8][256], uint32_t crc,
+                       const uint8_t* buf, size_t len) {
+    pthread_once(&tables_once, init_tables);
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    while (len >= 8) {
+        uint32_t lo, hi;
+        memcpy(&lo, buf, 4);
+        memcpy(&hi, buf + 4, 4);
+        lo ^= crc;
+        crc = tables[7][lo & 0xFF] ^ tables[6][(lo >> 8) & 0xFF] ^
+              tables[5][(lo >> 16) & 0xFF] ^ tables[4][lo >> 24] ^
+              tables[3][hi & 0xFF] ^ tables[2][(hi >> 8) & 0xFF] ^
+              tables[1][(hi >> 16) & 0xFF] ^ tables[0][hi >> 24];
+        buf += 8;
+        len -= 8;
+    }
+#endif
+    while (len-- > 0) {
+        crc = tables[0][(crc ^ *buf++) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
 }
 
 uint32_t crc32_update(uint32_t crc, const void* data, size_t len) {
-    init_crc32_table();
+    return ~slice8(crc32_tables, ~crc, (const uint8_t*)data, len);
+}
+
+uint32_t crc32(const void* data, size_t len) {
+    return crc32_update(0, data, len);
+}
+
+uint32_t crc32c_update_portable(uint32_t crc, const void* data, size_t len) {
+    return ~slice8(crc32c_tables, ~crc, (const uint8_t*)data, len);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <nmmintrin.h>
 
+// SSE4.2: the crc32 instruction computes CRC32C, 8 bytes per step on x86-64
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_update_sse42(uint32_t crc, const void* data, size_t len) {
     const uint8_t* buf = (const uint8_t*)data;
     crc = ~crc;
+#if defined(__x86_64__)
+    uint64_t crc64 = crc;
+    while (len >= 8) {
+        uint64_t v;
+        memcpy(&v, buf, 8);
+        crc64 = _mm_crc32_u64(crc64, v);
+        buf += 8;
+        len -= 8;
+    }
+    crc = (uint32_t)crc64;
+#endif
+    while (len-- > 0) {
+        crc = _mm_crc32_u8(crc, *buf++);
+    }
+    return ~crc;
+}
+#endif
 
-    for (size_t i = 0; i < len; i++) {
-        crc = crc32_table[(crc ^ buf[i]) & 0xFF] ^ (crc >> 8);
+typedef uint32_t (*crc32c_fn)(uint32_t crc, const void* data, size_t len);
+
+// Helper: the CRC32C implementation for this CPU, and its name
+static crc32c_fn crc32c_pick(const char** name) {
+#if defined(__x86_64__) || defined(__i386__)
+    if (cpu_features() & CPU_SSE42) {
+        if (name) *name = "sse4.2";
+        return crc32c_update_sse42;
     }
+#endif
+    if (name) *name = "slicing-by-8";
+    return crc32c_update_portable;
+}
 
-    return ~crc;
+uint32_t crc32c_update(uint32_t crc, const void* data, size_t len) {
+    return crc32c_pick(NULL)(crc, data, len);
 }
 
-uint32_t crc32(const void* data, size_t len) {
-    return crc32_update(0, data, len);
+uint32_t crc32c(const void* data, size_t len) {
+    return crc32c_update(0, data, len);
+}
+
+const char* crc32c_impl(void) {
+    const char* name;
+    crc32c_pick(&name);
+    return name;
 }
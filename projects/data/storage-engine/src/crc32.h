@@ -4,10 +4,21 @@
 #include <stdint.h>
 #include <stddef.h>
 
-// Calculate CRC32 checksum for data
+// CRC-32 (IEEE, polynomial 0xEDB88320): the original checksum, kept for
+// reading files written before CRC32C
 uint32_t crc32(const void* data, size_t len);
 
 // Update CRC32 incrementally (for streaming data)
 uint32_t crc32_update(uint32_t crc, const void* data, size_t len);
 
+// CRC-32C (Castagnoli, polynomial 0x82F63B78), used for new WAL records and
+// SSTables. Runs on the SSE4.2 crc32 instruction when the CPU has it,
+// slicing-by-8 tables otherwise.
+uint32_t crc32c(const void* data, size_t len);
+uint32_t crc32c_update(uint32_t crc, const void* data, size_t len);
+// Portable slicing-by-8 version; the SSE4.2 path must agree with it
+uint32_t crc32c_update_portable(uint32_t crc, const void* data, size_t len);
+// Implementation picked at runtime: "sse4.2" or "slicing-by-8"
+const char* crc32c_impl(void);
+
 #endif // CRC32_H
@@ -0,0 +1,684 @@
+#include "iterator.h"
+#include "compact.h"
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================
+// Generic iterator
+// ============================================================
+
+iterator_t* iterator_create(const iterator_ops_t* ops, void* state) {
+    if (!ops || !state) return NULL;
+
+    iterator_t* it = malloc(sizeof(iterator_t));
+    if (!it) return NULL;
+
+    it->ops = ops;
+    it->state = state;
+    return it;
+}
+
+void iterator_destroy(iterator_t* it) {
+    if (!it) return;
+    it->ops->destroy(it->state);
+    free(it);
+}
+
+bool iterator_valid(iterator_t* it) {
+    return it && it->ops->valid(it->state);
+}
+
+void iterator_seek_to_first(iterator_t* it) {
+    if (it) it->ops->seek_to_first(it->state);
+}
+
+void iterator_seek(iterator_t* it, const char* key, size_t key_len) {
+    if (it) it->ops->seek(it->state, key, key_len);
+}
+
+void iterator_next(iterator_t* it) {
+    if (it) it->ops->next(it->state);
+}
+
+const char* iterator_key(iterator_t* it, size_t* len) {
+    return it ? it->ops->key(it->state, len) : NULL;
+}
+
+const char* iterator_value(iterator_t* it, size_t* len) {
+    return it ? it->ops->value(it->state, len) : NULL;
+}
+
+bool iterator_is_deleted(iterator_t* it) {
+    return it && it->ops->is_deleted(it->state);
+}
+
+bool iterator_is_blob(iterator_t* it) {
+    return it && it->ops->is_blob(it->state);
+}
+
+// ============================================================
+// MemTable adapter
+// ============================================================
+
+// Holds a memtable reference so a flush can't free it under the iterator
+typedef struct {
+    memtable_t* mt;
+    memtable_iter_t* it;
+} mt_iter_t;
+
+static bool mt_valid(void* s) { return memtable_iter_valid(((mt_iter_t*)s)->it); }
+static void mt_seek_to_first(void* s) { memtable_iter_seek_to_first(((mt_iter_t*)s)->it); }
+static void mt_seek(void* s, const char* key, size_t key_len) {
+    memtable_iter_seek(((mt_iter_t*)s)->it, key, key_len);
+}
+static void mt_next(void* s) { memtable_iter_next(((mt_iter_t*)s)->it); }
+static const char* mt_key(void* s, size_t* len) {
+    return memtable_iter_key(((mt_iter_t*)s)->it, len);
+}
+static const char* mt_value(void* s, size_t* len) {
+    return memtable_iter_value(((mt_iter_t*)s)->it, len);
+}
+static bool mt_is_deleted(void* s) { return memtable_iter_is_deleted(((mt_iter_t*)s)->it); }
+static bool mt_is_blob(void* s) { (void)s; return false; }
+static void mt_destroy(void* s) {
+    mt_iter_t* mi = s;
+    memtable_iter_destroy(mi->it);
+    memtable_unref(mi->mt);
+    free(mi);
+}
+
+static const iterator_ops_t memtable_ops = {
+    mt_valid, mt_seek_to_first, mt_seek, mt_next,
+    mt_key, mt_value, mt_is_deleted, mt_is_blob, mt_destroy,
+};
+
+iterator_t* iterator_from_memtable(memtable_t* mt) {
+    if (!mt) return NULL;
+
+    mt_iter_t* mi = malloc(sizeof(mt_iter_t));
+    if (!mi) return NULL;
+
+    mi->it = memtable_iter_create(mt);
+    if (!mi->it) {
+        free(mi);
+        return NULL;
+    }
+    mi->mt = mt;
+    memtable_ref(mt);
+
+    iterator_t* it = iterator_create(&memtable_ops, mi);
+    if (!it) mt_destroy(mi);
+    return it;
+}
+
+// ============================================================
+// SSTable adapter
+// ============================================================
+
+static bool sst_valid(void* s) { return sstable_iter_valid(s); }
+static void sst_seek_to_first(void* s) { sstable_iter_seek_to_first(s); }
+static void sst_seek(void* s, const char* key, size_t key_len) {
+    sstable_iter_seek(s, key, key_len);
+}
+static void sst_next(void* s) { sstable_iter_next(s); }
+static const char* sst_key(void* s, size_t* len) { return sstable_iter_key(s, len); }
+static const char* sst_value(void* s, size_t* len) { return sstable_iter_value(s, len); }
+static bool sst_is_deleted(void* s) { return sstable_iter_is_deleted(s); }
+static bool sst_is_blob(void* s) { return sstable_iter_is_blob(s); }
+static void sst_destroy(void* s) { sstable_iter_destroy(s); }
+
+static const iterator_ops_t sstable_ops = {
+    sst_valid, sst_seek_to_first, sst_seek, sst_next,
+    sst_key, sst_value, sst_is_deleted, sst_is_blob, sst_destroy,
+};
+
+iterator_t* iterator_from_sstable(sstable_reader_t* reader) {
+    sstable_iter_t* si = sstable_iter_create(reader);
+    if (!si) return NULL;
+
+    iterator_t* it = iterator_create(&sstable_ops, si);
+    if (!it) sstable_iter_destroy(si);
+    return it;
+}
+
+// Prefix-seek table: a seek the prefix filter rules out leaves it exhausted
+typedef struct {
+    sstable_iter_t* it;
+    sstable_reader_t* reader;   // Referenced by it
+    bool skipped;
+} sst_prefix_iter_t;
+
+static bool sstp_valid(void* s) {
+    sst_prefix_iter_t* pi = s;
+    return !pi->skipped && sstable_iter_valid(pi->it);
+}
+static void sstp_seek_to_first(void* s) {
+    sst_prefix_iter_t* pi = s;
+    pi->skipped = false;
+    sstable_iter_seek_to_first(pi->it);
+}
+static void sstp_seek(void* s, const char* key, size_t key_len) {
+    sst_prefix_iter_t* pi = s;
+    pi->skipped = !sstable_reader_prefix_may_match(pi->reader, key, key_len);
+    if (!pi->skipped) sstable_iter_seek(pi->it, key, key_len);
+}
+static void sstp_next(void* s) {
+    sst_prefix_iter_t* pi = s;
+    if (!pi->skipped) sstable_iter_next(pi->it);
+}
+static const char* sstp_key(void* s, size_t* len) {
+    return sstable_iter_key(((sst_prefix_iter_t*)s)->it, len);
+}
+static const char* sstp_value(void* s, size_t* len) {
+    return sstable_iter_value(((sst_prefix_iter_t*)s)->it, len);
+}
+static bool sstp_is_deleted(void* s) { return sstable_iter_is_deleted(((sst_prefix_iter_t*)s)->it); }
+static bool sstp_is_blob(void* s) { return sstable_iter_is_blob(((sst_prefix_iter_t*)s)->it); }
+static void sstp_destroy(void* s) {
+    sst_prefix_iter_t* pi = s;
+    sstable_iter_destroy(pi->it);
+    free(pi);
+}
+
+static const iterator_ops_t sstable_prefix_ops = {
+    sstp_valid, sstp_seek_to_first, sstp_seek, sstp_next,
+    sstp_key, sstp_value, sstp_is_deleted, sstp_is_blob, sstp_destroy,
+};
+
+iterator_t* iterator_from_sstable_prefix(sstable_reader_t* reader) {
+    sst_prefix_iter_t* pi = calloc(1, sizeof(sst_prefix_iter_t));
+    if (!pi) return NULL;
+    pi->it = sstable_iter_create(reader);
+    if (!pi->it) {
+        free(pi);
+        return NULL;
+    }
+    pi->reader = reader;
+
+    iterator_t* it = iterator_create(&sstable_prefix_ops, pi);
+    if (!it) sstp_destroy(pi);
+    return it;
+}
+
+// ============================================================
+// Level concatenating iterator
+// ============================================================
+
+// Iterates a snapshot of the level's readers, so compactions that
+// replace files afterwards don't affect an open iterator
+typedef struct {
+    compare_fn cmp;
+    sstable_reader_t** files;   // Referenced readers, sorted by key range
+    size_t file_count;
+    size_t file_idx;
+    sstable_iter_t* cur;        // Iterator over files[file_idx], NULL if exhausted
+    bool prefix_seek;           // Seeks skip files the prefix filter rules out
+} level_iter_t;
+
+// Helper: open file_idx (or close everything if past the end)
+static void level_iter_open(level_iter_t* li, size_t file_idx) {
+    sstable_iter_destroy(li->cur);
+    li->cur = NULL;
+    li->file_idx = file_idx;
+
+    if (file_idx < li->file_count) {
+        li->cur = sstable_iter_create(li->files[file_idx]);
+    }
+}
+
+// Helper: move forward past exhausted files
+static void level_iter_skip_empty(level_iter_t* li) {
+    while (li->cur && !sstable_iter_valid(li->cur)) {
+        level_iter_open(li, li->file_idx + 1);
+        if (li->cur) sstable_iter_seek_to_first(li->cur);
+    }
+}
+
+static bool lvl_valid(void* s) {
+    level_iter_t* li = s;
+    return li->cur && sstable_iter_valid(li->cur);
+}
+
+static void lvl_seek_to_first(void* s) {
+    level_iter_t* li = s;
+    level_iter_open(li, 0);
+    if (li->cur) sstable_iter_seek_to_first(li->cur);
+    level_iter_skip_empty(li);
+}
+
+// Helper: check if the table's last key has the prefix of key (the table
+// has prefix filters)
+static bool ends_in_prefix(sstable_reader_t* r, const char* key, size_t key_len) {
+    size_t prefix_len = r->prefix_extractor(key, key_len);
+    if (prefix_len > key_len) prefix_len = key_len;
+    size_t max_len;
+    const char* max_key = sstable_reader_max_key(r, &max_len);
+    return max_len >= prefix_len && r->prefix_extractor(max_key, max_len) == prefix_len &&
+           memcmp(max_key, key, prefix_len) == 0;
+}
+
+static void lvl_seek(void* s, const char* key, size_t key_len) {
+    level_iter_t* li = s;
+
+    // Binary search for the first file whose max_key >= key
+    size_t left = 0, right = li->file_count;
+    while (left < right) {
+        size_t mid = left + (right - left) / 2;
+        size_t max_len;
+        const char* max_key = sstable_reader_max_key(li->files[mid], &max_len);
+        if (li->cmp(max_key, max_len, key, key_len) < 0) {
+            left = mid + 1;
+        } else {
+            right = mid;
+        }
+    }
+
+    // Prefix seek: the prefix's keys may continue into the next file only
+    // if this one ends inside the prefix
+    while (li->prefix_seek && left < li->file_count &&
+           !sstable_reader_prefix_may_match(li->files[left], key, key_len)) {
+        left = ends_in_prefix(li->files[left], key, key_len) ? left + 1 : li->file_count;
+    }
+
+    level_iter_open(li, left);
+    if (li->cur) sstable_iter_seek(li->cur, key, key_len);
+    level_iter_skip_empty(li);
+}
+
+static void lvl_next(void* s) {
+    level_iter_t* li = s;
+    if (!li->cur) return;
+    sstable_iter_next(li->cur);
+    level_iter_skip_empty(li);
+}
+
+static const char* lvl_key(void* s, size_t* len) {
+    level_iter_t* li = s;
+    return sstable_iter_key(li->cur, len);
+}
+
+static const char* lvl_value(void* s, size_t* len) {
+    level_iter_t* li = s;
+    return sstable_iter_value(li->cur, len);
+}
+
+static bool lvl_is_deleted(void* s) {
+    level_iter_t* li = s;
+    return sstable_iter_is_deleted(li->cur);
+}
+
+static bool lvl_is_blob(void* s) {
+    level_iter_t* li = s;
+    return sstable_iter_is_blob(li->cur);
+}
+
+static void lvl_destroy(void* s) {
+    level_iter_t* li = s;
+    sstable_iter_destroy(li->cur);
+    for (size_t i = 0; i < li->file_count; i++) {
+        sstable_reader_close(li->files[i]);
+    }
+    free(li->files);
+    free(li);
+}
+
+static const iterator_ops_t level_ops = {
+    lvl_valid, lvl_seek_to_first, lvl_seek, lvl_next,
+    lvl_key, lvl_value, lvl_is_deleted, lvl_is_blob, lvl_destroy,
+};
+
+// Helper: create a level iterator
+static iterator_t* level_iter_new(level_manager_t* lm, int level, bool prefix_seek) {
+    if (!lm || level < 1 || level >= MAX_LEVELS) return NULL;
+
+    level_iter_t* li = calloc(1, sizeof(level_iter_t));
+    if (!li) return NULL;
+
+    level_t* lvl = &lm->levels[level];
+    li->cmp = lm->cmp;
+    li->files = malloc((lvl->file_count > 0 ? lvl->file_count : 1) * sizeof(sstable_reader_t*));
+    if (!li->files) {
+        free(li);
+        return NULL;
+    }
+    for (size_t i = 0; i < lvl->file_count; i++) {
+        li->files[i] = lvl->files[i].reader;
+        sstable_reader_ref(li->files[i]);
+    }
+    li->file_count = lvl->file_count;
+    li->prefix_seek = prefix_seek;
+
+    iterator_t* it = iterator_create(&level_ops, li);
+    if (!it) lvl_destroy(li);
+    return it;
+}
+
+iterator_t* iterator_from_level(level_manager_t* lm, int level) {
+    return level_iter_new(lm, level, false);
+}
+
+iterator_t* iterator_from_level_prefix(level_manager_t* lm, int level) {
+    return level_iter_new(lm, level, true);
+}
+
+// ============================================================
+// Merge Iterator (min-heap based)
+// ============================================================
+
+typedef struct {
+    iterator_t** children;
+    size_t* heap;       // Indices into children array
+    size_t heap_size;
+    size_t child_count;
+    compare_fn cmp;
+    char* saved_key;    // Scratch buffer for duplicate skipping
+    size_t saved_cap;
+    merge_drop_fn drop; // Optional: told about each hidden duplicate
+    void* drop_ctx;
+} merge_iter_t;
+
+// Helper: compare two children by their current key
+static int merge_compare(merge_iter_t* mi, size_t a, size_t b) {
+    size_t key_a_len, key_b_len;
+    const char* key_a = iterator_key(mi->children[a], &key_a_len);
+    const char* key_b = iterator_key(mi->children[b], &key_b_len);
+
+    int cmp = mi->cmp(key_a, key_a_len, key_b, key_b_len);
+    if (cmp != 0) return cmp;
+
+    // Same key: prefer lower index (newer source)
+    return (a < b) ? -1 : 1;
+}
+
+// Helper: sift down in min-heap
+static void heap_sift_down(merge_iter_t* mi, size_t idx) {
+    while (true) {
+        size_t smallest = idx;
+        size_t left = 2 * idx + 1;
+        size_t right = 2 * idx + 2;
+
+        if (left < mi->heap_size &&
+            merge_compare(mi, mi->heap[left], mi->heap[smallest]) < 0) {
+            smallest = left;
+        }
+        if (right < mi->heap_size &&
+            merge_compare(mi, mi->heap[right], mi->heap[smallest]) < 0) {
+            smallest = right;
+        }
+
+        if (smallest == idx) break;
+
+        size_t tmp = mi->heap[idx];
+        mi->heap[idx] = mi->heap[smallest];
+        mi->heap[smallest] = tmp;
+        idx = smallest;
+    }
+}
+
+// Helper: rebuild heap from all valid children
+static void heap_build(merge_iter_t* mi) {
+    mi->heap_size = 0;
+    for (size_t i = 0; i < mi->child_count; i++) {
+        if (iterator_valid(mi->children[i])) {
+            mi->heap[mi->heap_size++] = i;
+        }
+    }
+
+    for (size_t i = mi->heap_size / 2; i > 0; i--) {
+        heap_sift_down(mi, i - 1);
+    }
+    if (mi->heap_size > 0) {
+        heap_sift_down(mi, 0);
+    }
+}
+
+static bool merge_valid(void* s) {
+    merge_iter_t* mi = s;
+    return mi->heap_size > 0;
+}
+
+static void merge_seek_to_first(void* s) {
+    merge_iter_t* mi = s;
+    for (size_t i = 0; i < mi->child_count; i++) {
+        iterator_seek_to_first(mi->children[i]);
+    }
+    heap_build(mi);
+}
+
+static void merge_seek(void* s, const char* key, size_t key_len) {
+    merge_iter_t* mi = s;
+    for (size_t i = 0; i < mi->child_count; i++) {
+        iterator_seek(mi->children[i], key, key_len);
+    }
+    heap_build(mi);
+}
+
+// Advance past the current key in every child (skip older duplicates)
+static void merge_next(void* s) {
+    merge_iter_t* mi = s;
+    if (mi->heap_size == 0) return;
+
+    // Save current key for duplicate detection
+    size_t cur_key_len;
+    const char* cur_key = iterator_key(mi->children[mi->heap[0]], &cur_key_len);
+    if (cur_key_len > mi->saved_cap) {
+        char* buf = realloc(mi->saved_key, cur_key_len);
+        if (!buf) return;
+        mi->saved_key = buf;
+        mi->saved_cap = cur_key_len;
+    }
+    memcpy(mi->saved_key, cur_key, cur_key_len);
+    size_t saved_key_len = cur_key_len;
+
+    // Advance all children with the same key; all but the first (the
+    // entry just surfaced) are hidden older versions
+    bool surfaced = true;
+    while (mi->heap_size > 0) {
+        iterator_t* top = mi->children[mi->heap[0]];
+
+        size_t key_len;
+        const char* key = iterator_key(top, &key_len);
+
+        if (mi->cmp(key, key_len, mi->saved_key, saved_key_len) != 0) {
+            break;  // Different key, stop
+        }
+
+        if (!surfaced && mi->drop) mi->drop(mi->drop_ctx, top);
+        surfaced = false;
+        iterator_next(top);
+
+        if (iterator_valid(top)) {
+            // Re-heapify
+            heap_sift_down(mi, 0);
+        } else {
+            // Remove from heap
+            mi->heap[0] = mi->heap[--mi->heap_size];
+            if (mi->heap_size > 0) {
+                heap_sift_down(mi, 0);
+            }
+        }
+    }
+}
+
+static const char* merge_key(void* s, size_t* len) {
+    merge_iter_t* mi = s;
+    if (mi->heap_size == 0) return NULL;
+    return iterator_key(mi->children[mi->heap[0]], len);
+}
+
+static const char* merge_value(void* s, size_t* len) {
+    merge_iter_t* mi = s;
+    if (mi->heap_size == 0) return NULL;
+    return iterator_value(mi->children[mi->heap[0]], len);
+}
+
+static bool merge_is_deleted(void* s) {
+    merge_iter_t* mi = s;
+    return mi->heap_size > 0 && iterator_is_deleted(mi->children[mi->heap[0]]);
+}
+
+static bool merge_is_blob(void* s) {
+    merge_iter_t* mi = s;
+    return mi->heap_size > 0 && iterator_is_blob(mi->children[mi->heap[0]]);
+}
+
+static void merge_destroy(void* s) {
+    merge_iter_t* mi = s;
+    for (size_t i = 0; i < mi->child_count; i++) {
+        iterator_destroy(mi->children[i]);
+    }
+    free(mi->children);
+    free(mi->heap);
+    free(mi->saved_key);
+    free(mi);
+}
+
+static const iterator_ops_t merge_ops = {
+    merge_valid, merge_seek_to_first, merge_seek, merge_next,
+    merge_key, merge_value, merge_is_deleted, merge_is_blob, merge_destroy,
+};
+
+// Helper: destroy children that could not be handed over
+static void destroy_children(iterator_t** children, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        iterator_destroy(children[i]);
+    }
+}
+
+iterator_t* merge_iter_create(iterator_t** children, size_t count, compare_fn cmp) {
+    return merge_iter_create_with_drop(children, count, cmp, NULL, NULL);
+}
+
+iterator_t* merge_iter_create_with_drop(iterator_t** children, size_t count, compare_fn cmp,
+                                        merge_drop_fn drop, void* drop_ctx) {
+    merge_iter_t* mi = calloc(1, sizeof(merge_iter_t));
+    if (!mi) {
+        destroy_children(children, count);
+        return NULL;
+    }
+
+    mi->cmp = cmp ? cmp : default_compare;
+    mi->drop = drop;
+    mi->drop_ctx = drop_ctx;
+    mi->child_count = count;
+    mi->children = malloc((count > 0 ? count : 1) * sizeof(iterator_t*));
+    mi->heap = malloc((count > 0 ? count : 1) * sizeof(size_t));
+    if (!mi->children || !mi->heap) {
+        free(mi->children);
+        free(mi->heap);
+        free(mi);
+        destroy_children(children, count);
+        return NULL;
+    }
+    if (count > 0) {
+        memcpy(mi->children, children, count * sizeof(iterator_t*));
+    }
+
+    // Children may already be positioned
+    heap_build(mi);
+
+    iterator_t* it = iterator_create(&merge_ops, mi);
+    if (!it) merge_destroy(mi);
+    return it;
+}
+
+// ============================================================
+// Range deletion filter
+// ============================================================
+
+typedef struct {
+    iterator_t* child;
+    compare_fn cmp;
+    range_del_list_t dels;
+    merge_drop_fn drop;
+    void* drop_ctx;
+} range_del_iter_t;
+
+// Helper: move the child past covered entries
+static void range_del_skip(range_del_iter_t* ri) {
+    while (iterator_valid(ri->child)) {
+        size_t key_len;
+        const char* key = iterator_key(ri->child, &key_len);
+        const range_tombstone_t* t = NULL;
+        for (size_t i = 0; i < ri->dels.count && !t; i++) {
+            const range_tombstone_t* c = &ri->dels.items[i];
+            if (ri->cmp(c->begin, c->begin_len, key, key_len) <= 0 &&
+                ri->cmp(key, key_len, c->end, c->end_len) < 0) {
+                t = c;
+            }
+        }
+        if (!t) return;
+
+        if (ri->drop) {
+            // Every hidden entry has to be reported: step over them
+            ri->drop(ri->drop_ctx, ri->child);
+            iterator_next(ri->child);
+        } else {
+            iterator_seek(ri->child, t->end, t->end_len);
+        }
+    }
+}
+
+static bool rd_valid(void* s) { return iterator_valid(((range_del_iter_t*)s)->child); }
+
+static void rd_seek_to_first(void* s) {
+    range_del_iter_t* ri = s;
+    iterator_seek_to_first(ri->child);
+    range_del_skip(ri);
+}
+
+static void rd_seek(void* s, const char* key, size_t key_len) {
+    range_del_iter_t* ri = s;
+    iterator_seek(ri->child, key, key_len);
+    range_del_skip(ri);
+}
+
+static void rd_next(void* s) {
+    range_del_iter_t* ri = s;
+    iterator_next(ri->child);
+    range_del_skip(ri);
+}
+
+static const char* rd_key(void* s, size_t* len) {
+    return iterator_key(((range_del_iter_t*)s)->child, len);
+}
+
+static const char* rd_value(void* s, size_t* len) {
+    return iterator_value(((range_del_iter_t*)s)->child, len);
+}
+
+static bool rd_is_deleted(void* s) { return iterator_is_deleted(((range_del_iter_t*)s)->child); }
+static bool rd_is_blob(void* s) { return iterator_is_blob(((range_del_iter_t*)s)->child); }
+
+static void rd_destroy(void* s) {
+    range_del_iter_t* ri = s;
+    iterator_destroy(ri->child);
+    range_del_list_free(&ri->dels);
+    free(ri);
+}
+
+static const iterator_ops_t range_del_ops = {
+    rd_valid, rd_seek_to_first, rd_seek, rd_next,
+    rd_key, rd_value, rd_is_deleted, rd_is_blob, rd_destroy,
+};
+
+iterator_t* range_del_iter_create(iterator_t* child, const range_del_list_t* dels,
+                                  compare_fn cmp, merge_drop_fn drop, void* drop_ctx) {
+    if (!child) return NULL;
+
+    range_del_iter_t* ri = calloc(1, sizeof(range_del_iter_t));
+    if (!ri || range_del_list_append(&ri->dels, dels) != STATUS_OK) {
+        if (ri) range_del_list_free(&ri->dels);
+        free(ri);
+        iterator_destroy(child);
+        return NULL;
+    }
+    ri->child = child;
+    ri->cmp = cmp ? cmp : default_compare;
+    ri->drop = drop;
+    ri->drop_ctx = drop_ctx;
+
+    iterator_t* it = iterator_create(&range_del_ops, ri);
+    if (!it) rd_destroy(ri);
+    return it;
+}
@@ -0,0 +1,75 @@
+#ifndef STORAGE_ITERATOR_H
+#define STORAGE_ITERATOR_H
+
+#include "types.h"
+#include "memtable.h"
+#include "level.h"
+
+// Internal iterator over (key, value, deleted) entries in key order.
+// Tombstones and blob references are surfaced; callers decide what to do
+// with them.
+typedef struct iterator iterator_t;
+
+typedef struct {
+    bool (*valid)(void* state);
+    void (*seek_to_first)(void* state);
+    void (*seek)(void* state, const char* key, size_t key_len);
+    void (*next)(void* state);
+    const char* (*key)(void* state, size_t* len);
+    const char* (*value)(void* state, size_t* len);
+    bool (*is_deleted)(void* state);
+    bool (*is_blob)(void* state);
+    void (*destroy)(void* state);
+} iterator_ops_t;
+
+struct iterator {
+    const iterator_ops_t* ops;
+    void* state;
+};
+
+// Generic operations
+iterator_t* iterator_create(const iterator_ops_t* ops, void* state);
+void iterator_destroy(iterator_t* it);
+bool iterator_valid(iterator_t* it);
+void iterator_seek_to_first(iterator_t* it);
+void iterator_seek(iterator_t* it, const char* key, size_t key_len);
+void iterator_next(iterator_t* it);
+const char* iterator_key(iterator_t* it, size_t* len);
+const char* iterator_value(iterator_t* it, size_t* len);
+bool iterator_is_deleted(iterator_t* it);
+// The value is an encoded blob reference; see level_read_blob
+bool iterator_is_blob(iterator_t* it);
+
+// Source adapters (each holds a reference on its memtable/reader)
+iterator_t* iterator_from_memtable(memtable_t* mt);
+iterator_t* iterator_from_sstable(sstable_reader_t* reader);
+
+// Concatenating iterator over one sorted, non-overlapping level (L1+).
+// Snapshots the level's files; call with the level lock held.
+iterator_t* iterator_from_level(level_manager_t* lm, int level);
+
+// Prefix-seek variants: a seek skips the tables whose prefix filter rules
+// out the target's prefix, so keys past that prefix may be missing. For
+// callers that stop at the end of the prefix (STORAGE_ITER_PREFIX).
+iterator_t* iterator_from_sstable_prefix(sstable_reader_t* reader);
+iterator_t* iterator_from_level_prefix(level_manager_t* lm, int level);
+
+// Merging iterator (min-heap based)
+// Children must be ordered newest first: when several children hold the same
+// key, only the entry from the lowest index is surfaced.
+// Takes ownership of the children (the array itself is copied).
+iterator_t* merge_iter_create(iterator_t** children, size_t count, compare_fn cmp);
+// Same, calling drop(ctx, child) for every older duplicate the merge hides,
+// while child is still positioned on it (compaction counts blob garbage)
+typedef void (*merge_drop_fn)(void* ctx, iterator_t* child);
+iterator_t* merge_iter_create_with_drop(iterator_t** children, size_t count, compare_fn cmp,
+                                        merge_drop_fn drop, void* drop_ctx);
+
+// Filtering iterator: hides the entries of child deleted by the range
+// tombstones in dels (those of the sources newer than child). Takes
+// ownership of child; dels is copied but the keys it points to must outlive
+// the iterator. drop, if set, is called for every hidden entry.
+iterator_t* range_del_iter_create(iterator_t* child, const range_del_list_t* dels,
+                                  compare_fn cmp, merge_drop_fn drop, void* drop_ctx);
+
+#endif // STORAGE_ITERATOR_H
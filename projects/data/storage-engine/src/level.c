@@ -1,6 +1,10 @@
 #include "level.h"
+#include "blob.h"
 #include <stdlib.h>
 #include <string.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <sys/stat.h>
 
 // Create level manager
@@ -18,6 +22,20 @@ level_manager_t* level_manager_create(const char* db_path, compare_fn cmp) {
 
     lm->cmp = cmp ? cmp : default_compare;
     lm->next_file_number = 1;
+    lm->max_subcompactions = MAX_SUBCOMPACTIONS;
+    lm->target_file_size = TARGET_FILE_SIZE_BASE;
+
+    if (pthread_rwlock_init(&lm->lock, NULL) != 0) {
+        free(lm->db_path);
+        free(lm);
+        return NULL;
+    }
+    if (pthread_mutex_init(&lm->blob_lock, NULL) != 0) {
+        pthread_rwlock_destroy(&lm->lock);
+        free(lm->db_path);
+        free(lm);
+        return NULL;
+    }
 
     // Initialize all levels
     for (int i = 0; i < MAX_LEVELS; i++) {
@@ -47,8 +65,16 @@ void level_manager_destroy(level_manager_t* lm) {
             free(meta->max_key);
         }
         free(level->files);
+        free(lm->compact_cursor[i]);
     }
 
+    for (size_t i = 0; i < lm->blob_count; i++) {
+        close(lm->blob_files[i].fd);
+    }
+    free(lm->blob_files);
+
+    pthread_mutex_destroy(&lm->blob_lock);
+    pthread_rwlock_destroy(&lm->lock);
     free(lm->db_path);
     free(lm);
 }
@@ -146,6 +172,9 @@ status_t level_add_sstable(level_manager_t* lm, int level, uint64_t file_num,
 
     lvl->total_bytes += meta.file_size;
 
+    // Route the reader's block reads through the shared cache
+    sstable_reader_set_cache(reader, lm->cache, file_num);
+
     // Update next file number if needed
     if (file_num >= lm->next_file_number) {
         lm->next_file_number = file_num + 1;
@@ -189,6 +218,52 @@ status_t level_remove_sstable(level_manager_t* lm, int level, uint64_t file_num)
     return STATUS_NOT_FOUND;
 }
 
+// Move SSTable between levels
+status_t level_move_sstable(level_manager_t* lm, int from_level, int to_level,
+                            uint64_t file_num) {
+    if (!lm || from_level < 0 || from_level >= MAX_LEVELS ||
+        to_level < 0 || to_level >= MAX_LEVELS || from_level == to_level) {
+        return STATUS_INVALID_ARG;
+    }
+
+    level_t* from = &lm->levels[from_level];
+    level_t* to = &lm->levels[to_level];
+
+    size_t i = 0;
+    while (i < from->file_count && from->files[i].file_number != file_num) i++;
+    if (i == from->file_count) return STATUS_NOT_FOUND;
+
+    // Ensure capacity before anything is unlinked
+    if (to->file_count >= to->file_capacity) {
+        size_t new_cap = to->file_capacity * 2;
+        if (new_cap == 0) new_cap = 4;
+        sstable_meta_t* new_files = realloc(to->files, new_cap * sizeof(sstable_meta_t));
+        if (!new_files) return STATUS_NO_MEMORY;
+        to->files = new_files;
+        to->file_capacity = new_cap;
+    }
+
+    sstable_meta_t meta = from->files[i];
+    memmove(&from->files[i], &from->files[i + 1],
+            (from->file_count - i - 1) * sizeof(sstable_meta_t));
+    from->file_count--;
+    from->total_bytes -= meta.file_size;
+
+    // Same placement rules as level_add_sstable
+    if (to_level == 0) {
+        to->files[to->file_count++] = meta;
+    } else {
+        size_t pos = find_insert_pos(lm, to, meta.min_key, meta.min_key_len);
+        memmove(&to->files[pos + 1], &to->files[pos],
+                (to->file_count - pos) * sizeof(sstable_meta_t));
+        to->files[pos] = meta;
+        to->file_count++;
+    }
+    to->total_bytes += meta.file_size;
+
+    return STATUS_OK;
+}
+
 // Helper: check if key is in range [min, max]
 static bool key_in_range(compare_fn cmp,
                          const char* key, size_t key_len,
@@ -199,17 +274,39 @@ static bool key_in_range(compare_fn cmp,
     return true;
 }
 
-// Query: search all levels for a key
-status_t level_get(level_manager_t* lm, const char* key, size_t key_len,
-                   char** value, size_t* value_len, bool* deleted) {
-    if (!lm || !key || !value || !value_len || !deleted) {
-        return STATUS_INVALID_ARG;
+// Helper: look up key in one SSTable, resolving blob references
+static status_t get_from_sstable(level_manager_t* lm, sstable_reader_t* reader,
+                                 const char* key, size_t key_len,
+                                 const char** value, size_t* value_len, bool* deleted,
+                                 level_pin_t* pin) {
+    uint8_t type;
+    status_t status = sstable_reader_get_pinned(reader, key, key_len, value, value_len,
+                                                &type, &pin->block);
+    if (status == STATUS_NOT_FOUND && sstable_reader_range_del_covers(reader, key, key_len)) {
+        // Range-deleted: reported like a tombstone so older files are skipped
+        *deleted = true;
+        return STATUS_OK;
+    }
+    if (status != STATUS_OK) return status;
+
+    *deleted = (type == SSTABLE_ENTRY_DELETION);
+    if (type == SSTABLE_ENTRY_BLOB) {
+        status = level_read_blob(lm, *value, *value_len, &pin->buf, value_len);
+        sstable_block_release(&pin->block);
+        *value = pin->buf;
+        return status;
     }
 
-    *value = NULL;
-    *value_len = 0;
-    *deleted = false;
+    // The block may be a slice of the reader's mapping
+    sstable_reader_ref(reader);
+    pin->reader = reader;
+    return STATUS_OK;
+}
 
+// Helper: search all levels (level lock held)
+static status_t level_get_locked(level_manager_t* lm, const char* key, size_t key_len,
+                                 const char** value, size_t* value_len, bool* deleted,
+                                 level_pin_t* pin) {
     // Search L0 first (all files, newest to oldest)
     level_t* l0 = &lm->levels[0];
     for (size_t i = l0->file_count; i > 0; i--) {
@@ -222,8 +319,8 @@ status_t level_get(level_manager_t* lm, const char* key, size_t key_len,
             continue;
         }
 
-        status_t status = sstable_reader_get(meta->reader, key, key_len,
-                                             value, value_len, deleted);
+        status_t status = get_from_sstable(lm, meta->reader, key, key_len,
+                                           value, value_len, deleted, pin);
         if (status == STATUS_OK) {
             return STATUS_OK;
         }
@@ -258,8 +355,8 @@ status_t level_get(level_manager_t* lm, const char* key, size_t key_len,
             if (key_in_range(lm->cmp, key, key_len,
                             meta->min_key, meta->min_key_len,
                             meta->max_key, meta->max_key_len)) {
-                status_t status = sstable_reader_get(meta->reader, key, key_len,
-                                                     value, value_len, deleted);
+                status_t status = get_from_sstable(lm, meta->reader, key, key_len,
+                                                   value, value_len, deleted, pin);
                 if (status == STATUS_OK) {
                     return STATUS_OK;
                 }
@@ -273,6 +370,61 @@ status_t level_get(level_manager_t* lm, const char* key, size_t key_len,
     return STATUS_NOT_FOUND;
 }
 
+// Query: search all levels for a key
+status_t level_get_pinned(level_manager_t* lm, const char* key, size_t key_len,
+                          const char** value, size_t* value_len, bool* deleted,
+                          level_pin_t* pin) {
+    if (pin) memset(pin, 0, sizeof(*pin));
+    if (!lm || !key || !value || !value_len || !deleted || !pin) {
+        return STATUS_INVALID_ARG;
+    }
+
+    *value = NULL;
+    *value_len = 0;
+    *deleted = false;
+
+    level_lock_shared(lm);
+    status_t status = level_get_locked(lm, key, key_len, value, value_len, deleted, pin);
+    level_unlock(lm);
+    return status;
+}
+
+void level_pin_release(level_pin_t* pin) {
+    if (!pin) return;
+    sstable_block_release(&pin->block);
+    if (pin->reader) sstable_reader_close(pin->reader);
+    free(pin->buf);
+    memset(pin, 0, sizeof(*pin));
+}
+
+status_t level_get(level_manager_t* lm, const char* key, size_t key_len,
+                   char** value, size_t* value_len, bool* deleted) {
+    if (!value || !value_len) return STATUS_INVALID_ARG;
+    *value = NULL;
+    *value_len = 0;
+
+    const char* found;
+    size_t found_len;
+    level_pin_t pin;
+    status_t status = level_get_pinned(lm, key, key_len, &found, &found_len, deleted, &pin);
+    if (status == STATUS_OK && pin.buf) {
+        // Blob values are private copies already
+        *value = pin.buf;
+        *value_len = found_len;
+        pin.buf = NULL;
+    } else if (status == STATUS_OK && found_len > 0) {
+        *value = malloc(found_len);
+        if (*value) {
+            memcpy(*value, found, found_len);
+            *value_len = found_len;
+        } else {
+            status = STATUS_NO_MEMORY;
+        }
+    }
+    level_pin_release(&pin);
+    return status;
+}
+
 // Calculate max bytes for a level
 uint64_t level_max_bytes_for_level(int level) {
     if (level == 0) {
@@ -286,6 +438,29 @@ uint64_t level_max_bytes_for_level(int level) {
     return result;
 }
 
+// Calculate the compaction output file size for a level
+uint64_t level_target_file_size(level_manager_t* lm, int level) {
+    uint64_t result = lm && lm->target_file_size > 0 ? lm->target_file_size
+                                                     : TARGET_FILE_SIZE_BASE;
+    for (int i = 1; i < level; i++) {
+        result *= TARGET_FILE_SIZE_MULTIPLIER;
+    }
+    return result;
+}
+
+// Score a level for compaction (>= 1.0 for L0 / > 1.0 for L1+ means due)
+double level_compaction_score(level_manager_t* lm, int level) {
+    if (!lm || level < 0 || level >= MAX_LEVELS - 1) {
+        return 0.0;
+    }
+
+    level_t* lvl = &lm->levels[level];
+    if (level == 0) {
+        return (double)lvl->file_count / L0_COMPACTION_TRIGGER;
+    }
+    return (double)lvl->total_bytes / (double)level_max_bytes_for_level(level);
+}
+
 // Check if a level needs compaction
 bool level_needs_compaction(level_manager_t* lm, int level) {
     if (!lm || level < 0 || level >= MAX_LEVELS - 1) {
@@ -385,16 +560,374 @@ size_t level_find_overlapping(level_manager_t* lm, int level,
     return count;
 }
 
+// Sum the sizes of the files in a level that overlap a key range
+uint64_t level_overlapping_bytes(level_manager_t* lm, int level,
+                                 const char* min_key, size_t min_key_len,
+                                 const char* max_key, size_t max_key_len) {
+    if (!lm || level < 0 || level >= MAX_LEVELS) return 0;
+
+    level_t* lvl = &lm->levels[level];
+    uint64_t bytes = 0;
+
+    if (level == 0) {
+        for (size_t i = 0; i < lvl->file_count; i++) {
+            sstable_meta_t* meta = &lvl->files[i];
+            if (ranges_overlap(lm->cmp,
+                              min_key, min_key_len, max_key, max_key_len,
+                              meta->min_key, meta->min_key_len,
+                              meta->max_key, meta->max_key_len)) {
+                bytes += meta->file_size;
+            }
+        }
+        return bytes;
+    }
+
+    // L1+: binary search for the first file that might overlap
+    size_t left = 0, right = lvl->file_count;
+    while (left < right) {
+        size_t mid = left + (right - left) / 2;
+        if (lm->cmp(lvl->files[mid].max_key, lvl->files[mid].max_key_len,
+                   min_key, min_key_len) < 0) {
+            left = mid + 1;
+        } else {
+            right = mid;
+        }
+    }
+    for (size_t i = left; i < lvl->file_count; i++) {
+        sstable_meta_t* meta = &lvl->files[i];
+        if (lm->cmp(meta->min_key, meta->min_key_len, max_key, max_key_len) > 0) {
+            break;
+        }
+        bytes += meta->file_size;
+    }
+    return bytes;
+}
+
+// Helper: check if any file in a level overlaps a key range
+static bool level_overlaps(level_manager_t* lm, int level,
+                           const char* min_key, size_t min_key_len,
+                           const char* max_key, size_t max_key_len) {
+    level_t* lvl = &lm->levels[level];
+    for (size_t i = 0; i < lvl->file_count; i++) {
+        sstable_meta_t* meta = &lvl->files[i];
+        if (ranges_overlap(lm->cmp, min_key, min_key_len, max_key, max_key_len,
+                           meta->min_key, meta->min_key_len,
+                           meta->max_key, meta->max_key_len)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Pick the level for an ingested table: the deepest one before the first
+// level with an overlapping file
+int level_pick_ingest_level(level_manager_t* lm,
+                            const char* min_key, size_t min_key_len,
+                            const char* max_key, size_t max_key_len) {
+    if (!lm) return 0;
+    for (int level = 0; level < MAX_LEVELS; level++) {
+        if (level_overlaps(lm, level, min_key, min_key_len, max_key, max_key_len)) {
+            return level > 0 ? level - 1 : 0;
+        }
+    }
+    return MAX_LEVELS - 1;
+}
+
+// Pick the next L1+ file to compact, round-robin from the cursor
+size_t level_pick_compaction_file(level_manager_t* lm, int level) {
+    if (!lm || level < 1 || level >= MAX_LEVELS - 1) return 0;
+
+    level_t* lvl = &lm->levels[level];
+    if (lvl->file_count == 0) return 0;
+
+    // First file starting after the cursor (files are sorted by min_key)
+    size_t start = 0;
+    if (lm->compact_cursor[level]) {
+        while (start < lvl->file_count &&
+               lm->cmp(lvl->files[start].min_key, lvl->files[start].min_key_len,
+                       lm->compact_cursor[level], lm->compact_cursor_len[level]) <= 0) {
+            start++;
+        }
+        if (start == lvl->file_count) start = 0;
+    }
+
+    // Least overlap with the next level per byte of input; ties go to the
+    // file nearest the cursor
+    size_t window = lvl->file_count < COMPACTION_PICK_WINDOW ? lvl->file_count
+                                                             : COMPACTION_PICK_WINDOW;
+    size_t best = start;
+    double best_ratio = 0.0;
+    for (size_t n = 0; n < window; n++) {
+        size_t i = (start + n) % lvl->file_count;
+        sstable_meta_t* meta = &lvl->files[i];
+        uint64_t overlap = level_overlapping_bytes(lm, level + 1,
+                                                   meta->min_key, meta->min_key_len,
+                                                   meta->max_key, meta->max_key_len);
+        double ratio = (double)overlap / (double)(meta->file_size > 0 ? meta->file_size : 1);
+        if (n == 0 || ratio < best_ratio) {
+            best = i;
+            best_ratio = ratio;
+        }
+    }
+    return best;
+}
+
+// Remember where the last compaction out of a level ended
+status_t level_set_compact_cursor(level_manager_t* lm, int level,
+                                  const char* key, size_t key_len) {
+    if (!lm || level < 0 || level >= MAX_LEVELS || (!key && key_len > 0)) {
+        return STATUS_INVALID_ARG;
+    }
+
+    char* copy = malloc(key_len > 0 ? key_len : 1);
+    if (!copy) return STATUS_NO_MEMORY;
+    if (key_len > 0) memcpy(copy, key, key_len);
+
+    free(lm->compact_cursor[level]);
+    lm->compact_cursor[level] = copy;
+    lm->compact_cursor_len[level] = key_len;
+    return STATUS_OK;
+}
+
 // Accessors
 size_t level_file_count(level_manager_t* lm, int level) {
     if (!lm || level < 0 || level >= MAX_LEVELS) return 0;
-    return lm->levels[level].file_count;
+    level_lock_shared(lm);
+    size_t count = lm->levels[level].file_count;
+    level_unlock(lm);
+    return count;
 }
 
 uint64_t level_next_file_number(level_manager_t* lm) {
     return lm ? lm->next_file_number : 0;
 }
 
+uint64_t level_new_file_number(level_manager_t* lm) {
+    return lm ? __atomic_fetch_add(&lm->next_file_number, 1, __ATOMIC_RELAXED) : 0;
+}
+
 void level_set_next_file_number(level_manager_t* lm, uint64_t num) {
     if (lm) lm->next_file_number = num;
 }
+
+void level_set_block_cache(level_manager_t* lm, block_cache_t* cache) {
+    if (lm) lm->cache = cache;
+}
+
+void level_set_use_mmap(level_manager_t* lm, bool use_mmap) {
+    if (lm) lm->use_mmap = use_mmap;
+}
+
+void level_set_compression(level_manager_t* lm, compression_t compression) {
+    if (lm) lm->compression = compression;
+}
+
+void level_set_max_subcompactions(level_manager_t* lm, int n) {
+    if (lm) lm->max_subcompactions = n > 1 ? n : 1;
+}
+
+void level_set_target_file_size(level_manager_t* lm, uint64_t base) {
+    if (lm) lm->target_file_size = base > 0 ? base : TARGET_FILE_SIZE_BASE;
+}
+
+void level_set_blob_min_size(level_manager_t* lm, size_t min_size) {
+    if (lm) lm->blob_min_size = min_size;
+}
+
+void level_set_prefix_extractor(level_manager_t* lm, prefix_extractor_fn fn,
+                                const char* name) {
+    if (!lm) return;
+    lm->prefix_extractor = fn;
+    lm->prefix_name = name;
+}
+
+sstable_reader_t* level_open_sstable(level_manager_t* lm, const char* path) {
+    if (!lm || !path) return NULL;
+    sstable_reader_t* reader = sstable_reader_open_ex(path, lm->cmp,
+                                                      lm->use_mmap ? SSTABLE_OPEN_MMAP : 0);
+    sstable_reader_set_prefix_extractor(reader, lm->prefix_extractor, lm->prefix_name);
+    return reader;
+}
+
+// ============================================================
+// Blob files
+// ============================================================
+
+// Helper: find a blob file (blob_lock held)
+static blob_file_t* find_blob_file(level_manager_t* lm, uint64_t file_num) {
+    for (size_t i = 0; i < lm->blob_count; i++) {
+        if (lm->blob_files[i].file_number == file_num) return &lm->blob_files[i];
+    }
+    return NULL;
+}
+
+status_t level_add_blob_file(level_manager_t* lm, uint64_t file_num, uint64_t total_bytes) {
+    if (!lm || !lm->db_path) return STATUS_INVALID_ARG;
+
+    char path[512];
+    blob_file_path(path, sizeof(path), lm->db_path, file_num);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return STATUS_IO_ERROR;
+
+    pthread_mutex_lock(&lm->blob_lock);
+    if (find_blob_file(lm, file_num)) {
+        pthread_mutex_unlock(&lm->blob_lock);
+        close(fd);
+        return STATUS_OK;
+    }
+    if (lm->blob_count >= lm->blob_capacity) {
+        size_t new_cap = lm->blob_capacity ? lm->blob_capacity * 2 : 4;
+        blob_file_t* files = realloc(lm->blob_files, new_cap * sizeof(blob_file_t));
+        if (!files) {
+            pthread_mutex_unlock(&lm->blob_lock);
+            close(fd);
+            return STATUS_NO_MEMORY;
+        }
+        lm->blob_files = files;
+        lm->blob_capacity = new_cap;
+    }
+    blob_file_t* bf = &lm->blob_files[lm->blob_count++];
+    bf->file_number = file_num;
+    bf->fd = fd;
+    bf->total_bytes = total_bytes;
+    bf->garbage_bytes = 0;
+    bf->pins = 0;
+    bf->obsolete = false;
+
+    // Update next file number
+    if (file_num >= lm->next_file_number) {
+        lm->next_file_number = file_num + 1;
+    }
+    pthread_mutex_unlock(&lm->blob_lock);
+    return STATUS_OK;
+}
+
+// Helper: close and forget a blob file (blob_lock held)
+static void drop_blob_file(level_manager_t* lm, blob_file_t* bf) {
+    close(bf->fd);
+    *bf = lm->blob_files[--lm->blob_count];
+}
+
+// Helper: drop a pin; an obsolete file goes with its last one (blob_lock held)
+static void unpin_blob_file(level_manager_t* lm, uint64_t file_num) {
+    blob_file_t* bf = find_blob_file(lm, file_num);
+    if (!bf) return;
+    bf->pins--;
+    if (bf->obsolete && bf->pins == 0) drop_blob_file(lm, bf);
+}
+
+void level_remove_blob_file(level_manager_t* lm, uint64_t file_num) {
+    if (!lm) return;
+    pthread_mutex_lock(&lm->blob_lock);
+    blob_file_t* bf = find_blob_file(lm, file_num);
+    if (bf) drop_blob_file(lm, bf);
+    pthread_mutex_unlock(&lm->blob_lock);
+}
+
+status_t level_read_blob(level_manager_t* lm, const char* ref, size_t ref_len,
+                         char** value, size_t* value_len) {
+    if (!lm || !ref || !value || !value_len) return STATUS_INVALID_ARG;
+
+    blob_ref_t br;
+    if (!blob_ref_decode(ref, ref_len, &br)) return STATUS_CORRUPTION;
+
+    // Pinned, the fd stays open after the lock is dropped
+    pthread_mutex_lock(&lm->blob_lock);
+    blob_file_t* bf = find_blob_file(lm, br.file_number);
+    int fd = -1;
+    if (bf) {
+        bf->pins++;
+        fd = bf->fd;
+    }
+    pthread_mutex_unlock(&lm->blob_lock);
+    if (fd < 0) return STATUS_CORRUPTION;
+
+    status_t status = blob_read(fd, &br, value, value_len);
+
+    pthread_mutex_lock(&lm->blob_lock);
+    unpin_blob_file(lm, br.file_number);
+    pthread_mutex_unlock(&lm->blob_lock);
+    return status;
+}
+
+status_t level_pin_blob_files(level_manager_t* lm, uint64_t** file_nums, size_t* count) {
+    if (!lm || !file_nums || !count) return STATUS_INVALID_ARG;
+    *file_nums = NULL;
+    *count = 0;
+
+    pthread_mutex_lock(&lm->blob_lock);
+    if (lm->blob_count > 0) {
+        *file_nums = malloc(lm->blob_count * sizeof(uint64_t));
+        if (!*file_nums) {
+            pthread_mutex_unlock(&lm->blob_lock);
+            return STATUS_NO_MEMORY;
+        }
+    }
+    // Obsolete files are out of reach of the current SSTables
+    for (size_t i = 0; i < lm->blob_count; i++) {
+        blob_file_t* bf = &lm->blob_files[i];
+        if (bf->obsolete) continue;
+        bf->pins++;
+        (*file_nums)[(*count)++] = bf->file_number;
+    }
+    pthread_mutex_unlock(&lm->blob_lock);
+    return STATUS_OK;
+}
+
+void level_unpin_blob_files(level_manager_t* lm, const uint64_t* file_nums, size_t count) {
+    if (!lm || count == 0) return;
+    pthread_mutex_lock(&lm->blob_lock);
+    for (size_t i = 0; i < count; i++) {
+        unpin_blob_file(lm, file_nums[i]);
+    }
+    pthread_mutex_unlock(&lm->blob_lock);
+}
+
+bool level_add_blob_garbage(level_manager_t* lm, uint64_t file_num, uint64_t bytes) {
+    if (!lm) return false;
+    pthread_mutex_lock(&lm->blob_lock);
+    blob_file_t* bf = find_blob_file(lm, file_num);
+    bool all_garbage = false;
+    if (bf && !bf->obsolete) {
+        bf->garbage_bytes += bytes;
+        all_garbage = bf->garbage_bytes >= bf->total_bytes;
+    }
+    pthread_mutex_unlock(&lm->blob_lock);
+    return all_garbage;
+}
+
+void level_set_blob_obsolete(level_manager_t* lm, uint64_t file_num) {
+    if (!lm) return;
+    pthread_mutex_lock(&lm->blob_lock);
+    blob_file_t* bf = find_blob_file(lm, file_num);
+    if (bf) {
+        bf->obsolete = true;
+        if (bf->pins == 0) drop_blob_file(lm, bf);
+    }
+    pthread_mutex_unlock(&lm->blob_lock);
+}
+
+double level_blob_garbage_ratio(level_manager_t* lm, uint64_t file_num) {
+    if (!lm) return 0.0;
+    pthread_mutex_lock(&lm->blob_lock);
+    blob_file_t* bf = find_blob_file(lm, file_num);
+    double ratio = 0.0;
+    if (bf && bf->total_bytes > 0) {
+        ratio = (double)bf->garbage_bytes / (double)bf->total_bytes;
+    }
+    pthread_mutex_unlock(&lm->blob_lock);
+    return ratio;
+}
+
+// Locking
+void level_lock_shared(level_manager_t* lm) {
+    pthread_rwlock_rdlock(&lm->lock);
+}
+
+void level_lock_exclusive(level_manager_t* lm) {
+    pthread_rwlock_wrlock(&lm->lock);
+}
+
+void level_unlock(level_manager_t* lm) {
+    pthread_rwlock_unlock(&lm->lock);
+}
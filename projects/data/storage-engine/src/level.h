@@ -4,6 +4,8 @@
 #include "types.h"
 #include "param.h"
 #include "sstable.h"
+#include "cache.h"
+#include <pthread.h>
 
 // SSTable metadata for level management
 typedef struct {
@@ -17,6 +19,25 @@ typedef struct {
     uint64_t file_size;
 } sstable_meta_t;
 
+// Live blob file (blob.h). total_bytes is the file size; garbage_bytes
+// counts records no SSTable references any more.
+typedef struct {
+    uint64_t file_number;
+    int fd;
+    uint64_t total_bytes;
+    uint64_t garbage_bytes;
+    int pins;               // Open iterators and reads in progress
+    bool obsolete;          // All garbage: unlinked, closed once unpinned
+} blob_file_t;
+
+// What keeps a level_get_pinned value alive: a data block of a
+// referenced table, or a private buffer (values read from blob files)
+typedef struct {
+    sstable_reader_t* reader;
+    sstable_block_t block;
+    char* buf;
+} level_pin_t;
+
 // Level structure
 typedef struct {
     int level_num;
@@ -32,6 +53,26 @@ struct level_manager {
     compare_fn cmp;
     level_t levels[MAX_LEVELS];
     uint64_t next_file_number;
+    block_cache_t* cache;   // Shared block cache (owned by storage_t)
+    bool use_mmap;          // Open SSTables with SSTABLE_OPEN_MMAP
+    compression_t compression;  // Data block codec for compaction output
+    int max_subcompactions;     // Key ranges a compaction may merge in parallel
+    uint64_t target_file_size;  // Compaction output size for L1 (grows per level)
+    // Per level: max key of the last file compacted out of it; the next
+    // pick starts after it (in memory only, restarts from the first file)
+    char* compact_cursor[MAX_LEVELS];
+    size_t compact_cursor_len[MAX_LEVELS];
+    // Blob files, by file number; blob_lock guards the array
+    blob_file_t* blob_files;
+    size_t blob_count;
+    size_t blob_capacity;
+    size_t blob_min_size;       // Values this large go to blob files (0: off)
+    pthread_mutex_t blob_lock;
+    prefix_extractor_fn prefix_extractor;   // New SSTables get prefix filters
+    const char* prefix_name;                // Recorded with them (caller's string)
+    // Readers hold it shared; file list changes (flush/compaction install)
+    // hold it exclusive. Only one thread may change the file lists.
+    pthread_rwlock_t lock;
 };
 
 // Lifecycle
@@ -39,25 +80,101 @@ level_manager_t* level_manager_create(const char* db_path, compare_fn cmp);
 void level_manager_destroy(level_manager_t* lm);
 
 // SSTable management
+// Open an SSTable with the manager's comparator, read mode and prefix extractor
+sstable_reader_t* level_open_sstable(level_manager_t* lm, const char* path);
 status_t level_add_sstable(level_manager_t* lm, int level, uint64_t file_num,
                            const char* path, sstable_reader_t* reader);
 status_t level_remove_sstable(level_manager_t* lm, int level, uint64_t file_num);
+// Move an SSTable to another level as is (reader and metadata kept)
+status_t level_move_sstable(level_manager_t* lm, int from_level, int to_level,
+                            uint64_t file_num);
 
 // Query
 status_t level_get(level_manager_t* lm, const char* key, size_t key_len,
                    char** value, size_t* value_len, bool* deleted);
+// Like level_get without the copy: *value stays valid, whatever happens
+// to the files, until level_pin_release(pin). Release pin after any status.
+status_t level_get_pinned(level_manager_t* lm, const char* key, size_t key_len,
+                          const char** value, size_t* value_len, bool* deleted,
+                          level_pin_t* pin);
+void level_pin_release(level_pin_t* pin);
 
 // Compaction helpers
 bool level_needs_compaction(level_manager_t* lm, int level);
+// How urgently a level needs compaction: L0 file count over
+// L0_COMPACTION_TRIGGER, L1+ bytes over level_max_bytes_for_level
+double level_compaction_score(level_manager_t* lm, int level);
+// Total size of the files in a level overlapping [min_key, max_key]
+uint64_t level_overlapping_bytes(level_manager_t* lm, int level,
+                                 const char* min_key, size_t min_key_len,
+                                 const char* max_key, size_t max_key_len);
+// Index of the L1+ file to compact next: among the COMPACTION_PICK_WINDOW
+// files after the level's cursor (wrapping), the one whose overlap with
+// the next level is smallest relative to its own size
+size_t level_pick_compaction_file(level_manager_t* lm, int level);
+// Move the cursor past a compacted file's key range
+status_t level_set_compact_cursor(level_manager_t* lm, int level,
+                                  const char* key, size_t key_len);
+// Level for an externally built table of [min_key, max_key]: the deepest
+// one with no overlapping file in it or above it, since the table must
+// shadow everything it overlaps (L0 if it overlaps an L0 file)
+int level_pick_ingest_level(level_manager_t* lm,
+                            const char* min_key, size_t min_key_len,
+                            const char* max_key, size_t max_key_len);
 size_t level_find_overlapping(level_manager_t* lm, int level,
                               const char* min_key, size_t min_key_len,
                               const char* max_key, size_t max_key_len,
                               uint64_t** file_nums);
 uint64_t level_max_bytes_for_level(int level);
+// Compaction output files are cut once they reach this size
+uint64_t level_target_file_size(level_manager_t* lm, int level);
+
+// Blob files
+// Open and register a finished blob file of total_bytes
+status_t level_add_blob_file(level_manager_t* lm, uint64_t file_num, uint64_t total_bytes);
+// Close and forget a blob file (manifest recovery of REMOVE_BLOB)
+void level_remove_blob_file(level_manager_t* lm, uint64_t file_num);
+// Resolve an encoded blob reference; *value is malloc'd
+status_t level_read_blob(level_manager_t* lm, const char* ref, size_t ref_len,
+                         char** value, size_t* value_len);
+// Pin the live blob files for an iterator over the current SSTables, so
+// files collected meanwhile stay readable; *file_nums is malloc'd
+status_t level_pin_blob_files(level_manager_t* lm, uint64_t** file_nums, size_t* count);
+void level_unpin_blob_files(level_manager_t* lm, const uint64_t* file_nums, size_t count);
+// Record bytes of a blob file that are no longer referenced. Returns true
+// when the whole file has become garbage (the caller deletes it and calls
+// level_set_blob_obsolete).
+bool level_add_blob_garbage(level_manager_t* lm, uint64_t file_num, uint64_t bytes);
+void level_set_blob_obsolete(level_manager_t* lm, uint64_t file_num);
+// Fraction of a blob file that is garbage (0 for unknown files)
+double level_blob_garbage_ratio(level_manager_t* lm, uint64_t file_num);
+
+// Locking for callers that walk the file lists directly
+void level_lock_shared(level_manager_t* lm);
+void level_lock_exclusive(level_manager_t* lm);
+void level_unlock(level_manager_t* lm);
 
 // Accessors
 size_t level_file_count(level_manager_t* lm, int level);
 uint64_t level_next_file_number(level_manager_t* lm);
+// Allocate a file number; safe to call from several compaction threads
+uint64_t level_new_file_number(level_manager_t* lm);
 void level_set_next_file_number(level_manager_t* lm, uint64_t num);
+void level_set_block_cache(level_manager_t* lm, block_cache_t* cache);
+void level_set_use_mmap(level_manager_t* lm, bool use_mmap);
+void level_set_compression(level_manager_t* lm, compression_t compression);
+// Split large compactions into up to n key ranges merged on their own
+// threads (default MAX_SUBCOMPACTIONS; 1 merges on the calling thread)
+void level_set_max_subcompactions(level_manager_t* lm, int n);
+// L1 output file size; level N files are TARGET_FILE_SIZE_MULTIPLIER^(N-1)
+// times larger (default TARGET_FILE_SIZE_BASE)
+void level_set_target_file_size(level_manager_t* lm, uint64_t base);
+// Store values of at least min_size bytes in blob files (0 disables)
+void level_set_blob_min_size(level_manager_t* lm, size_t min_size);
+// Add key prefixes to the filters of new SSTables and check them on
+// prefix seeks; call before any SSTable is opened. Tables whose filters
+// were built under another name are searched as if they had none.
+void level_set_prefix_extractor(level_manager_t* lm, prefix_extractor_fn fn,
+                                const char* name);
 
 #endif // STORAGE_LEVEL_H
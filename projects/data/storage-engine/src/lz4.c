@@ -0,0 +1,188 @@
+#include "lz4.h"
+#include <string.h>
+
+// Block format: a list of sequences
+//   token (4 bits literal length | 4 bits match length - 4)
+//   [literal length extension bytes] literals
+//   offset (uint16 LE) [match length extension bytes]
+// The last sequence has literals only.
+#define LZ4_MIN_MATCH       4
+#define LZ4_MFLIMIT         12      // Last match starts at least this far from the end
+#define LZ4_LAST_LITERALS   5       // ...and ends at least this far from the end
+#define LZ4_MAX_OFFSET      65535
+#define LZ4_HASH_BITS       12
+#define LZ4_SKIP_TRIGGER    6       // Misses before the search starts skipping
+
+// Helper: unaligned 32-bit load
+static uint32_t read32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+// Helper: hash of the next 4 bytes (Knuth multiplicative)
+static uint32_t hash4(uint32_t v) {
+    return (v * 2654435761u) >> (32 - LZ4_HASH_BITS);
+}
+
+// Helper: write a length extension (the part of len past 15)
+static uint8_t* write_length(uint8_t* op, size_t len) {
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = (uint8_t)len;
+    return op;
+}
+
+// Helper: emit one sequence; match_len == 0 marks the final literals-only
+// sequence. Returns the new output position, or NULL if dst is too small.
+static uint8_t* emit_sequence(uint8_t* op, uint8_t* oend,
+                              const uint8_t* literals, size_t lit_len,
+                              size_t offset, size_t match_len) {
+    // Worst case: token + extensions + literals + offset
+    size_t needed = 1 + lit_len / 255 + 1 + lit_len + 2 + match_len / 255 + 1;
+    if (needed > (size_t)(oend - op)) return NULL;
+
+    uint8_t* token = op++;
+    size_t ml = match_len > 0 ? match_len - LZ4_MIN_MATCH : 0;
+    *token = (uint8_t)(((lit_len < 15 ? lit_len : 15) << 4) | (ml < 15 ? ml : 15));
+
+    if (lit_len >= 15) op = write_length(op, lit_len - 15);
+    memcpy(op, literals, lit_len);
+    op += lit_len;
+
+    if (match_len > 0) {
+        *op++ = (uint8_t)(offset & 0xFF);
+        *op++ = (uint8_t)(offset >> 8);
+        if (ml >= 15) op = write_length(op, ml - 15);
+    }
+    return op;
+}
+
+size_t lz4_compress_bound(size_t src_len) {
+    return src_len + src_len / 255 + 16;
+}
+
+size_t lz4_compress(const uint8_t* src, size_t src_len, uint8_t* dst, size_t dst_cap) {
+    if (!src || !dst) return 0;
+
+    uint8_t* op = dst;
+    uint8_t* oend = dst + dst_cap;
+    const uint8_t* anchor = src;
+
+    // Inputs too short for a match are stored as literals
+    if (src_len > LZ4_MFLIMIT) {
+        // Position + 1 of the last occurrence of each hash (0 = none)
+        uint32_t table[1 << LZ4_HASH_BITS];
+        memset(table, 0, sizeof(table));
+
+        const uint8_t* ip = src;
+        const uint8_t* mflimit = src + src_len - LZ4_MFLIMIT;
+        const uint8_t* matchlimit = src + src_len - LZ4_LAST_LITERALS;
+        size_t misses = 0;
+
+        while (ip < mflimit) {
+            uint32_t seq = read32(ip);
+            uint32_t h = hash4(seq);
+            uint32_t ref = table[h];
+            table[h] = (uint32_t)(ip - src) + 1;
+
+            const uint8_t* match = src + ref - 1;
+            if (ref == 0 || (size_t)(ip - match) > LZ4_MAX_OFFSET || read32(match) != seq) {
+                // Incompressible stretches are crossed in growing steps
+                ip += 1 + (misses++ >> LZ4_SKIP_TRIGGER);
+                continue;
+            }
+            misses = 0;
+
+            // Extend backwards over literals, then forwards
+            while (ip > anchor && match > src && ip[-1] == match[-1]) {
+                ip--;
+                match--;
+            }
+            size_t len = LZ4_MIN_MATCH;
+            while (ip + len < matchlimit && ip[len] == match[len]) len++;
+
+            op = emit_sequence(op, oend, anchor, (size_t)(ip - anchor),
+                               (size_t)(ip - match), len);
+            if (!op) return 0;
+            ip += len;
+            anchor = ip;
+
+            // Index a position inside the match for the next search
+            if (ip - 2 > src && ip < mflimit) {
+                table[hash4(read32(ip - 2))] = (uint32_t)(ip - 2 - src) + 1;
+            }
+        }
+    }
+
+    op = emit_sequence(op, oend, anchor, (size_t)(src + src_len - anchor), 0, 0);
+    if (!op) return 0;
+    return (size_t)(op - dst);
+}
+
+// Helper: read a length extension; false if it runs past the input
+static bool read_length(const uint8_t** ip, const uint8_t* iend, size_t* len) {
+    uint8_t b;
+    do {
+        if (*ip >= iend) return false;
+        b = *(*ip)++;
+        *len += b;
+    } while (b == 255);
+    return true;
+}
+
+status_t lz4_decompress(const uint8_t* src, size_t src_len, uint8_t* dst, size_t dst_len) {
+    if (!src || !dst) return STATUS_INVALID_ARG;
+
+    const uint8_t* ip = src;
+    const uint8_t* iend = src + src_len;
+    uint8_t* op = dst;
+    uint8_t* oend = dst + dst_len;
+
+    while (ip < iend) {
+        uint8_t token = *ip++;
+
+        // Literals
+        size_t lit_len = token >> 4;
+        if (lit_len == 15 && !read_length(&ip, iend, &lit_len)) return STATUS_CORRUPTION;
+        if (lit_len > (size_t)(iend - ip) || lit_len > (size_t)(oend - op)) {
+            return STATUS_CORRUPTION;
+        }
+        memcpy(op, ip, lit_len);
+        ip += lit_len;
+        op += lit_len;
+
+        // The last sequence ends after its literals
+        if (ip == iend) break;
+
+        // Match
+        if (iend - ip < 2) return STATUS_CORRUPTION;
+        size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - dst)) return STATUS_CORRUPTION;
+
+        size_t match_len = token & 15;
+        if (match_len == 15 && !read_length(&ip, iend, &match_len)) return STATUS_CORRUPTION;
+        match_len += LZ4_MIN_MATCH;
+        if (match_len > (size_t)(oend - op)) return STATUS_CORRUPTION;
+
+        const uint8_t* match = op - offset;
+        if (offset >= match_len) {
+            memcpy(op, match, match_len);
+        } else if (offset >= 8) {
+            // Overlapping, but each 8-byte chunk reads only finished output
+            for (size_t i = 0; i < match_len; i += 8) {
+                size_t n = match_len - i < 8 ? match_len - i : 8;
+                memcpy(op + i, match + i, n);
+            }
+        } else {
+            // Short offsets repeat a pattern byte by byte
+            for (size_t i = 0; i < match_len; i++) op[i] = match[i];
+        }
+        op += match_len;
+    }
+
+    return op == oend ? STATUS_OK : STATUS_CORRUPTION;
+}
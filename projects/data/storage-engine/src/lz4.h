@@ -0,0 +1,24 @@
+#ifndef LZ4_H
+#define LZ4_H
+
+#include "types.h"
+#include <stdint.h>
+#include <stddef.h>
+
+// Self-contained compressor/decompressor for the LZ4 block format
+// (https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md).
+// Output is readable by any LZ4 block decoder; no frame header.
+
+// Worst-case compressed size of src_len bytes
+size_t lz4_compress_bound(size_t src_len);
+
+// Compress src into dst; returns the compressed size, or 0 if it does not
+// fit in dst_cap bytes
+size_t lz4_compress(const uint8_t* src, size_t src_len, uint8_t* dst, size_t dst_cap);
+
+// Decompress exactly dst_len bytes. Malformed input (bad offsets, overruns,
+// wrong decoded size) returns STATUS_CORRUPTION and never reads or writes
+// out of bounds.
+status_t lz4_decompress(const uint8_t* src, size_t src_len, uint8_t* dst, size_t dst_len);
+
+#endif // LZ4_H
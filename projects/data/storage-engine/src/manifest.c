@@ -101,21 +101,30 @@ static status_t manifest_append(const char* db_path, uint8_t type,
     return (written == (ssize_t)record_size) ? STATUS_OK : STATUS_IO_ERROR;
 }
 
-// Log add file
-status_t manifest_log_add_file(const char* db_path, int level, uint64_t file_num) {
-    uint8_t data[12];
+// Helper: encode a (level, file number) record
+static void encode_file(uint8_t data[12], int level, uint64_t file_num) {
     uint32_t level32 = (uint32_t)level;
     memcpy(data, &level32, 4);
     memcpy(data + 4, &file_num, 8);
+}
+
+// Helper: encode a (file number, count) record
+static void encode_pair(uint8_t data[16], uint64_t file_num, uint64_t value) {
+    memcpy(data, &file_num, 8);
+    memcpy(data + 8, &value, 8);
+}
+
+// Log add file
+status_t manifest_log_add_file(const char* db_path, int level, uint64_t file_num) {
+    uint8_t data[12];
+    encode_file(data, level, file_num);
     return manifest_append(db_path, MANIFEST_ADD_FILE, data, 12);
 }
 
 // Log remove file
 status_t manifest_log_remove_file(const char* db_path, int level, uint64_t file_num) {
     uint8_t data[12];
-    uint32_t level32 = (uint32_t)level;
-    memcpy(data, &level32, 4);
-    memcpy(data + 4, &file_num, 8);
+    encode_file(data, level, file_num);
     return manifest_append(db_path, MANIFEST_REMOVE_FILE, data, 12);
 }
 
@@ -124,6 +133,172 @@ status_t manifest_log_next_file_num(const char* db_path, uint64_t next_num) {
     return manifest_append(db_path, MANIFEST_NEXT_FILE_NUM, &next_num, 8);
 }
 
+// Helper: append a (file number, count) record
+static status_t log_blob_pair(const char* db_path, uint8_t type,
+                              uint64_t file_num, uint64_t value) {
+    uint8_t data[16];
+    encode_pair(data, file_num, value);
+    return manifest_append(db_path, type, data, 16);
+}
+
+// Log new blob file
+status_t manifest_log_add_blob(const char* db_path, uint64_t file_num, uint64_t size) {
+    return log_blob_pair(db_path, MANIFEST_ADD_BLOB, file_num, size);
+}
+
+// Log blob garbage
+status_t manifest_log_blob_garbage(const char* db_path, uint64_t file_num, uint64_t bytes) {
+    return log_blob_pair(db_path, MANIFEST_BLOB_GARBAGE, file_num, bytes);
+}
+
+// Log remove blob file
+status_t manifest_log_remove_blob(const char* db_path, uint64_t file_num) {
+    return manifest_append(db_path, MANIFEST_REMOVE_BLOB, &file_num, 8);
+}
+
+// Helper: add a record to an edit
+static void edit_append(manifest_edit_t* edit, uint8_t type, const void* data, uint32_t len) {
+    if (!edit || edit->status != STATUS_OK) return;
+    size_t needed = edit->size + 5 + len;
+    if (needed > edit->cap) {
+        size_t new_cap = edit->cap ? edit->cap * 2 : 256;
+        while (new_cap < needed) new_cap *= 2;
+        uint8_t* buf = realloc(edit->buf, new_cap);
+        if (!buf) {
+            edit->status = STATUS_NO_MEMORY;
+            return;
+        }
+        edit->buf = buf;
+        edit->cap = new_cap;
+    }
+    edit->buf[edit->size] = type;
+    memcpy(edit->buf + edit->size + 1, &len, 4);
+    memcpy(edit->buf + edit->size + 5, data, len);
+    edit->size = needed;
+}
+
+void manifest_edit_add_file(manifest_edit_t* edit, int level, uint64_t file_num) {
+    uint8_t data[12];
+    encode_file(data, level, file_num);
+    edit_append(edit, MANIFEST_ADD_FILE, data, 12);
+}
+
+void manifest_edit_remove_file(manifest_edit_t* edit, int level, uint64_t file_num) {
+    uint8_t data[12];
+    encode_file(data, level, file_num);
+    edit_append(edit, MANIFEST_REMOVE_FILE, data, 12);
+}
+
+void manifest_edit_next_file_num(manifest_edit_t* edit, uint64_t next_num) {
+    edit_append(edit, MANIFEST_NEXT_FILE_NUM, &next_num, 8);
+}
+
+void manifest_edit_add_blob(manifest_edit_t* edit, uint64_t file_num, uint64_t size) {
+    uint8_t data[16];
+    encode_pair(data, file_num, size);
+    edit_append(edit, MANIFEST_ADD_BLOB, data, 16);
+}
+
+void manifest_edit_blob_garbage(manifest_edit_t* edit, uint64_t file_num, uint64_t bytes) {
+    uint8_t data[16];
+    encode_pair(data, file_num, bytes);
+    edit_append(edit, MANIFEST_BLOB_GARBAGE, data, 16);
+}
+
+// Log an edit as one record
+status_t manifest_log_edit(const char* db_path, const manifest_edit_t* edit) {
+    if (!db_path || !edit) return STATUS_INVALID_ARG;
+    if (edit->status != STATUS_OK) return edit->status;
+    if (edit->size == 0) return STATUS_OK;
+    return manifest_append(db_path, MANIFEST_EDIT, edit->buf, edit->size);
+}
+
+void manifest_edit_free(manifest_edit_t* edit) {
+    if (!edit) return;
+    free(edit->buf);
+    memset(edit, 0, sizeof(*edit));
+}
+
+// Helper: apply one record to the level manager
+static void apply_record(const char* db_path, level_manager_t* lm, uint8_t type,
+                         const uint8_t* data, uint32_t data_len) {
+    switch (type) {
+        case MANIFEST_ADD_FILE: {
+            if (data_len >= 12) {
+                uint32_t level;
+                uint64_t file_num;
+                memcpy(&level, data, 4);
+                memcpy(&file_num, data + 4, 8);
+
+                char sst_path[512];
+                snprintf(sst_path, sizeof(sst_path), "%s/%06llu.sst",
+                         db_path, (unsigned long long)file_num);
+
+                sstable_reader_t* reader = level_open_sstable(lm, sst_path);
+                if (reader) {
+                    level_add_sstable(lm, (int)level, file_num, sst_path, reader);
+                }
+            }
+            break;
+        }
+        case MANIFEST_REMOVE_FILE: {
+            if (data_len >= 12) {
+                uint32_t level;
+                uint64_t file_num;
+                memcpy(&level, data, 4);
+                memcpy(&file_num, data + 4, 8);
+                level_remove_sstable(lm, (int)level, file_num);
+            }
+            break;
+        }
+        case MANIFEST_NEXT_FILE_NUM: {
+            if (data_len >= 8) {
+                uint64_t next_num;
+                memcpy(&next_num, data, 8);
+                level_set_next_file_number(lm, next_num);
+            }
+            break;
+        }
+        case MANIFEST_ADD_BLOB:
+        case MANIFEST_BLOB_GARBAGE: {
+            if (data_len >= 16) {
+                uint64_t file_num, value;
+                memcpy(&file_num, data, 8);
+                memcpy(&value, data + 8, 8);
+                if (type == MANIFEST_ADD_BLOB) {
+                    level_add_blob_file(lm, file_num, value);
+                } else {
+                    level_add_blob_garbage(lm, file_num, value);
+                }
+            }
+            break;
+        }
+        case MANIFEST_REMOVE_BLOB: {
+            if (data_len >= 8) {
+                uint64_t file_num;
+                memcpy(&file_num, data, 8);
+                level_remove_blob_file(lm, file_num);
+            }
+            break;
+        }
+        case MANIFEST_EDIT: {
+            // Nested records (edits don't nest further)
+            uint32_t pos = 0;
+            while (data_len - pos >= 5) {
+                uint8_t sub_type = data[pos];
+                uint32_t sub_len;
+                memcpy(&sub_len, data + pos + 1, 4);
+                if (sub_len > data_len - pos - 5) break;
+                if (sub_type != MANIFEST_EDIT) {
+                    apply_record(db_path, lm, sub_type, data + pos + 5, sub_len);
+                }
+                pos += 5 + sub_len;
+            }
+            break;
+        }
+    }
+}
+
 // Recover from manifest
 status_t manifest_recover(const char* db_path, level_manager_t* lm) {
     if (!db_path || !lm) return STATUS_INVALID_ARG;
@@ -148,7 +323,7 @@ status_t manifest_recover(const char* db_path, level_manager_t* lm) {
                 char sst_path[512];
                 snprintf(sst_path, sizeof(sst_path), "%s/%s", db_path, entry->d_name);
 
-                sstable_reader_t* reader = sstable_reader_open(sst_path, lm->cmp);
+                sstable_reader_t* reader = level_open_sstable(lm, sst_path);
                 if (reader) {
                     // Add to L0 by default when no manifest
                     level_add_sstable(lm, 0, file_num, sst_path, reader);
@@ -205,45 +380,7 @@ status_t manifest_recover(const char* db_path, level_manager_t* lm) {
             return STATUS_CORRUPTION;
         }
 
-        // Process record
-        switch (type) {
-            case MANIFEST_ADD_FILE: {
-                if (data_len >= 12) {
-                    uint32_t level;
-                    uint64_t file_num;
-                    memcpy(&level, data, 4);
-                    memcpy(&file_num, data + 4, 8);
-
-                    char sst_path[512];
-                    snprintf(sst_path, sizeof(sst_path), "%s/%06llu.sst",
-                             db_path, (unsigned long long)file_num);
-
-                    sstable_reader_t* reader = sstable_reader_open(sst_path, lm->cmp);
-                    if (reader) {
-                        level_add_sstable(lm, (int)level, file_num, sst_path, reader);
-                    }
-                }
-                break;
-            }
-            case MANIFEST_REMOVE_FILE: {
-                if (data_len >= 12) {
-                    uint32_t level;
-                    uint64_t file_num;
-                    memcpy(&level, data, 4);
-                    memcpy(&file_num, data + 4, 8);
-                    level_remove_sstable(lm, (int)level, file_num);
-                }
-                break;
-            }
-            case MANIFEST_NEXT_FILE_NUM: {
-                if (data_len >= 8) {
-                    uint64_t next_num;
-                    memcpy(&next_num, data, 8);
-                    level_set_next_file_number(lm, next_num);
-                }
-                break;
-            }
-        }
+        apply_record(db_path, lm, type, data, data_len);
 
         free(data);
     }
@@ -9,13 +9,37 @@ typedef enum {
     MANIFEST_ADD_FILE = 1,
     MANIFEST_REMOVE_FILE = 2,
     MANIFEST_NEXT_FILE_NUM = 3,
+    MANIFEST_ADD_BLOB = 4,          // Blob file number + size
+    MANIFEST_BLOB_GARBAGE = 5,      // Blob file number + bytes no longer referenced
+    MANIFEST_REMOVE_BLOB = 6,
+    MANIFEST_EDIT = 7,              // Records above, applied all or none
 } manifest_record_type_t;
 
+// Several changes logged as one MANIFEST_EDIT record, so a crash never
+// leaves half of them (e.g. a compaction's outputs next to its inputs).
+// Payload: (type(1) | len(4) | data)* with the single-record layouts.
+typedef struct {
+    uint8_t* buf;
+    size_t size;
+    size_t cap;
+    status_t status;        // First encoding failure, reported by manifest_log_edit
+} manifest_edit_t;
+
 // Manifest operations
 status_t manifest_create(const char* db_path);
 status_t manifest_log_add_file(const char* db_path, int level, uint64_t file_num);
 status_t manifest_log_remove_file(const char* db_path, int level, uint64_t file_num);
 status_t manifest_log_next_file_num(const char* db_path, uint64_t next_num);
+status_t manifest_log_add_blob(const char* db_path, uint64_t file_num, uint64_t size);
+status_t manifest_log_blob_garbage(const char* db_path, uint64_t file_num, uint64_t bytes);
+status_t manifest_log_remove_blob(const char* db_path, uint64_t file_num);
+void manifest_edit_add_file(manifest_edit_t* edit, int level, uint64_t file_num);
+void manifest_edit_remove_file(manifest_edit_t* edit, int level, uint64_t file_num);
+void manifest_edit_next_file_num(manifest_edit_t* edit, uint64_t next_num);
+void manifest_edit_add_blob(manifest_edit_t* edit, uint64_t file_num, uint64_t size);
+void manifest_edit_blob_garbage(manifest_edit_t* edit, uint64_t file_num, uint64_t bytes);
+status_t manifest_log_edit(const char* db_path, const manifest_edit_t* edit);
+void manifest_edit_free(manifest_edit_t* edit);
 status_t manifest_recover(const char* db_path, level_manager_t* lm);
 
 #endif // STORAGE_MANIFEST_H
@@ -1,12 +1,13 @@
 #include "memtable.h"
 #include <stdlib.h>
+#include <string.h>
 
-// Create a new memtable
-memtable_t* memtable_create(size_t size_limit, compare_fn cmp) {
+// Helper: create a memtable over a single- or multi-writer skiplist
+static memtable_t* memtable_new(size_t size_limit, compare_fn cmp, bool concurrent) {
     memtable_t* mt = malloc(sizeof(memtable_t));
     if (!mt) return NULL;
 
-    mt->list = skiplist_create(cmp);
+    mt->list = concurrent ? skiplist_create_concurrent(cmp) : skiplist_create(cmp);
     if (!mt->list) {
         free(mt);
         return NULL;
@@ -14,18 +15,48 @@ memtable_t* memtable_create(size_t size_limit, compare_fn cmp) {
 
     mt->size_limit = size_limit > 0 ? size_limit : MEMTABLE_SIZE_LIMIT;
     mt->seq_num = 0;
+    mt->refs = 1;
+    mt->range_dels = NULL;
 
     return mt;
 }
 
+// Create a new memtable
+memtable_t* memtable_create(size_t size_limit, compare_fn cmp) {
+    return memtable_new(size_limit, cmp, false);
+}
+
+// Create a memtable that accepts concurrent writers
+memtable_t* memtable_create_concurrent(size_t size_limit, compare_fn cmp) {
+    return memtable_new(size_limit, cmp, true);
+}
+
 // Destroy memtable
 void memtable_destroy(memtable_t* mt) {
     if (mt) {
+        memtable_range_del_t* rd = mt->range_dels;
+        while (rd) {
+            memtable_range_del_t* next = rd->next;
+            free(rd);
+            rd = next;
+        }
         skiplist_destroy(mt->list);
         free(mt);
     }
 }
 
+// Take a reference
+void memtable_ref(memtable_t* mt) {
+    if (mt) __atomic_add_fetch(&mt->refs, 1, __ATOMIC_RELAXED);
+}
+
+// Drop a reference
+void memtable_unref(memtable_t* mt) {
+    if (mt && __atomic_sub_fetch(&mt->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        memtable_destroy(mt);
+    }
+}
+
 // Put a key-value pair
 status_t memtable_put(memtable_t* mt, const char* key, size_t key_len,
                       const char* value, size_t value_len) {
@@ -46,12 +77,122 @@ status_t memtable_delete(memtable_t* mt, const char* key, size_t key_len) {
     return skiplist_delete(mt->list, key, key_len);
 }
 
+// Delete a key range
+status_t memtable_delete_range(memtable_t* mt, const char* begin, size_t begin_len,
+                               const char* end, size_t end_len) {
+    if (!mt || !begin || !end) return STATUS_INVALID_ARG;
+    compare_fn cmp = mt->list->compare;
+    if (cmp(begin, begin_len, end, end_len) >= 0) return STATUS_INVALID_ARG;
+
+    // Entries of this memtable are as new as the tombstone, so it cannot
+    // hide them: overwrite the ones in range with point tombstones
+    skiplist_iter_t* iter = skiplist_iter_create(mt->list);
+    if (!iter) return STATUS_NO_MEMORY;
+    status_t status = STATUS_OK;
+    for (skiplist_iter_seek(iter, begin, begin_len);
+         skiplist_iter_valid(iter); skiplist_iter_next(iter)) {
+        size_t key_len;
+        const char* key = skiplist_iter_key(iter, &key_len);
+        if (cmp(key, key_len, end, end_len) >= 0) break;
+        if (skiplist_iter_is_deleted(iter)) continue;
+        status = skiplist_delete(mt->list, key, key_len);
+        if (status != STATUS_OK) break;
+    }
+    skiplist_iter_destroy(iter);
+    if (status != STATUS_OK) return status;
+
+    memtable_range_del_t* rd = malloc(sizeof(memtable_range_del_t) + begin_len + end_len);
+    if (!rd) return STATUS_NO_MEMORY;
+    char* keys = (char*)(rd + 1);
+    memcpy(keys, begin, begin_len);
+    memcpy(keys + begin_len, end, end_len);
+    rd->t.begin = keys;
+    rd->t.begin_len = begin_len;
+    rd->t.end = keys + begin_len;
+    rd->t.end_len = end_len;
+    rd->next = mt->range_dels;
+
+    // Publish: readers load the head with acquire
+    __atomic_store_n(&mt->range_dels, rd, __ATOMIC_RELEASE);
+    return STATUS_OK;
+}
+
+// Check range tombstones for a key
+bool memtable_range_del_covers(memtable_t* mt, const char* key, size_t key_len) {
+    if (!mt) return false;
+    compare_fn cmp = mt->list->compare;
+    for (memtable_range_del_t* rd = __atomic_load_n(&mt->range_dels, __ATOMIC_ACQUIRE);
+         rd; rd = rd->next) {
+        if (cmp(rd->t.begin, rd->t.begin_len, key, key_len) <= 0 &&
+            cmp(key, key_len, rd->t.end, rd->t.end_len) < 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Collect range tombstones
+status_t memtable_collect_range_dels(memtable_t* mt, range_del_list_t* list) {
+    if (!mt || !list) return STATUS_INVALID_ARG;
+    for (memtable_range_del_t* rd = __atomic_load_n(&mt->range_dels, __ATOMIC_ACQUIRE);
+         rd; rd = rd->next) {
+        status_t status = range_del_list_add(list, &rd->t);
+        if (status != STATUS_OK) return status;
+    }
+    return STATUS_OK;
+}
+
+// Check if the memtable has anything in [min_key, max_key]
+bool memtable_overlaps(memtable_t* mt, const char* min_key, size_t min_key_len,
+                       const char* max_key, size_t max_key_len) {
+    if (!mt) return false;
+    compare_fn cmp = mt->list->compare;
+    for (memtable_range_del_t* rd = __atomic_load_n(&mt->range_dels, __ATOMIC_ACQUIRE);
+         rd; rd = rd->next) {
+        if (cmp(rd->t.begin, rd->t.begin_len, max_key, max_key_len) <= 0 &&
+            cmp(min_key, min_key_len, rd->t.end, rd->t.end_len) < 0) {
+            return true;
+        }
+    }
+
+    // Without an iterator, assume the worst
+    memtable_iter_t* iter = memtable_iter_create(mt);
+    if (!iter) return true;
+    memtable_iter_seek(iter, min_key, min_key_len);
+    bool overlaps = false;
+    if (memtable_iter_valid(iter)) {
+        size_t key_len;
+        const char* key = memtable_iter_key(iter, &key_len);
+        overlaps = cmp(key, key_len, max_key, max_key_len) <= 0;
+    }
+    memtable_iter_destroy(iter);
+    return overlaps;
+}
+
+// Check if key has an entry (live or tombstone)
+bool memtable_contains(memtable_t* mt, const char* key, size_t key_len) {
+    return mt && skiplist_contains(mt->list, key, key_len);
+}
+
+// Get the entry for a key (live or tombstone)
+status_t memtable_get_entry(memtable_t* mt, const char* key, size_t key_len,
+                            char** value, size_t* value_len, bool* deleted) {
+    if (!mt) return STATUS_INVALID_ARG;
+    return skiplist_get_entry(mt->list, key, key_len, value, value_len, deleted);
+}
+
 // Check if memtable should be flushed
 bool memtable_should_flush(memtable_t* mt) {
     if (!mt) return false;
     return skiplist_memory_usage(mt->list) >= mt->size_limit;
 }
 
+// Check for entries or range tombstones
+bool memtable_is_empty(memtable_t* mt) {
+    return !mt || (skiplist_count(mt->list) == 0 &&
+                   __atomic_load_n(&mt->range_dels, __ATOMIC_ACQUIRE) == NULL);
+}
+
 // Get count
 size_t memtable_count(memtable_t* mt) {
     return mt ? skiplist_count(mt->list) : 0;
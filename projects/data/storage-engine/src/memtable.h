@@ -4,18 +4,34 @@
 #include "types.h"
 #include "param.h"
 #include "skiplist.h"
+#include "range_del.h"
+
+// Range tombstone held by a memtable (keys stored after the struct)
+typedef struct memtable_range_del {
+    range_tombstone_t t;
+    struct memtable_range_del* next;
+} memtable_range_del_t;
 
 // MemTable structure
 struct memtable {
     skiplist_t* list;
     size_t size_limit;
     uint64_t seq_num;       // Current sequence number
+    int refs;               // Owners (storage slot, open iterators)
+    memtable_range_del_t* range_dels;   // Newest first, published atomically
 };
 
 // MemTable operations
+// Readers never block. A default memtable takes one writer at a time;
+// a concurrent one accepts inserts from several threads at once.
 memtable_t* memtable_create(size_t size_limit, compare_fn cmp);
+memtable_t* memtable_create_concurrent(size_t size_limit, compare_fn cmp);
 void memtable_destroy(memtable_t* mt);
 
+// Reference counting (memtable_unref destroys on the last reference)
+void memtable_ref(memtable_t* mt);
+void memtable_unref(memtable_t* mt);
+
 // Basic operations
 status_t memtable_put(memtable_t* mt, const char* key, size_t key_len,
                       const char* value, size_t value_len);
@@ -23,9 +39,35 @@ status_t memtable_get(memtable_t* mt, const char* key, size_t key_len,
                       char** value, size_t* value_len);
 status_t memtable_delete(memtable_t* mt, const char* key, size_t key_len);
 
+// Delete every key in [begin, end): keys already in the memtable become
+// point tombstones, and the range tombstone hides the older sources.
+// Same single-writer rule as memtable_put.
+status_t memtable_delete_range(memtable_t* mt, const char* begin, size_t begin_len,
+                               const char* end, size_t end_len);
+
+// Check if a range tombstone of this memtable deletes key
+bool memtable_range_del_covers(memtable_t* mt, const char* key, size_t key_len);
+
+// Append the range tombstones to list (they point into the memtable)
+status_t memtable_collect_range_dels(memtable_t* mt, range_del_list_t* list);
+
+// Check if any entry or range tombstone falls in [min_key, max_key]
+bool memtable_overlaps(memtable_t* mt, const char* min_key, size_t min_key_len,
+                       const char* max_key, size_t max_key_len);
+
+// Check if key has an entry, including tombstones
+bool memtable_contains(memtable_t* mt, const char* key, size_t key_len);
+
+// Get the entry for a key, including tombstones (*deleted tells which)
+status_t memtable_get_entry(memtable_t* mt, const char* key, size_t key_len,
+                            char** value, size_t* value_len, bool* deleted);
+
 // Check if memtable should be flushed
 bool memtable_should_flush(memtable_t* mt);
 
+// Check if memtable holds nothing to flush
+bool memtable_is_empty(memtable_t* mt);
+
 // Get statistics
 size_t memtable_count(memtable_t* mt);
 size_t memtable_memory_usage(memtable_t* mt);
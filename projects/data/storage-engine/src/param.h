@@ -9,15 +9,23 @@
 #define MEMTABLE_SIZE_LIMIT     (4 * 1024 * 1024)   // 4 MB
 #define SKIPLIST_MAX_LEVEL      12
 #define SKIPLIST_P              0.25                 // Probability for level promotion
+#define SKIPLIST_P_BITS         2                    // log2(1 / SKIPLIST_P): random bits per level
+#define ARENA_BLOCK_SIZE        4096                 // Arena block size for memtable data
 
 // WAL parameters
 #define WAL_BLOCK_SIZE          32768               // 32 KB
 #define WAL_HEADER_SIZE         12                  // length(4) + crc32(4) + type(4)
+#define WAL_GROUP_MAX_BYTES     (1024 * 1024)       // Max key+value bytes per group commit
 
 // SSTable parameters
 #define SSTABLE_BLOCK_SIZE      4096                // 4 KB
 #define SSTABLE_RESTART_INTERVAL 16                 // Keys between restart points
 #define BLOOM_BITS_PER_KEY      10                  // Bloom filter bits per key
+#define BLOOM_BLOCKED           1                   // New filters keep each key in one cache line
+#define SSTABLE_HASH_UTIL_RATIO 0.75                // Keys per bucket in the data block hash index
+#define SSTABLE_PARTITION_BLOCKS 64                 // Data blocks per index/filter partition
+#define SSTABLE_PARTITION_MIN_ENTRIES (256 * 1024)  // Larger tables get partitioned index/filters
+#define SSTABLE_MIN_COMPRESSION_RATIO 0.875         // Blocks that compress worse are stored raw
 
 // Level parameters
 #define MAX_LEVELS              7
@@ -26,16 +34,34 @@
 #define L0_STOP_TRIGGER         12                  // Stop writes when L0 has 12 files
 #define LEVEL_SIZE_MULTIPLIER   10                  // Each level is 10x larger than previous
 #define L1_MAX_BYTES            (10 * 1024 * 1024)  // 10 MB for L1
+#define COMPACTION_PICK_WINDOW  8                   // L1+ files after the cursor weighed per pick
+#define MAX_SUBCOMPACTIONS      4                   // Key ranges merged in parallel per compaction
+#define SUBCOMPACTION_MIN_BLOCKS 64                 // Data blocks per range (smaller: fewer ranges)
+#define TARGET_FILE_SIZE_BASE   (2 * 1024 * 1024)   // 2 MB compaction output files in L1
+#define TARGET_FILE_SIZE_MULTIPLIER 2               // Each level's files are 2x larger
+
+// Blob file parameters
+#define BLOB_GC_RATIO           0.5                 // Compaction relocates values out of blob
+                                                    // files that are at least this much garbage
 
 // Cache parameters
 #define BLOCK_CACHE_SIZE        (8 * 1024 * 1024)   // 8 MB default cache size
+#define CACHE_MAX_SHARD_BITS    4                   // At most 16 shards
+#define CACHE_MIN_SHARD_SIZE    (512 * 1024)        // Don't split below 512 KB per shard
 
 // Storage options
 typedef struct {
     size_t memtable_size;       // MemTable size limit
     size_t block_cache_size;    // Block cache size
     bool sync_writes;           // Sync WAL on every write
+    bool use_mmap_reads;        // Map SSTables instead of read() per block
+    compression_t compression;  // Data block codec for new SSTables
+    int max_subcompactions;     // Parallel key ranges per compaction (1: serial)
+    size_t target_file_size;    // L1 compaction output file size (0: default)
+    size_t blob_min_size;       // Values this large go to blob files (0: inline)
     compare_fn comparator;      // Key comparator
+    prefix_extractor_fn prefix_extractor;   // Filters also hold key prefixes (NULL: off)
+    const char* prefix_extractor_name;      // Required with it; change it with the extractor
 } storage_opts_t;
 
 // Default options
@@ -43,7 +69,14 @@ typedef struct {
     .memtable_size = MEMTABLE_SIZE_LIMIT, \
     .block_cache_size = BLOCK_CACHE_SIZE, \
     .sync_writes = false, \
-    .comparator = NULL \
+    .use_mmap_reads = false, \
+    .compression = COMPRESSION_NONE, \
+    .max_subcompactions = MAX_SUBCOMPACTIONS, \
+    .target_file_size = TARGET_FILE_SIZE_BASE, \
+    .blob_min_size = 0, \
+    .comparator = NULL, \
+    .prefix_extractor = NULL, \
+    .prefix_extractor_name = NULL \
 }
 
 #endif // STORAGE_PARAM_H
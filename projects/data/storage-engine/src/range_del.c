@@ -0,0 +1,124 @@
+#include "range_del.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Helper: encode varint
+static size_t encode_varint(uint8_t* buf, uint64_t value) {
+    size_t i = 0;
+    while (value >= 0x80) {
+        buf[i++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    buf[i++] = (uint8_t)value;
+    return i;
+}
+
+// Helper: decode varint
+static size_t decode_varint(const uint8_t* buf, size_t len, uint64_t* value) {
+    *value = 0;
+    size_t i = 0;
+    int shift = 0;
+    while (i < len && i < 10) {
+        uint64_t byte = buf[i++];
+        *value |= (byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return i;
+        shift += 7;
+    }
+    return 0;
+}
+
+status_t range_del_list_add(range_del_list_t* list, const range_tombstone_t* t) {
+    if (!list || !t) return STATUS_INVALID_ARG;
+    if (list->count >= list->capacity) {
+        size_t new_cap = list->capacity ? list->capacity * 2 : 4;
+        range_tombstone_t* items = realloc(list->items, new_cap * sizeof(range_tombstone_t));
+        if (!items) return STATUS_NO_MEMORY;
+        list->items = items;
+        list->capacity = new_cap;
+    }
+    list->items[list->count++] = *t;
+    return STATUS_OK;
+}
+
+status_t range_del_list_append(range_del_list_t* list, const range_del_list_t* other) {
+    if (!list) return STATUS_INVALID_ARG;
+    if (!other) return STATUS_OK;
+    for (size_t i = 0; i < other->count; i++) {
+        status_t status = range_del_list_add(list, &other->items[i]);
+        if (status != STATUS_OK) return status;
+    }
+    return STATUS_OK;
+}
+
+void range_del_list_free(range_del_list_t* list) {
+    if (!list) return;
+    free(list->items);
+    list->items = NULL;
+    list->count = 0;
+    list->capacity = 0;
+}
+
+// Linear scan: range deletes are rare, lists stay short
+bool range_del_covers(const range_del_list_t* list, compare_fn cmp,
+                      const char* key, size_t key_len) {
+    if (!list) return false;
+    for (size_t i = 0; i < list->count; i++) {
+        const range_tombstone_t* t = &list->items[i];
+        if (cmp(t->begin, t->begin_len, key, key_len) <= 0 &&
+            cmp(key, key_len, t->end, t->end_len) < 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Helper: make room for n more bytes
+static bool reserve(uint8_t** buf, size_t* cap, size_t needed) {
+    if (needed <= *cap) return true;
+    size_t new_cap = *cap ? *cap * 2 : 256;
+    while (new_cap < needed) new_cap *= 2;
+    uint8_t* p = realloc(*buf, new_cap);
+    if (!p) return false;
+    *buf = p;
+    *cap = new_cap;
+    return true;
+}
+
+status_t range_del_encode(uint8_t** buf, size_t* len, size_t* cap,
+                          const range_tombstone_t* t) {
+    if (!reserve(buf, cap, *len + 20 + t->begin_len + t->end_len)) return STATUS_NO_MEMORY;
+    uint8_t* p = *buf + *len;
+    p += encode_varint(p, t->begin_len);
+    memcpy(p, t->begin, t->begin_len);
+    p += t->begin_len;
+    p += encode_varint(p, t->end_len);
+    memcpy(p, t->end, t->end_len);
+    p += t->end_len;
+    *len = (size_t)(p - *buf);
+    return STATUS_OK;
+}
+
+bool range_del_decode(const uint8_t* buf, size_t len, range_del_list_t* list) {
+    uint64_t count;
+    size_t pos = decode_varint(buf, len, &count);
+    if (pos == 0) return false;
+
+    for (uint64_t i = 0; i < count; i++) {
+        range_tombstone_t t;
+        uint64_t n;
+        size_t m = decode_varint(buf + pos, len - pos, &n);
+        if (m == 0 || n > len - pos - m) return false;
+        t.begin = (const char*)buf + pos + m;
+        t.begin_len = (size_t)n;
+        pos += m + n;
+
+        m = decode_varint(buf + pos, len - pos, &n);
+        if (m == 0 || n > len - pos - m) return false;
+        t.end = (const char*)buf + pos + m;
+        t.end_len = (size_t)n;
+        pos += m + n;
+
+        if (range_del_list_add(list, &t) != STATUS_OK) return false;
+    }
+    return pos == len;
+}
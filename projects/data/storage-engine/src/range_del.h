@@ -0,0 +1,45 @@
+#ifndef STORAGE_RANGE_DEL_H
+#define STORAGE_RANGE_DEL_H
+
+#include "types.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Range tombstone: deletes every key in [begin, end).
+// There are no sequence numbers, so a tombstone only ever covers entries of
+// sources older than the one holding it (memtable, SSTable): a memtable
+// turns its own keys in the range into point tombstones when the range
+// delete arrives, and compaction drops the entries a tombstone covers.
+typedef struct {
+    const char* begin;
+    size_t begin_len;
+    const char* end;
+    size_t end_len;
+} range_tombstone_t;
+
+// List of tombstones. Only the pointers are stored: the memtable or reader
+// holding the keys must outlive the list.
+typedef struct {
+    range_tombstone_t* items;
+    size_t count;
+    size_t capacity;
+} range_del_list_t;
+
+status_t range_del_list_add(range_del_list_t* list, const range_tombstone_t* t);
+status_t range_del_list_append(range_del_list_t* list, const range_del_list_t* other);
+void range_del_list_free(range_del_list_t* list);
+
+// Check if any tombstone in the list deletes key
+bool range_del_covers(const range_del_list_t* list, compare_fn cmp,
+                      const char* key, size_t key_len);
+
+// SSTable range-deletion block payload:
+//   count (varint) | (begin_len (varint) | begin | end_len (varint) | end)*
+// Append one tombstone to an encoded payload (without the count)
+status_t range_del_encode(uint8_t** buf, size_t* len, size_t* cap,
+                          const range_tombstone_t* t);
+// Decode a payload; the tombstones point into buf
+bool range_del_decode(const uint8_t* buf, size_t len, range_del_list_t* list);
+
+#endif // STORAGE_RANGE_DEL_H
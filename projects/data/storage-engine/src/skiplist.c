@@ -1,6 +1,7 @@
 #include "skiplist.h"
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include <time.h>
 
 // Default comparison function (lexicographic)
@@ -14,59 +15,93 @@ int default_compare(const char* a, size_t a_len,
     return 0;
 }
 
+// Helper: xorshift64* step
+static inline uint64_t xorshift64(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+// Helper: seed for a new list; distinct lists get distinct sequences
+static uint64_t make_seed(const void* salt) {
+    static uint64_t counter = 0;
+    uint64_t seed = (uint64_t)time(NULL) ^ (uint64_t)(uintptr_t)salt ^
+                    (__atomic_add_fetch(&counter, 1, __ATOMIC_RELAXED) *
+                     0x9E3779B97F4A7C15ULL);
+    return seed ? seed : 1;  // xorshift state must not be zero
+}
+
+// Per-thread generator for concurrent lists, so writers don't share state
+static __thread uint64_t tls_rng_state = 0;
+
 // Generate random level for new node
-static int random_level(void) {
-    static int seeded = 0;
-    if (!seeded) {
-        srand((unsigned int)time(NULL));
-        seeded = 1;
+// Each level is kept with probability SKIPLIST_P, i.e. when the next
+// SKIPLIST_P_BITS random bits are all zero: count trailing zero bits.
+static int random_level(skiplist_t* list) {
+    uint64_t r;
+    if (list->concurrent) {
+        if (tls_rng_state == 0) {
+            tls_rng_state = list->rng_state ^ make_seed(&tls_rng_state);
+            if (tls_rng_state == 0) tls_rng_state = 1;
+        }
+        r = xorshift64(&tls_rng_state);
+    } else {
+        r = xorshift64(&list->rng_state);
     }
 
-    int level = 1;
-    while ((rand() / (double)RAND_MAX) < SKIPLIST_P &&
-           level < SKIPLIST_MAX_LEVEL) {
-        level++;
-    }
-    return level;
+    // The top bit bounds the count even for r == 0
+    int zeros = __builtin_ctzll(r | (1ULL << 63));
+    int level = 1 + zeros / SKIPLIST_P_BITS;
+    return level < SKIPLIST_MAX_LEVEL ? level : SKIPLIST_MAX_LEVEL;
 }
 
-// Create a new node
-static skiplist_node_t* create_node(int level, const char* key, size_t key_len,
-                                    const char* value, size_t value_len) {
-    skiplist_node_t* node = malloc(sizeof(skiplist_node_t));
-    if (!node) return NULL;
+// Helper: atomic accessors for links shared with readers
+static inline skiplist_node_t* load_next(skiplist_node_t* node, int i) {
+    return __atomic_load_n(&node->forward[i], __ATOMIC_ACQUIRE);
+}
 
-    node->forward = malloc(sizeof(skiplist_node_t*) * level);
-    if (!node->forward) {
-        free(node);
-        return NULL;
-    }
+static inline skiplist_value_t* load_value(skiplist_node_t* node) {
+    return __atomic_load_n(&node->value, __ATOMIC_ACQUIRE);
+}
 
-    node->key = malloc(key_len);
-    if (!node->key) {
-        free(node->forward);
-        free(node);
-        return NULL;
+static inline int load_level(skiplist_t* list) {
+    return __atomic_load_n(&list->level, __ATOMIC_RELAXED);
+}
+
+// Helper: build a value record in the arena
+static skiplist_value_t* create_value(skiplist_t* list, const char* value,
+                                      size_t value_len, bool deleted) {
+    if (!value) value_len = 0;
+
+    skiplist_value_t* v = arena_alloc_aligned(list->arena,
+                                              sizeof(skiplist_value_t) + value_len);
+    if (!v) return NULL;
+
+    v->len = value_len;
+    v->deleted = deleted;
+    if (value_len > 0) {
+        memcpy(v->data, value, value_len);
     }
+    return v;
+}
+
+// Create a new node in the list's arena (not yet linked)
+static skiplist_node_t* create_node(skiplist_t* list, int level,
+                                    const char* key, size_t key_len,
+                                    skiplist_value_t* value) {
+    skiplist_node_t* node = arena_alloc_aligned(
+        list->arena, sizeof(skiplist_node_t) + sizeof(skiplist_node_t*) * level);
+    if (!node) return NULL;
+
+    node->key = arena_alloc(list->arena, key_len);
+    if (!node->key) return NULL;
     memcpy(node->key, key, key_len);
     node->key_len = key_len;
 
-    if (value && value_len > 0) {
-        node->value = malloc(value_len);
-        if (!node->value) {
-            free(node->key);
-            free(node->forward);
-            free(node);
-            return NULL;
-        }
-        memcpy(node->value, value, value_len);
-        node->value_len = value_len;
-    } else {
-        node->value = NULL;
-        node->value_len = 0;
-    }
-
-    node->deleted = false;
+    node->value = value;
     node->level = level;
 
     for (int i = 0; i < level; i++) {
@@ -76,31 +111,23 @@ static skiplist_node_t* create_node(int level, const char* key, size_t key_len,
     return node;
 }
 
-// Free a node
-static void free_node(skiplist_node_t* node) {
-    if (node) {
-        free(node->key);
-        free(node->value);
-        free(node->forward);
-        free(node);
-    }
-}
-
-// Create a new skip list
-skiplist_t* skiplist_create(compare_fn cmp) {
+// Helper: create a list in either mode
+static skiplist_t* skiplist_new(compare_fn cmp, bool concurrent) {
     skiplist_t* list = malloc(sizeof(skiplist_t));
     if (!list) return NULL;
 
-    // Create header node with max level
-    list->header = malloc(sizeof(skiplist_node_t));
-    if (!list->header) {
+    list->arena = concurrent ? arena_create_concurrent() : arena_create();
+    if (!list->arena) {
         free(list);
         return NULL;
     }
 
-    list->header->forward = malloc(sizeof(skiplist_node_t*) * SKIPLIST_MAX_LEVEL);
-    if (!list->header->forward) {
-        free(list->header);
+    // Header node with max level; kept out of the arena so an empty list
+    // doesn't hold a whole block
+    list->header = malloc(sizeof(skiplist_node_t) +
+                          sizeof(skiplist_node_t*) * SKIPLIST_MAX_LEVEL);
+    if (!list->header) {
+        arena_destroy(list->arena);
         free(list);
         return NULL;
     }
@@ -108,203 +135,209 @@ skiplist_t* skiplist_create(compare_fn cmp) {
     list->header->key = NULL;
     list->header->key_len = 0;
     list->header->value = NULL;
-    list->header->value_len = 0;
     list->header->level = SKIPLIST_MAX_LEVEL;
-
     for (int i = 0; i < SKIPLIST_MAX_LEVEL; i++) {
         list->header->forward[i] = NULL;
     }
 
     list->level = 1;
     list->count = 0;
-    list->memory_usage = sizeof(skiplist_t) + sizeof(skiplist_node_t) +
-                         sizeof(skiplist_node_t*) * SKIPLIST_MAX_LEVEL;
     list->compare = cmp ? cmp : default_compare;
+    list->concurrent = concurrent;
+    list->rng_state = make_seed(list);
 
     return list;
 }
 
+// Create a new skip list (single writer)
+skiplist_t* skiplist_create(compare_fn cmp) {
+    return skiplist_new(cmp, false);
+}
+
+// Create a new skip list that accepts concurrent writers
+skiplist_t* skiplist_create_concurrent(compare_fn cmp) {
+    return skiplist_new(cmp, true);
+}
+
 // Destroy skip list and free all memory
 void skiplist_destroy(skiplist_t* list) {
     if (!list) return;
 
-    skiplist_node_t* node = list->header->forward[0];
-    while (node) {
-        skiplist_node_t* next = node->forward[0];
-        free_node(node);
-        node = next;
-    }
-
-    free(list->header->forward);
+    arena_destroy(list->arena);
     free(list->header);
     free(list);
 }
 
-// Insert or update a key-value pair
-status_t skiplist_put(skiplist_t* list, const char* key, size_t key_len,
-                      const char* value, size_t value_len) {
-    if (!list || !key || key_len == 0) return STATUS_INVALID_ARG;
+// Helper: starting at before (whose key is < key), advance along level i
+// and return the last node with key < key; *after is its successor
+static skiplist_node_t* find_at_level(skiplist_t* list, skiplist_node_t* before,
+                                      int i, const char* key, size_t key_len,
+                                      skiplist_node_t** after) {
+    skiplist_node_t* next = load_next(before, i);
+    while (next && list->compare(next->key, next->key_len, key, key_len) < 0) {
+        before = next;
+        next = load_next(before, i);
+    }
+    *after = next;
+    return before;
+}
 
-    skiplist_node_t* update[SKIPLIST_MAX_LEVEL];
+// Helper: find the first node with key >= key
+static skiplist_node_t* find_greater_or_equal(skiplist_t* list,
+                                              const char* key, size_t key_len) {
     skiplist_node_t* x = list->header;
+    skiplist_node_t* next = NULL;
 
-    // Find position for insertion
-    for (int i = list->level - 1; i >= 0; i--) {
-        while (x->forward[i] &&
-               list->compare(x->forward[i]->key, x->forward[i]->key_len,
-                           key, key_len) < 0) {
-            x = x->forward[i];
-        }
-        update[i] = x;
+    for (int i = load_level(list) - 1; i >= 0; i--) {
+        x = find_at_level(list, x, i, key, key_len, &next);
     }
+    return next;
+}
 
-    x = x->forward[0];
-
-    // Key exists - update value
-    if (x && list->compare(x->key, x->key_len, key, key_len) == 0) {
-        // Update memory usage
-        list->memory_usage -= x->value_len;
-
-        free(x->value);
-        if (value && value_len > 0) {
-            x->value = malloc(value_len);
-            if (!x->value) return STATUS_NO_MEMORY;
-            memcpy(x->value, value, value_len);
-            x->value_len = value_len;
-        } else {
-            x->value = NULL;
-            x->value_len = 0;
-        }
-        x->deleted = false;
-
-        list->memory_usage += value_len;
-        return STATUS_OK;
-    }
+// Helper: publish a new value record on an existing node
+static void set_value(skiplist_node_t* node, skiplist_value_t* value) {
+    __atomic_store_n(&node->value, value, __ATOMIC_RELEASE);
+}
 
-    // Insert new node
-    int new_level = random_level();
-    if (new_level > list->level) {
-        for (int i = list->level; i < new_level; i++) {
-            update[i] = list->header;
+// Helper: raise the list height to at least level
+static void raise_level(skiplist_t* list, int level) {
+    int cur = load_level(list);
+    while (level > cur) {
+        if (__atomic_compare_exchange_n(&list->level, &cur, level, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            break;
         }
-        list->level = new_level;
     }
+}
 
-    skiplist_node_t* new_node = create_node(new_level, key, key_len, value, value_len);
-    if (!new_node) return STATUS_NO_MEMORY;
-
-    for (int i = 0; i < new_level; i++) {
-        new_node->forward[i] = update[i]->forward[i];
-        update[i]->forward[i] = new_node;
+// Helper: link node at level i between prev and next.
+// Returns false if a concurrent writer changed prev->forward[i] first.
+static bool link_at_level(skiplist_t* list, skiplist_node_t* prev,
+                          skiplist_node_t* next, skiplist_node_t* node, int i) {
+    __atomic_store_n(&node->forward[i], next, __ATOMIC_RELAXED);
+    if (!list->concurrent) {
+        __atomic_store_n(&prev->forward[i], node, __ATOMIC_RELEASE);
+        return true;
     }
-
-    list->count++;
-    list->memory_usage += sizeof(skiplist_node_t) +
-                          sizeof(skiplist_node_t*) * new_level +
-                          key_len + value_len;
-
-    return STATUS_OK;
+    return __atomic_compare_exchange_n(&prev->forward[i], &next, node, false,
+                                       __ATOMIC_RELEASE, __ATOMIC_RELAXED);
 }
 
-// Get value for a key
-status_t skiplist_get(skiplist_t* list, const char* key, size_t key_len,
-                      char** value, size_t* value_len) {
+// Helper: insert or replace the value record for key
+static status_t insert(skiplist_t* list, const char* key, size_t key_len,
+                       const char* value, size_t value_len, bool deleted) {
     if (!list || !key || key_len == 0) return STATUS_INVALID_ARG;
 
+    skiplist_value_t* v = create_value(list, value, value_len, deleted);
+    if (!v) return STATUS_NO_MEMORY;
+
+    // Find the splice (prev/next at each level) for the key. All levels are
+    // searched, since another writer may raise the height meanwhile.
+    skiplist_node_t* prev[SKIPLIST_MAX_LEVEL];
+    skiplist_node_t* next[SKIPLIST_MAX_LEVEL];
     skiplist_node_t* x = list->header;
+    for (int i = SKIPLIST_MAX_LEVEL - 1; i >= 0; i--) {
+        x = find_at_level(list, x, i, key, key_len, &next[i]);
+        prev[i] = x;
+    }
 
-    for (int i = list->level - 1; i >= 0; i--) {
-        while (x->forward[i] &&
-               list->compare(x->forward[i]->key, x->forward[i]->key_len,
-                           key, key_len) < 0) {
-            x = x->forward[i];
-        }
+    // Key exists - publish the new value (the old record stays in the
+    // arena until the memtable is dropped)
+    if (next[0] && list->compare(next[0]->key, next[0]->key_len, key, key_len) == 0) {
+        set_value(next[0], v);
+        return STATUS_OK;
     }
 
-    x = x->forward[0];
+    int new_level = random_level(list);
+    skiplist_node_t* node = create_node(list, new_level, key, key_len, v);
+    if (!node) return STATUS_NO_MEMORY;
+    raise_level(list, new_level);
 
-    if (x && list->compare(x->key, x->key_len, key, key_len) == 0) {
-        if (x->deleted) {
-            return STATUS_NOT_FOUND;
-        }
-        if (value && value_len) {
-            *value = x->value;
-            *value_len = x->value_len;
+    // Link bottom-up: once level 0 is linked the node is visible, and
+    // higher levels only make it faster to find
+    for (int i = 0; i < new_level; i++) {
+        while (!link_at_level(list, prev[i], next[i], node, i)) {
+            // Lost a race: rescan this level from prev[i]
+            prev[i] = find_at_level(list, prev[i], i, key, key_len, &next[i]);
+            if (i == 0 && next[0] &&
+                list->compare(next[0]->key, next[0]->key_len, key, key_len) == 0) {
+                // Same key inserted concurrently: update that node instead
+                set_value(next[0], v);
+                return STATUS_OK;
+            }
         }
-        return STATUS_OK;
     }
 
-    return STATUS_NOT_FOUND;
+    __atomic_add_fetch(&list->count, 1, __ATOMIC_RELAXED);
+    return STATUS_OK;
 }
 
-// Mark a key as deleted (tombstone)
-status_t skiplist_delete(skiplist_t* list, const char* key, size_t key_len) {
-    if (!list || !key || key_len == 0) return STATUS_INVALID_ARG;
+// Insert or update a key-value pair
+status_t skiplist_put(skiplist_t* list, const char* key, size_t key_len,
+                      const char* value, size_t value_len) {
+    return insert(list, key, key_len, value, value_len, false);
+}
 
-    skiplist_node_t* x = list->header;
+// Get the entry for a key, including tombstones
+status_t skiplist_get_entry(skiplist_t* list, const char* key, size_t key_len,
+                            char** value, size_t* value_len, bool* deleted) {
+    if (!list || !key || key_len == 0) return STATUS_INVALID_ARG;
 
-    for (int i = list->level - 1; i >= 0; i--) {
-        while (x->forward[i] &&
-               list->compare(x->forward[i]->key, x->forward[i]->key_len,
-                           key, key_len) < 0) {
-            x = x->forward[i];
-        }
+    skiplist_node_t* x = find_greater_or_equal(list, key, key_len);
+    if (!x || list->compare(x->key, x->key_len, key, key_len) != 0) {
+        return STATUS_NOT_FOUND;
     }
 
-    x = x->forward[0];
-
-    if (x && list->compare(x->key, x->key_len, key, key_len) == 0) {
-        x->deleted = true;
-        return STATUS_OK;
+    skiplist_value_t* v = load_value(x);
+    if (deleted) *deleted = v->deleted;
+    if (value && value_len) {
+        *value = v->len > 0 ? v->data : NULL;
+        *value_len = v->len;
     }
+    return STATUS_OK;
+}
 
-    // Key not found - insert tombstone
-    status_t status = skiplist_put(list, key, key_len, NULL, 0);
+// Get value for a key
+status_t skiplist_get(skiplist_t* list, const char* key, size_t key_len,
+                      char** value, size_t* value_len) {
+    char* v = NULL;
+    size_t v_len = 0;
+    bool deleted = false;
+    status_t status = skiplist_get_entry(list, key, key_len, &v, &v_len, &deleted);
     if (status != STATUS_OK) return status;
+    if (deleted) return STATUS_NOT_FOUND;
 
-    // Mark the newly inserted node as deleted
-    // Find the node we just inserted
-    x = list->header;
-    for (int i = list->level - 1; i >= 0; i--) {
-        while (x->forward[i] &&
-               list->compare(x->forward[i]->key, x->forward[i]->key_len,
-                           key, key_len) < 0) {
-            x = x->forward[i];
-        }
-    }
-    x = x->forward[0];
-    if (x && list->compare(x->key, x->key_len, key, key_len) == 0) {
-        x->deleted = true;
+    if (value && value_len) {
+        *value = v;
+        *value_len = v_len;
     }
     return STATUS_OK;
 }
 
+// Mark a key as deleted (tombstone)
+status_t skiplist_delete(skiplist_t* list, const char* key, size_t key_len) {
+    return insert(list, key, key_len, NULL, 0, true);
+}
+
 // Check if key exists (including tombstones)
 bool skiplist_contains(skiplist_t* list, const char* key, size_t key_len) {
     if (!list || !key || key_len == 0) return false;
 
-    skiplist_node_t* x = list->header;
-
-    for (int i = list->level - 1; i >= 0; i--) {
-        while (x->forward[i] &&
-               list->compare(x->forward[i]->key, x->forward[i]->key_len,
-                           key, key_len) < 0) {
-            x = x->forward[i];
-        }
-    }
-
-    x = x->forward[0];
+    skiplist_node_t* x = find_greater_or_equal(list, key, key_len);
     return x && list->compare(x->key, x->key_len, key, key_len) == 0;
 }
 
 // Get count
 size_t skiplist_count(skiplist_t* list) {
-    return list ? list->count : 0;
+    return list ? __atomic_load_n(&list->count, __ATOMIC_RELAXED) : 0;
 }
 
 // Get memory usage
 size_t skiplist_memory_usage(skiplist_t* list) {
-    return list ? list->memory_usage : 0;
+    if (!list) return 0;
+    return sizeof(skiplist_t) + sizeof(skiplist_node_t) +
+           sizeof(skiplist_node_t*) * SKIPLIST_MAX_LEVEL +
+           arena_memory_usage(list->arena);
 }
 
 // Create iterator
@@ -316,6 +349,7 @@ skiplist_iter_t* skiplist_iter_create(skiplist_t* list) {
 
     iter->list = list;
     iter->current = NULL;
+    iter->value = NULL;
 
     return iter;
 }
@@ -325,28 +359,23 @@ void skiplist_iter_destroy(skiplist_iter_t* iter) {
     free(iter);
 }
 
+// Helper: move to node and load its value record
+static void iter_set(skiplist_iter_t* iter, skiplist_node_t* node) {
+    iter->current = node;
+    iter->value = node ? load_value(node) : NULL;
+}
+
 // Seek to first entry
 void skiplist_iter_seek_to_first(skiplist_iter_t* iter) {
     if (iter && iter->list) {
-        iter->current = iter->list->header->forward[0];
+        iter_set(iter, load_next(iter->list->header, 0));
     }
 }
 
 // Seek to key (or first key >= target)
 void skiplist_iter_seek(skiplist_iter_t* iter, const char* key, size_t key_len) {
     if (!iter || !iter->list || !key || key_len == 0) return;
-
-    skiplist_node_t* x = iter->list->header;
-
-    for (int i = iter->list->level - 1; i >= 0; i--) {
-        while (x->forward[i] &&
-               iter->list->compare(x->forward[i]->key, x->forward[i]->key_len,
-                                  key, key_len) < 0) {
-            x = x->forward[i];
-        }
-    }
-
-    iter->current = x->forward[0];
+    iter_set(iter, find_greater_or_equal(iter->list, key, key_len));
 }
 
 // Check if iterator is valid
@@ -357,7 +386,7 @@ bool skiplist_iter_valid(skiplist_iter_t* iter) {
 // Move to next entry
 void skiplist_iter_next(skiplist_iter_t* iter) {
     if (iter && iter->current) {
-        iter->current = iter->current->forward[0];
+        iter_set(iter, load_next(iter->current, 0));
     }
 }
 
@@ -371,11 +400,11 @@ const char* skiplist_iter_key(skiplist_iter_t* iter, size_t* key_len) {
 // Get current value
 const char* skiplist_iter_value(skiplist_iter_t* iter, size_t* value_len) {
     if (!iter || !iter->current) return NULL;
-    if (value_len) *value_len = iter->current->value_len;
-    return iter->current->value;
+    if (value_len) *value_len = iter->value->len;
+    return iter->value->len > 0 ? iter->value->data : NULL;
 }
 
 // Check if current entry is deleted
 bool skiplist_iter_is_deleted(skiplist_iter_t* iter) {
-    return iter && iter->current && iter->current->deleted;
-}
\ No newline at end of file
+    return iter && iter->current && iter->value->deleted;
+}
@@ -3,16 +3,28 @@
 
 #include "types.h"
 #include "param.h"
+#include "arena.h"
+
+// Value record (immutable once published)
+// Updates and deletes publish a new record instead of modifying in place,
+// so readers always see a consistent (value, deleted) pair.
+typedef struct skiplist_value {
+    size_t len;
+    bool deleted;
+    char data[];
+} skiplist_value_t;
 
 // Skip list node
+// Nodes, keys and values live in the list's arena and are freed together.
+// Forward pointers and the value pointer are read with acquire loads and
+// published with release stores (or CAS in concurrent mode), so readers
+// never block and never see a half-linked node.
 typedef struct skiplist_node {
     char* key;
     size_t key_len;
-    char* value;
-    size_t value_len;
-    bool deleted;
+    skiplist_value_t* value;
     int level;
-    struct skiplist_node** forward;  // Array of forward pointers
+    struct skiplist_node* forward[];  // level forward pointers
 } skiplist_node_t;
 
 // Skip list structure
@@ -20,18 +32,27 @@ struct skiplist {
     skiplist_node_t* header;
     int level;                  // Current max level
     size_t count;               // Number of entries
-    size_t memory_usage;        // Approximate memory usage
+    arena_t* arena;             // Backing memory for all nodes
     compare_fn compare;
+    bool concurrent;            // Multi-writer mode (CAS-linked inserts)
+    uint64_t rng_state;         // xorshift state for node levels (single writer);
+                                // concurrent writers seed thread-local state from it
 };
 
 // Skip list iterator
+// Stays valid while other threads insert; it may or may not see entries
+// inserted after it was positioned.
 struct skiplist_iter {
     skiplist_t* list;
     skiplist_node_t* current;
+    skiplist_value_t* value;    // Value record of current, loaded once
 };
 
 // Skip list operations
+// A default list allows one writer at a time alongside any number of
+// readers; a concurrent list also allows several writers at once.
 skiplist_t* skiplist_create(compare_fn cmp);
+skiplist_t* skiplist_create_concurrent(compare_fn cmp);
 void skiplist_destroy(skiplist_t* list);
 
 // Insert or update a key-value pair
@@ -48,7 +69,12 @@ status_t skiplist_delete(skiplist_t* list, const char* key, size_t key_len);
 // Check if key exists (including tombstones)
 bool skiplist_contains(skiplist_t* list, const char* key, size_t key_len);
 
-// Get count and memory usage
+// Get the entry for a key, live or tombstone, in a single lookup
+// (returns STATUS_NOT_FOUND only if the key has no entry at all)
+status_t skiplist_get_entry(skiplist_t* list, const char* key, size_t key_len,
+                            char** value, size_t* value_len, bool* deleted);
+
+// Get count and memory usage (exact: list plus arena blocks)
 size_t skiplist_count(skiplist_t* list);
 size_t skiplist_memory_usage(skiplist_t* list);
 
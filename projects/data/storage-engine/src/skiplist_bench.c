@@ -0,0 +1,129 @@
+/*
+ * Skip List Insert Micro-benchmark
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <pthread.h>
+
+#include "skiplist.h"
+
+#define KEY_SIZE 16
+#define VALUE_SIZE 32
+#define MAX_THREADS 16
+
+// Get current time in microseconds
+static uint64_t now_usec(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+// Helper: scrambled key order, so inserts land all over the list
+static void make_key(char* buf, int index) {
+    uint32_t h = (uint32_t)index * 2654435761u;
+    snprintf(buf, KEY_SIZE, "k%08x%06u", h, (unsigned)index % 1000000u);
+}
+
+// Helper: print one result line
+static void print_result(const char* name, int count, uint64_t elapsed) {
+    double secs = elapsed / 1000000.0;
+    printf("  %-28s %10.0f ops/sec  (%d ops, %.3f sec)\n",
+           name, count / secs, count, secs);
+}
+
+// Benchmark: single writer inserts
+static void bench_insert(int count) {
+    skiplist_t* list = skiplist_create(NULL);
+    if (!list) return;
+
+    char key[KEY_SIZE];
+    char value[VALUE_SIZE];
+    memset(value, 'v', sizeof(value));
+
+    uint64_t start = now_usec();
+    for (int i = 0; i < count; i++) {
+        make_key(key, i);
+        skiplist_put(list, key, KEY_SIZE - 1, value, sizeof(value));
+    }
+    print_result("insert (single writer)", count, now_usec() - start);
+
+    // Level histogram sanity check: about 1 / SKIPLIST_P times fewer nodes
+    // at each higher level
+    size_t levels[SKIPLIST_MAX_LEVEL + 1] = {0};
+    for (skiplist_node_t* n = list->header->forward[0]; n; n = n->forward[0]) {
+        levels[n->level]++;
+    }
+    printf("  level histogram:");
+    for (int l = 1; l <= 6; l++) {
+        printf(" L%d=%zu", l, levels[l]);
+    }
+    printf("\n");
+
+    skiplist_destroy(list);
+}
+
+typedef struct {
+    skiplist_t* list;
+    int begin;
+    int end;
+} insert_arg_t;
+
+static void* insert_thread(void* arg) {
+    insert_arg_t* a = arg;
+    char key[KEY_SIZE];
+    char value[VALUE_SIZE];
+    memset(value, 'v', sizeof(value));
+
+    for (int i = a->begin; i < a->end; i++) {
+        make_key(key, i);
+        skiplist_put(a->list, key, KEY_SIZE - 1, value, sizeof(value));
+    }
+    return NULL;
+}
+
+// Benchmark: concurrent writers on a multi-writer list
+static void bench_concurrent_insert(int count, int threads) {
+    skiplist_t* list = skiplist_create_concurrent(NULL);
+    if (!list) return;
+
+    pthread_t tids[MAX_THREADS];
+    insert_arg_t args[MAX_THREADS];
+    int per_thread = count / threads;
+
+    uint64_t start = now_usec();
+    for (int t = 0; t < threads; t++) {
+        args[t].list = list;
+        args[t].begin = t * per_thread;
+        args[t].end = (t + 1) * per_thread;
+        pthread_create(&tids[t], NULL, insert_thread, &args[t]);
+    }
+    for (int t = 0; t < threads; t++) {
+        pthread_join(tids[t], NULL);
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "insert (%d writers)", threads);
+    print_result(name, per_thread * threads, now_usec() - start);
+
+    skiplist_destroy(list);
+}
+
+int main(int argc, char** argv) {
+    int count = 500000;
+    int threads = 4;
+    if (argc > 1) count = atoi(argv[1]);
+    if (argc > 2) threads = atoi(argv[2]);
+    if (count <= 0) count = 500000;
+    if (threads < 1 || threads > MAX_THREADS) threads = 4;
+
+    printf("Skip List Insert Benchmark\n");
+    printf("==========================\n\n");
+
+    bench_insert(count);
+    bench_concurrent_insert(count, threads);
+
+    return 0;
+}
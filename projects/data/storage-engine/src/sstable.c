@@ -1,11 +1,13 @@
 #include "sstable.h"
 #include "param.h"
 #include "crc32.h"
+#include "lz4.h"
 #include <stdlib.h>
 #include <string.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <stddef.h>
 
 // Helper: write all bytes to fd
@@ -21,14 +23,16 @@ static ssize_t write_all(int fd, const void* buf, size_t len) {
     return (ssize_t)len;
 }
 
-// Helper: read all bytes from fd
-static ssize_t read_all(int fd, void* buf, size_t len) {
+// Helper: read all bytes at offset. Positional reads leave the file offset
+// alone, so one reader can serve several threads at once.
+static ssize_t pread_all(int fd, void* buf, size_t len, uint64_t offset) {
     uint8_t* p = buf;
     size_t remaining = len;
     while (remaining > 0) {
-        ssize_t n = read(fd, p, remaining);
+        ssize_t n = pread(fd, p, remaining, (off_t)offset);
         if (n <= 0) return n == 0 ? (ssize_t)(len - remaining) : -1;
         p += n;
+        offset += n;
         remaining -= n;
     }
     return (ssize_t)len;
@@ -117,6 +121,9 @@ sstable_writer_t* sstable_writer_create(const char* path,
     w->restart_count = 0;
     w->entries_since_restart = SSTABLE_RESTART_INTERVAL;  // Force first restart
 
+    // The hash index matches keys by bytes, so it needs the bytewise order
+    w->hash_index = (SSTABLE_HASH_UTIL_RATIO > 0 && w->cmp == default_compare);
+
     // Initialize index
     w->index_capacity = 64;
     w->index = malloc(w->index_capacity * sizeof(sstable_index_entry_t));
@@ -130,16 +137,20 @@ sstable_writer_t* sstable_writer_create(const char* path,
     }
     w->index_count = 0;
 
-    // Create bloom filter
-    w->bloom = bloom_create(estimated_entries > 0 ? estimated_entries : 1000);
-    if (!w->bloom) {
-        free(w->index);
-        free(w->restarts);
-        free(w->block_buf);
-        close(w->fd);
-        free(w->path);
-        free(w);
-        return NULL;
+    // Create bloom filter (partitioned tables build one per partition)
+    w->estimated_entries = estimated_entries > 0 ? estimated_entries : 1000;
+    w->partitioned = (estimated_entries >= SSTABLE_PARTITION_MIN_ENTRIES);
+    if (!w->partitioned) {
+        w->bloom = bloom_create(w->estimated_entries);
+        if (!w->bloom) {
+            free(w->index);
+            free(w->restarts);
+            free(w->block_buf);
+            close(w->fd);
+            free(w->path);
+            free(w);
+            return NULL;
+        }
     }
 
     w->num_entries = 0;
@@ -152,6 +163,145 @@ sstable_writer_t* sstable_writer_create(const char* path,
     return w;
 }
 
+// Helper: keys the whole-table filter is sized for (every key may bring
+// a new prefix)
+static size_t filter_entries(sstable_writer_t* w) {
+    return w->prefix_extractor ? 2 * w->estimated_entries : w->estimated_entries;
+}
+
+status_t sstable_writer_set_partitioned(sstable_writer_t* w, bool enabled) {
+    if (!w || w->num_entries > 0) return STATUS_INVALID_ARG;
+
+    if (enabled) {
+        bloom_destroy(w->bloom);
+        w->bloom = NULL;
+    } else if (!w->bloom) {
+        w->bloom = bloom_create(filter_entries(w));
+        if (!w->bloom) return STATUS_NO_MEMORY;
+    }
+    w->partitioned = enabled;
+    return STATUS_OK;
+}
+
+status_t sstable_writer_set_prefix_extractor(sstable_writer_t* w, prefix_extractor_fn fn,
+                                             const char* name) {
+    if (!w || w->num_entries > 0) return STATUS_INVALID_ARG;
+
+    char* name_copy = NULL;
+    if (fn && name) {
+        name_copy = strdup(name);
+        if (!name_copy) return STATUS_NO_MEMORY;
+    }
+    free(w->prefix_name);
+    w->prefix_name = name_copy;
+    w->prefix_extractor = fn;
+    if (!w->partitioned) {
+        bloom_filter_t* bloom = bloom_create(filter_entries(w));
+        if (!bloom) return STATUS_NO_MEMORY;
+        bloom_destroy(w->bloom);
+        w->bloom = bloom;
+    }
+    return STATUS_OK;
+}
+
+// Helper: write the open partition's filter and start the next partition.
+// Its index partition is written by sstable_writer_finish.
+static status_t close_partition(sstable_writer_t* w) {
+    size_t num_blocks = w->index_count - w->part_first_block;
+    if (num_blocks == 0) return STATUS_OK;
+
+    if (w->part_count >= w->part_capacity) {
+        size_t new_cap = w->part_capacity ? w->part_capacity * 2 : 16;
+        sstable_partition_t* new_parts = realloc(w->parts, new_cap * sizeof(sstable_partition_t));
+        if (!new_parts) return STATUS_NO_MEMORY;
+        w->parts = new_parts;
+        w->part_capacity = new_cap;
+    }
+
+    bloom_filter_t* bf = bloom_create_format(w->part_hash_count, BLOOM_FORMAT_BLOCKED);
+    if (!bf) return STATUS_NO_MEMORY;
+    for (size_t i = 0; i < w->part_hash_count; i++) {
+        bloom_add_hash64(bf, w->part_hashes[i]);
+    }
+
+    size_t bloom_size = bloom_serialized_size(bf);
+    uint8_t* buf = malloc(bloom_size + 4);
+    if (!buf) {
+        bloom_destroy(bf);
+        return STATUS_NO_MEMORY;
+    }
+    bloom_serialize(bf, buf, bloom_size);
+    bloom_destroy(bf);
+    uint32_t crc = crc32c(buf, bloom_size);
+    memcpy(buf + bloom_size, &crc, 4);
+
+    if (write_all(w->fd, buf, bloom_size + 4) < 0) {
+        free(buf);
+        return STATUS_IO_ERROR;
+    }
+    free(buf);
+
+    sstable_partition_t* part = &w->parts[w->part_count++];
+    memset(part, 0, sizeof(*part));
+    part->first_block = (uint32_t)w->part_first_block;
+    part->num_blocks = (uint32_t)num_blocks;
+    part->filter_offset = w->file_offset;
+    part->filter_size = (uint32_t)(bloom_size + 4);
+    w->file_offset += bloom_size + 4;
+
+    w->part_hash_count = 0;
+    w->part_first_block = w->index_count;
+    w->has_last_prefix = false;     // The next partition's filter needs it again
+    return STATUS_OK;
+}
+
+status_t sstable_writer_set_compression(sstable_writer_t* w, compression_t compression) {
+    if (!w || (compression != COMPRESSION_NONE && compression != COMPRESSION_LZ4)) {
+        return STATUS_INVALID_ARG;
+    }
+    w->compression = compression;
+    return STATUS_OK;
+}
+
+uint64_t sstable_writer_file_size(sstable_writer_t* w) {
+    return w ? w->file_offset + w->block_offset : 0;
+}
+
+// Helper: compress the finished block contents into w->compress_buf.
+// Returns the compressed size, or 0 to store the block raw.
+static size_t compress_block(sstable_writer_t* w) {
+    // raw size (varint) | codec output, plus room for type and crc
+    size_t needed = 10 + lz4_compress_bound(w->block_offset) + 5;
+    if (needed > w->compress_cap) {
+        uint8_t* new_buf = realloc(w->compress_buf, needed);
+        if (!new_buf) return 0;
+        w->compress_buf = new_buf;
+        w->compress_cap = needed;
+    }
+
+    size_t n = encode_varint(w->compress_buf, w->block_offset);
+    size_t c = lz4_compress(w->block_buf, w->block_offset, w->compress_buf + n,
+                            w->compress_cap - n - 5);
+    if (c == 0 || n + c > w->block_offset * SSTABLE_MIN_COMPRESSION_RATIO) return 0;
+    return n + c;
+}
+
+void sstable_writer_set_hash_index(sstable_writer_t* w, bool enabled) {
+    if (w) w->hash_index = enabled && SSTABLE_HASH_UTIL_RATIO > 0 && w->cmp == default_compare;
+}
+
+// Helper: number of hash buckets for a block holding `keys` keys
+static size_t hash_bucket_count(size_t keys) {
+    return (size_t)(keys / SSTABLE_HASH_UTIL_RATIO) + 1;
+}
+
+// Helper: whether the current block gets a hash index
+static bool block_has_hash_index(sstable_writer_t* w) {
+    return w->hash_index && w->hash_count > 0 &&
+           w->restart_count <= SSTABLE_HASH_MAX_RESTARTS &&
+           hash_bucket_count(w->hash_count) <= UINT16_MAX;
+}
+
 // Helper: flush current block to file
 static status_t flush_block(sstable_writer_t* w, const char* last_key, size_t last_key_len) {
     if (w->block_offset == 0) return STATUS_OK;
@@ -163,18 +313,54 @@ static status_t flush_block(sstable_writer_t* w, const char* last_key, size_t la
         w->block_offset += 4;
     }
 
-    // Write number of restarts
     uint32_t num_restarts = (uint32_t)w->restart_count;
+
+    // Write the hash index: bucket -> restart interval of its key
+    if (block_has_hash_index(w)) {
+        uint16_t num_buckets = (uint16_t)hash_bucket_count(w->hash_count);
+        uint8_t* buckets = w->block_buf + w->block_offset;
+        memset(buckets, SSTABLE_HASH_EMPTY, num_buckets);
+        for (size_t i = 0; i < w->hash_count; i++) {
+            uint8_t* b = &buckets[w->hashes[i].hash % num_buckets];
+            if (*b == SSTABLE_HASH_EMPTY) {
+                *b = w->hashes[i].restart;
+            } else if (*b != w->hashes[i].restart) {
+                *b = SSTABLE_HASH_COLLISION;
+            }
+        }
+        w->block_offset += num_buckets;
+        memcpy(w->block_buf + w->block_offset, &num_buckets, 2);
+        w->block_offset += 2;
+        num_restarts |= SSTABLE_BLOCK_HASH_FLAG;
+    }
+    w->hash_count = 0;
+
+    // Write number of restarts
     memcpy(w->block_buf + w->block_offset, &num_restarts, 4);
     w->block_offset += 4;
 
-    // Write CRC32
-    uint32_t block_crc = crc32(w->block_buf, w->block_offset);
-    memcpy(w->block_buf + w->block_offset, &block_crc, 4);
-    w->block_offset += 4;
+    // Compress if that saves enough, else keep the block raw
+    uint8_t* out = w->block_buf;
+    size_t block_len = w->block_offset;
+    uint8_t type = COMPRESSION_NONE;
+    if (w->compression == COMPRESSION_LZ4) {
+        size_t compressed_len = compress_block(w);
+        if (compressed_len > 0) {
+            out = w->compress_buf;
+            block_len = compressed_len;
+            type = COMPRESSION_LZ4;
+            w->compressed_blocks++;
+        }
+    }
+
+    // Write type byte and CRC32 (covering the stored bytes)
+    out[block_len++] = type;
+    uint32_t block_crc = crc32c(out, block_len);
+    memcpy(out + block_len, &block_crc, 4);
+    block_len += 4;
 
     // Write block to file
-    if (write_all(w->fd, w->block_buf, w->block_offset) < 0) {
+    if (write_all(w->fd, out, block_len) < 0) {
         return STATUS_IO_ERROR;
     }
 
@@ -193,26 +379,56 @@ static status_t flush_block(sstable_writer_t* w, const char* last_key, size_t la
     memcpy(entry->last_key, last_key, last_key_len);
     entry->last_key_len = last_key_len;
     entry->offset = w->file_offset;
-    entry->size = (uint32_t)w->block_offset;
+    entry->size = (uint32_t)block_len;
 
-    w->file_offset += w->block_offset;
+    w->file_offset += block_len;
 
     // Reset block state
     w->block_offset = 0;
     w->restart_count = 0;
     w->entries_since_restart = SSTABLE_RESTART_INTERVAL;
-    free(w->prev_key);
-    w->prev_key = NULL;
     w->prev_key_len = 0;
 
+    if (w->partitioned && w->index_count - w->part_first_block >= SSTABLE_PARTITION_BLOCKS) {
+        return close_partition(w);
+    }
     return STATUS_OK;
 }
 
-// Add entry to SSTable (must be called in sorted order)
-status_t sstable_writer_add(sstable_writer_t* w,
-                            const char* key, size_t key_len,
-                            const char* value, size_t value_len,
-                            bool deleted) {
+// Helper: copy key into a reusable buffer, growing it only when needed
+static bool copy_key(char** buf, size_t* cap, size_t* len,
+                     const char* key, size_t key_len) {
+    if (key_len > *cap || !*buf) {
+        size_t new_cap = *cap * 2 > key_len ? *cap * 2 : key_len;
+        if (new_cap < 64) new_cap = 64;
+        char* new_buf = realloc(*buf, new_cap);
+        if (!new_buf) return false;
+        *buf = new_buf;
+        *cap = new_cap;
+    }
+    memcpy(*buf, key, key_len);
+    *len = key_len;
+    return true;
+}
+
+// Helper: add a hash to the open partition's filter
+static bool add_part_hash(sstable_writer_t* w, uint64_t hash) {
+    if (w->part_hash_count >= w->part_hash_capacity) {
+        size_t new_cap = w->part_hash_capacity ? w->part_hash_capacity * 2 : 1024;
+        uint64_t* new_hashes = realloc(w->part_hashes, new_cap * sizeof(uint64_t));
+        if (!new_hashes) return false;
+        w->part_hashes = new_hashes;
+        w->part_hash_capacity = new_cap;
+    }
+    w->part_hashes[w->part_hash_count++] = hash;
+    return true;
+}
+
+// Helper: add entry of any type (must be called in sorted order)
+static status_t add_entry(sstable_writer_t* w,
+                          const char* key, size_t key_len,
+                          const char* value, size_t value_len,
+                          uint8_t type) {
     if (!w || !key) return STATUS_INVALID_ARG;
 
     // Add to bloom filter
@@ -226,34 +442,35 @@ status_t sstable_writer_add(sstable_writer_t* w,
         w->min_key_len = key_len;
     }
     // Always update max key (since keys come in sorted order)
-    free(w->max_key);
-    w->max_key = malloc(key_len);
-    if (!w->max_key) return STATUS_NO_MEMORY;
-    memcpy(w->max_key, key, key_len);
-    w->max_key_len = key_len;
+    if (!copy_key(&w->max_key, &w->max_key_cap, &w->max_key_len, key, key_len)) {
+        return STATUS_NO_MEMORY;
+    }
 
     // Check if we need a restart point
     bool is_restart = (w->entries_since_restart >= SSTABLE_RESTART_INTERVAL);
 
     // Calculate prefix compression
     size_t shared = 0;
-    if (!is_restart && w->prev_key) {
+    if (!is_restart && w->prev_key_len > 0) {
         shared = shared_prefix_len(w->prev_key, w->prev_key_len, key, key_len);
     }
     size_t unshared = key_len - shared;
 
-    // Encode entry: shared | unshared | value_len | deleted | key_delta | value
+    // Encode entry: shared | unshared | value_len | type | key_delta | value
     uint8_t entry_buf[32];  // For varints
     size_t entry_len = 0;
     entry_len += encode_varint(entry_buf + entry_len, shared);
     entry_len += encode_varint(entry_buf + entry_len, unshared);
     entry_len += encode_varint(entry_buf + entry_len, value_len);
-    entry_buf[entry_len++] = deleted ? 1 : 0;
+    entry_buf[entry_len++] = type;
 
     size_t total_entry_size = entry_len + unshared + value_len;
 
-    // Check if block is full (leave room for restarts + crc)
-    size_t overhead = (w->restart_count + 1) * 4 + 8;  // restarts + num_restarts + crc
+    // Check if block is full (leave room for restarts + hash index + crc)
+    size_t overhead = (w->restart_count + 1) * 4 + 9;  // restarts + num_restarts + type + crc
+    if (w->hash_index) {
+        overhead += hash_bucket_count(w->hash_count + 1) + 2;
+    }
     if (w->block_offset + total_entry_size + overhead > w->block_size && w->block_offset > 0) {
         // Flush current block
         status_t status = flush_block(w, w->prev_key, w->prev_key_len);
@@ -266,7 +483,32 @@ status_t sstable_writer_add(sstable_writer_t* w,
         entry_len += encode_varint(entry_buf + entry_len, 0);
         entry_len += encode_varint(entry_buf + entry_len, key_len);
         entry_len += encode_varint(entry_buf + entry_len, value_len);
-        entry_buf[entry_len++] = deleted ? 1 : 0;
+        entry_buf[entry_len++] = type;
+    }
+
+    // Partitioned: the key belongs to the open partition's filter
+    if (w->partitioned && !add_part_hash(w, bloom_key_hash64(key, key_len))) {
+        return STATUS_NO_MEMORY;
+    }
+
+    // Prefix filter: keys sharing a prefix are adjacent, so comparing with
+    // the last prefix adds each one once
+    if (w->prefix_extractor) {
+        size_t prefix_len = w->prefix_extractor(key, key_len);
+        if (prefix_len > key_len) prefix_len = key_len;
+        if (!w->has_last_prefix || prefix_len != w->last_prefix_len ||
+            memcmp(key, w->last_prefix, prefix_len) != 0) {
+            if (w->partitioned) {
+                if (!add_part_hash(w, bloom_key_hash64(key, prefix_len))) return STATUS_NO_MEMORY;
+            } else {
+                bloom_add(w->bloom, key, prefix_len);
+            }
+            if (!copy_key(&w->last_prefix, &w->last_prefix_cap, &w->last_prefix_len,
+                          key, prefix_len)) {
+                return STATUS_NO_MEMORY;
+            }
+            w->has_last_prefix = true;
+        }
     }
 
     // Record restart point if needed
@@ -282,6 +524,21 @@ status_t sstable_writer_add(sstable_writer_t* w,
         w->entries_since_restart = 0;
     }
 
+    // Remember the key's restart interval for the hash index
+    if (w->hash_index) {
+        if (w->hash_count >= w->hash_capacity) {
+            size_t new_cap = w->hash_capacity ? w->hash_capacity * 2 : 64;
+            sstable_hash_entry_t* new_hashes = realloc(w->hashes, new_cap * sizeof(sstable_hash_entry_t));
+            if (!new_hashes) return STATUS_NO_MEMORY;
+            w->hashes = new_hashes;
+            w->hash_capacity = new_cap;
+        }
+        w->hashes[w->hash_count].hash = bloom_hash(key, key_len, 0);
+        // Past SSTABLE_HASH_MAX_RESTARTS the block is written without an index
+        w->hashes[w->hash_count].restart = (uint8_t)(w->restart_count - 1);
+        w->hash_count++;
+    }
+
     // Write entry to block buffer
     memcpy(w->block_buf + w->block_offset, entry_buf, entry_len);
     w->block_offset += entry_len;
@@ -293,28 +550,97 @@ status_t sstable_writer_add(sstable_writer_t* w,
     }
 
     // Update previous key
-    free(w->prev_key);
-    w->prev_key = malloc(key_len);
-    if (!w->prev_key) return STATUS_NO_MEMORY;
-    memcpy(w->prev_key, key, key_len);
-    w->prev_key_len = key_len;
+    if (!copy_key(&w->prev_key, &w->prev_key_cap, &w->prev_key_len, key, key_len)) {
+        return STATUS_NO_MEMORY;
+    }
 
     w->num_entries++;
     w->entries_since_restart++;
+    if (type == SSTABLE_ENTRY_BLOB) w->blob_refs++;
 
     return STATUS_OK;
 }
 
-// Finish writing SSTable
-status_t sstable_writer_finish(sstable_writer_t* w) {
-    if (!w) return STATUS_INVALID_ARG;
+// Add entry to SSTable (must be called in sorted order)
+status_t sstable_writer_add(sstable_writer_t* w,
+                            const char* key, size_t key_len,
+                            const char* value, size_t value_len,
+                            bool deleted) {
+    return add_entry(w, key, key_len, value, value_len,
+                     deleted ? SSTABLE_ENTRY_DELETION : SSTABLE_ENTRY_VALUE);
+}
 
-    // Flush remaining data block
-    if (w->block_offset > 0 && w->prev_key) {
-        status_t status = flush_block(w, w->prev_key, w->prev_key_len);
-        if (status != STATUS_OK) return status;
+// Add blob reference entry (must be called in sorted order)
+status_t sstable_writer_add_blob(sstable_writer_t* w,
+                                 const char* key, size_t key_len,
+                                 const char* ref, size_t ref_len) {
+    if (!ref || ref_len == 0) return STATUS_INVALID_ARG;
+    return add_entry(w, key, key_len, ref, ref_len, SSTABLE_ENTRY_BLOB);
+}
+
+// Add a range tombstone
+status_t sstable_writer_add_range_tombstone(sstable_writer_t* w, const range_tombstone_t* t) {
+    if (!w || !t || !t->begin || !t->end) return STATUS_INVALID_ARG;
+    // An inverted span would widen the file's key range the wrong way
+    if (w->cmp(t->begin, t->begin_len, t->end, t->end_len) >= 0) return STATUS_INVALID_ARG;
+
+    status_t status = range_del_encode(&w->range_del_buf, &w->range_del_len,
+                                       &w->range_del_cap, t);
+    if (status != STATUS_OK) return status;
+    w->range_del_count++;
+
+    // Widen the span of the tombstones
+    if (!w->range_del_min ||
+        w->cmp(t->begin, t->begin_len, w->range_del_min, w->range_del_min_len) < 0) {
+        if (!copy_key(&w->range_del_min, &w->range_del_min_cap, &w->range_del_min_len,
+                      t->begin, t->begin_len)) {
+            return STATUS_NO_MEMORY;
+        }
     }
+    if (!w->range_del_max ||
+        w->cmp(t->end, t->end_len, w->range_del_max, w->range_del_max_len) > 0) {
+        if (!copy_key(&w->range_del_max, &w->range_del_max_cap, &w->range_del_max_len,
+                      t->end, t->end_len)) {
+            return STATUS_NO_MEMORY;
+        }
+    }
+    return STATUS_OK;
+}
+
+// Helper: write the range-deletion block
+static status_t write_range_del_block(sstable_writer_t* w) {
+    uint8_t head[10];
+    size_t head_len = encode_varint(head, w->range_del_count);
+    uint32_t crc = crc32c_update(crc32c(head, head_len), w->range_del_buf, w->range_del_len);
+    uint32_t size = (uint32_t)(head_len + w->range_del_len + 4);
+
+    if (write_all(w->fd, head, head_len) < 0 ||
+        write_all(w->fd, w->range_del_buf, w->range_del_len) < 0 ||
+        write_all(w->fd, &crc, 4) < 0 ||
+        write_all(w->fd, &size, 4) < 0) {
+        return STATUS_IO_ERROR;
+    }
+    w->file_offset += size + 4;
+    return STATUS_OK;
+}
+
+// Helper: write the prefix block (extractor name)
+static status_t write_prefix_block(sstable_writer_t* w) {
+    size_t name_len = strlen(w->prefix_name);
+    uint32_t crc = crc32c(w->prefix_name, name_len);
+    uint32_t size = (uint32_t)(name_len + 4);
+
+    if (write_all(w->fd, w->prefix_name, name_len) < 0 ||
+        write_all(w->fd, &crc, 4) < 0 ||
+        write_all(w->fd, &size, 4) < 0) {
+        return STATUS_IO_ERROR;
+    }
+    w->file_offset += size + 4;
+    return STATUS_OK;
+}
 
+// Helper: whole-table layout: one index block and one bloom filter
+static status_t write_flat_index(sstable_writer_t* w, sstable_footer_t* footer) {
     // Write index block
     uint64_t index_offset = w->file_offset;
     for (size_t i = 0; i < w->index_count; i++) {
@@ -343,25 +669,171 @@ status_t sstable_writer_finish(sstable_writer_t* w) {
     free(bloom_buf);
     w->file_offset += bloom_size;
 
-    // Write footer
+    footer->index_offset = index_offset;
+    footer->index_size = index_size;
+    footer->bloom_offset = bloom_offset;
+    footer->bloom_size = (uint32_t)bloom_size;
+    return STATUS_OK;
+}
+
+// Helper: append bytes to a growable buffer
+static bool buf_append(uint8_t** buf, size_t* len, size_t* cap, const void* data, size_t n) {
+    if (*len + n > *cap) {
+        size_t new_cap = *cap ? *cap * 2 : 4096;
+        while (new_cap < *len + n) new_cap *= 2;
+        uint8_t* new_buf = realloc(*buf, new_cap);
+        if (!new_buf) return false;
+        *buf = new_buf;
+        *cap = new_cap;
+    }
+    memcpy(*buf + *len, data, n);
+    *len += n;
+    return true;
+}
+
+// Helper: partitioned layout: one index partition per partition, then the
+// top-level index (filter partitions were written by close_partition)
+static status_t write_partitioned_index(sstable_writer_t* w, sstable_footer_t* footer) {
+    uint8_t* buf = NULL;
+    size_t len = 0, cap = 0;
+    uint32_t* offsets = malloc(SSTABLE_PARTITION_BLOCKS * sizeof(uint32_t));
+    if (!offsets) return STATUS_NO_MEMORY;
+
+    for (size_t p = 0; p < w->part_count; p++) {
+        sstable_partition_t* part = &w->parts[p];
+        len = 0;
+
+        // entries | offsets | count | crc
+        bool ok = true;
+        for (uint32_t i = 0; i < part->num_blocks && ok; i++) {
+            sstable_index_entry_t* entry = &w->index[part->first_block + i];
+            uint8_t varint[10];
+            size_t n = encode_varint(varint, entry->last_key_len);
+            offsets[i] = (uint32_t)len;
+            ok = buf_append(&buf, &len, &cap, varint, n) &&
+                 buf_append(&buf, &len, &cap, entry->last_key, entry->last_key_len) &&
+                 buf_append(&buf, &len, &cap, &entry->offset, 8) &&
+                 buf_append(&buf, &len, &cap, &entry->size, 4);
+        }
+        ok = ok && buf_append(&buf, &len, &cap, offsets, part->num_blocks * sizeof(uint32_t)) &&
+             buf_append(&buf, &len, &cap, &part->num_blocks, 4);
+        uint32_t crc = ok ? crc32c(buf, len) : 0;
+        if (!ok || !buf_append(&buf, &len, &cap, &crc, 4)) {
+            free(offsets);
+            free(buf);
+            return STATUS_NO_MEMORY;
+        }
+
+        if (write_all(w->fd, buf, len) < 0) {
+            free(offsets);
+            free(buf);
+            return STATUS_IO_ERROR;
+        }
+        part->index_offset = w->file_offset;
+        part->index_size = (uint32_t)len;
+        w->file_offset += len;
+
+        sstable_index_entry_t* last = &w->index[part->first_block + part->num_blocks - 1];
+        part->last_key = last->last_key;
+        part->last_key_len = last->last_key_len;
+    }
+    free(offsets);
+
+    // Top-level index: per partition
+    //   key_len (varint) | last_key | first_block(4) | num_blocks(4)
+    //   | index_offset(8) | index_size(4) | filter_offset(8) | filter_size(4)
+    len = 0;
+    for (size_t p = 0; p < w->part_count; p++) {
+        sstable_partition_t* part = &w->parts[p];
+        uint8_t varint[10];
+        size_t n = encode_varint(varint, part->last_key_len);
+        if (!buf_append(&buf, &len, &cap, varint, n) ||
+            !buf_append(&buf, &len, &cap, part->last_key, part->last_key_len) ||
+            !buf_append(&buf, &len, &cap, &part->first_block, 4) ||
+            !buf_append(&buf, &len, &cap, &part->num_blocks, 4) ||
+            !buf_append(&buf, &len, &cap, &part->index_offset, 8) ||
+            !buf_append(&buf, &len, &cap, &part->index_size, 4) ||
+            !buf_append(&buf, &len, &cap, &part->filter_offset, 8) ||
+            !buf_append(&buf, &len, &cap, &part->filter_size, 4)) {
+            free(buf);
+            return STATUS_NO_MEMORY;
+        }
+    }
+    if (len > 0 && write_all(w->fd, buf, len) < 0) {
+        free(buf);
+        return STATUS_IO_ERROR;
+    }
+    free(buf);
+
+    footer->index_offset = w->file_offset;
+    footer->index_size = (uint32_t)len;
+    w->file_offset += len;
+    return STATUS_OK;
+}
+
+// Finish writing SSTable
+status_t sstable_writer_finish(sstable_writer_t* w) {
+    if (!w) return STATUS_INVALID_ARG;
+
+    // Flush remaining data block
+    if (w->block_offset > 0) {
+        status_t status = flush_block(w, w->prev_key, w->prev_key_len);
+        if (status != STATUS_OK) return status;
+    }
+    if (w->partitioned) {
+        status_t status = close_partition(w);
+        if (status != STATUS_OK) return status;
+    }
+
+    // Write index and filters
     sstable_footer_t footer = {0};
-    footer.index_offset = index_offset;
-    footer.index_size = index_size;
-    footer.bloom_offset = bloom_offset;
-    footer.bloom_size = (uint32_t)bloom_size;
+    status_t status = w->partitioned ? write_partitioned_index(w, &footer)
+                                     : write_flat_index(w, &footer);
+    if (status != STATUS_OK) return status;
+    bool named = w->prefix_extractor && w->prefix_name;
+    if (named) {
+        status = write_prefix_block(w);
+        if (status != STATUS_OK) return status;
+    }
+    if (w->range_del_count > 0) {
+        status = write_range_del_block(w);
+        if (status != STATUS_OK) return status;
+    }
     footer.num_entries = w->num_entries;
 
-    if (w->min_key && w->min_key_len <= SSTABLE_MAX_KEY_SIZE) {
-        footer.min_key_len = (uint32_t)w->min_key_len;
-        memcpy(footer.min_key, w->min_key, w->min_key_len);
+    // Key range: the entries plus the span of the range tombstones
+    const char* min_key = w->min_key;
+    size_t min_key_len = w->min_key_len;
+    const char* max_key = w->max_key;
+    size_t max_key_len = w->max_key_len;
+    if (w->range_del_min &&
+        (!min_key || w->cmp(w->range_del_min, w->range_del_min_len, min_key, min_key_len) < 0)) {
+        min_key = w->range_del_min;
+        min_key_len = w->range_del_min_len;
     }
-    if (w->max_key && w->max_key_len <= SSTABLE_MAX_KEY_SIZE) {
-        footer.max_key_len = (uint32_t)w->max_key_len;
-        memcpy(footer.max_key, w->max_key, w->max_key_len);
+    if (w->range_del_max &&
+        (!max_key || w->cmp(w->range_del_max, w->range_del_max_len, max_key, max_key_len) > 0)) {
+        max_key = w->range_del_max;
+        max_key_len = w->range_del_max_len;
+    }
+    if (min_key && min_key_len <= SSTABLE_MAX_KEY_SIZE) {
+        footer.min_key_len = (uint32_t)min_key_len;
+        memcpy(footer.min_key, min_key, min_key_len);
+    }
+    if (max_key && max_key_len <= SSTABLE_MAX_KEY_SIZE) {
+        footer.max_key_len = (uint32_t)max_key_len;
+        memcpy(footer.max_key, max_key, max_key_len);
     }
 
-    footer.magic = SSTABLE_MAGIC;
-    footer.crc32 = crc32(&footer, offsetof(sstable_footer_t, crc32));
+    footer.flags = SSTABLE_FLAG_BLOCK_TYPE | SSTABLE_FLAG_CRC32C;
+    if (w->partitioned) footer.flags |= SSTABLE_FLAG_PARTITIONED;
+    if (w->compressed_blocks > 0) footer.flags |= SSTABLE_FLAG_COMPRESSED;
+    if (w->blob_refs > 0) footer.flags |= SSTABLE_FLAG_BLOB;
+    if (w->range_del_count > 0) footer.flags |= SSTABLE_FLAG_RANGE_DEL;
+    if (w->prefix_extractor) footer.flags |= SSTABLE_FLAG_PREFIX;
+    if (named) footer.flags |= SSTABLE_FLAG_PREFIX_NAME;
+    footer.magic = SSTABLE_MAGIC_V2;
+    footer.crc32 = crc32c(&footer, offsetof(sstable_footer_t, crc32));
 
     if (write_all(w->fd, &footer, sizeof(footer)) < 0) return STATUS_IO_ERROR;
 
@@ -375,10 +847,19 @@ status_t sstable_writer_finish(sstable_writer_t* w) {
     }
     free(w->index);
     free(w->restarts);
+    free(w->hashes);
+    free(w->part_hashes);
+    free(w->parts);
+    free(w->compress_buf);
     free(w->block_buf);
     free(w->prev_key);
     free(w->min_key);
     free(w->max_key);
+    free(w->last_prefix);
+    free(w->prefix_name);
+    free(w->range_del_buf);
+    free(w->range_del_min);
+    free(w->range_del_max);
     bloom_destroy(w->bloom);
     free(w->path);
     free(w);
@@ -400,10 +881,19 @@ void sstable_writer_abort(sstable_writer_t* w) {
     }
     free(w->index);
     free(w->restarts);
+    free(w->hashes);
+    free(w->part_hashes);
+    free(w->parts);
+    free(w->compress_buf);
     free(w->block_buf);
     free(w->prev_key);
     free(w->min_key);
     free(w->max_key);
+    free(w->last_prefix);
+    free(w->prefix_name);
+    free(w->range_del_buf);
+    free(w->range_del_min);
+    free(w->range_del_max);
     bloom_destroy(w->bloom);
     free(w->path);
     free(w);
@@ -413,265 +903,494 @@ void sstable_writer_abort(sstable_writer_t* w) {
 // SSTable Reader
 // ============================================================
 
+// Helper: free everything a (possibly half-opened) reader owns
+static void reader_free(sstable_reader_t* r) {
+    if (r->index) {
+        for (size_t i = 0; i < r->index_count; i++) {
+            free(r->index[i].last_key);
+        }
+        free(r->index);
+    }
+    if (r->parts) {
+        for (size_t i = 0; i < r->part_count; i++) {
+            free(r->parts[i].last_key);
+        }
+        free(r->parts);
+    }
+    free(r->part_verified);
+    free(r->verified);
+    range_del_list_free(&r->range_dels);
+    free(r->range_del_buf);
+    free(r->prefix_name);
+    bloom_destroy(r->bloom);
+    if (r->map) munmap((void*)r->map, r->map_size);
+    if (r->fd >= 0) close(r->fd);
+    free(r->path);
+    free(r);
+}
+
+// Helper: get [offset, offset + size) of the file. Mapped readers return a
+// pointer into the mapping; otherwise the bytes are read into *owned.
+static const uint8_t* reader_region(sstable_reader_t* r, uint64_t offset,
+                                    size_t size, uint8_t** owned) {
+    *owned = NULL;
+    if (offset > r->file_size || size > r->file_size - offset) return NULL;
+
+    if (r->map) return r->map + offset;
+
+    uint8_t* buf = malloc(size > 0 ? size : 1);
+    if (!buf) return NULL;
+    if (pread_all(r->fd, buf, size, offset) != (ssize_t)size) {
+        free(buf);
+        return NULL;
+    }
+    *owned = buf;
+    return buf;
+}
+
+// Helper: parse the index block into r->index
+static bool parse_index(sstable_reader_t* r, const uint8_t* index_buf, size_t index_size) {
+    size_t capacity = 16;
+    r->index = malloc(capacity * sizeof(sstable_index_entry_t));
+    if (!r->index) return false;
+    r->index_count = 0;
+
+    size_t pos = 0;
+    while (pos < index_size) {
+        if (r->index_count >= capacity) {
+            capacity *= 2;
+            sstable_index_entry_t* new_idx = realloc(r->index, capacity * sizeof(sstable_index_entry_t));
+            if (!new_idx) return false;
+            r->index = new_idx;
+        }
+
+        uint64_t key_len;
+        size_t n = decode_varint(index_buf + pos, index_size - pos, &key_len);
+        if (n == 0) break;
+        pos += n;
+
+        if (pos + key_len + 12 > index_size) break;
+
+        sstable_index_entry_t* entry = &r->index[r->index_count];
+        entry->last_key = malloc(key_len);
+        if (!entry->last_key) return false;
+        r->index_count++;
+        memcpy(entry->last_key, index_buf + pos, key_len);
+        entry->last_key_len = key_len;
+        pos += key_len;
+
+        memcpy(&entry->offset, index_buf + pos, 8);
+        pos += 8;
+        memcpy(&entry->size, index_buf + pos, 4);
+        pos += 4;
+    }
+    return true;
+}
+
+// Helper: parse the top-level index of a partitioned table into r->parts
+static bool parse_partitions(sstable_reader_t* r, const uint8_t* buf, size_t size) {
+    size_t capacity = 16;
+    r->parts = malloc(capacity * sizeof(sstable_partition_t));
+    if (!r->parts) return false;
+    r->part_count = 0;
+    r->index_count = 0;
+
+    size_t pos = 0;
+    while (pos < size) {
+        if (r->part_count >= capacity) {
+            capacity *= 2;
+            sstable_partition_t* new_parts = realloc(r->parts, capacity * sizeof(sstable_partition_t));
+            if (!new_parts) return false;
+            r->parts = new_parts;
+        }
+
+        uint64_t key_len;
+        size_t n = decode_varint(buf + pos, size - pos, &key_len);
+        if (n == 0) return false;
+        pos += n;
+        if (pos + key_len + 32 > size) return false;
+
+        sstable_partition_t* part = &r->parts[r->part_count];
+        part->last_key = malloc(key_len > 0 ? key_len : 1);
+        if (!part->last_key) return false;
+        r->part_count++;
+        memcpy(part->last_key, buf + pos, key_len);
+        part->last_key_len = key_len;
+        pos += key_len;
+
+        memcpy(&part->first_block, buf + pos, 4);
+        memcpy(&part->num_blocks, buf + pos + 4, 4);
+        memcpy(&part->index_offset, buf + pos + 8, 8);
+        memcpy(&part->index_size, buf + pos + 16, 4);
+        memcpy(&part->filter_offset, buf + pos + 20, 8);
+        memcpy(&part->filter_size, buf + pos + 28, 4);
+        pos += 32;
+
+        // Partitions cover the data blocks in order, without gaps
+        if (part->first_block != r->index_count || part->num_blocks == 0) return false;
+        r->index_count += part->num_blocks;
+    }
+    return true;
+}
+
+// Helper: checksum of a table region: CRC32C, or CRC-32 for tables written
+// before SSTABLE_FLAG_CRC32C
+static uint32_t table_crc(uint32_t flags, const void* data, size_t len) {
+    return (flags & SSTABLE_FLAG_CRC32C) ? crc32c(data, len) : crc32(data, len);
+}
+
+// Helper: read the footer of either version into r->footer (version 1
+// footers get flags 0) and check its magic and CRC
+static bool read_footer(sstable_reader_t* r) {
+    _Static_assert(sizeof(sstable_footer_t) - offsetof(sstable_footer_t, magic) == 16,
+                   "footer must end in magic | crc32 | padding");
+
+    uint64_t magic;
+    if (pread_all(r->fd, &magic, 8, r->file_size - 16) != 8) return false;
+    size_t size;
+    if (magic == SSTABLE_MAGIC) {
+        size = SSTABLE_FOOTER_V1_SIZE;
+    } else if (magic == SSTABLE_MAGIC_V2) {
+        size = sizeof(sstable_footer_t);
+        if (r->file_size < size) return false;
+    } else {
+        return false;
+    }
+
+    uint8_t buf[sizeof(sstable_footer_t)];
+    if (pread_all(r->fd, buf, size, r->file_size - size) != (ssize_t)size) return false;
+
+    // CRC covers everything before the crc32 field, with the algorithm the
+    // flags name (a damaged flags field fails either way)
+    size_t crc_offset = size - 8;
+    uint32_t stored_crc;
+    memcpy(&stored_crc, buf + crc_offset, 4);
+    uint32_t flags = 0;
+    if (magic == SSTABLE_MAGIC_V2) memcpy(&flags, buf + offsetof(sstable_footer_t, flags), 4);
+    if (table_crc(flags, buf, crc_offset) != stored_crc) return false;
+
+    if (magic == SSTABLE_MAGIC) {
+        memset(&r->footer, 0, sizeof(r->footer));
+        memcpy(&r->footer, buf, offsetof(sstable_footer_t, flags));
+        r->footer.magic = magic;
+        r->footer.crc32 = stored_crc;
+    } else {
+        memcpy(&r->footer, buf, sizeof(r->footer));
+    }
+    return true;
+}
+
+// Helper: load the range-deletion block into r->range_dels
+static bool read_range_dels(sstable_reader_t* r) {
+    size_t footer_size = sizeof(sstable_footer_t);
+    if (r->file_size < footer_size + 4) return false;
+    uint32_t size;
+    if (pread_all(r->fd, &size, 4, r->file_size - footer_size - 4) != 4) return false;
+    if (size < 5 || size > r->file_size - footer_size - 4) return false;
+
+    r->range_del_buf = malloc(size);
+    if (!r->range_del_buf) return false;
+    r->range_del_size = size;
+    uint64_t offset = r->file_size - footer_size - 4 - size;
+    if (pread_all(r->fd, r->range_del_buf, size, offset) != (ssize_t)size) return false;
+
+    uint32_t stored_crc;
+    memcpy(&stored_crc, r->range_del_buf + size - 4, 4);
+    if (crc32c(r->range_del_buf, size - 4) != stored_crc) return false;
+    return range_del_decode(r->range_del_buf, size - 4, &r->range_dels);
+}
+
+// Helper: load the extractor name from the prefix block
+static bool read_prefix_name(sstable_reader_t* r) {
+    // The range-deletion block, if any, sits between it and the footer
+    size_t tail = sizeof(sstable_footer_t);
+    if (r->footer.flags & SSTABLE_FLAG_RANGE_DEL) tail += r->range_del_size + 4;
+    if (r->file_size < tail + 4) return false;
+    uint32_t size;
+    if (pread_all(r->fd, &size, 4, r->file_size - tail - 4) != 4) return false;
+    if (size < 4 || size > r->file_size - tail - 4) return false;
+
+    uint8_t* buf = malloc(size);
+    if (!buf) return false;
+    uint64_t offset = r->file_size - tail - 4 - size;
+    uint32_t stored_crc;
+    if (pread_all(r->fd, buf, size, offset) != (ssize_t)size) {
+        free(buf);
+        return false;
+    }
+    memcpy(&stored_crc, buf + size - 4, 4);
+    if (crc32c(buf, size - 4) != stored_crc) {
+        free(buf);
+        return false;
+    }
+
+    // Reuse the buffer for the terminated name
+    buf[size - 4] = '\0';
+    r->prefix_name = (char*)buf;
+    return true;
+}
+
 sstable_reader_t* sstable_reader_open(const char* path, compare_fn cmp) {
+    return sstable_reader_open_ex(path, cmp, 0);
+}
+
+sstable_reader_t* sstable_reader_open_ex(const char* path, compare_fn cmp, int flags) {
     if (!path) return NULL;
 
     sstable_reader_t* r = calloc(1, sizeof(sstable_reader_t));
     if (!r) return NULL;
+    r->fd = -1;
 
     r->path = strdup(path);
     if (!r->path) {
-        free(r);
+        reader_free(r);
         return NULL;
     }
 
     r->fd = open(path, O_RDONLY);
     if (r->fd < 0) {
-        free(r->path);
-        free(r);
+        reader_free(r);
         return NULL;
     }
 
     r->cmp = cmp ? cmp : default_compare;
+    r->refs = 1;
 
     // Get file size
     struct stat st;
     if (fstat(r->fd, &st) < 0) {
-        close(r->fd);
-        free(r->path);
-        free(r);
+        reader_free(r);
         return NULL;
     }
-
-    // Read footer
-    if ((size_t)st.st_size < sizeof(sstable_footer_t)) {
-        close(r->fd);
-        free(r->path);
-        free(r);
+    r->file_size = (size_t)st.st_size;
+    if (r->file_size < SSTABLE_FOOTER_V1_SIZE) {
+        reader_free(r);
         return NULL;
     }
 
-    if (lseek(r->fd, st.st_size - sizeof(sstable_footer_t), SEEK_SET) < 0) {
-        close(r->fd);
-        free(r->path);
-        free(r);
-        return NULL;
-    }
-
-    if (read_all(r->fd, &r->footer, sizeof(sstable_footer_t)) != sizeof(sstable_footer_t)) {
-        close(r->fd);
-        free(r->path);
-        free(r);
-        return NULL;
-    }
-
-    // Verify magic and CRC
-    if (r->footer.magic != SSTABLE_MAGIC) {
-        close(r->fd);
-        free(r->path);
-        free(r);
-        return NULL;
-    }
-
-    uint32_t expected_crc = crc32(&r->footer, offsetof(sstable_footer_t, crc32));
-    if (r->footer.crc32 != expected_crc) {
-        close(r->fd);
-        free(r->path);
-        free(r);
-        return NULL;
-    }
-
-    // Read bloom filter
-    if (lseek(r->fd, r->footer.bloom_offset, SEEK_SET) < 0) {
-        close(r->fd);
-        free(r->path);
-        free(r);
-        return NULL;
+    if (flags & SSTABLE_OPEN_MMAP) {
+        void* map = mmap(NULL, r->file_size, PROT_READ, MAP_SHARED, r->fd, 0);
+        if (map == MAP_FAILED) {
+            reader_free(r);
+            return NULL;
+        }
+        r->map = map;
+        r->map_size = r->file_size;
     }
 
-    uint8_t* bloom_buf = malloc(r->footer.bloom_size);
-    if (!bloom_buf) {
-        close(r->fd);
-        free(r->path);
-        free(r);
+    // Read and verify footer
+    if (!read_footer(r)) {
+        reader_free(r);
         return NULL;
     }
+    bool partitioned = (r->footer.flags & SSTABLE_FLAG_PARTITIONED) != 0;
+    uint8_t* owned;
 
-    if (read_all(r->fd, bloom_buf, r->footer.bloom_size) != (ssize_t)r->footer.bloom_size) {
-        free(bloom_buf);
-        close(r->fd);
-        free(r->path);
-        free(r);
+    // Range tombstones stay resident: every lookup consults them
+    if ((r->footer.flags & SSTABLE_FLAG_RANGE_DEL) && !read_range_dels(r)) {
+        reader_free(r);
         return NULL;
     }
-
-    r->bloom = bloom_deserialize(bloom_buf, r->footer.bloom_size);
-    free(bloom_buf);
-    if (!r->bloom) {
-        close(r->fd);
-        free(r->path);
-        free(r);
+    if ((r->footer.flags & SSTABLE_FLAG_PREFIX_NAME) && !read_prefix_name(r)) {
+        reader_free(r);
         return NULL;
     }
 
-    // Read index
-    if (lseek(r->fd, r->footer.index_offset, SEEK_SET) < 0) {
-        bloom_destroy(r->bloom);
-        close(r->fd);
-        free(r->path);
-        free(r);
-        return NULL;
+    // Read bloom filter (partitioned tables load filter partitions on demand)
+    if (!partitioned) {
+        const uint8_t* bloom_buf = reader_region(r, r->footer.bloom_offset,
+                                                 r->footer.bloom_size, &owned);
+        if (!bloom_buf) {
+            reader_free(r);
+            return NULL;
+        }
+        r->bloom = bloom_deserialize(bloom_buf, r->footer.bloom_size);
+        free(owned);
+        if (!r->bloom) {
+            reader_free(r);
+            return NULL;
+        }
     }
 
-    // Count index entries by parsing
-    uint8_t* index_buf = malloc(r->footer.index_size);
+    // Read and parse index (the top-level index when partitioned)
+    const uint8_t* index_buf = reader_region(r, r->footer.index_offset,
+                                             r->footer.index_size, &owned);
     if (!index_buf) {
-        bloom_destroy(r->bloom);
-        close(r->fd);
-        free(r->path);
-        free(r);
+        reader_free(r);
         return NULL;
     }
-
-    if (read_all(r->fd, index_buf, r->footer.index_size) != (ssize_t)r->footer.index_size) {
-        free(index_buf);
-        bloom_destroy(r->bloom);
-        close(r->fd);
-        free(r->path);
-        free(r);
+    bool parsed = partitioned ? parse_partitions(r, index_buf, r->footer.index_size)
+                              : parse_index(r, index_buf, r->footer.index_size);
+    free(owned);
+    if (!parsed) {
+        reader_free(r);
         return NULL;
     }
 
-    // Parse index entries
-    size_t capacity = 16;
-    r->index = malloc(capacity * sizeof(sstable_index_entry_t));
-    if (!r->index) {
-        free(index_buf);
-        bloom_destroy(r->bloom);
-        close(r->fd);
-        free(r->path);
-        free(r);
-        return NULL;
-    }
-    r->index_count = 0;
-
-    size_t pos = 0;
-    while (pos < r->footer.index_size) {
-        if (r->index_count >= capacity) {
-            capacity *= 2;
-            sstable_index_entry_t* new_idx = realloc(r->index, capacity * sizeof(sstable_index_entry_t));
-            if (!new_idx) {
-                for (size_t i = 0; i < r->index_count; i++) free(r->index[i].last_key);
-                free(r->index);
-                free(index_buf);
-                bloom_destroy(r->bloom);
-                close(r->fd);
-                free(r->path);
-                free(r);
+    // Mapped blocks are CRC-checked on first use, then trusted
+    if (r->map) {
+        r->verified = calloc(r->index_count > 0 ? r->index_count : 1, 1);
+        if (!r->verified) {
+            reader_free(r);
+            return NULL;
+        }
+        if (partitioned) {
+            r->part_verified = calloc(r->part_count > 0 ? 2 * r->part_count : 1, 1);
+            if (!r->part_verified) {
+                reader_free(r);
                 return NULL;
             }
-            r->index = new_idx;
         }
-
-        uint64_t key_len;
-        size_t n = decode_varint(index_buf + pos, r->footer.index_size - pos, &key_len);
-        if (n == 0) break;
-        pos += n;
-
-        if (pos + key_len + 12 > r->footer.index_size) break;
-
-        sstable_index_entry_t* entry = &r->index[r->index_count++];
-        entry->last_key = malloc(key_len);
-        if (!entry->last_key) break;
-        memcpy(entry->last_key, index_buf + pos, key_len);
-        entry->last_key_len = key_len;
-        pos += key_len;
-
-        memcpy(&entry->offset, index_buf + pos, 8);
-        pos += 8;
-        memcpy(&entry->size, index_buf + pos, 4);
-        pos += 4;
     }
 
-    free(index_buf);
     return r;
 }
 
+void sstable_reader_ref(sstable_reader_t* r) {
+    if (r) __atomic_add_fetch(&r->refs, 1, __ATOMIC_RELAXED);
+}
+
 void sstable_reader_close(sstable_reader_t* r) {
     if (!r) return;
-
-    for (size_t i = 0; i < r->index_count; i++) {
-        free(r->index[i].last_key);
-    }
-    free(r->index);
-    bloom_destroy(r->bloom);
-    close(r->fd);
-    free(r->path);
-    free(r);
+    if (__atomic_sub_fetch(&r->refs, 1, __ATOMIC_ACQ_REL) > 0) return;
+    reader_free(r);
 }
 
-// Helper: search for key in a data block
-static status_t search_block(sstable_reader_t* r, uint8_t* block, size_t block_size,
-                              const char* key, size_t key_len,
-                              char** value, size_t* value_len, bool* deleted) {
-    // Read trailer: num_restarts (4B) + crc32 (4B)
-    if (block_size < 8) return STATUS_CORRUPTION;
-
-    uint32_t num_restarts;
-    memcpy(&num_restarts, block + block_size - 8, 4);
-
-    uint32_t stored_crc;
-    memcpy(&stored_crc, block + block_size - 4, 4);
+bool sstable_reader_is_mapped(sstable_reader_t* r) {
+    return r && r->map != NULL;
+}
 
-    // Verify CRC (excluding the CRC itself)
-    uint32_t computed_crc = crc32(block, block_size - 4);
-    if (computed_crc != stored_crc) return STATUS_CORRUPTION;
+bool sstable_reader_is_partitioned(sstable_reader_t* r) {
+    return r && r->parts != NULL;
+}
 
-    // Calculate data end (before restart offsets)
-    size_t restarts_start = block_size - 8 - num_restarts * 4;
+size_t sstable_reader_resident_bytes(sstable_reader_t* r) {
+    if (!r) return 0;
+    size_t bytes = sizeof(*r) + bloom_serialized_size(r->bloom);
+    if (r->parts) {
+        bytes += r->part_count * sizeof(sstable_partition_t);
+        for (size_t i = 0; i < r->part_count; i++) bytes += r->parts[i].last_key_len;
+        if (r->part_verified) bytes += 2 * r->part_count;
+    } else {
+        bytes += r->index_count * sizeof(sstable_index_entry_t);
+        for (size_t i = 0; i < r->index_count; i++) bytes += r->index[i].last_key_len;
+    }
+    if (r->verified) bytes += r->index_count;
+    bytes += r->range_del_size + r->range_dels.capacity * sizeof(range_tombstone_t);
+    return bytes;
+}
 
-    // Binary search restart points to find starting position
-    uint32_t* restarts = (uint32_t*)(block + restarts_start);
-    size_t left = 0, right = num_restarts;
+// Parse a data block's trailer
+status_t sstable_block_layout(const uint8_t* block, size_t size,
+                              sstable_block_layout_t* layout) {
+    // Trailer: num_restarts (4B); type and crc32 are already stripped
+    if (!block || !layout || size < 4) return STATUS_CORRUPTION;
+
+    uint32_t packed;
+    memcpy(&packed, block + size - 4, 4);
+    size_t end = size - 4;
+
+    layout->buckets = NULL;
+    layout->num_buckets = 0;
+    if (packed & SSTABLE_BLOCK_HASH_FLAG) {
+        uint16_t num_buckets;
+        if (end < 2) return STATUS_CORRUPTION;
+        memcpy(&num_buckets, block + end - 2, 2);
+        end -= 2;
+        if (num_buckets == 0 || num_buckets > end) return STATUS_CORRUPTION;
+        end -= num_buckets;
+        layout->buckets = block + end;
+        layout->num_buckets = num_buckets;
+    }
 
-    // Build key at each restart point and binary search
-    while (left < right) {
-        size_t mid = left + (right - left) / 2;
-        uint32_t restart_offset = restarts[mid];
+    layout->num_restarts = packed & ~SSTABLE_BLOCK_HASH_FLAG;
+    if ((size_t)layout->num_restarts * 4 > end) return STATUS_CORRUPTION;
+    end -= (size_t)layout->num_restarts * 4;
+    layout->restarts = block + end;
+    layout->data_end = end;
+    return STATUS_OK;
+}
 
-        // Decode key at restart point (shared=0)
-        size_t pos = restart_offset;
-        uint64_t shared, unshared, val_len;
-        size_t n = decode_varint(block + pos, restarts_start - pos, &shared);
-        if (n == 0 || shared != 0) return STATUS_CORRUPTION;
-        pos += n;
-        n = decode_varint(block + pos, restarts_start - pos, &unshared);
-        if (n == 0) return STATUS_CORRUPTION;
-        pos += n;
-        n = decode_varint(block + pos, restarts_start - pos, &val_len);
-        if (n == 0) return STATUS_CORRUPTION;
-        pos += n;
-        pos++;  // Skip deleted flag
+// Helper: offset of restart point i
+static uint32_t restart_offset(const sstable_block_layout_t* layout, size_t i) {
+    uint32_t offset;
+    memcpy(&offset, layout->restarts + i * 4, 4);
+    return offset;
+}
 
-        if (pos + unshared > restarts_start) return STATUS_CORRUPTION;
+// Helper: search for key in a data block. On a hit, *value points into the
+// block; the caller copies it or keeps the block alive.
+static status_t search_block(sstable_reader_t* r, const uint8_t* block, size_t block_size,
+                              const char* key, size_t key_len,
+                              const char** value, size_t* value_len, uint8_t* type) {
+    sstable_block_layout_t layout;
+    status_t status = sstable_block_layout(block, block_size, &layout);
+    if (status != STATUS_OK) return status;
+    if (layout.num_restarts == 0) return STATUS_NOT_FOUND;
+
+    size_t restarts_start = layout.data_end;
+    size_t scan_end = restarts_start;
+    size_t start_restart = 0;
+    bool hashed = false;
+
+    // Hash index: jump straight to the key's restart interval
+    if (layout.buckets && r->cmp == default_compare) {
+        uint8_t b = layout.buckets[bloom_hash(key, key_len, 0) % layout.num_buckets];
+        if (b == SSTABLE_HASH_EMPTY) return STATUS_NOT_FOUND;
+        if (b < layout.num_restarts) {
+            start_restart = b;
+            if (b + 1u < layout.num_restarts) scan_end = restart_offset(&layout, b + 1);
+            if (scan_end > restarts_start) return STATUS_CORRUPTION;
+            hashed = true;
+        }
+    }
 
-        int cmp = r->cmp((const char*)(block + pos), unshared, key, key_len);
-        if (cmp < 0) {
-            left = mid + 1;
-        } else {
-            right = mid;
+    // Otherwise binary search the restart points
+    if (!hashed) {
+        size_t left = 0, right = layout.num_restarts;
+        while (left < right) {
+            size_t mid = left + (right - left) / 2;
+
+            // Decode key at restart point (shared=0)
+            size_t pos = restart_offset(&layout, mid);
+            if (pos >= restarts_start) return STATUS_CORRUPTION;
+            uint64_t shared, unshared, val_len;
+            size_t n = decode_varint(block + pos, restarts_start - pos, &shared);
+            if (n == 0 || shared != 0) return STATUS_CORRUPTION;
+            pos += n;
+            n = decode_varint(block + pos, restarts_start - pos, &unshared);
+            if (n == 0) return STATUS_CORRUPTION;
+            pos += n;
+            n = decode_varint(block + pos, restarts_start - pos, &val_len);
+            if (n == 0) return STATUS_CORRUPTION;
+            pos += n;
+            pos++;  // Skip entry type
+
+            if (pos + unshared > restarts_start) return STATUS_CORRUPTION;
+
+            int cmp = r->cmp((const char*)(block + pos), unshared, key, key_len);
+            if (cmp < 0) {
+                left = mid + 1;
+            } else {
+                right = mid;
+            }
         }
+
+        // Start from the restart point before or at our target
+        start_restart = (left > 0) ? left - 1 : 0;
     }
 
-    // Start from the restart point before or at our target
-    size_t start_restart = (left > 0) ? left - 1 : 0;
-    size_t pos = restarts[start_restart];
+    size_t pos = restart_offset(&layout, start_restart);
 
-    // Linear scan from restart point
-    char* current_key = NULL;
+    // Linear scan from restart point, rebuilding keys in a stack buffer
+    // (moved to the heap only for keys longer than SSTABLE_MAX_KEY_SIZE)
+    char stack_key[SSTABLE_MAX_KEY_SIZE];
+    char* current_key = stack_key;
+    size_t current_key_cap = sizeof(stack_key);
     size_t current_key_len = 0;
+    status = STATUS_NOT_FOUND;
 
-    while (pos < restarts_start) {
+    while (pos < scan_end) {
         uint64_t shared, unshared, val_len;
         size_t n = decode_varint(block + pos, restarts_start - pos, &shared);
         if (n == 0) break;
@@ -683,73 +1402,257 @@ static status_t search_block(sstable_reader_t* r, uint8_t* block, size_t block_s
         if (n == 0) break;
         pos += n;
 
-        uint8_t is_deleted = block[pos++];
+        uint8_t entry_type = block[pos++];
 
         if (pos + unshared + val_len > restarts_start) break;
+        if (shared > current_key_len) break;
 
-        // Reconstruct full key
+        // Reconstruct full key: the shared prefix is already in place
         size_t full_key_len = shared + unshared;
-        char* full_key = malloc(full_key_len);
-        if (!full_key) {
-            free(current_key);
-            return STATUS_NO_MEMORY;
-        }
-
-        if (shared > 0 && current_key) {
-            memcpy(full_key, current_key, shared);
+        if (full_key_len > current_key_cap) {
+            size_t new_cap = current_key_cap * 2 > full_key_len ? current_key_cap * 2 : full_key_len;
+            char* new_key = malloc(new_cap);
+            if (!new_key) {
+                status = STATUS_NO_MEMORY;
+                break;
+            }
+            memcpy(new_key, current_key, shared);
+            if (current_key != stack_key) free(current_key);
+            current_key = new_key;
+            current_key_cap = new_cap;
         }
-        memcpy(full_key + shared, block + pos, unshared);
-        pos += unshared;
-
-        free(current_key);
-        current_key = full_key;
+        memcpy(current_key + shared, block + pos, unshared);
         current_key_len = full_key_len;
+        pos += unshared;
 
         int cmp = r->cmp(current_key, current_key_len, key, key_len);
         if (cmp == 0) {
             // Found it
-            *deleted = (is_deleted != 0);
-            if (!*deleted && val_len > 0) {
-                *value = malloc(val_len);
-                if (!*value) {
-                    free(current_key);
-                    return STATUS_NO_MEMORY;
-                }
-                memcpy(*value, block + pos, val_len);
+            *type = entry_type;
+            if (entry_type != SSTABLE_ENTRY_DELETION && val_len > 0) {
+                *value = (const char*)(block + pos);
                 *value_len = val_len;
             } else {
                 *value = NULL;
                 *value_len = 0;
             }
-            free(current_key);
-            return STATUS_OK;
+            status = STATUS_OK;
+            break;
         } else if (cmp > 0) {
             // Passed the target key
-            free(current_key);
-            return STATUS_NOT_FOUND;
+            break;
         }
 
         pos += val_len;
     }
 
-    free(current_key);
-    return STATUS_NOT_FOUND;
+    if (current_key != stack_key) free(current_key);
+    return status;
 }
 
-// Get value for key from SSTable
-status_t sstable_reader_get(sstable_reader_t* r,
-                            const char* key, size_t key_len,
-                            char** value, size_t* value_len,
-                            bool* deleted) {
-    if (!r || !key || !value || !value_len || !deleted) return STATUS_INVALID_ARG;
+// Helper: decode a compressed data block into a new heap buffer
+static status_t decompress_block(const uint8_t* data, size_t len, uint8_t type,
+                                 uint8_t** raw, size_t* raw_len) {
+    if (type != COMPRESSION_LZ4) return STATUS_CORRUPTION;
+
+    uint64_t size;
+    size_t n = decode_varint(data, len, &size);
+    if (n == 0 || size == 0 || size > UINT32_MAX) return STATUS_CORRUPTION;
+
+    uint8_t* buf = malloc(size);
+    if (!buf) return STATUS_NO_MEMORY;
+    status_t status = lz4_decompress(data + n, len - n, buf, size);
+    if (status != STATUS_OK) {
+        free(buf);
+        return STATUS_CORRUPTION;
+    }
+    *raw = buf;
+    *raw_len = size;
+    return STATUS_OK;
+}
 
-    *value = NULL;
-    *value_len = 0;
-    *deleted = false;
+// Helper: read a CRC-protected region (data block or index/filter partition),
+// from the cache if possible. verified is the region's mapped CRC flag; typed
+// regions end in a compression type byte. The view excludes type and crc32.
+static status_t read_checked(sstable_reader_t* r, uint64_t offset, uint32_t size,
+                             uint8_t* verified, bool typed, sstable_block_t* block) {
+    memset(block, 0, sizeof(*block));
+    if (size < 8) return STATUS_CORRUPTION;
+
+    // Mapped: parse in place. The page cache already holds the block, so
+    // the block cache is bypassed unless the block needs decompressing.
+    const uint8_t* data = NULL;
+    if (r->map) {
+        if (offset > r->map_size || size > r->map_size - offset) {
+            return STATUS_CORRUPTION;
+        }
+        data = r->map + offset;
+        if (!__atomic_load_n(verified, __ATOMIC_ACQUIRE)) {
+            uint32_t stored_crc;
+            memcpy(&stored_crc, data + size - 4, 4);
+            if (table_crc(r->footer.flags, data, size - 4) != stored_crc) return STATUS_CORRUPTION;
+            __atomic_store_n(verified, 1, __ATOMIC_RELEASE);
+        }
+        if (!typed || data[size - 5] == COMPRESSION_NONE) {
+            block->data = data;
+            block->size = size - (typed ? 5 : 4);
+            return STATUS_OK;
+        }
+    }
 
-    // Check bloom filter first
-    if (!bloom_may_contain(r->bloom, key, key_len)) {
-        return STATUS_NOT_FOUND;
+    // Cache hit: no syscalls, no copy, no decompression
+    if (r->cache) {
+        cache_entry_t* handle = cache_lookup_block(r->cache, r->file_number, offset);
+        if (handle) {
+            block->data = handle->data;
+            block->size = handle->data_len;
+            block->cache = r->cache;
+            block->handle = handle;
+            return STATUS_OK;
+        }
+    }
+
+    uint8_t* buf = NULL;
+    if (!data) {
+        buf = malloc(size);
+        if (!buf) return STATUS_NO_MEMORY;
+
+        if (pread_all(r->fd, buf, size, offset) != (ssize_t)size) {
+            free(buf);
+            return STATUS_IO_ERROR;
+        }
+
+        // Verify CRC once, before the block becomes visible to other readers
+        uint32_t stored_crc;
+        memcpy(&stored_crc, buf + size - 4, 4);
+        if (table_crc(r->footer.flags, buf, size - 4) != stored_crc) {
+            free(buf);
+            return STATUS_CORRUPTION;
+        }
+        data = buf;
+    }
+
+    size_t len = size - 4;
+    if (typed) {
+        uint8_t type = data[--len];
+        if (type != COMPRESSION_NONE) {
+            uint8_t* raw;
+            size_t raw_len;
+            status_t status = decompress_block(data, len, type, &raw, &raw_len);
+            free(buf);
+            if (status != STATUS_OK) return status;
+            buf = raw;
+            len = raw_len;
+        }
+    }
+
+    block->data = buf;
+    block->size = len;
+
+    if (r->cache) {
+        cache_entry_t* handle = cache_insert_block(r->cache, r->file_number,
+                                                   offset, buf, len);
+        if (handle) {
+            block->cache = r->cache;
+            block->handle = handle;
+            return STATUS_OK;
+        }
+    }
+
+    block->owned = buf;
+    return STATUS_OK;
+}
+
+// Helper: load the index (which = 0) or filter (which = 1) partition p
+static status_t read_partition(sstable_reader_t* r, size_t p, int which,
+                               sstable_block_t* block) {
+    sstable_partition_t* part = &r->parts[p];
+    uint8_t* verified = r->part_verified ? &r->part_verified[2 * p + which] : NULL;
+    return which == 0 ? read_checked(r, part->index_offset, part->index_size, verified, false, block)
+                      : read_checked(r, part->filter_offset, part->filter_size, verified, false, block);
+}
+
+// Helper: decode entry k of an index partition
+//   entries | entry offsets (4B each) | count (4B), crc32 already stripped
+static bool index_part_entry(const sstable_block_t* block, uint32_t k,
+                             const char** key, size_t* key_len,
+                             uint64_t* offset, uint32_t* size) {
+    uint32_t count;
+    memcpy(&count, block->data + block->size - 4, 4);
+    if (k >= count || (size_t)count * 4 > block->size - 4) return false;
+    size_t entries_end = block->size - 4 - (size_t)count * 4;
+
+    uint32_t pos;
+    memcpy(&pos, block->data + entries_end + (size_t)k * 4, 4);
+    if (pos >= entries_end) return false;
+
+    uint64_t len;
+    size_t n = decode_varint(block->data + pos, entries_end - pos, &len);
+    if (n == 0 || pos + n + len + 12 > entries_end) return false;
+
+    *key = (const char*)(block->data + pos + n);
+    *key_len = len;
+    if (offset) memcpy(offset, block->data + pos + n + len, 8);
+    if (size) memcpy(size, block->data + pos + n + len + 8, 4);
+    return true;
+}
+
+// Helper: first partition whose last key is >= key
+static bool find_partition(sstable_reader_t* r, const char* key, size_t key_len, size_t* p) {
+    size_t left = 0, right = r->part_count;
+    while (left < right) {
+        size_t mid = left + (right - left) / 2;
+        int cmp = r->cmp(r->parts[mid].last_key, r->parts[mid].last_key_len, key, key_len);
+        if (cmp < 0) {
+            left = mid + 1;
+        } else {
+            right = mid;
+        }
+    }
+    *p = left;
+    return left < r->part_count;
+}
+
+// Helper: first block of partition p whose last key is >= key
+static status_t search_index_partition(sstable_reader_t* r, size_t p,
+                                       const char* key, size_t key_len,
+                                       size_t* block_idx) {
+    sstable_block_t block;
+    status_t status = read_partition(r, p, 0, &block);
+    if (status != STATUS_OK) return status;
+
+    size_t left = 0, right = r->parts[p].num_blocks;
+    while (left < right) {
+        size_t mid = left + (right - left) / 2;
+        const char* last_key;
+        size_t last_key_len;
+        if (!index_part_entry(&block, (uint32_t)mid, &last_key, &last_key_len, NULL, NULL)) {
+            sstable_block_release(&block);
+            return STATUS_CORRUPTION;
+        }
+        if (r->cmp(last_key, last_key_len, key, key_len) < 0) {
+            left = mid + 1;
+        } else {
+            right = mid;
+        }
+    }
+    sstable_block_release(&block);
+
+    // The partition's last key is >= key, so some block in it qualifies
+    if (left >= r->parts[p].num_blocks) return STATUS_CORRUPTION;
+    *block_idx = r->parts[p].first_block + left;
+    return STATUS_OK;
+}
+
+// Find the first data block whose last key is >= key
+status_t sstable_reader_seek_block(sstable_reader_t* r, const char* key, size_t key_len,
+                                   size_t* block_idx) {
+    if (!r || !key || !block_idx) return STATUS_INVALID_ARG;
+
+    if (r->parts) {
+        size_t p;
+        if (!find_partition(r, key, key_len, &p)) return STATUS_NOT_FOUND;
+        return search_index_partition(r, p, key, key_len, block_idx);
     }
 
     // Binary search index to find candidate block
@@ -768,26 +1671,240 @@ status_t sstable_reader_get(sstable_reader_t* r,
         return STATUS_NOT_FOUND;
     }
 
-    // Read and search the candidate block
-    sstable_index_entry_t* entry = &r->index[left];
-    uint8_t* block = malloc(entry->size);
-    if (!block) return STATUS_NO_MEMORY;
+    *block_idx = left;
+    return STATUS_OK;
+}
 
-    if (lseek(r->fd, entry->offset, SEEK_SET) < 0) {
-        free(block);
-        return STATUS_IO_ERROR;
+// Helper: bloom check + index search; returns the candidate block index
+static status_t find_block(sstable_reader_t* r, const char* key, size_t key_len,
+                           size_t* block_idx) {
+    if (!r->parts) {
+        // Check bloom filter first
+        if (!bloom_may_contain(r->bloom, key, key_len)) {
+            return STATUS_NOT_FOUND;
+        }
+        return sstable_reader_seek_block(r, key, key_len, block_idx);
     }
 
-    if (read_all(r->fd, block, entry->size) != (ssize_t)entry->size) {
-        free(block);
-        return STATUS_IO_ERROR;
+    // Partitioned: the top-level index picks the partition, whose filter
+    // then decides whether its index partition is worth loading
+    size_t p;
+    if (!find_partition(r, key, key_len, &p)) return STATUS_NOT_FOUND;
+
+    sstable_block_t filter;
+    status_t status = read_partition(r, p, 1, &filter);
+    if (status != STATUS_OK) return status;
+    bool may_contain = bloom_may_contain_serialized(filter.data, filter.size, key, key_len);
+    sstable_block_release(&filter);
+    if (!may_contain) return STATUS_NOT_FOUND;
+
+    return search_index_partition(r, p, key, key_len, block_idx);
+}
+
+void sstable_reader_set_prefix_extractor(sstable_reader_t* r, prefix_extractor_fn fn,
+                                         const char* name) {
+    if (!r) return;
+    // Filters built by another extractor would rule out live prefixes
+    bool same = name && r->prefix_name ? strcmp(name, r->prefix_name) == 0
+                                       : !name && !r->prefix_name;
+    r->prefix_extractor = same ? fn : NULL;
+}
+
+const char* sstable_reader_prefix_name(sstable_reader_t* r) {
+    return r ? r->prefix_name : NULL;
+}
+
+bool sstable_reader_prefix_may_match(sstable_reader_t* r, const char* key, size_t key_len) {
+    if (!r || !key || !r->prefix_extractor || !(r->footer.flags & SSTABLE_FLAG_PREFIX)) {
+        return true;
     }
+    size_t prefix_len = r->prefix_extractor(key, key_len);
+    if (prefix_len > key_len) prefix_len = key_len;
+
+    if (!r->parts) return bloom_may_contain(r->bloom, key, prefix_len);
+
+    // Partitioned: keys with the prefix may run over several partitions,
+    // starting from the one a seek to key lands in
+    size_t p;
+    if (!find_partition(r, key, key_len, &p)) return false;
+    for (; p < r->part_count; p++) {
+        sstable_block_t filter;
+        if (read_partition(r, p, 1, &filter) != STATUS_OK) return true;
+        bool may_match = bloom_may_contain_serialized(filter.data, filter.size, key, prefix_len);
+        sstable_block_release(&filter);
+        if (may_match) return true;
+
+        // Later partitions can only hold the prefix if this one ends inside it
+        const sstable_partition_t* part = &r->parts[p];
+        if (part->last_key_len < prefix_len ||
+            r->prefix_extractor(part->last_key, part->last_key_len) != prefix_len ||
+            memcmp(part->last_key, key, prefix_len) != 0) {
+            return false;
+        }
+    }
+    return false;
+}
+
+// Get entry for key from SSTable
+status_t sstable_reader_get_entry(sstable_reader_t* r,
+                                  const char* key, size_t key_len,
+                                  char** value, size_t* value_len,
+                                  uint8_t* type) {
+    if (!r || !key || !value || !value_len || !type) return STATUS_INVALID_ARG;
+
+    *value = NULL;
+    *value_len = 0;
+
+    const char* found;
+    size_t found_len;
+    sstable_block_t block;
+    status_t status = sstable_reader_get_pinned(r, key, key_len, &found, &found_len, type, &block);
+    if (status == STATUS_OK && found_len > 0) {
+        *value = malloc(found_len);
+        if (*value) {
+            memcpy(*value, found, found_len);
+            *value_len = found_len;
+        } else {
+            status = STATUS_NO_MEMORY;
+        }
+    }
+    sstable_block_release(&block);
+    return status;
+}
+
+// Get entry for key, pinning the block that holds it
+status_t sstable_reader_get_pinned(sstable_reader_t* r,
+                                   const char* key, size_t key_len,
+                                   const char** value, size_t* value_len,
+                                   uint8_t* type, sstable_block_t* block) {
+    if (!r || !key || !value || !value_len || !type || !block) return STATUS_INVALID_ARG;
+
+    *value = NULL;
+    *value_len = 0;
+    *type = SSTABLE_ENTRY_VALUE;
+    memset(block, 0, sizeof(*block));
+
+    size_t block_idx;
+    status_t status = find_block(r, key, key_len, &block_idx);
+    if (status != STATUS_OK) return status;
+
+    // Read and search the candidate block
+    status = sstable_reader_read_block(r, block_idx, block);
+    if (status != STATUS_OK) return status;
 
-    status_t status = search_block(r, block, entry->size, key, key_len, value, value_len, deleted);
-    free(block);
+    status = search_block(r, block->data, block->size, key, key_len, value, value_len, type);
+    if (status != STATUS_OK) sstable_block_release(block);
+    return status;
+}
+
+// Get value for key from SSTable
+status_t sstable_reader_get(sstable_reader_t* r,
+                            const char* key, size_t key_len,
+                            char** value, size_t* value_len,
+                            bool* deleted) {
+    if (!deleted) return STATUS_INVALID_ARG;
+    *deleted = false;
+
+    uint8_t type;
+    status_t status = sstable_reader_get_entry(r, key, key_len, value, value_len, &type);
+    if (status == STATUS_OK && type == SSTABLE_ENTRY_BLOB) {
+        free(*value);
+        *value = NULL;
+        *value_len = 0;
+        return STATUS_INVALID_ARG;
+    }
+    *deleted = (type == SSTABLE_ENTRY_DELETION);
     return status;
 }
 
+// Zero-copy lookup on a mapped reader
+status_t sstable_reader_get_ref(sstable_reader_t* r,
+                                const char* key, size_t key_len,
+                                const char** value, size_t* value_len,
+                                bool* deleted) {
+    if (!r || !key || !value || !value_len || !deleted) return STATUS_INVALID_ARG;
+    if (!r->map || (r->footer.flags & SSTABLE_FLAG_COMPRESSED)) return STATUS_INVALID_ARG;
+
+    *value = NULL;
+    *value_len = 0;
+    *deleted = false;
+
+    size_t block_idx;
+    status_t status = find_block(r, key, key_len, &block_idx);
+    if (status != STATUS_OK) return status;
+
+    // Mapped blocks never own memory, so there is nothing to release
+    sstable_block_t block;
+    status = sstable_reader_read_block(r, block_idx, &block);
+    if (status != STATUS_OK) return status;
+
+    uint8_t type = SSTABLE_ENTRY_VALUE;
+    status = search_block(r, block.data, block.size, key, key_len, value, value_len, &type);
+    if (status == STATUS_OK && type == SSTABLE_ENTRY_BLOB) {
+        *value = NULL;
+        *value_len = 0;
+        return STATUS_INVALID_ARG;
+    }
+    *deleted = (type == SSTABLE_ENTRY_DELETION);
+    return status;
+}
+
+// Attach block cache
+void sstable_reader_set_cache(sstable_reader_t* r, block_cache_t* cache,
+                              uint64_t file_number) {
+    if (!r) return;
+    r->cache = cache;
+    r->file_number = file_number;
+}
+
+// Read a data block, from the cache if possible
+status_t sstable_reader_read_block(sstable_reader_t* r, size_t block_idx,
+                                   sstable_block_t* block) {
+    if (!r || !block || block_idx >= r->index_count) return STATUS_INVALID_ARG;
+
+    uint64_t offset;
+    uint32_t size;
+    if (r->parts) {
+        // Largest partition starting at or before block_idx
+        size_t left = 0, right = r->part_count;
+        while (right - left > 1) {
+            size_t mid = left + (right - left) / 2;
+            if (r->parts[mid].first_block <= block_idx) {
+                left = mid;
+            } else {
+                right = mid;
+            }
+        }
+
+        sstable_block_t index;
+        status_t status = read_partition(r, left, 0, &index);
+        if (status != STATUS_OK) return status;
+        const char* last_key;
+        size_t last_key_len;
+        bool ok = index_part_entry(&index, (uint32_t)(block_idx - r->parts[left].first_block),
+                                   &last_key, &last_key_len, &offset, &size);
+        sstable_block_release(&index);
+        if (!ok) return STATUS_CORRUPTION;
+    } else {
+        offset = r->index[block_idx].offset;
+        size = r->index[block_idx].size;
+    }
+
+    bool typed = (r->footer.flags & SSTABLE_FLAG_BLOCK_TYPE) != 0;
+    return read_checked(r, offset, size, r->verified ? &r->verified[block_idx] : NULL,
+                        typed, block);
+}
+
+// Release a block obtained from sstable_reader_read_block
+void sstable_block_release(sstable_block_t* block) {
+    if (!block) return;
+    if (block->handle) {
+        cache_release(block->cache, block->handle);
+    }
+    free(block->owned);
+    memset(block, 0, sizeof(*block));
+}
+
 // Utility functions
 const char* sstable_reader_min_key(sstable_reader_t* r, size_t* len) {
     if (!r || !len) return NULL;
@@ -804,3 +1921,11 @@ const char* sstable_reader_max_key(sstable_reader_t* r, size_t* len) {
 uint64_t sstable_reader_num_entries(sstable_reader_t* r) {
     return r ? r->footer.num_entries : 0;
 }
+
+const range_del_list_t* sstable_reader_range_dels(sstable_reader_t* r) {
+    return r ? &r->range_dels : NULL;
+}
+
+bool sstable_reader_range_del_covers(sstable_reader_t* r, const char* key, size_t key_len) {
+    return r && range_del_covers(&r->range_dels, r->cmp, key, key_len);
+}
@@ -3,12 +3,50 @@
 
 #include "types.h"
 #include "bloom.h"
+#include "cache.h"
+#include "range_del.h"
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
 
-// SSTable magic number
-#define SSTABLE_MAGIC 0x535354424C455631ULL  // "SSTBLEV1"
+// SSTable magic numbers (the magic also identifies the footer version)
+#define SSTABLE_MAGIC    0x535354424C455631ULL  // "SSTBLEV1": no flags field
+#define SSTABLE_MAGIC_V2 0x535354424C455632ULL  // "SSTBLEV2": footer carries flags
+
+// Footer flags (version 1 tables have none)
+#define SSTABLE_FLAG_PARTITIONED 0x1    // Partitioned index and filters
+#define SSTABLE_FLAG_BLOCK_TYPE  0x2    // Data blocks carry a compression type byte
+#define SSTABLE_FLAG_COMPRESSED  0x4    // At least one data block is compressed
+#define SSTABLE_FLAG_CRC32C      0x8    // Checksums are CRC32C (else CRC-32)
+#define SSTABLE_FLAG_BLOB        0x10   // Some values are blob references
+#define SSTABLE_FLAG_RANGE_DEL   0x20   // Range-deletion block before the footer
+#define SSTABLE_FLAG_PREFIX      0x40   // Filters also hold every key prefix
+#define SSTABLE_FLAG_PREFIX_NAME 0x80   // Prefix block names the extractor
+
+// Entry type byte, stored after the lengths of each data block entry
+#define SSTABLE_ENTRY_VALUE      0
+#define SSTABLE_ENTRY_DELETION   1
+#define SSTABLE_ENTRY_BLOB       2      // Value is an encoded blob reference (blob.h)
+
+// Partitioned layout (SSTABLE_FLAG_PARTITIONED): the footer's index points
+// at a small top-level index of partitions; bloom_offset/size are unused.
+// Each partition covers up to SSTABLE_PARTITION_BLOCKS data blocks and has
+//   - an index partition: entries | entry offsets (uint32 each) | count (uint32) | crc32
+//   - a filter partition: serialized blocked bloom filter | crc32
+// Both are loaded on demand through the block cache.
+
+// Range-deletion block (SSTABLE_FLAG_RANGE_DEL), right before the footer:
+//   payload (range_del.h) | crc32c(payload) | block size (uint32, payload + crc)
+// The tombstones cover entries of older tables only; the footer's min/max
+// keys span them too (max key is the largest exclusive end).
+
+// Prefix block (SSTABLE_FLAG_PREFIX_NAME), before the range-deletion block
+// if any, else right before the footer:
+//   extractor name | crc32c(name) | block size (uint32, name + crc)
+// Readers use the prefix filters only under the extractor of that name.
+
+// sstable_reader_open_ex flags
+#define SSTABLE_OPEN_MMAP 0x1   // Map the file read-only and parse blocks in place
 
 // Maximum key size for footer
 #define SSTABLE_MAX_KEY_SIZE 256
@@ -24,10 +62,45 @@ typedef struct {
     char min_key[SSTABLE_MAX_KEY_SIZE];
     uint32_t max_key_len;
     char max_key[SSTABLE_MAX_KEY_SIZE];
+    uint32_t flags;         // SSTABLE_FLAG_* (absent from version 1 footers)
     uint64_t magic;
     uint32_t crc32;
 } sstable_footer_t;
 
+// Version 1 footers are the fields up to max_key, then magic and crc32.
+// Both versions end in magic | crc32 | 4 bytes of padding.
+#define SSTABLE_FOOTER_V1_SIZE (offsetof(sstable_footer_t, flags) + 16)
+
+// Data block layout:
+//   entries | restarts[num_restarts] (uint32 each)
+//   | [buckets[num_buckets] (uint8 each) | num_buckets (uint16)]
+//   | num_restarts (uint32, top bit set when the hash index is present)
+//   | [type (uint8, SSTABLE_FLAG_BLOCK_TYPE)] | crc32 (uint32)
+// type is a compression_t. Compressed blocks store
+//   raw size (varint) | codec output | type | crc32
+// and are decompressed on read, before they enter the block cache.
+// Each hash bucket holds the restart interval of the key(s) hashing to it,
+// or one of the markers below.
+#define SSTABLE_BLOCK_HASH_FLAG     0x80000000u
+#define SSTABLE_HASH_EMPTY          255     // No key in this bucket
+#define SSTABLE_HASH_COLLISION      254     // Keys from several intervals
+#define SSTABLE_HASH_MAX_RESTARTS   254     // Larger blocks get no hash index
+
+// Parsed data block trailer
+typedef struct {
+    size_t data_end;                // Entries occupy [0, data_end)
+    const uint8_t* restarts;        // num_restarts uint32 offsets
+    uint32_t num_restarts;
+    const uint8_t* buckets;         // NULL when the block has no hash index
+    uint32_t num_buckets;
+} sstable_block_layout_t;
+
+// Hash index entry collected while a block is being built
+typedef struct {
+    uint32_t hash;
+    uint8_t restart;
+} sstable_hash_entry_t;
+
 // Index entry (points to a data block)
 typedef struct {
     char* last_key;         // Last key in the block
@@ -36,6 +109,18 @@ typedef struct {
     uint32_t size;          // Block size
 } sstable_index_entry_t;
 
+// Top-level index entry of a partitioned table
+typedef struct {
+    char* last_key;             // Last key of the partition's last block
+    size_t last_key_len;
+    uint32_t first_block;       // Global index of the first data block
+    uint32_t num_blocks;
+    uint64_t index_offset;      // Index partition
+    uint32_t index_size;
+    uint64_t filter_offset;     // Filter partition
+    uint32_t filter_size;
+} sstable_partition_t;
+
 // SSTable writer
 struct sstable_writer {
     char* path;
@@ -53,17 +138,64 @@ struct sstable_writer {
     size_t restart_capacity;
     size_t entries_since_restart;
 
-    // Previous key for prefix compression
+    // Hash index for the current block (bytewise comparator only)
+    bool hash_index;
+    sstable_hash_entry_t* hashes;
+    size_t hash_count;
+    size_t hash_capacity;
+
+    // Previous key for prefix compression (buffer reused across entries)
     char* prev_key;
     size_t prev_key_len;
+    size_t prev_key_cap;
 
     // Index entries
     sstable_index_entry_t* index;
     size_t index_count;
     size_t index_capacity;
 
-    // Bloom filter
+    // Bloom filter (whole-table layout)
     bloom_filter_t* bloom;
+    size_t estimated_entries;
+
+    // Partitioned layout: key hashes of the open partition, closed partitions
+    bool partitioned;
+    uint64_t* part_hashes;
+    size_t part_hash_count;
+    size_t part_hash_capacity;
+    sstable_partition_t* parts;
+    size_t part_count;
+    size_t part_capacity;
+    size_t part_first_block;
+
+    // Block compression (blocks that don't shrink enough stay raw)
+    compression_t compression;
+    uint8_t* compress_buf;
+    size_t compress_cap;
+    uint64_t compressed_blocks;
+
+    // Entries whose value is a blob reference
+    uint64_t blob_refs;
+
+    // Prefix filter: the prefix last added, so each one goes in once per filter
+    prefix_extractor_fn prefix_extractor;
+    char* prefix_name;
+    char* last_prefix;
+    size_t last_prefix_len;
+    size_t last_prefix_cap;
+    bool has_last_prefix;
+
+    // Range tombstones (encoded, without the count) and the keys they span
+    uint8_t* range_del_buf;
+    size_t range_del_len;
+    size_t range_del_cap;
+    uint64_t range_del_count;
+    char* range_del_min;
+    size_t range_del_min_len;
+    size_t range_del_min_cap;
+    char* range_del_max;
+    size_t range_del_max_len;
+    size_t range_del_max_cap;
 
     // Statistics
     uint64_t num_entries;
@@ -74,9 +206,12 @@ struct sstable_writer {
     size_t min_key_len;
     char* max_key;
     size_t max_key_len;
+    size_t max_key_cap;
 };
 
 // SSTable reader
+// Safe to share between threads: blocks are fetched with pread() and the
+// file offset is never moved.
 struct sstable_reader {
     char* path;
     int fd;
@@ -85,14 +220,52 @@ struct sstable_reader {
     // Footer info
     sstable_footer_t footer;
 
-    // Index (loaded into memory)
+    // Index (loaded into memory; NULL when partitioned)
     sstable_index_entry_t* index;
-    size_t index_count;
+    size_t index_count;         // Number of data blocks
 
-    // Bloom filter
+    // Bloom filter (NULL when partitioned)
     bloom_filter_t* bloom;
+
+    // Partitioned layout: only the top-level index stays resident
+    sstable_partition_t* parts;
+    size_t part_count;
+    uint8_t* part_verified;     // Mapped CRC flags: [2p] index, [2p + 1] filter
+
+    // Read-only mapping of the whole file (SSTABLE_OPEN_MMAP), else NULL
+    size_t file_size;
+    const uint8_t* map;
+    size_t map_size;
+    uint8_t* verified;          // Per data block: CRC already checked
+
+    // Block cache (optional, shared across readers; unused when mapped)
+    block_cache_t* cache;
+    uint64_t file_number;
+
+    // Prefix seeks consult the filters only if the table has prefixes
+    // built by the same extractor (NULL otherwise)
+    prefix_extractor_fn prefix_extractor;
+    char* prefix_name;          // Extractor named in the table, or NULL
+
+    // Range tombstones, resident (they point into range_del_buf)
+    uint8_t* range_del_buf;
+    size_t range_del_size;
+    range_del_list_t range_dels;
+
+    // Owners (level manager, open iterators); closed on the last release
+    int refs;
 };
 
+// Data block view: a private heap buffer, a pinned cache entry, or a slice
+// of the reader's mapping (no owner; valid while the reader is referenced)
+typedef struct {
+    const uint8_t* data;
+    size_t size;
+    uint8_t* owned;             // Heap buffer when the block is not cached
+    block_cache_t* cache;
+    cache_entry_t* handle;      // Pinned cache entry
+} sstable_block_t;
+
 // Writer API
 sstable_writer_t* sstable_writer_create(const char* path,
                                          size_t estimated_entries,
@@ -101,20 +274,108 @@ status_t sstable_writer_add(sstable_writer_t* writer,
                             const char* key, size_t key_len,
                             const char* value, size_t value_len,
                             bool deleted);
+// Add an entry whose value lives in a blob file; ref is an encoded blob_ref_t
+status_t sstable_writer_add_blob(sstable_writer_t* writer,
+                                 const char* key, size_t key_len,
+                                 const char* ref, size_t ref_len);
+// Add a range tombstone (any order, before finish)
+status_t sstable_writer_add_range_tombstone(sstable_writer_t* writer,
+                                            const range_tombstone_t* t);
 status_t sstable_writer_finish(sstable_writer_t* writer);
 void sstable_writer_abort(sstable_writer_t* writer);
+// Use the partitioned index/filter layout (default: estimated entries >=
+// SSTABLE_PARTITION_MIN_ENTRIES). Call before the first add.
+status_t sstable_writer_set_partitioned(sstable_writer_t* writer, bool enabled);
+// Enable/disable the per-block hash index (on by default for the default
+// comparator; ignored for custom comparators). Call before the first add.
+void sstable_writer_set_hash_index(sstable_writer_t* writer, bool enabled);
+// Also add the prefix of every key to the filters (the bloom filter of the
+// whole-table layout is resized for it) and record name, if not NULL, as
+// the extractor's. Call before the first add.
+status_t sstable_writer_set_prefix_extractor(sstable_writer_t* writer, prefix_extractor_fn fn,
+                                             const char* name);
+// Codec for data blocks flushed from now on (default: COMPRESSION_NONE)
+status_t sstable_writer_set_compression(sstable_writer_t* writer, compression_t compression);
+// Bytes written so far plus the open data block; index and filters not included
+uint64_t sstable_writer_file_size(sstable_writer_t* writer);
 
 // Reader API
 sstable_reader_t* sstable_reader_open(const char* path, compare_fn cmp);
+sstable_reader_t* sstable_reader_open_ex(const char* path, compare_fn cmp, int flags);
+// Drops one reference; the file is closed when the last one goes away
 void sstable_reader_close(sstable_reader_t* reader);
+void sstable_reader_ref(sstable_reader_t* reader);
+// Blob references are not resolved here: a key whose value is a blob
+// reference returns STATUS_INVALID_ARG (see sstable_reader_get_entry)
 status_t sstable_reader_get(sstable_reader_t* reader,
                             const char* key, size_t key_len,
                             char** value, size_t* value_len,
                             bool* deleted);
+// Like sstable_reader_get, but reports the entry type (SSTABLE_ENTRY_*);
+// for SSTABLE_ENTRY_BLOB, *value is the encoded blob reference
+status_t sstable_reader_get_entry(sstable_reader_t* reader,
+                                  const char* key, size_t key_len,
+                                  char** value, size_t* value_len,
+                                  uint8_t* type);
+// Like sstable_reader_get_entry without the copy: on STATUS_OK *value
+// points into *block, which stays pinned until sstable_block_release
+// (mapped blocks also need a reference on the reader until then)
+status_t sstable_reader_get_pinned(sstable_reader_t* reader,
+                                   const char* key, size_t key_len,
+                                   const char** value, size_t* value_len,
+                                   uint8_t* type, sstable_block_t* block);
+// Zero-copy variant for mapped readers of uncompressed tables
+// (STATUS_INVALID_ARG otherwise, and for blob references).
+// *value points into the mapping and stays valid while the caller holds a
+// reference on the reader.
+status_t sstable_reader_get_ref(sstable_reader_t* reader,
+                                const char* key, size_t key_len,
+                                const char** value, size_t* value_len,
+                                bool* deleted);
+bool sstable_reader_is_mapped(sstable_reader_t* reader);
+bool sstable_reader_is_partitioned(sstable_reader_t* reader);
+// Memory held by the reader itself (index, filter, bookkeeping); blocks in
+// the shared cache are not counted
+size_t sstable_reader_resident_bytes(sstable_reader_t* reader);
+// First data block whose last key is >= key (STATUS_NOT_FOUND past the end)
+status_t sstable_reader_seek_block(sstable_reader_t* reader,
+                                   const char* key, size_t key_len,
+                                   size_t* block_idx);
+
+// Extractor for sstable_reader_prefix_may_match; ignored (every prefix may
+// match) unless name is the one the writer recorded (both NULL also match)
+void sstable_reader_set_prefix_extractor(sstable_reader_t* reader, prefix_extractor_fn fn,
+                                         const char* name);
+// Extractor named in the table (NULL if none)
+const char* sstable_reader_prefix_name(sstable_reader_t* reader);
+// Check if the table may hold keys with the prefix of key at or after key;
+// true unless the table has prefix filters and they rule the prefix out
+bool sstable_reader_prefix_may_match(sstable_reader_t* reader,
+                                     const char* key, size_t key_len);
+
+// Attach a block cache; blocks are keyed by (file_number, offset)
+void sstable_reader_set_cache(sstable_reader_t* reader, block_cache_t* cache,
+                              uint64_t file_number);
+
+// Read data block block_idx (CRC verified, decompressed, trailer stripped),
+// consulting the cache if attached
+status_t sstable_reader_read_block(sstable_reader_t* reader, size_t block_idx,
+                                   sstable_block_t* block);
+void sstable_block_release(sstable_block_t* block);
+
+// Parse a data block's trailer (restarts and optional hash index); block is
+// the contents returned by sstable_reader_read_block
+status_t sstable_block_layout(const uint8_t* block, size_t size,
+                              sstable_block_layout_t* layout);
 
 // Utility
 const char* sstable_reader_min_key(sstable_reader_t* reader, size_t* len);
 const char* sstable_reader_max_key(sstable_reader_t* reader, size_t* len);
 uint64_t sstable_reader_num_entries(sstable_reader_t* reader);
+// Range tombstones of the table (empty list if none)
+const range_del_list_t* sstable_reader_range_dels(sstable_reader_t* reader);
+// Check if a range tombstone of the table deletes key
+bool sstable_reader_range_del_covers(sstable_reader_t* reader,
+                                     const char* key, size_t key_len);
 
 #endif // SSTABLE_H
@@ -0,0 +1,305 @@
+/*
+ * SSTable Read-Path Micro-benchmark
+ *
+ * Counts heap allocations per operation: the binary is linked with
+ * -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc so every allocation made
+ * by the engine goes through the counters below.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "sstable.h"
+#include "bloom.h"
+#include "compact.h"
+#include "iterator.h"
+
+#define KEY_SIZE 24
+#define VALUE_SIZE 100
+#define TABLE_A "bench_sstable_a.sst"
+#define TABLE_B "bench_sstable_b.sst"
+#define TABLE_OUT "bench_sstable_out.sst"
+#define TABLE_JSON "bench_sstable_json.sst"
+
+// Allocation counters (linker-wrapped allocator)
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t n, size_t size);
+void* __real_realloc(void* p, size_t size);
+
+static size_t alloc_count = 0;
+
+void* __wrap_malloc(size_t size) {
+    alloc_count++;
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t n, size_t size) {
+    alloc_count++;
+    return __real_calloc(n, size);
+}
+
+void* __wrap_realloc(void* p, size_t size) {
+    alloc_count++;
+    return __real_realloc(p, size);
+}
+
+// Get current time in microseconds
+static uint64_t now_usec(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+// Helper: long keys with a shared prefix, like real prefix-compressed tables
+static void make_key(char* buf, int index) {
+    snprintf(buf, KEY_SIZE, "user:profile:%010d", index);
+}
+
+// Helper: print one result line
+static void print_result(const char* name, size_t ops, uint64_t elapsed, size_t allocs) {
+    double secs = elapsed / 1000000.0;
+    printf("  %-30s %10.0f ops/sec  %6.2f allocs/op\n",
+           name, ops / secs, (double)allocs / ops);
+}
+
+// Helper: write keys start, start + step, ... into path
+static int write_table(const char* path, int count, int start, int step) {
+    sstable_writer_t* w = sstable_writer_create(path, count, NULL);
+    if (!w) return -1;
+
+    char key[KEY_SIZE];
+    char value[VALUE_SIZE];
+    memset(value, 'v', sizeof(value));
+    for (int i = 0; i < count; i++) {
+        make_key(key, start + i * step);
+        if (sstable_writer_add(w, key, strlen(key), value, sizeof(value), false) != STATUS_OK) {
+            sstable_writer_abort(w);
+            return -1;
+        }
+    }
+    return sstable_writer_finish(w) == STATUS_OK ? 0 : -1;
+}
+
+// Benchmark: point lookups through read() and through the mapping
+static void bench_get(int count, int lookups) {
+    char key[KEY_SIZE];
+    unsigned seed = 1;
+
+    for (int mode = 0; mode < 2; mode++) {
+        sstable_reader_t* r = sstable_reader_open_ex(TABLE_A, NULL,
+                                                     mode ? SSTABLE_OPEN_MMAP : 0);
+        if (!r) return;
+
+        size_t allocs = alloc_count;
+        uint64_t start = now_usec();
+        for (int i = 0; i < lookups; i++) {
+            make_key(key, 2 * (rand_r(&seed) % count));
+            size_t len;
+            bool deleted;
+            if (mode) {
+                const char* ref;
+                sstable_reader_get_ref(r, key, strlen(key), &ref, &len, &deleted);
+            } else {
+                char* val = NULL;
+                sstable_reader_get(r, key, strlen(key), &val, &len, &deleted);
+                free(val);
+            }
+        }
+        print_result(mode ? "get_ref (mmap, zero-copy)" : "get (read + value copy)",
+                     lookups, now_usec() - start, alloc_count - allocs);
+
+        sstable_reader_close(r);
+    }
+}
+
+// Benchmark: full scan with the SSTable iterator
+static void bench_scan(void) {
+    sstable_reader_t* r = sstable_reader_open_ex(TABLE_A, NULL, SSTABLE_OPEN_MMAP);
+    if (!r) return;
+    sstable_iter_t* it = sstable_iter_create(r);
+
+    size_t entries = 0;
+    size_t allocs = alloc_count;
+    uint64_t start = now_usec();
+    for (sstable_iter_seek_to_first(it); sstable_iter_valid(it); sstable_iter_next(it)) {
+        entries++;
+    }
+    print_result("iterator scan (per entry)", entries, now_usec() - start,
+                 alloc_count - allocs);
+
+    sstable_iter_destroy(it);
+    sstable_reader_close(r);
+}
+
+// Benchmark: merge two tables into a new one, as compaction does
+static void bench_merge(void) {
+    sstable_reader_t* a = sstable_reader_open_ex(TABLE_A, NULL, SSTABLE_OPEN_MMAP);
+    sstable_reader_t* b = sstable_reader_open_ex(TABLE_B, NULL, SSTABLE_OPEN_MMAP);
+    if (!a || !b) {
+        sstable_reader_close(a);
+        sstable_reader_close(b);
+        return;
+    }
+
+    iterator_t* children[2] = { iterator_from_sstable(a), iterator_from_sstable(b) };
+    iterator_t* merge = merge_iter_create(children, 2, NULL);
+    sstable_writer_t* w = sstable_writer_create(TABLE_OUT,
+                                                sstable_reader_num_entries(a) +
+                                                sstable_reader_num_entries(b), NULL);
+    if (!merge || !w) {
+        iterator_destroy(merge);
+        sstable_writer_abort(w);
+        sstable_reader_close(a);
+        sstable_reader_close(b);
+        return;
+    }
+
+    size_t entries = 0;
+    size_t allocs = alloc_count;
+    uint64_t start = now_usec();
+    for (iterator_seek_to_first(merge); iterator_valid(merge); iterator_next(merge)) {
+        size_t key_len, val_len;
+        const char* key = iterator_key(merge, &key_len);
+        const char* val = iterator_value(merge, &val_len);
+        sstable_writer_add(w, key, key_len, val, val_len, iterator_is_deleted(merge));
+        entries++;
+    }
+    print_result("compaction merge (per entry)", entries, now_usec() - start,
+                 alloc_count - allocs);
+
+    sstable_writer_finish(w);
+    iterator_destroy(merge);
+    sstable_reader_close(a);
+    sstable_reader_close(b);
+}
+
+// Benchmark: negative filter probes, legacy vs cache-line blocked
+static void bench_bloom(int count) {
+    char key[KEY_SIZE];
+    // Several tables' worth of filter, so probes miss the CPU caches
+    int keys = count * 8;
+    int probes = count * 2;
+
+    for (int format = BLOOM_FORMAT_LEGACY; format <= BLOOM_FORMAT_BLOCKED; format++) {
+        bloom_filter_t* bf = bloom_create_format(keys, (uint8_t)format);
+        if (!bf) return;
+        for (int i = 0; i < keys; i++) {
+            make_key(key, 2 * i);
+            bloom_add(bf, key, strlen(key));
+        }
+
+        // Keys are built up front so the loop times only the probes
+        char (*probe_keys)[KEY_SIZE] = malloc((size_t)probes * KEY_SIZE);
+        if (!probe_keys) {
+            bloom_destroy(bf);
+            return;
+        }
+        for (int i = 0; i < probes; i++) {
+            make_key(probe_keys[i], 2 * i + 1);
+        }
+
+        int false_positives = 0;
+        uint64_t start = now_usec();
+        for (int i = 0; i < probes; i++) {
+            if (bloom_may_contain(bf, probe_keys[i], KEY_SIZE - 1)) false_positives++;
+        }
+        uint64_t elapsed = now_usec() - start;
+
+        char name[64];
+        snprintf(name, sizeof(name), "bloom miss (%s)",
+                 format == BLOOM_FORMAT_BLOCKED ? bloom_probe_impl() : "legacy");
+        print_result(name, probes, elapsed, 0);
+        printf("  %-30s %9.2f%% false positives\n", "", 100.0 * false_positives / probes);
+
+        free(probe_keys);
+        bloom_destroy(bf);
+    }
+}
+
+// Helper: JSON document value, compressible the way real documents are
+static size_t make_json(char* buf, size_t cap, int index) {
+    return (size_t)snprintf(buf, cap,
+                            "{\"id\":%d,\"name\":\"user%d\",\"email\":\"user%d@example.com\","
+                            "\"active\":%s,\"score\":%d,\"tags\":[\"alpha\",\"beta\"],"
+                            "\"address\":{\"city\":\"Springfield\",\"zip\":\"%05d\"}}",
+                            index, index, index, index % 3 ? "true" : "false",
+                            index % 1000, index % 100000);
+}
+
+// Benchmark: on-disk size and block decode throughput per codec
+static void bench_compression(int count) {
+    char key[KEY_SIZE];
+    char value[256];
+    long raw_size = 0;
+
+    for (int codec = COMPRESSION_NONE; codec <= COMPRESSION_LZ4; codec++) {
+        sstable_writer_t* w = sstable_writer_create(TABLE_JSON, count, NULL);
+        if (!w) return;
+        sstable_writer_set_compression(w, (compression_t)codec);
+        for (int i = 0; i < count; i++) {
+            make_key(key, i);
+            size_t len = make_json(value, sizeof(value), i);
+            sstable_writer_add(w, key, strlen(key), value, len, false);
+        }
+        if (sstable_writer_finish(w) != STATUS_OK) return;
+
+        struct stat st;
+        if (stat(TABLE_JSON, &st) != 0) return;
+        if (codec == COMPRESSION_NONE) raw_size = st.st_size;
+
+        // Every block through pread + CRC (+ decompress), no block cache
+        sstable_reader_t* r = sstable_reader_open(TABLE_JSON, NULL);
+        if (!r) return;
+        size_t decoded = 0;
+        uint64_t start = now_usec();
+        for (int pass = 0; pass < 5; pass++) {
+            for (size_t b = 0; b < r->index_count; b++) {
+                sstable_block_t block;
+                if (sstable_reader_read_block(r, b, &block) != STATUS_OK) break;
+                decoded += block.size;
+                sstable_block_release(&block);
+            }
+        }
+        double secs = (now_usec() - start) / 1000000.0;
+        sstable_reader_close(r);
+
+        printf("  %-30s %10ld bytes  %5.2fx  %8.1f MB/s decoded\n",
+               codec == COMPRESSION_LZ4 ? "json blocks (lz4)" : "json blocks (raw)",
+               (long)st.st_size, (double)raw_size / st.st_size,
+               decoded / secs / (1024 * 1024));
+    }
+    unlink(TABLE_JSON);
+}
+
+int main(int argc, char** argv) {
+    int count = 200000;
+    if (argc > 1) {
+        count = atoi(argv[1]);
+        if (count <= 0) count = 200000;
+    }
+
+    // Even keys in A, odd keys in B
+    if (write_table(TABLE_A, count, 0, 2) != 0 || write_table(TABLE_B, count, 1, 2) != 0) {
+        printf("Failed to write tables\n");
+        return 1;
+    }
+
+    printf("SSTable Read-Path Benchmark\n");
+    printf("===========================\n");
+    printf("Entries per table: %d\n\n", count);
+
+    bench_get(count, count);
+    bench_scan();
+    bench_merge();
+    bench_bloom(count);
+    bench_compression(count);
+
+    unlink(TABLE_A);
+    unlink(TABLE_B);
+    unlink(TABLE_OUT);
+    return 0;
+}
@@ -1,14 +1,20 @@
 #include "storage.h"
 #include "compact.h"
 #include "manifest.h"
+#include "blob.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <sys/stat.h>
 #include <errno.h>
 #include <dirent.h>
+#include <unistd.h>
+#include <fcntl.h>
 
-// WAL recovery callback
+#define WAL_FILENAME      "wal.log"
+#define IMM_WAL_FILENAME  "wal.imm.log"    // WAL of the memtable being flushed
+
+// WAL recovery callback (also applies write batches to the memtable)
 static status_t recover_callback(void* ctx, wal_record_type_t type,
                                   const char* key, size_t key_len,
                                   const char* val, size_t val_len) {
@@ -18,6 +24,11 @@ static status_t recover_callback(void* ctx, wal_record_type_t type,
         return memtable_put(mt, key, key_len, val, val_len);
     } else if (type == WAL_RECORD_DELETE) {
         return memtable_delete(mt, key, key_len);
+    } else if (type == WAL_RECORD_DELETE_RANGE) {
+        // Empty or reversed ranges, logged before batches were checked,
+        // delete nothing
+        status_t status = memtable_delete_range(mt, key, key_len, val, val_len);
+        return status == STATUS_INVALID_ARG ? STATUS_OK : status;
     }
     return STATUS_CORRUPTION;
 }
@@ -34,20 +45,570 @@ static int ensure_directory(const char* path) {
     return -1;
 }
 
+// Helper: build "<dir>/<name>" (caller frees)
+static char* build_path(const char* dir, const char* name) {
+    size_t len = strlen(dir) + strlen(name) + 2;
+    char* path = malloc(len);
+    if (path) {
+        snprintf(path, len, "%s/%s", dir, name);
+    }
+    return path;
+}
+
+// Helper: free everything owned by db (worker must not be running)
+static void storage_release(storage_t* db) {
+    level_manager_destroy(db->levels);
+    cache_destroy(db->cache);
+    if (db->wal) {
+        wal_close(db->wal);
+    }
+    memtable_unref(db->memtable);
+    memtable_unref(db->imm);
+    free(db->group);
+    pthread_cond_destroy(&db->done_cv);
+    pthread_cond_destroy(&db->bg_cv);
+    pthread_mutex_destroy(&db->mutex);
+    free(db->path);
+    free(db);
+}
+
+// ============================================================
+// Background flush and compaction
+// ============================================================
+
+// Helper: write one memtable entry; values of at least blob_min_size go
+// to the flush's blob file (created on first use)
+static status_t add_level0_entry(storage_t* db, sstable_writer_t* writer,
+                                 blob_writer_t** blob_writer,
+                                 const char* key, size_t key_len,
+                                 const char* val, size_t val_len, bool deleted) {
+    size_t min_size = db->opts.blob_min_size;
+    if (deleted || min_size == 0 || val_len < min_size) {
+        return sstable_writer_add(writer, key, key_len, val, val_len, deleted);
+    }
+
+    if (!*blob_writer) {
+        *blob_writer = blob_writer_create(db->path, level_new_file_number(db->levels));
+        if (!*blob_writer) return STATUS_IO_ERROR;
+    }
+    blob_ref_t ref;
+    status_t status = blob_writer_add(*blob_writer, val, val_len, &ref);
+    if (status != STATUS_OK) return status;
+
+    char buf[BLOB_REF_MAX_SIZE];
+    size_t len = blob_ref_encode(&ref, buf);
+    return sstable_writer_add_blob(writer, key, key_len, buf, len);
+}
+
+// Helper: write a memtable to a new L0 SSTable and install it.
+// Runs on the worker without db->mutex; mt is immutable by now.
+static status_t write_level0_table(storage_t* db, memtable_t* mt) {
+    if (memtable_is_empty(mt)) return STATUS_OK;
+    size_t count = memtable_count(mt);
+
+    // Get next file number from level manager
+    uint64_t file_num = level_new_file_number(db->levels);
+
+    // Generate SSTable filename
+    size_t path_len = strlen(db->path) + 32;
+    char* sst_path = malloc(path_len);
+    if (!sst_path) return STATUS_NO_MEMORY;
+    snprintf(sst_path, path_len, "%s/%06llu.sst", db->path, (unsigned long long)file_num);
+
+    // Create SSTable writer
+    sstable_writer_t* writer = sstable_writer_create(sst_path, count, db->opts.comparator);
+    if (!writer) {
+        free(sst_path);
+        return STATUS_IO_ERROR;
+    }
+    sstable_writer_set_compression(writer, db->opts.compression);
+    sstable_writer_set_prefix_extractor(writer, db->opts.prefix_extractor,
+                                        db->opts.prefix_extractor_name);
+
+    // Iterate memtable and write all entries (including tombstones)
+    memtable_iter_t* iter = memtable_iter_create(mt);
+    if (!iter) {
+        sstable_writer_abort(writer);
+        free(sst_path);
+        return STATUS_NO_MEMORY;
+    }
+
+    blob_writer_t* blob_writer = NULL;
+    memtable_iter_seek_to_first(iter);
+    while (memtable_iter_valid(iter)) {
+        size_t key_len, val_len;
+        const char* key = memtable_iter_key(iter, &key_len);
+        const char* val = memtable_iter_value(iter, &val_len);
+        bool deleted = memtable_iter_is_deleted(iter);
+
+        status_t status = add_level0_entry(db, writer, &blob_writer,
+                                           key, key_len, val, val_len, deleted);
+        if (status != STATUS_OK) {
+            memtable_iter_destroy(iter);
+            sstable_writer_abort(writer);
+            blob_writer_abort(blob_writer);
+            free(sst_path);
+            return status;
+        }
+
+        memtable_iter_next(iter);
+    }
+    memtable_iter_destroy(iter);
+
+    // Range tombstones go into the table's range-deletion block
+    range_del_list_t range_dels = {0};
+    status_t status = memtable_collect_range_dels(mt, &range_dels);
+    for (size_t i = 0; status == STATUS_OK && i < range_dels.count; i++) {
+        status = sstable_writer_add_range_tombstone(writer, &range_dels.items[i]);
+    }
+    range_del_list_free(&range_dels);
+    if (status != STATUS_OK) {
+        sstable_writer_abort(writer);
+        blob_writer_abort(blob_writer);
+        free(sst_path);
+        return status;
+    }
+
+    // Finish the blob file first and register it: the SSTable refers to it
+    uint64_t blob_num = 0, blob_size = 0;
+    if (blob_writer) {
+        blob_num = blob_writer->file_number;
+        blob_size = blob_writer->offset;
+        status = blob_writer_finish(blob_writer);
+        if (status == STATUS_OK) {
+            status = level_add_blob_file(db->levels, blob_num, blob_size);
+        }
+        if (status != STATUS_OK) {
+            sstable_writer_abort(writer);
+            free(sst_path);
+            return status;
+        }
+    }
+
+    // Finish writing SSTable
+    status = sstable_writer_finish(writer);
+    if (status != STATUS_OK) {
+        free(sst_path);
+        return status;
+    }
+
+    // Open the new SSTable for reading
+    sstable_reader_t* reader = level_open_sstable(db->levels, sst_path);
+    if (!reader) {
+        free(sst_path);
+        return STATUS_IO_ERROR;
+    }
+
+    // Add to L0 in level manager
+    level_lock_exclusive(db->levels);
+    status = level_add_sstable(db->levels, 0, file_num, sst_path, reader);
+    level_unlock(db->levels);
+    free(sst_path);
+    if (status != STATUS_OK) {
+        sstable_reader_close(reader);
+        return status;
+    }
+
+    // Log to manifest
+    manifest_edit_t edit = {0};
+    if (blob_size > 0) {
+        manifest_edit_add_blob(&edit, blob_num, blob_size);
+    }
+    manifest_edit_add_file(&edit, 0, file_num);
+    manifest_edit_next_file_num(&edit, level_next_file_number(db->levels));
+    status = manifest_log_edit(db->path, &edit);
+    manifest_edit_free(&edit);
+    return status;
+}
+
+// Helper: flush the immutable memtable and drop its WAL
+// Called with db->mutex held; releases it while writing.
+static void flush_imm(storage_t* db) {
+    memtable_t* imm = db->imm;
+
+    pthread_mutex_unlock(&db->mutex);
+    status_t status = write_level0_table(db, imm);
+    pthread_mutex_lock(&db->mutex);
+
+    if (status != STATUS_OK) {
+        db->bg_error = status;
+        return;
+    }
+
+    db->imm = NULL;
+    memtable_unref(imm);
+
+    char* imm_wal_path = build_path(db->path, IMM_WAL_FILENAME);
+    if (imm_wal_path) {
+        unlink(imm_wal_path);
+        free(imm_wal_path);
+    }
+}
+
+// Table being ingested, already under its file number in the database
+typedef struct {
+    uint64_t file_num;
+    char* path;
+    sstable_reader_t* reader;
+    bool installed;         // The level manager owns the reader
+} ingest_file_t;
+
+struct storage_ingest {
+    ingest_file_t* files;
+    size_t count;
+    bool done;
+    status_t status;
+};
+
+// Helper: add ingested tables to their levels and log them.
+// Runs on the worker without db->mutex, so no flush or compaction changes
+// the levels between the pick and the add.
+static status_t install_ingested(storage_t* db, storage_ingest_t* job) {
+    manifest_edit_t edit = {0};
+    for (size_t i = 0; i < job->count; i++) {
+        ingest_file_t* f = &job->files[i];
+        size_t min_len, max_len;
+        const char* min_key = sstable_reader_min_key(f->reader, &min_len);
+        const char* max_key = sstable_reader_max_key(f->reader, &max_len);
+
+        level_lock_exclusive(db->levels);
+        int level = level_pick_ingest_level(db->levels, min_key, min_len, max_key, max_len);
+        status_t status = level_add_sstable(db->levels, level, f->file_num, f->path, f->reader);
+        level_unlock(db->levels);
+        if (status != STATUS_OK) {
+            manifest_edit_free(&edit);
+            return status;
+        }
+        f->installed = true;
+        manifest_edit_add_file(&edit, level, f->file_num);
+    }
+
+    // One record, so a crash never leaves part of the batch ingested
+    manifest_edit_next_file_num(&edit, level_next_file_number(db->levels));
+    status_t status = manifest_log_edit(db->path, &edit);
+    manifest_edit_free(&edit);
+    return status;
+}
+
+// Worker thread: flush first (writers may be waiting on it), then compact
+// until no level needs it, then sleep until woken
+static void* bg_main(void* arg) {
+    storage_t* db = arg;
+
+    pthread_mutex_lock(&db->mutex);
+    while (!db->shutting_down) {
+        int level;
+        if (db->bg_error == STATUS_OK && db->imm) {
+            flush_imm(db);
+        } else if (db->ingest) {
+            storage_ingest_t* job = db->ingest;
+            job->status = db->bg_error;
+            if (job->status == STATUS_OK) {
+                pthread_mutex_unlock(&db->mutex);
+                job->status = install_ingested(db, job);
+                pthread_mutex_lock(&db->mutex);
+                if (job->status != STATUS_OK) db->bg_error = job->status;
+            }
+            job->done = true;
+            db->ingest = NULL;
+        } else if (db->bg_error == STATUS_OK &&
+                   (level = compact_pick_level(db->levels)) >= 0) {
+            pthread_mutex_unlock(&db->mutex);
+            status_t status = compact_level(db->levels, level);
+            pthread_mutex_lock(&db->mutex);
+            if (status != STATUS_OK) db->bg_error = status;
+        } else {
+            db->manual_compaction = false;
+            pthread_cond_broadcast(&db->done_cv);
+            pthread_cond_wait(&db->bg_cv, &db->mutex);
+            continue;
+        }
+        pthread_cond_broadcast(&db->done_cv);
+    }
+    pthread_mutex_unlock(&db->mutex);
+
+    return NULL;
+}
+
+// Helper: hand the active memtable to the worker and start a new one.
+// The WAL is rotated with it, so wal.imm.log covers exactly db->imm.
+static status_t switch_memtable(storage_t* db) {
+    memtable_t* mem = memtable_create(db->opts.memtable_size, db->opts.comparator);
+    if (!mem) return STATUS_NO_MEMORY;
+
+    char* wal_path = build_path(db->path, WAL_FILENAME);
+    char* imm_wal_path = build_path(db->path, IMM_WAL_FILENAME);
+    if (!wal_path || !imm_wal_path) {
+        free(wal_path);
+        free(imm_wal_path);
+        memtable_unref(mem);
+        return STATUS_NO_MEMORY;
+    }
+
+    // Rename the live log first: the open descriptor keeps working, so any
+    // failure below leaves the current state untouched
+    status_t status = STATUS_OK;
+    wal_t* wal = NULL;
+    if (rename(wal_path, imm_wal_path) != 0) {
+        status = STATUS_IO_ERROR;
+    } else {
+        wal = wal_open(wal_path, db->opts.sync_writes);
+        if (!wal) {
+            rename(imm_wal_path, wal_path);
+            status = STATUS_IO_ERROR;
+        }
+    }
+    free(wal_path);
+    free(imm_wal_path);
+
+    if (status != STATUS_OK) {
+        memtable_unref(mem);
+        return status;
+    }
+
+    wal_close(db->wal);
+    db->wal = wal;
+    db->imm = db->memtable;
+    db->memtable = mem;
+    pthread_cond_signal(&db->bg_cv);
+
+    return STATUS_OK;
+}
+
+// Helper: make sure the active memtable can take a write.
+// Called with db->mutex held; may release it to delay or wait. With force,
+// a non-empty memtable is switched out even if it isn't full.
+static status_t make_room_for_write(storage_t* db, bool force) {
+    bool allow_delay = !force;
+
+    for (;;) {
+        if (db->bg_error != STATUS_OK) {
+            return db->bg_error;
+        }
+
+        size_t l0_files = level_file_count(db->levels, 0);
+        if (allow_delay && l0_files >= L0_SLOWDOWN_TRIGGER) {
+            // Getting close to the stop trigger: delay this write by 1ms
+            // instead of stalling a single write for a whole compaction
+            pthread_mutex_unlock(&db->mutex);
+            usleep(1000);
+            pthread_mutex_lock(&db->mutex);
+            allow_delay = false;
+        } else if (!force && !memtable_should_flush(db->memtable)) {
+            return STATUS_OK;
+        } else if (memtable_is_empty(db->memtable)) {
+            return STATUS_OK;
+        } else if (db->imm) {
+            // Previous memtable is still being flushed
+            pthread_cond_wait(&db->done_cv, &db->mutex);
+        } else if (l0_files >= L0_STOP_TRIGGER) {
+            // Too many L0 files: wait for compaction to catch up
+            pthread_cond_wait(&db->done_cv, &db->mutex);
+        } else {
+            status_t status = switch_memtable(db);
+            if (status != STATUS_OK) return status;
+            force = false;
+        }
+    }
+}
+
+// ============================================================
+// Group commit
+// ============================================================
+
+// A pending write, on the calling thread's stack
+struct storage_writer {
+    const wal_entry_t* entries;
+    size_t count;
+    bool force_flush;       // storage_flush: switch the memtable, no entries
+    bool done;              // Committed by a leader; status is set
+    status_t status;
+    pthread_cond_t cv;
+    storage_writer_t* next;
+};
+
+// Helper: apply one record to a memtable
+static status_t memtable_apply(memtable_t* mt, const wal_entry_t* e) {
+    if (e->type == WAL_RECORD_BATCH) {
+        return wal_batch_iterate(e->val, e->val_len, recover_callback, mt);
+    }
+    if (e->type == WAL_RECORD_PUT) {
+        return memtable_put(mt, e->key, e->key_len, e->val, e->val_len);
+    }
+    if (e->type == WAL_RECORD_DELETE_RANGE) {
+        return memtable_delete_range(mt, e->key, e->key_len, e->val, e->val_len);
+    }
+    return memtable_delete(mt, e->key, e->key_len);
+}
+
+// Helper: collect the records of the writers at the head of the queue into
+// db->group. Stops before a flush request or once WAL_GROUP_MAX_BYTES is
+// reached; *last is the final writer included.
+static status_t build_group(storage_t* db, storage_writer_t** last, size_t* count) {
+    size_t n = 0, bytes = 0;
+    storage_writer_t* head = db->writers_head;
+    *last = head;
+
+    for (storage_writer_t* w = head; w && !w->force_flush; w = w->next) {
+        size_t w_bytes = 0;
+        for (size_t i = 0; i < w->count; i++) {
+            w_bytes += w->entries[i].key_len + w->entries[i].val_len;
+        }
+        if (w != head && bytes + w_bytes > WAL_GROUP_MAX_BYTES) break;
+
+        if (n + w->count > db->group_cap) {
+            size_t new_cap = db->group_cap > 0 ? db->group_cap * 2 : 16;
+            while (new_cap < n + w->count) new_cap *= 2;
+            wal_entry_t* new_group = realloc(db->group, new_cap * sizeof(wal_entry_t));
+            if (!new_group) {
+                if (w == head) return STATUS_NO_MEMORY;
+                break;
+            }
+            db->group = new_group;
+            db->group_cap = new_cap;
+        }
+
+        memcpy(db->group + n, w->entries, w->count * sizeof(wal_entry_t));
+        n += w->count;
+        bytes += w_bytes;
+        *last = w;
+    }
+
+    *count = n;
+    return STATUS_OK;
+}
+
+// Helper: commit records through the writer queue.
+// The first queued writer becomes leader: it makes room in the memtable,
+// then with db->mutex released writes the whole group to the WAL with one
+// write (and one fsync) and applies it to the memtable, then wakes the group.
+static status_t storage_write_entries(storage_t* db, const wal_entry_t* entries,
+                                      size_t count, bool force_flush) {
+    storage_writer_t w;
+    w.entries = entries;
+    w.count = count;
+    w.force_flush = force_flush;
+    w.done = false;
+    w.status = STATUS_OK;
+    w.next = NULL;
+    pthread_cond_init(&w.cv, NULL);
+
+    pthread_mutex_lock(&db->mutex);
+    if (db->writers_tail) {
+        db->writers_tail->next = &w;
+    } else {
+        db->writers_head = &w;
+    }
+    db->writers_tail = &w;
+
+    while (!w.done && db->writers_head != &w) {
+        pthread_cond_wait(&w.cv, &db->mutex);
+    }
+    if (w.done) {
+        // A leader committed this write
+        pthread_mutex_unlock(&db->mutex);
+        pthread_cond_destroy(&w.cv);
+        return w.status;
+    }
+
+    // Leader. The queue head doesn't change until it is done, so no other
+    // thread touches the WAL or switches memtables meanwhile.
+    status_t status = STATUS_OK;
+    if (db->bg_started) {
+        status = make_room_for_write(db, force_flush);
+    }
+
+    storage_writer_t* last = &w;
+    if (status == STATUS_OK && !force_flush) {
+        size_t n = 0;
+        status = build_group(db, &last, &n);
+
+        // The memtable takes one writer alongside lock-free readers, so it
+        // is updated with the mutex released too
+        if (status == STATUS_OK) {
+            memtable_t* mem = db->memtable;
+            pthread_mutex_unlock(&db->mutex);
+            if (db->wal) {
+                status = wal_write_group(db->wal, db->group, n);
+            }
+            for (size_t i = 0; i < n && status == STATUS_OK; i++) {
+                status = memtable_apply(mem, &db->group[i]);
+            }
+            pthread_mutex_lock(&db->mutex);
+        }
+    }
+
+    // Release the group and hand leadership to the next writer
+    for (;;) {
+        storage_writer_t* ready = db->writers_head;
+        db->writers_head = ready->next;
+        if (!db->writers_head) db->writers_tail = NULL;
+        if (ready != &w) {
+            ready->status = status;
+            ready->done = true;
+            pthread_cond_signal(&ready->cv);
+        }
+        if (ready == last) break;
+    }
+    if (db->writers_head) {
+        pthread_cond_signal(&db->writers_head->cv);
+    }
+
+    pthread_mutex_unlock(&db->mutex);
+    pthread_cond_destroy(&w.cv);
+    return status;
+}
+
+// Helper: look up a key in one memtable. *found is set whenever the memtable
+// has an entry for the key, including a tombstone (which returns NOT_FOUND).
+// *val points into the memtable.
+static status_t memtable_lookup(memtable_t* mt, const char* key, size_t key_len,
+                                const char** val, size_t* val_len, bool* found) {
+    char* mt_val = NULL;
+    size_t mt_val_len = 0;
+    bool deleted = false;
+    status_t status = memtable_get_entry(mt, key, key_len, &mt_val, &mt_val_len, &deleted);
+    if (status == STATUS_NOT_FOUND && memtable_range_del_covers(mt, key, key_len)) {
+        // Range-deleted: older sources must not be consulted
+        *found = true;
+        return STATUS_NOT_FOUND;
+    }
+    if (status != STATUS_OK) return status;
+
+    *found = true;
+    if (deleted) return STATUS_NOT_FOUND;
+    *val = mt_val;
+    *val_len = mt_val_len;
+    return STATUS_OK;
+}
+
+// ============================================================
+// Public API
+// ============================================================
+
 // Open storage engine
 storage_t* storage_open(const char* path, storage_opts_t* opts) {
-    storage_t* db = malloc(sizeof(storage_t));
+    // Tables record the extractor's name; filters of another one are unsafe
+    if (opts && opts->prefix_extractor && !opts->prefix_extractor_name) return NULL;
+
+    storage_t* db = calloc(1, sizeof(storage_t));
     if (!db) return NULL;
 
+    if (pthread_mutex_init(&db->mutex, NULL) != 0) {
+        free(db);
+        return NULL;
+    }
+    pthread_cond_init(&db->bg_cv, NULL);
+    pthread_cond_init(&db->done_cv, NULL);
+    db->bg_error = STATUS_OK;
+
     // Copy path
     if (path) {
         db->path = strdup(path);
         if (!db->path) {
-            free(db);
+            storage_release(db);
             return NULL;
         }
-    } else {
-        db->path = NULL;
     }
 
     // Copy options or use defaults
@@ -61,93 +622,117 @@ storage_t* storage_open(const char* path, storage_opts_t* opts) {
     // Create memtable
     db->memtable = memtable_create(db->opts.memtable_size, db->opts.comparator);
     if (!db->memtable) {
-        free(db->path);
-        free(db);
+        storage_release(db);
         return NULL;
     }
 
-    // Initialize WAL
-    db->wal = NULL;
-
     // Initialize level manager
     db->levels = level_manager_create(path, db->opts.comparator);
     if (!db->levels) {
-        memtable_destroy(db->memtable);
-        free(db->path);
-        free(db);
+        storage_release(db);
         return NULL;
     }
 
-    // If path is provided, set up persistence
-    if (path) {
-        // Ensure directory exists
-        if (ensure_directory(path) != 0) {
-            level_manager_destroy(db->levels);
-            memtable_destroy(db->memtable);
-            free(db->path);
-            free(db);
+    // Create block cache and attach it before any SSTable is opened
+    if (db->opts.block_cache_size > 0) {
+        db->cache = cache_create(db->opts.block_cache_size);
+        if (!db->cache) {
+            storage_release(db);
             return NULL;
         }
+        level_set_block_cache(db->levels, db->cache);
+    }
+    level_set_use_mmap(db->levels, db->opts.use_mmap_reads);
+    level_set_compression(db->levels, db->opts.compression);
+    level_set_max_subcompactions(db->levels, db->opts.max_subcompactions);
+    level_set_target_file_size(db->levels, db->opts.target_file_size);
+    level_set_prefix_extractor(db->levels, db->opts.prefix_extractor,
+                               db->opts.prefix_extractor_name);
 
-        // Build WAL path
-        size_t wal_path_len = strlen(path) + 16;
-        char* wal_path = malloc(wal_path_len);
-        if (!wal_path) {
-            level_manager_destroy(db->levels);
-            memtable_destroy(db->memtable);
-            free(db->path);
-            free(db);
-            return NULL;
-        }
-        snprintf(wal_path, wal_path_len, "%s/wal.log", path);
-
-        // Recover from WAL if it exists
-        status_t status = wal_recover(wal_path, recover_callback, db->memtable);
-        if (status != STATUS_OK && status != STATUS_NOT_FOUND) {
-            free(wal_path);
-            level_manager_destroy(db->levels);
-            memtable_destroy(db->memtable);
-            free(db->path);
-            free(db);
-            return NULL;
-        }
+    // Memory-only database: no WAL, no background work (and no blob files)
+    if (!path) {
+        return db;
+    }
+    level_set_blob_min_size(db->levels, db->opts.blob_min_size);
+
+    // Ensure directory exists
+    if (ensure_directory(path) != 0) {
+        storage_release(db);
+        return NULL;
+    }
 
-        // Open WAL for writing
-        db->wal = wal_open(wal_path, db->opts.sync_writes);
+    char* wal_path = build_path(path, WAL_FILENAME);
+    char* imm_wal_path = build_path(path, IMM_WAL_FILENAME);
+    if (!wal_path || !imm_wal_path) {
         free(wal_path);
+        free(imm_wal_path);
+        storage_release(db);
+        return NULL;
+    }
 
-        if (!db->wal) {
-            level_manager_destroy(db->levels);
-            memtable_destroy(db->memtable);
-            free(db->path);
-            free(db);
-            return NULL;
-        }
+    // A leftover wal.imm.log belongs to a memtable whose flush didn't
+    // finish; recover it separately so the worker flushes it again
+    db->imm = memtable_create(db->opts.memtable_size, db->opts.comparator);
+    status_t status = db->imm ? STATUS_OK : STATUS_NO_MEMORY;
+    if (status == STATUS_OK) {
+        status = wal_recover(imm_wal_path, recover_callback, db->imm);
+        if (status == STATUS_NOT_FOUND) status = STATUS_OK;
+    }
+    if (status == STATUS_OK && memtable_is_empty(db->imm)) {
+        memtable_unref(db->imm);
+        db->imm = NULL;
+        unlink(imm_wal_path);
+    }
+    free(imm_wal_path);
 
-        // Recover level structure from manifest
-        if (manifest_recover(path, db->levels) != STATUS_OK) {
-            wal_close(db->wal);
-            level_manager_destroy(db->levels);
-            memtable_destroy(db->memtable);
-            free(db->path);
-            free(db);
-            return NULL;
-        }
+    // Recover from WAL if it exists
+    if (status == STATUS_OK) {
+        status = wal_recover(wal_path, recover_callback, db->memtable);
+        if (status == STATUS_NOT_FOUND) status = STATUS_OK;
+    }
+    if (status != STATUS_OK) {
+        free(wal_path);
+        storage_release(db);
+        return NULL;
+    }
+
+    // Open WAL for writing
+    db->wal = wal_open(wal_path, db->opts.sync_writes);
+    free(wal_path);
+    if (!db->wal) {
+        storage_release(db);
+        return NULL;
+    }
+
+    // Recover level structure from manifest
+    if (manifest_recover(path, db->levels) != STATUS_OK) {
+        storage_release(db);
+        return NULL;
+    }
+
+    // Start the background worker
+    if (pthread_create(&db->bg_thread, NULL, bg_main, db) != 0) {
+        storage_release(db);
+        return NULL;
     }
+    db->bg_started = true;
 
     return db;
 }
 
 // Close storage engine
+// A memtable still waiting to be flushed stays in wal.imm.log and is
+// recovered on the next open.
 void storage_close(storage_t* db) {
     if (db) {
-        level_manager_destroy(db->levels);
-        if (db->wal) {
-            wal_close(db->wal);
+        if (db->bg_started) {
+            pthread_mutex_lock(&db->mutex);
+            db->shutting_down = true;
+            pthread_cond_signal(&db->bg_cv);
+            pthread_mutex_unlock(&db->mutex);
+            pthread_join(db->bg_thread, NULL);
         }
-        memtable_destroy(db->memtable);
-        free(db->path);
-        free(db);
+        storage_release(db);
     }
 }
 
@@ -156,82 +741,363 @@ status_t storage_put(storage_t* db, const char* key, size_t key_len,
                      const char* val, size_t val_len) {
     if (!db) return STATUS_INVALID_ARG;
 
-    // Write to WAL first (if enabled)
-    if (db->wal) {
-        status_t status = wal_write_put(db->wal, key, key_len, val, val_len);
-        if (status != STATUS_OK) return status;
-    }
-
-    // Then update memtable
-    return memtable_put(db->memtable, key, key_len, val, val_len);
+    wal_entry_t e = { WAL_RECORD_PUT, key, key_len, val, val_len };
+    return storage_write_entries(db, &e, 1, false);
 }
 
 // Get value for a key
 status_t storage_get(storage_t* db, const char* key, size_t key_len,
                      char** val, size_t* val_len) {
-    if (!db) return STATUS_INVALID_ARG;
+    if (!val || !val_len) return STATUS_INVALID_ARG;
+    *val = NULL;
+    *val_len = 0;
 
-    // First check memtable
-    char* mt_val = NULL;
-    size_t mt_val_len = 0;
-    status_t status = memtable_get(db->memtable, key, key_len, &mt_val, &mt_val_len);
+    storage_pinned_t pinned;
+    status_t status = storage_get_pinned(db, key, key_len, &pinned);
+    if (status == STATUS_OK && pinned.pin.buf) {
+        // Blob values are private copies already
+        *val = pinned.pin.buf;
+        *val_len = pinned.size;
+        pinned.pin.buf = NULL;
+    } else if (status == STATUS_OK) {
+        *val = malloc(pinned.size > 0 ? pinned.size : 1);
+        if (*val) {
+            if (pinned.size > 0) memcpy(*val, pinned.data, pinned.size);
+            *val_len = pinned.size;
+        } else {
+            status = STATUS_NO_MEMORY;
+        }
+    }
+    storage_pinned_release(&pinned);
+    return status;
+}
+
+// Get a value without copying it
+status_t storage_get_pinned(storage_t* db, const char* key, size_t key_len,
+                            storage_pinned_t* value) {
+    if (value) memset(value, 0, sizeof(*value));
+    if (!db || !value) return STATUS_INVALID_ARG;
+
+    // Check the memtables, newest first. A tombstone there hides any
+    // older value in the levels. Memtable reads don't block writers, so
+    // the mutex is only held to take references.
+    pthread_mutex_lock(&db->mutex);
+    memtable_t* mem = db->memtable;
+    memtable_t* imm = db->imm;
+    memtable_ref(mem);
+    memtable_ref(imm);
+    pthread_mutex_unlock(&db->mutex);
+
+    bool found = false;
+    memtable_t* source = mem;
+    status_t status = memtable_lookup(mem, key, key_len, &value->data, &value->size, &found);
+    if (!found && status == STATUS_NOT_FOUND && imm) {
+        source = imm;
+        status = memtable_lookup(imm, key, key_len, &value->data, &value->size, &found);
+    }
+
+    // The memtable holding the value stays referenced until release
     if (status == STATUS_OK) {
-        // Memtable returns internal pointer, make a copy
-        *val = malloc(mt_val_len);
-        if (!*val) return STATUS_NO_MEMORY;
-        memcpy(*val, mt_val, mt_val_len);
-        *val_len = mt_val_len;
+        value->memtable = source;
+        memtable_unref(source == mem ? imm : mem);
         return STATUS_OK;
     }
-    if (status != STATUS_NOT_FOUND) {
+    memtable_unref(mem);
+    memtable_unref(imm);
+    if (found || status != STATUS_NOT_FOUND) {
         return status;
     }
 
     // Search levels using level manager
-    if (db->levels) {
-        bool deleted = false;
-        status = level_get(db->levels, key, key_len, val, val_len, &deleted);
-        if (status == STATUS_OK) {
-            if (deleted) {
-                free(*val);
-                *val = NULL;
-                *val_len = 0;
-                return STATUS_NOT_FOUND;
-            }
-            return STATUS_OK;
-        }
-        if (status != STATUS_NOT_FOUND) {
-            return status;
-        }
+    bool deleted = false;
+    status = level_get_pinned(db->levels, key, key_len, &value->data, &value->size,
+                              &deleted, &value->pin);
+    if (status == STATUS_OK && deleted) {
+        storage_pinned_release(value);
+        return STATUS_NOT_FOUND;
     }
+    return status;
+}
 
-    return STATUS_NOT_FOUND;
+// Unpin a value
+void storage_pinned_release(storage_pinned_t* value) {
+    if (!value) return;
+    memtable_unref(value->memtable);
+    level_pin_release(&value->pin);
+    memset(value, 0, sizeof(*value));
 }
 
 // Delete a key
 status_t storage_delete(storage_t* db, const char* key, size_t key_len) {
     if (!db) return STATUS_INVALID_ARG;
 
-    // Write to WAL first (if enabled)
-    if (db->wal) {
-        status_t status = wal_write_delete(db->wal, key, key_len);
-        if (status != STATUS_OK) return status;
+    wal_entry_t e = { WAL_RECORD_DELETE, key, key_len, NULL, 0 };
+    return storage_write_entries(db, &e, 1, false);
+}
+
+// Delete all keys in [begin, end)
+status_t storage_delete_range(storage_t* db, const char* begin, size_t begin_len,
+                              const char* end, size_t end_len) {
+    if (!db || !begin || !end) return STATUS_INVALID_ARG;
+
+    compare_fn cmp = db->opts.comparator ? db->opts.comparator : default_compare;
+    int c = cmp(begin, begin_len, end, end_len);
+    if (c > 0) return STATUS_INVALID_ARG;
+    if (c == 0) return STATUS_OK;   // Empty range
+
+    wal_entry_t e = { WAL_RECORD_DELETE_RANGE, begin, begin_len, end, end_len };
+    return storage_write_entries(db, &e, 1, false);
+}
+
+// ============================================================
+// Write batch
+// ============================================================
+
+// Create an empty batch
+storage_write_batch_t* storage_write_batch_create(void) {
+    storage_write_batch_t* batch = calloc(1, sizeof(storage_write_batch_t));
+    if (!batch) return NULL;
+
+    batch->cap = 256;
+    batch->rep = malloc(batch->cap);
+    if (!batch->rep) {
+        free(batch);
+        return NULL;
     }
+    storage_write_batch_clear(batch);
 
-    // Then update memtable
-    return memtable_delete(db->memtable, key, key_len);
+    return batch;
+}
+
+// Destroy batch
+void storage_write_batch_destroy(storage_write_batch_t* batch) {
+    if (batch) {
+        free(batch->rep);
+        free(batch);
+    }
+}
+
+// Helper: append one entry and bump the count in the header
+static status_t batch_append(storage_write_batch_t* batch, wal_record_type_t type,
+                             const char* key, size_t key_len,
+                             const char* val, size_t val_len) {
+    if (!batch || !key) return STATUS_INVALID_ARG;
+
+    size_t need = batch->size + wal_entry_encoded_size(key_len, val_len);
+    if (need > batch->cap) {
+        size_t new_cap = batch->cap * 2;
+        while (new_cap < need) new_cap *= 2;
+        char* new_rep = realloc(batch->rep, new_cap);
+        if (!new_rep) return STATUS_NO_MEMORY;
+        batch->rep = new_rep;
+        batch->cap = new_cap;
+    }
+
+    char* end = wal_encode_entry(batch->rep + batch->size, type,
+                                 key, key_len, val, val_len);
+    batch->size = (size_t)(end - batch->rep);
+
+    uint32_t count;
+    memcpy(&count, batch->rep, 4);
+    count++;
+    memcpy(batch->rep, &count, 4);
+
+    return STATUS_OK;
+}
+
+// Add a put to the batch
+status_t storage_write_batch_put(storage_write_batch_t* batch,
+                                 const char* key, size_t key_len,
+                                 const char* val, size_t val_len) {
+    return batch_append(batch, WAL_RECORD_PUT, key, key_len, val, val_len);
+}
+
+// Add a delete to the batch
+status_t storage_write_batch_delete(storage_write_batch_t* batch,
+                                    const char* key, size_t key_len) {
+    return batch_append(batch, WAL_RECORD_DELETE, key, key_len, NULL, 0);
+}
+
+// Append a range delete (storage_write rejects a reversed range)
+status_t storage_write_batch_delete_range(storage_write_batch_t* batch,
+                                          const char* begin, size_t begin_len,
+                                          const char* end, size_t end_len) {
+    if (!end) return STATUS_INVALID_ARG;
+    return batch_append(batch, WAL_RECORD_DELETE_RANGE, begin, begin_len, end, end_len);
+}
+
+// Remove all entries (keeps the buffer for reuse)
+void storage_write_batch_clear(storage_write_batch_t* batch) {
+    if (batch) {
+        memset(batch->rep, 0, WAL_BATCH_HEADER_SIZE);
+        batch->size = WAL_BATCH_HEADER_SIZE;
+    }
+}
+
+// Number of entries in the batch
+size_t storage_write_batch_count(storage_write_batch_t* batch) {
+    if (!batch) return 0;
+    uint32_t count;
+    memcpy(&count, batch->rep, 4);
+    return count;
+}
+
+// Range check of a batch, optionally copying it without its empty ranges
+typedef struct {
+    compare_fn cmp;
+    size_t empty;
+    storage_write_batch_t* out;
+} batch_check_t;
+
+// Helper: check one batch entry (wal_recover_fn)
+static status_t check_batch_entry(void* ctx, wal_record_type_t type,
+                                  const char* key, size_t key_len,
+                                  const char* val, size_t val_len) {
+    batch_check_t* check = ctx;
+    if (type == WAL_RECORD_DELETE_RANGE) {
+        int c = check->cmp(key, key_len, val, val_len);
+        if (c > 0) return STATUS_INVALID_ARG;
+        if (c == 0) {
+            check->empty++;
+            return STATUS_OK;
+        }
+    }
+    return check->out ? batch_append(check->out, type, key, key_len, val, val_len) : STATUS_OK;
+}
+
+// Apply a batch as one WAL record and one memtable update
+// Range deletes are checked like storage_delete_range's: a reversed one
+// fails the whole batch, empty ones are dropped.
+status_t storage_write(storage_t* db, storage_write_batch_t* batch) {
+    if (!db || !batch) return STATUS_INVALID_ARG;
+    if (storage_write_batch_count(batch) == 0) return STATUS_OK;
+
+    batch_check_t check = { db->opts.comparator ? db->opts.comparator : default_compare, 0, NULL };
+    status_t status = wal_batch_iterate(batch->rep, batch->size, check_batch_entry, &check);
+    if (status != STATUS_OK) return status;
+
+    if (check.empty == 0) {
+        wal_entry_t e = { WAL_RECORD_BATCH, NULL, 0, batch->rep, batch->size };
+        return storage_write_entries(db, &e, 1, false);
+    }
+
+    check.out = storage_write_batch_create();
+    if (!check.out) return STATUS_NO_MEMORY;
+    status = wal_batch_iterate(batch->rep, batch->size, check_batch_entry, &check);
+    if (status == STATUS_OK && storage_write_batch_count(check.out) > 0) {
+        wal_entry_t e = { WAL_RECORD_BATCH, NULL, 0, check.out->rep, check.out->size };
+        status = storage_write_entries(db, &e, 1, false);
+    }
+    storage_write_batch_destroy(check.out);
+    return status;
+}
+
+// Helper: append an iterator child, hiding what the tombstones of the newer
+// children delete
+static bool add_iter_child(iterator_t** children, size_t* count, iterator_t* child,
+                           const range_del_list_t* newer, compare_fn cmp) {
+    if (child && newer->count > 0) {
+        child = range_del_iter_create(child, newer, cmp, NULL, NULL);
+    }
+    if (!child) return false;
+    children[(*count)++] = child;
+    return true;
 }
 
 // Create iterator
 storage_iter_t* storage_iter_create(storage_t* db) {
+    return storage_iter_create_ex(db, 0);
+}
+
+storage_iter_t* storage_iter_create_ex(storage_t* db, int flags) {
     if (!db) return NULL;
+    bool prefix_mode = (flags & STORAGE_ITER_PREFIX) && db->opts.prefix_extractor;
 
     storage_iter_t* iter = malloc(sizeof(storage_iter_t));
     if (!iter) return NULL;
 
+    // Hold both locks while the sources are captured; every child keeps its
+    // own references, so later flushes and compactions don't affect it
+    pthread_mutex_lock(&db->mutex);
+    level_lock_shared(db->levels);
+
+    // Children ordered newest first: memtable, immutable memtable,
+    // L0 newest to oldest, L1, L2, ...
+    level_t* l0 = &db->levels->levels[0];
+    size_t max_children = 2 + MAX_LEVELS + l0->file_count;
+
+    iterator_t** children = malloc(max_children * sizeof(iterator_t*));
+    if (!children) {
+        level_unlock(db->levels);
+        pthread_mutex_unlock(&db->mutex);
+        free(iter);
+        return NULL;
+    }
+
+    // Each child is filtered by the range tombstones of the newer ones
+    size_t count = 0;
+    range_del_list_t newer = {0};
+    bool ok = add_iter_child(children, &count, iterator_from_memtable(db->memtable),
+                             &newer, db->levels->cmp) &&
+              memtable_collect_range_dels(db->memtable, &newer) == STATUS_OK;
+
+    if (db->imm && ok) {
+        ok = add_iter_child(children, &count, iterator_from_memtable(db->imm),
+                            &newer, db->levels->cmp) &&
+             memtable_collect_range_dels(db->imm, &newer) == STATUS_OK;
+    }
+
+    for (size_t i = l0->file_count; i > 0 && ok; i--) {
+        sstable_reader_t* reader = l0->files[i - 1].reader;
+        iterator_t* child = prefix_mode ? iterator_from_sstable_prefix(reader)
+                                        : iterator_from_sstable(reader);
+        ok = add_iter_child(children, &count, child, &newer, db->levels->cmp) &&
+             range_del_list_append(&newer, sstable_reader_range_dels(reader)) == STATUS_OK;
+    }
+    for (int level = 1; level < MAX_LEVELS && ok; level++) {
+        level_t* lvl = &db->levels->levels[level];
+        if (lvl->file_count == 0) continue;
+        iterator_t* child = prefix_mode ? iterator_from_level_prefix(db->levels, level)
+                                        : iterator_from_level(db->levels, level);
+        ok = add_iter_child(children, &count, child, &newer, db->levels->cmp);
+        for (size_t i = 0; i < lvl->file_count && ok; i++) {
+            ok = range_del_list_append(&newer, sstable_reader_range_dels(lvl->files[i].reader))
+                 == STATUS_OK;
+        }
+    }
+    range_del_list_free(&newer);
+
+    // The SSTables may refer to blob files compacted away while iterating
+    uint64_t* blob_files = NULL;
+    size_t blob_count = 0;
+    ok = ok && level_pin_blob_files(db->levels, &blob_files, &blob_count) == STATUS_OK;
+
+    level_unlock(db->levels);
+    pthread_mutex_unlock(&db->mutex);
+
+    if (!ok) {
+        for (size_t i = 0; i < count; i++) {
+            iterator_destroy(children[i]);
+        }
+        free(children);
+        free(iter);
+        return NULL;
+    }
+
     iter->db = db;
-    iter->mt_iter = memtable_iter_create(db->memtable);
-    if (!iter->mt_iter) {
+    iter->blob_value = NULL;
+    iter->blob_files = blob_files;
+    iter->blob_count = blob_count;
+    iter->prefix_mode = prefix_mode;
+    iter->bounded = false;
+    iter->prefix = NULL;
+    iter->prefix_len = 0;
+    iter->prefix_cap = 0;
+    iter->merged = merge_iter_create(children, count, db->levels->cmp);
+    free(children);
+    if (!iter->merged) {
+        level_unpin_blob_files(db->levels, blob_files, blob_count);
+        free(blob_files);
         free(iter);
         return NULL;
     }
@@ -242,183 +1108,321 @@ storage_iter_t* storage_iter_create(storage_t* db) {
 // Destroy iterator
 void storage_iter_destroy(storage_iter_t* iter) {
     if (iter) {
-        memtable_iter_destroy(iter->mt_iter);
+        iterator_destroy(iter->merged);
+        level_unpin_blob_files(iter->db->levels, iter->blob_files, iter->blob_count);
+        free(iter->blob_files);
+        free(iter->blob_value);
+        free(iter->prefix);
         free(iter);
     }
 }
 
+// Helper: check if the current entry is within the seek prefix (always
+// true outside prefix mode)
+static bool in_prefix(storage_iter_t* iter) {
+    if (!iter->bounded) return true;
+    size_t key_len;
+    const char* key = iterator_key(iter->merged, &key_len);
+    size_t prefix_len = iter->db->opts.prefix_extractor(key, key_len);
+    if (prefix_len > key_len) prefix_len = key_len;
+    return prefix_len == iter->prefix_len && memcmp(key, iter->prefix, prefix_len) == 0;
+}
+
+// Helper: skip entries whose newest version is a tombstone
+static void skip_deleted(storage_iter_t* iter) {
+    while (iterator_valid(iter->merged) && in_prefix(iter) &&
+           iterator_is_deleted(iter->merged)) {
+        iterator_next(iter->merged);
+    }
+}
+
 // Seek to first entry
 void storage_iter_seek_to_first(storage_iter_t* iter) {
     if (iter) {
-        memtable_iter_seek_to_first(iter->mt_iter);
-        // Skip deleted entries
-        while (memtable_iter_valid(iter->mt_iter) &&
-               memtable_iter_is_deleted(iter->mt_iter)) {
-            memtable_iter_next(iter->mt_iter);
-        }
+        iter->bounded = false;
+        iterator_seek_to_first(iter->merged);
+        skip_deleted(iter);
     }
 }
 
 // Seek to key
 void storage_iter_seek(storage_iter_t* iter, const char* key, size_t key_len) {
-    if (iter) {
-        memtable_iter_seek(iter->mt_iter, key, key_len);
-        // Skip deleted entries
-        while (memtable_iter_valid(iter->mt_iter) &&
-               memtable_iter_is_deleted(iter->mt_iter)) {
-            memtable_iter_next(iter->mt_iter);
+    if (!iter) return;
+
+    // Prefix mode: remember the target's prefix to stop at its end
+    iter->bounded = false;
+    if (iter->prefix_mode && key) {
+        size_t prefix_len = iter->db->opts.prefix_extractor(key, key_len);
+        if (prefix_len > key_len) prefix_len = key_len;
+        if (prefix_len > iter->prefix_cap) {
+            char* buf = realloc(iter->prefix, prefix_len);
+            if (buf) {
+                iter->prefix = buf;
+                iter->prefix_cap = prefix_len;
+            }
+        }
+        // Without room for the prefix, fall back to seeking every file
+        if (prefix_len <= iter->prefix_cap) {
+            if (prefix_len > 0) memcpy(iter->prefix, key, prefix_len);
+            iter->prefix_len = prefix_len;
+            iter->bounded = true;
         }
     }
+    iterator_seek(iter->merged, key, key_len);
+    skip_deleted(iter);
 }
 
 // Check if iterator is valid
 bool storage_iter_valid(storage_iter_t* iter) {
-    return iter && memtable_iter_valid(iter->mt_iter);
+    return iter && iterator_valid(iter->merged) && in_prefix(iter);
 }
 
 // Move to next entry
 void storage_iter_next(storage_iter_t* iter) {
     if (iter) {
-        memtable_iter_next(iter->mt_iter);
-        // Skip deleted entries
-        while (memtable_iter_valid(iter->mt_iter) &&
-               memtable_iter_is_deleted(iter->mt_iter)) {
-            memtable_iter_next(iter->mt_iter);
-        }
+        iterator_next(iter->merged);
+        skip_deleted(iter);
     }
 }
 
 // Get current key
 const char* storage_iter_key(storage_iter_t* iter, size_t* key_len) {
-    return iter ? memtable_iter_key(iter->mt_iter, key_len) : NULL;
+    return iter ? iterator_key(iter->merged, key_len) : NULL;
 }
 
 // Get current value
 const char* storage_iter_value(storage_iter_t* iter, size_t* val_len) {
-    return iter ? memtable_iter_value(iter->mt_iter, val_len) : NULL;
+    if (!iter) return NULL;
+    const char* value = iterator_value(iter->merged, val_len);
+    if (!value || !iterator_is_blob(iter->merged)) return value;
+
+    // The buffer is replaced on the next call, like the entry itself
+    free(iter->blob_value);
+    iter->blob_value = NULL;
+    char* blob;
+    if (level_read_blob(iter->db->levels, value, *val_len, &blob, val_len) != STATUS_OK) {
+        *val_len = 0;
+        return NULL;
+    }
+    iter->blob_value = blob;
+    return blob;
 }
 
-// Compact: trigger compaction if needed
+// Compact: run compactions until no level needs one
 status_t storage_compact(storage_t* db) {
     if (!db || !db->levels) return STATUS_INVALID_ARG;
 
-    int level = compact_pick_level(db->levels);
-    if (level >= 0) {
-        return compact_level(db->levels, level);
+    // Memory-only database: compact inline
+    if (!db->bg_started) {
+        int level = compact_pick_level(db->levels);
+        if (level >= 0) {
+            return compact_level(db->levels, level);
+        }
+        return STATUS_OK;
+    }
+
+    // Wake the worker and wait until it has nothing left to do
+    pthread_mutex_lock(&db->mutex);
+    db->manual_compaction = true;
+    pthread_cond_signal(&db->bg_cv);
+    while (db->manual_compaction && db->bg_error == STATUS_OK) {
+        pthread_cond_wait(&db->done_cv, &db->mutex);
     }
-    return STATUS_OK;
+    status_t status = db->bg_error;
+    pthread_mutex_unlock(&db->mutex);
+
+    return status;
 }
 
 // Flush memtable to SSTable
+// Switches the memtable out and waits for the worker to write it to L0.
+// Compaction of L0 happens afterwards in the background.
 status_t storage_flush(storage_t* db) {
     if (!db || !db->path || !db->levels) return STATUS_INVALID_ARG;
 
-    // Check if memtable has data
-    size_t count = memtable_count(db->memtable);
-    if (count == 0) return STATUS_OK;
+    // Switch the memtable out through the writer queue, then wait for it
+    status_t status = storage_write_entries(db, NULL, 0, true);
 
-    // Get next file number from level manager
-    uint64_t file_num = level_next_file_number(db->levels);
+    pthread_mutex_lock(&db->mutex);
+    while (status == STATUS_OK && db->imm && db->bg_error == STATUS_OK) {
+        pthread_cond_wait(&db->done_cv, &db->mutex);
+    }
+    if (status == STATUS_OK) {
+        status = db->bg_error;
+    }
+    pthread_mutex_unlock(&db->mutex);
 
-    // Generate SSTable filename
-    size_t path_len = strlen(db->path) + 32;
-    char* sst_path = malloc(path_len);
-    if (!sst_path) return STATUS_NO_MEMORY;
-    snprintf(sst_path, path_len, "%s/%06llu.sst", db->path, (unsigned long long)file_num);
+    return status;
+}
 
-    // Create SSTable writer
-    sstable_writer_t* writer = sstable_writer_create(sst_path, count, db->opts.comparator);
-    if (!writer) {
-        free(sst_path);
+// ============================================================
+// Ingestion
+// ============================================================
+
+// Helper: copy a file byte for byte
+static status_t copy_file(const char* src, const char* dst) {
+    int in = open(src, O_RDONLY);
+    if (in < 0) return STATUS_IO_ERROR;
+    int out = open(dst, O_WRONLY | O_CREAT | O_EXCL, 0644);
+    if (out < 0) {
+        close(in);
         return STATUS_IO_ERROR;
     }
 
-    // Iterate memtable and write all entries (including tombstones)
-    memtable_iter_t* iter = memtable_iter_create(db->memtable);
-    if (!iter) {
-        sstable_writer_abort(writer);
-        free(sst_path);
-        return STATUS_NO_MEMORY;
+    char buf[64 * 1024];
+    status_t status = STATUS_OK;
+    ssize_t n;
+    while (status == STATUS_OK && (n = read(in, buf, sizeof(buf))) != 0) {
+        if (n < 0 || write(out, buf, (size_t)n) != n) status = STATUS_IO_ERROR;
     }
+    if (status == STATUS_OK && fsync(out) != 0) status = STATUS_IO_ERROR;
+    close(in);
+    close(out);
+    if (status != STATUS_OK) unlink(dst);
+    return status;
+}
 
-    memtable_iter_seek_to_first(iter);
-    while (memtable_iter_valid(iter)) {
-        size_t key_len, val_len;
-        const char* key = memtable_iter_key(iter, &key_len);
-        const char* val = memtable_iter_value(iter, &val_len);
-        bool deleted = memtable_iter_is_deleted(iter);
+// Helper: bring an external table in under a new file number and open it
+static status_t import_table(storage_t* db, const char* src, ingest_file_t* f) {
+    f->file_num = level_new_file_number(db->levels);
+    size_t path_len = strlen(db->path) + 32;
+    f->path = malloc(path_len);
+    if (!f->path) return STATUS_NO_MEMORY;
+    snprintf(f->path, path_len, "%s/%06llu.sst", db->path, (unsigned long long)f->file_num);
 
-        status_t status = sstable_writer_add(writer, key, key_len, val, val_len, deleted);
+    // SSTables are never modified, so a link is as good as a copy
+    if (link(src, f->path) != 0) {
+        status_t status = copy_file(src, f->path);
         if (status != STATUS_OK) {
-            memtable_iter_destroy(iter);
-            sstable_writer_abort(writer);
-            free(sst_path);
+            free(f->path);
+            f->path = NULL;
             return status;
         }
+    }
 
-        memtable_iter_next(iter);
+    f->reader = level_open_sstable(db->levels, f->path);
+    if (!f->reader) return STATUS_CORRUPTION;
+
+    // Prefix filters built by another extractor are ignored (see
+    // level_open_sstable); blob references would point into another
+    // database's blob files
+    if (f->reader->footer.flags & SSTABLE_FLAG_BLOB) return STATUS_INVALID_ARG;
+    if (sstable_reader_num_entries(f->reader) == 0 &&
+        sstable_reader_range_dels(f->reader)->count == 0) {
+        return STATUS_INVALID_ARG;
     }
-    memtable_iter_destroy(iter);
+    return STATUS_OK;
+}
 
-    // Finish writing SSTable
-    status_t status = sstable_writer_finish(writer);
-    if (status != STATUS_OK) {
-        free(sst_path);
-        return status;
+// Helper: sort tables by min key and check that their ranges are disjoint
+static status_t check_ingest_ranges(storage_t* db, ingest_file_t* files, size_t count) {
+    compare_fn cmp = db->levels->cmp;
+    size_t a_len, b_len;
+    for (size_t i = 1; i < count; i++) {
+        ingest_file_t f = files[i];
+        const char* key = sstable_reader_min_key(f.reader, &a_len);
+        size_t j = i;
+        while (j > 0) {
+            const char* prev = sstable_reader_min_key(files[j - 1].reader, &b_len);
+            if (cmp(prev, b_len, key, a_len) <= 0) break;
+            files[j] = files[j - 1];
+            j--;
+        }
+        files[j] = f;
     }
 
-    // Open the new SSTable for reading
-    sstable_reader_t* reader = sstable_reader_open(sst_path, db->opts.comparator);
-    if (!reader) {
-        free(sst_path);
-        return STATUS_IO_ERROR;
+    for (size_t i = 1; i < count; i++) {
+        const char* prev_max = sstable_reader_max_key(files[i - 1].reader, &a_len);
+        const char* min = sstable_reader_min_key(files[i].reader, &b_len);
+        if (cmp(prev_max, a_len, min, b_len) >= 0) return STATUS_INVALID_ARG;
     }
+    return STATUS_OK;
+}
 
-    // Add to L0 in level manager
-    status = level_add_sstable(db->levels, 0, file_num, sst_path, reader);
-    free(sst_path);
-    if (status != STATUS_OK) {
-        sstable_reader_close(reader);
-        return status;
+// Helper: check if a memtable holds keys in any ingested table's range
+static bool memtables_overlap(storage_t* db, const ingest_file_t* files, size_t count) {
+    pthread_mutex_lock(&db->mutex);
+    bool overlap = false;
+    for (size_t i = 0; i < count && !overlap; i++) {
+        size_t min_len, max_len;
+        const char* min_key = sstable_reader_min_key(files[i].reader, &min_len);
+        const char* max_key = sstable_reader_max_key(files[i].reader, &max_len);
+        overlap = memtable_overlaps(db->memtable, min_key, min_len, max_key, max_len) ||
+                  memtable_overlaps(db->imm, min_key, min_len, max_key, max_len);
     }
+    pthread_mutex_unlock(&db->mutex);
+    return overlap;
+}
 
-    // Log to manifest
-    manifest_log_add_file(db->path, 0, file_num);
-    manifest_log_next_file_num(db->path, level_next_file_number(db->levels));
+// Ingest external SSTables
+status_t storage_ingest_files(storage_t* db, const char* const* paths, size_t count) {
+    if (!db || !db->bg_started || (!paths && count > 0)) return STATUS_INVALID_ARG;
+    if (count == 0) return STATUS_OK;
 
-    // Clear memtable
-    memtable_destroy(db->memtable);
-    db->memtable = memtable_create(db->opts.memtable_size, db->opts.comparator);
-    if (!db->memtable) {
-        return STATUS_NO_MEMORY;
+    ingest_file_t* files = calloc(count, sizeof(ingest_file_t));
+    if (!files) return STATUS_NO_MEMORY;
+
+    status_t status = STATUS_OK;
+    for (size_t i = 0; i < count && status == STATUS_OK; i++) {
+        status = paths[i] ? import_table(db, paths[i], &files[i]) : STATUS_INVALID_ARG;
+    }
+    if (status == STATUS_OK) {
+        status = check_ingest_ranges(db, files, count);
     }
 
-    // Reset WAL
-    if (db->wal) {
-        wal_close(db->wal);
-        size_t wal_path_len = strlen(db->path) + 16;
-        char* wal_path = malloc(wal_path_len);
-        if (!wal_path) return STATUS_NO_MEMORY;
-        snprintf(wal_path, wal_path_len, "%s/wal.log", db->path);
-        db->wal = wal_open(wal_path, db->opts.sync_writes);
-        free(wal_path);
-        if (!db->wal) return STATUS_IO_ERROR;
+    // Writes already in a memtable are older than the tables: get them
+    // into L0 first so the tables can go above them
+    if (status == STATUS_OK && memtables_overlap(db, files, count)) {
+        status = storage_flush(db);
     }
 
-    // Check if compaction is needed
-    if (level_needs_compaction(db->levels, 0)) {
-        storage_compact(db);
+    // The worker is the only thread changing the levels
+    if (status == STATUS_OK) {
+        storage_ingest_t job = {files, count, false, STATUS_OK};
+        pthread_mutex_lock(&db->mutex);
+        while (db->ingest) {
+            pthread_cond_wait(&db->done_cv, &db->mutex);
+        }
+        db->ingest = &job;
+        pthread_cond_signal(&db->bg_cv);
+        while (!job.done) {
+            pthread_cond_wait(&db->done_cv, &db->mutex);
+        }
+        pthread_mutex_unlock(&db->mutex);
+        status = job.status;
     }
 
-    return STATUS_OK;
+    for (size_t i = 0; i < count; i++) {
+        if (!files[i].installed) {
+            if (files[i].reader) sstable_reader_close(files[i].reader);
+            if (files[i].path) unlink(files[i].path);
+        }
+        free(files[i].path);
+    }
+    free(files);
+    return status;
 }
 
 // Get count
 size_t storage_count(storage_t* db) {
-    return db ? memtable_count(db->memtable) : 0;
+    if (!db) return 0;
+
+    pthread_mutex_lock(&db->mutex);
+    size_t count = memtable_count(db->memtable);
+    if (db->imm) count += memtable_count(db->imm);
+    pthread_mutex_unlock(&db->mutex);
+
+    return count;
 }
 
 // Get memory usage
 size_t storage_memory_usage(storage_t* db) {
-    return db ? memtable_memory_usage(db->memtable) : 0;
-}
\ No newline at end of file
+    if (!db) return 0;
+
+    pthread_mutex_lock(&db->mutex);
+    size_t usage = memtable_memory_usage(db->memtable);
+    if (db->imm) usage += memtable_memory_usage(db->imm);
+    pthread_mutex_unlock(&db->mutex);
+
+    return usage;
+}
@@ -7,24 +7,92 @@
 #include "wal.h"
 #include "sstable.h"
 #include "level.h"
+#include "cache.h"
+#include "iterator.h"
+
+// Pending write waiting in the group-commit queue (defined in storage.c)
+typedef struct storage_writer storage_writer_t;
+// Ingestion waiting for the worker to install its tables (storage.c)
+typedef struct storage_ingest storage_ingest_t;
 
 // Storage engine structure
 struct storage {
     char* path;
     storage_opts_t opts;
-    memtable_t* memtable;
+    memtable_t* memtable;   // Active memtable, receives all writes
+    memtable_t* imm;        // Full memtable waiting to be flushed (or NULL)
     wal_t* wal;  // Write-ahead log for durability
     // Phase 4: Level-based SSTable management
     level_manager_t* levels;
+    // Block cache shared by all SSTable readers (NULL if disabled)
+    block_cache_t* cache;
+
+    // Background worker: flushes imm to L0 and runs compactions.
+    // Only started for on-disk databases.
+    pthread_mutex_t mutex;      // Guards memtable, imm, wal and the fields below
+    pthread_cond_t bg_cv;       // Wakes the worker
+    pthread_cond_t done_cv;     // Signalled whenever the worker finishes a job
+    pthread_t bg_thread;
+    bool bg_started;
+    bool shutting_down;
+    bool manual_compaction;     // storage_compact is waiting for the worker to go idle
+    storage_ingest_t* ingest;   // storage_ingest_files waiting for the worker
+    status_t bg_error;          // First background failure; fails later writes
+
+    // Group commit: the writer at the head of the queue writes the WAL
+    // for itself and the writers behind it
+    storage_writer_t* writers_head;
+    storage_writer_t* writers_tail;
+    wal_entry_t* group;         // Leader's scratch list of grouped records
+    size_t group_cap;
+};
+
+// Write batch
+// Puts and deletes applied atomically by storage_write. rep holds the WAL
+// batch payload (see wal.h), so the whole batch is logged as one record.
+struct storage_write_batch {
+    char* rep;
+    size_t size;
+    size_t cap;
 };
 
+// Value returned by storage_get_pinned, read in place: from a memtable
+// node or from a data block (cached, mapped or private to the lookup).
+// Holds its source until storage_pinned_release, which must come before
+// storage_close.
+typedef struct {
+    const char* data;
+    size_t size;
+    memtable_t* memtable;   // Referenced memtable holding data, or NULL
+    level_pin_t pin;        // Otherwise: the block (or buffer) holding data
+} storage_pinned_t;
+
 // Storage iterator
+// Merges the memtable, every L0 file (newest first) and one concatenating
+// iterator per L1+ level; tombstones hide older versions and are skipped.
+// Blob references are resolved when the value is asked for.
 struct storage_iter {
     storage_t* db;
-    memtable_iter_t* mt_iter;
-    // Future phases will add SSTable iterators
+    iterator_t* merged;
+    char* blob_value;       // Value read from a blob file for the current entry
+    uint64_t* blob_files;   // Blob files pinned for the iterator's SSTables
+    size_t blob_count;
+    bool prefix_mode;       // STORAGE_ITER_PREFIX with a prefix extractor
+    bool bounded;           // Prefix mode after a seek: stop past prefix
+    char* prefix;           // Prefix of the last seek target
+    size_t prefix_len;
+    size_t prefix_cap;
 };
 
+// storage_iter_create_ex flags
+// Prefix seek (needs opts.prefix_extractor): storage_iter_seek only visits
+// keys with the target's prefix, becoming invalid past them, and skips the
+// SSTables whose prefix filter rules the prefix out. Only filters built
+// under opts.prefix_extractor_name count; others (older tables, ingested
+// ones) are read as if absent.
+// storage_iter_seek_to_first still iterates everything.
+#define STORAGE_ITER_PREFIX 0x1
+
 // Lifecycle
 storage_t* storage_open(const char* path, storage_opts_t* opts);
 void storage_close(storage_t* db);
@@ -34,10 +102,34 @@ status_t storage_put(storage_t* db, const char* key, size_t key_len,
                      const char* val, size_t val_len);
 status_t storage_get(storage_t* db, const char* key, size_t key_len,
                      char** val, size_t* val_len);
+// Zero-copy get: value->data points into the engine's own memory
+status_t storage_get_pinned(storage_t* db, const char* key, size_t key_len,
+                            storage_pinned_t* value);
+void storage_pinned_release(storage_pinned_t* value);
 status_t storage_delete(storage_t* db, const char* key, size_t key_len);
+// Delete every key in [begin, end); INVALID_ARG if begin > end
+status_t storage_delete_range(storage_t* db, const char* begin, size_t begin_len,
+                              const char* end, size_t end_len);
+
+// Batch operations
+storage_write_batch_t* storage_write_batch_create(void);
+void storage_write_batch_destroy(storage_write_batch_t* batch);
+status_t storage_write_batch_put(storage_write_batch_t* batch,
+                                 const char* key, size_t key_len,
+                                 const char* val, size_t val_len);
+status_t storage_write_batch_delete(storage_write_batch_t* batch,
+                                    const char* key, size_t key_len);
+status_t storage_write_batch_delete_range(storage_write_batch_t* batch,
+                                          const char* begin, size_t begin_len,
+                                          const char* end, size_t end_len);
+void storage_write_batch_clear(storage_write_batch_t* batch);
+size_t storage_write_batch_count(storage_write_batch_t* batch);
+// All of the batch or none of it survives a crash
+status_t storage_write(storage_t* db, storage_write_batch_t* batch);
 
 // Range operations
 storage_iter_t* storage_iter_create(storage_t* db);
+storage_iter_t* storage_iter_create_ex(storage_t* db, int flags);
 void storage_iter_destroy(storage_iter_t* iter);
 void storage_iter_seek_to_first(storage_iter_t* iter);
 void storage_iter_seek(storage_iter_t* iter, const char* key, size_t key_len);
@@ -46,10 +138,23 @@ void storage_iter_next(storage_iter_t* iter);
 const char* storage_iter_key(storage_iter_t* iter, size_t* key_len);
 const char* storage_iter_value(storage_iter_t* iter, size_t* val_len);
 
-// Maintenance (stubs for Phase 1)
+// Maintenance
+// storage_flush returns once the current memtable is on disk in L0;
+// storage_compact returns once no level needs compaction any more.
 status_t storage_compact(storage_t* db);
 status_t storage_flush(storage_t* db);
 
+// Bulk load
+// Add SSTables built with sstable_writer_t (same comparator, no blob
+// values) without going through the WAL and memtable. The tables must
+// not overlap each other; they shadow everything already in the database.
+// Their prefix filters are used only if built under the same extractor name.
+// Each is hard-linked (or copied) into the database and added to the
+// deepest level that keeps it above all the data it overlaps; memtables
+// it overlaps are flushed first. The originals may be deleted afterwards.
+// Needs an on-disk database.
+status_t storage_ingest_files(storage_t* db, const char* const* paths, size_t count);
+
 // Statistics
 size_t storage_count(storage_t* db);
 size_t storage_memory_usage(storage_t* db);
@@ -15,6 +15,12 @@ typedef enum {
     STATUS_NO_MEMORY = 5,
 } status_t;
 
+// Block compression codecs (the value is also the on-disk block type byte)
+typedef enum {
+    COMPRESSION_NONE = 0,
+    COMPRESSION_LZ4 = 1,
+} compression_t;
+
 // Key-value entry
 typedef struct {
     char* key;
@@ -28,6 +34,7 @@ typedef struct {
 // Forward declarations
 typedef struct storage storage_t;
 typedef struct storage_iter storage_iter_t;
+typedef struct storage_write_batch storage_write_batch_t;
 typedef struct memtable memtable_t;
 typedef struct skiplist skiplist_t;
 typedef struct skiplist_iter skiplist_iter_t;
@@ -43,6 +50,11 @@ typedef struct block_cache block_cache_t;
 typedef int (*compare_fn)(const char* a, size_t a_len,
                           const char* b, size_t b_len);
 
+// Prefix extractor: length of the prefix of key used by prefix filters.
+// Keys sharing a prefix must be adjacent in comparator order, and the
+// extractor must not change for the life of a database.
+typedef size_t (*prefix_extractor_fn)(const char* key, size_t key_len);
+
 // Default comparison (lexicographic)
 int default_compare(const char* a, size_t a_len,
                     const char* b, size_t b_len);
@@ -81,6 +81,8 @@ wal_t* wal_open(const char* path, bool sync_writes) {
     }
 
     wal->sync_writes = sync_writes;
+    wal->buf = NULL;
+    wal->buf_cap = 0;
     return wal;
 }
 
@@ -92,37 +94,20 @@ void wal_close(wal_t* wal) {
             close(wal->fd);
         }
         free(wal->path);
+        free(wal->buf);
         free(wal);
     }
 }
 
-// Write a record to WAL
-// Record format: length(4) | crc32(4) | type(1) | key_len(4) | key | val_len(4) | value
-static status_t wal_write_record(wal_t* wal, wal_record_type_t type,
-                                  const char* key, size_t key_len,
-                                  const char* val, size_t val_len) {
-    if (!wal || !key) return STATUS_INVALID_ARG;
-
-    // Calculate record size (excluding length field)
-    size_t record_size = WAL_CRC_SIZE + WAL_TYPE_SIZE + WAL_KEYLEN_SIZE +
-                         key_len + WAL_VALLEN_SIZE + val_len;
-
-    // Allocate buffer for entire record
-    size_t total_size = WAL_LENGTH_SIZE + record_size;
-    char* buf = malloc(total_size);
-    if (!buf) return STATUS_NO_MEMORY;
-
-    char* p = buf;
-
-    // Write length (record_size, not including length field itself)
-    uint32_t len32 = (uint32_t)record_size;
-    memcpy(p, &len32, 4);
-    p += 4;
-
-    // Skip CRC for now (will fill in after)
-    char* crc_pos = p;
-    p += 4;
+// Encoded size of one entry: type(1) | key_len(4) | key | val_len(4) | value
+size_t wal_entry_encoded_size(size_t key_len, size_t val_len) {
+    return WAL_TYPE_SIZE + WAL_KEYLEN_SIZE + key_len + WAL_VALLEN_SIZE + val_len;
+}
 
+// Encode one entry at p, returns the end of the entry
+char* wal_encode_entry(char* p, wal_record_type_t type,
+                       const char* key, size_t key_len,
+                       const char* val, size_t val_len) {
     // Write type
     *p++ = (char)type;
 
@@ -139,20 +124,81 @@ static status_t wal_write_record(wal_t* wal, wal_record_type_t type,
     p += 4;
     if (val_len > 0 && val) {
         memcpy(p, val, val_len);
+        p += val_len;
+    }
+    return p;
+}
+
+// Helper: encoded size of one record, including the length field
+static size_t wal_record_size(const wal_entry_t* e) {
+    if (e->type == WAL_RECORD_BATCH) {
+        return WAL_LENGTH_SIZE + WAL_CRC_SIZE + WAL_TYPE_SIZE + e->val_len;
+    }
+    return WAL_LENGTH_SIZE + WAL_CRC_SIZE + wal_entry_encoded_size(e->key_len, e->val_len);
+}
+
+// Helper: encode one record at p
+// Record format: length(4) | crc(4) | type(1) | key_len(4) | key | val_len(4) | value
+// Batch records: length(4) | crc(4) | type(1) | batch payload
+// New records carry WAL_RECORD_CRC32C in their type byte.
+static char* wal_encode_record(char* p, const wal_entry_t* e) {
+    // Length covers everything after the length field itself
+    uint32_t len32 = (uint32_t)(wal_record_size(e) - WAL_LENGTH_SIZE);
+    memcpy(p, &len32, 4);
+    p += 4;
+
+    // Skip CRC for now (will fill in after)
+    char* crc_pos = p;
+    p += 4;
+
+    if (e->type == WAL_RECORD_BATCH) {
+        *p++ = (char)e->type;
+        memcpy(p, e->val, e->val_len);
+        p += e->val_len;
+    } else {
+        p = wal_encode_entry(p, e->type, e->key, e->key_len, e->val, e->val_len);
     }
 
-    // Calculate CRC32 over type + key_len + key + val_len + value
-    uint32_t crc = crc32(crc_pos + 4, record_size - WAL_CRC_SIZE);
+    // Calculate CRC32C over everything after the CRC
+    crc_pos[4] |= (char)WAL_RECORD_CRC32C;
+    uint32_t crc = crc32c(crc_pos + 4, (size_t)(p - crc_pos - 4));
     memcpy(crc_pos, &crc, 4);
 
+    return p;
+}
+
+// Write a group of records
+status_t wal_write_group(wal_t* wal, const wal_entry_t* entries, size_t count) {
+    if (!wal || (!entries && count > 0)) return STATUS_INVALID_ARG;
+    if (count == 0) return STATUS_OK;
+
+    size_t total_size = 0;
+    for (size_t i = 0; i < count; i++) {
+        bool is_batch = entries[i].type == WAL_RECORD_BATCH;
+        if (is_batch ? !entries[i].val : !entries[i].key) return STATUS_INVALID_ARG;
+        total_size += wal_record_size(&entries[i]);
+    }
+
+    // Grow the encoding buffer if needed
+    if (total_size > wal->buf_cap) {
+        size_t new_cap = wal->buf_cap > 0 ? wal->buf_cap : 4096;
+        while (new_cap < total_size) new_cap *= 2;
+        char* new_buf = realloc(wal->buf, new_cap);
+        if (!new_buf) return STATUS_NO_MEMORY;
+        wal->buf = new_buf;
+        wal->buf_cap = new_cap;
+    }
+
+    char* p = wal->buf;
+    for (size_t i = 0; i < count; i++) {
+        p = wal_encode_record(p, &entries[i]);
+    }
+
     // Write to file
-    if (write_all(wal->fd, buf, total_size) != (ssize_t)total_size) {
-        free(buf);
+    if (write_all(wal->fd, wal->buf, total_size) != (ssize_t)total_size) {
         return STATUS_IO_ERROR;
     }
-
     wal->file_size += total_size;
-    free(buf);
 
     // Sync if configured
     if (wal->sync_writes) {
@@ -167,12 +213,14 @@ static status_t wal_write_record(wal_t* wal, wal_record_type_t type,
 // Write PUT record
 status_t wal_write_put(wal_t* wal, const char* key, size_t key_len,
                        const char* val, size_t val_len) {
-    return wal_write_record(wal, WAL_RECORD_PUT, key, key_len, val, val_len);
+    wal_entry_t e = { WAL_RECORD_PUT, key, key_len, val, val_len };
+    return wal_write_group(wal, &e, 1);
 }
 
 // Write DELETE record
 status_t wal_write_delete(wal_t* wal, const char* key, size_t key_len) {
-    return wal_write_record(wal, WAL_RECORD_DELETE, key, key_len, NULL, 0);
+    wal_entry_t e = { WAL_RECORD_DELETE, key, key_len, NULL, 0 };
+    return wal_write_group(wal, &e, 1);
 }
 
 // Sync WAL to disk
@@ -184,6 +232,57 @@ status_t wal_sync(wal_t* wal) {
     return STATUS_OK;
 }
 
+// Helper: parse one entry at p (bounded by end)
+static const char* wal_parse_entry(const char* p, const char* end,
+                                   wal_record_type_t* type,
+                                   const char** key, uint32_t* key_len,
+                                   const char** val, uint32_t* val_len) {
+    if (end - p < WAL_TYPE_SIZE + WAL_KEYLEN_SIZE) return NULL;
+    *type = (wal_record_type_t)*p++;
+    memcpy(key_len, p, 4);
+    p += 4;
+    if ((size_t)(end - p) < (size_t)*key_len + WAL_VALLEN_SIZE) return NULL;
+    *key = p;
+    p += *key_len;
+    memcpy(val_len, p, 4);
+    p += 4;
+    if ((size_t)(end - p) < *val_len) return NULL;
+    *val = (*val_len > 0) ? p : NULL;
+    return p + *val_len;
+}
+
+// Replay a batch payload
+status_t wal_batch_iterate(const char* rep, size_t len, wal_recover_fn fn, void* ctx) {
+    if (!rep || len < WAL_BATCH_HEADER_SIZE) return STATUS_CORRUPTION;
+
+    uint32_t count;
+    memcpy(&count, rep, 4);
+    const char* end = rep + len;
+
+    // Pass 0 validates, pass 1 applies: a bad batch applies nothing
+    for (int pass = 0; pass < 2; pass++) {
+        const char* p = rep + WAL_BATCH_HEADER_SIZE;
+        for (uint32_t i = 0; i < count; i++) {
+            wal_record_type_t type;
+            const char* key;
+            const char* val;
+            uint32_t key_len, val_len;
+            p = wal_parse_entry(p, end, &type, &key, &key_len, &val, &val_len);
+            if (!p || (type != WAL_RECORD_PUT && type != WAL_RECORD_DELETE &&
+                       type != WAL_RECORD_DELETE_RANGE)) {
+                return STATUS_CORRUPTION;
+            }
+            if (pass == 1 && fn) {
+                status_t status = fn(ctx, type, key, key_len, val, val_len);
+                if (status != STATUS_OK) return status;
+            }
+        }
+        if (p != end) return STATUS_CORRUPTION;
+    }
+
+    return STATUS_OK;
+}
+
 // Recover WAL by replaying records
 status_t wal_recover(const char* path, wal_recover_fn fn, void* ctx) {
     if (!path || !fn) return STATUS_INVALID_ARG;
@@ -212,7 +311,7 @@ status_t wal_recover(const char* path, wal_recover_fn fn, void* ctx) {
         memcpy(&record_len, header, 4);
 
         // Sanity check on record length
-        if (record_len < WAL_CRC_SIZE + WAL_TYPE_SIZE + WAL_KEYLEN_SIZE + WAL_VALLEN_SIZE) {
+        if (record_len < WAL_CRC_SIZE + WAL_TYPE_SIZE + WAL_BATCH_HEADER_SIZE) {
             result = STATUS_CORRUPTION;
             break;
         }
@@ -231,10 +330,12 @@ status_t wal_recover(const char* path, wal_recover_fn fn, void* ctx) {
             break;
         }
 
-        // Verify CRC
+        // Verify CRC (the type byte says which checksum the record uses)
         uint32_t stored_crc;
         memcpy(&stored_crc, record, 4);
-        uint32_t computed_crc = crc32(record + 4, record_len - 4);
+        bool is_crc32c = ((uint8_t)record[4] & WAL_RECORD_CRC32C) != 0;
+        uint32_t computed_crc = is_crc32c ? crc32c(record + 4, record_len - 4)
+                                          : crc32(record + 4, record_len - 4);
 
         if (stored_crc != computed_crc) {
             // Corrupted record - stop recovery
@@ -244,22 +345,24 @@ status_t wal_recover(const char* path, wal_recover_fn fn, void* ctx) {
         }
 
         // Parse record
-        char* p = record + 4;  // Skip CRC
-        wal_record_type_t type = (wal_record_type_t)*p++;
-
-        uint32_t key_len;
-        memcpy(&key_len, p, 4);
-        p += 4;
-        const char* key = p;
-        p += key_len;
-
-        uint32_t val_len;
-        memcpy(&val_len, p, 4);
-        p += 4;
-        const char* val = (val_len > 0) ? p : NULL;
-
-        // Call recovery callback
-        result = fn(ctx, type, key, key_len, val, val_len);
+        record[4] &= (char)~WAL_RECORD_CRC32C;
+        const char* p = record + 4;  // Skip CRC
+        const char* end = record + record_len;
+        if ((wal_record_type_t)*p == WAL_RECORD_BATCH) {
+            result = wal_batch_iterate(p + 1, (size_t)(end - p - 1), fn, ctx);
+        } else {
+            wal_record_type_t type;
+            const char* key;
+            const char* val;
+            uint32_t key_len, val_len;
+            p = wal_parse_entry(p, end, &type, &key, &key_len, &val, &val_len);
+            if (!p) {
+                result = STATUS_CORRUPTION;
+            } else {
+                // Call recovery callback
+                result = fn(ctx, type, key, key_len, val, val_len);
+            }
+        }
         free(record);
 
         if (result != STATUS_OK) break;
@@ -8,16 +8,34 @@
 typedef enum {
     WAL_RECORD_PUT = 1,
     WAL_RECORD_DELETE = 2,
+    WAL_RECORD_BATCH = 3,   // Several puts/deletes under one CRC
+    WAL_RECORD_DELETE_RANGE = 4,    // key = begin, value = end (exclusive)
 } wal_record_type_t;
 
+// Set in a record's type byte when its checksum is CRC32C (format version 2).
+// Version 1 records, without the bit, use CRC-32 and are still recovered.
+#define WAL_RECORD_CRC32C 0x80
+
 // WAL structure
 struct wal {
     int fd;              // File descriptor
     char* path;          // WAL file path
     size_t file_size;    // Current file size
     bool sync_writes;    // Whether to fsync after each write
+    char* buf;           // Encoding buffer, reused across writes
+    size_t buf_cap;
 };
 
+// One record of a group write
+// For WAL_RECORD_BATCH, val/val_len hold the batch payload and key is unused.
+typedef struct {
+    wal_record_type_t type;
+    const char* key;
+    size_t key_len;
+    const char* val;
+    size_t val_len;
+} wal_entry_t;
+
 // Lifecycle
 wal_t* wal_open(const char* path, bool sync_writes);
 void wal_close(wal_t* wal);
@@ -26,6 +44,9 @@ void wal_close(wal_t* wal);
 status_t wal_write_put(wal_t* wal, const char* key, size_t key_len,
                        const char* val, size_t val_len);
 status_t wal_write_delete(wal_t* wal, const char* key, size_t key_len);
+// Group commit: appends all records with a single write() and, with
+// sync_writes, a single fsync. Not thread-safe; callers elect one writer.
+status_t wal_write_group(wal_t* wal, const wal_entry_t* entries, size_t count);
 status_t wal_sync(wal_t* wal);
 
 // Recovery callback type
@@ -33,9 +54,19 @@ typedef status_t (*wal_recover_fn)(void* ctx, wal_record_type_t type,
                                    const char* key, size_t key_len,
                                    const char* val, size_t val_len);
 
-// Recovery operation
+// Recovery operation (batch records are replayed entry by entry)
 status_t wal_recover(const char* path, wal_recover_fn fn, void* ctx);
 
+// Batch payload: count(4) | { type(1) | key_len(4) | key | val_len(4) | value }*
+// Entries use the same layout as the body of a single record.
+#define WAL_BATCH_HEADER_SIZE 4
+size_t wal_entry_encoded_size(size_t key_len, size_t val_len);
+char* wal_encode_entry(char* p, wal_record_type_t type,
+                       const char* key, size_t key_len,
+                       const char* val, size_t val_len);
+// Validates the whole payload before calling fn for each entry
+status_t wal_batch_iterate(const char* rep, size_t len, wal_recover_fn fn, void* ctx);
+
 // Maintenance
 status_t wal_truncate(wal_t* wal);
 
@@ -2,6 +2,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "../src/arena.h"
 #include "../src/skiplist.h"
 #include "../src/memtable.h"
 #include "../src/storage.h"
@@ -140,6 +143,163 @@ TEST(skiplist_iterator) {
     skiplist_destroy(list);
 }
 
+TEST(arena_alloc) {
+    arena_t* arena = arena_create();
+    ASSERT_NE(arena, NULL);
+    size_t base = arena_memory_usage(arena);
+
+    // Small allocations share one block
+    char* a = arena_alloc(arena, 3);
+    ASSERT_NE(a, NULL);
+    void* b = arena_alloc_aligned(arena, 24);
+    ASSERT_NE(b, NULL);
+    ASSERT_EQ((uintptr_t)b % sizeof(void*), 0);
+    ASSERT((char*)b > a && (char*)b < a + ARENA_BLOCK_SIZE);
+    size_t one_block = arena_memory_usage(arena);
+    ASSERT(one_block > base + ARENA_BLOCK_SIZE);
+    memset(a, 'x', 3);
+    memset(b, 0, 24);
+
+    // Large allocations get a block of their own, accounted exactly
+    ASSERT_NE(arena_alloc(arena, ARENA_BLOCK_SIZE * 2), NULL);
+    ASSERT(arena_memory_usage(arena) >= one_block + ARENA_BLOCK_SIZE * 2);
+    ASSERT(arena_memory_usage(arena) < one_block + ARENA_BLOCK_SIZE * 2 + 64);
+
+    arena_destroy(arena);
+}
+
+TEST(skiplist_memory_usage) {
+    skiplist_t* list = skiplist_create(NULL);
+    size_t empty = skiplist_memory_usage(list);
+
+    // Usage covers every key and value byte, in whole arena blocks
+    char key[32], val[128];
+    size_t data = 0;
+    for (int i = 0; i < 200; i++) {
+        snprintf(key, sizeof(key), "key%04d", i);
+        snprintf(val, sizeof(val), "%0100d", i);
+        ASSERT_EQ(skiplist_put(list, key, strlen(key), val, strlen(val)), STATUS_OK);
+        data += strlen(key) + strlen(val);
+    }
+    size_t used = skiplist_memory_usage(list) - empty;
+    ASSERT(used >= data);
+    ASSERT(used < data * 2);
+
+    skiplist_destroy(list);
+}
+
+TEST(skiplist_level_distribution) {
+    skiplist_t* list = skiplist_create(NULL);
+
+    char key[32];
+    for (int i = 0; i < 20000; i++) {
+        snprintf(key, sizeof(key), "key%06d", i);
+        ASSERT_EQ(skiplist_put(list, key, strlen(key), "v", 1), STATUS_OK);
+    }
+
+    // Each level keeps about SKIPLIST_P of the nodes below it
+    size_t at_least[4] = {0};
+    for (skiplist_node_t* n = list->header->forward[0]; n; n = n->forward[0]) {
+        ASSERT(n->level >= 1 && n->level <= SKIPLIST_MAX_LEVEL);
+        for (int l = 1; l <= 3; l++) {
+            if (n->level >= l) at_least[l]++;
+        }
+    }
+    ASSERT_EQ(at_least[1], 20000);
+    for (int l = 2; l <= 3; l++) {
+        double ratio = (double)at_least[l] / at_least[l - 1];
+        ASSERT(ratio > SKIPLIST_P * 0.8 && ratio < SKIPLIST_P * 1.2);
+    }
+
+    skiplist_destroy(list);
+}
+
+// Concurrent skiplist test threads
+#define CONC_WRITERS 4
+#define CONC_KEYS_PER_WRITER 2000
+
+typedef struct {
+    skiplist_t* list;
+    int id;
+    int* stop;
+    int errors;
+} conc_arg_t;
+
+static void* conc_writer(void* arg) {
+    conc_arg_t* a = arg;
+    char key[32], val[32];
+    for (int i = 0; i < CONC_KEYS_PER_WRITER; i++) {
+        // Interleaved keys, so writers keep splicing next to each other
+        snprintf(key, sizeof(key), "key%06d", i * CONC_WRITERS + a->id);
+        snprintf(val, sizeof(val), "val%06d", i * CONC_WRITERS + a->id);
+        if (skiplist_put(a->list, key, strlen(key), val, strlen(val)) != STATUS_OK) {
+            a->errors++;
+        }
+        // Every writer also races on the same shared keys
+        snprintf(key, sizeof(key), "shared%03d", i % 100);
+        if (skiplist_put(a->list, key, strlen(key), "x", 1) != STATUS_OK) {
+            a->errors++;
+        }
+    }
+    return NULL;
+}
+
+static void* conc_reader(void* arg) {
+    conc_arg_t* a = arg;
+    skiplist_iter_t* iter = skiplist_iter_create(a->list);
+    while (!__atomic_load_n(a->stop, __ATOMIC_ACQUIRE)) {
+        // Readers never block and always see a sorted list
+        char prev[32] = "";
+        for (skiplist_iter_seek_to_first(iter); skiplist_iter_valid(iter);
+             skiplist_iter_next(iter)) {
+            size_t len;
+            const char* k = skiplist_iter_key(iter, &len);
+            char cur[32];
+            snprintf(cur, sizeof(cur), "%.*s", (int)len, k);
+            if (prev[0] && strcmp(prev, cur) >= 0) a->errors++;
+            strcpy(prev, cur);
+        }
+    }
+    skiplist_iter_destroy(iter);
+    return NULL;
+}
+
+TEST(skiplist_concurrent_insert) {
+    skiplist_t* list = skiplist_create_concurrent(NULL);
+    ASSERT_NE(list, NULL);
+
+    int stop = 0;
+    pthread_t writers[CONC_WRITERS], reader;
+    conc_arg_t args[CONC_WRITERS], reader_arg = { list, 0, &stop, 0 };
+    ASSERT_EQ(pthread_create(&reader, NULL, conc_reader, &reader_arg), 0);
+    for (int t = 0; t < CONC_WRITERS; t++) {
+        args[t] = (conc_arg_t){ list, t, &stop, 0 };
+        ASSERT_EQ(pthread_create(&writers[t], NULL, conc_writer, &args[t]), 0);
+    }
+    for (int t = 0; t < CONC_WRITERS; t++) {
+        pthread_join(writers[t], NULL);
+        ASSERT_EQ(args[t].errors, 0);
+    }
+    __atomic_store_n(&stop, 1, __ATOMIC_RELEASE);
+    pthread_join(reader, NULL);
+    ASSERT_EQ(reader_arg.errors, 0);
+
+    // No lost or duplicated inserts
+    ASSERT_EQ(skiplist_count(list), (size_t)(CONC_WRITERS * CONC_KEYS_PER_WRITER + 100));
+    for (int i = 0; i < CONC_WRITERS * CONC_KEYS_PER_WRITER; i++) {
+        char key[32], expected[32];
+        snprintf(key, sizeof(key), "key%06d", i);
+        snprintf(expected, sizeof(expected), "val%06d", i);
+        char* val;
+        size_t val_len;
+        ASSERT_EQ(skiplist_get(list, key, strlen(key), &val, &val_len), STATUS_OK);
+        ASSERT_EQ(val_len, strlen(expected));
+        ASSERT_STR_EQ(val, expected, val_len);
+    }
+
+    skiplist_destroy(list);
+}
+
 // ============================================================
 // MemTable Tests
 // ============================================================
@@ -291,6 +451,10 @@ int main(void) {
     RUN_TEST(skiplist_update);
     RUN_TEST(skiplist_delete);
     RUN_TEST(skiplist_iterator);
+    RUN_TEST(arena_alloc);
+    RUN_TEST(skiplist_memory_usage);
+    RUN_TEST(skiplist_level_distribution);
+    RUN_TEST(skiplist_concurrent_insert);
 
     printf("\nMemTable Tests:\n");
     RUN_TEST(memtable_basic);
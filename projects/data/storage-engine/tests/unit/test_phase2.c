@@ -4,6 +4,7 @@
 #include <assert.h>
 #include <unistd.h>
 #include <sys/stat.h>
+#include <pthread.h>
 #include "../../src/crc32.h"
 #include "../../src/wal.h"
 #include "../../src/storage.h"
@@ -70,6 +71,26 @@ TEST(crc32_incremental) {
     ASSERT_EQ(full_crc, inc_crc);
 }
 
+TEST(crc32c_known_values) {
+    // Standard check values for "123456789"
+    ASSERT_EQ(crc32("123456789", 9), 0xCBF43926u);
+    ASSERT_EQ(crc32c("123456789", 9), 0xE3069283u);
+    ASSERT_EQ(crc32c_update_portable(0, "123456789", 9), 0xE3069283u);
+
+    // The runtime-selected path agrees with slicing-by-8 at every alignment
+    // and length, and streams like the one-shot call
+    uint8_t buf[300];
+    for (size_t i = 0; i < sizeof(buf); i++) buf[i] = (uint8_t)(i * 131 + 7);
+    for (size_t off = 0; off < 8; off++) {
+        for (size_t len = 0; len + off <= sizeof(buf); len += 13) {
+            uint32_t crc = crc32c(buf + off, len);
+            ASSERT_EQ(crc, crc32c_update_portable(0, buf + off, len));
+            ASSERT_EQ(crc32c_update(crc32c(buf + off, len / 3), buf + off + len / 3, len - len / 3), crc);
+        }
+    }
+    ASSERT_NE(crc32c_impl(), NULL);
+}
+
 // ============================================================
 // WAL Tests
 // ============================================================
@@ -165,6 +186,72 @@ TEST(wal_recover) {
     unlink(path);
 }
 
+TEST(wal_recover_crc32_records) {
+    const char* path = "test_wal_crc32.wal";
+    unlink(path);
+
+    // A version 1 record: no CRC32C bit, CRC-32 checksum
+    char body[64];
+    char* end = wal_encode_entry(body, WAL_RECORD_PUT, "old", 3, "crc32", 5);
+    uint32_t body_len = (uint32_t)(end - body);
+    uint32_t record_len = 4 + body_len;
+    uint32_t crc = crc32(body, body_len);
+    FILE* f = fopen(path, "wb");
+    ASSERT_NE(f, NULL);
+    fwrite(&record_len, 4, 1, f);
+    fwrite(&crc, 4, 1, f);
+    fwrite(body, 1, body_len, f);
+    fclose(f);
+
+    // New records append after it with CRC32C
+    wal_t* wal = wal_open(path, false);
+    ASSERT_NE(wal, NULL);
+    ASSERT_EQ(wal_write_put(wal, "new", 3, "crc32c", 6), STATUS_OK);
+    wal_close(wal);
+
+    recover_ctx_t ctx = {0};
+    ASSERT_EQ(wal_recover(path, test_recover_fn, &ctx), STATUS_OK);
+    ASSERT_EQ(ctx.put_count, 2);
+    ASSERT_STR_EQ(ctx.last_key, "new", 3);
+
+    // Flipping the bit makes the checksum fail rather than misparse
+    f = fopen(path, "r+b");
+    ASSERT_NE(f, NULL);
+    fseek(f, 8, SEEK_SET);
+    fputc(WAL_RECORD_PUT | WAL_RECORD_CRC32C, f);
+    fclose(f);
+    ASSERT_EQ(wal_recover(path, test_recover_fn, &ctx), STATUS_CORRUPTION);
+
+    unlink(path);
+}
+
+TEST(wal_write_group) {
+    const char* path = "test_wal_group.wal";
+    unlink(path);
+
+    wal_t* wal = wal_open(path, true);
+    ASSERT_NE(wal, NULL);
+
+    // One write call for all three records, recovered as separate records
+    wal_entry_t group[] = {
+        { WAL_RECORD_PUT, "key1", 4, "value1", 6 },
+        { WAL_RECORD_DELETE, "key1", 4, NULL, 0 },
+        { WAL_RECORD_PUT, "key2", 4, "value2", 6 },
+    };
+    ASSERT_EQ(wal_write_group(wal, group, 3), STATUS_OK);
+    ASSERT_EQ(wal_write_group(wal, NULL, 0), STATUS_OK);
+    wal_close(wal);
+
+    recover_ctx_t ctx = {0};
+    ASSERT_EQ(wal_recover(path, test_recover_fn, &ctx), STATUS_OK);
+    ASSERT_EQ(ctx.put_count, 2);
+    ASSERT_EQ(ctx.delete_count, 1);
+    ASSERT_STR_EQ(ctx.last_key, "key2", 4);
+    ASSERT_STR_EQ(ctx.last_val, "value2", 6);
+
+    unlink(path);
+}
+
 // ============================================================
 // Storage Persistence Tests
 // ============================================================
@@ -235,6 +322,134 @@ TEST(storage_crash_recovery) {
     remove_dir(db_path);
 }
 
+TEST(storage_write_batch) {
+    const char* db_path = "test_storage_batch";
+    remove_dir(db_path);
+
+    storage_t* db = storage_open(db_path, NULL);
+    ASSERT_NE(db, NULL);
+    ASSERT_EQ(storage_put(db, "key0", 4, "value0", 6), STATUS_OK);
+    ASSERT_EQ(storage_put(db, "key1", 4, "value1", 6), STATUS_OK);
+
+    storage_write_batch_t* batch = storage_write_batch_create();
+    ASSERT_NE(batch, NULL);
+    ASSERT_EQ(storage_write_batch_put(batch, "key2", 4, "value2", 6), STATUS_OK);
+    ASSERT_EQ(storage_write_batch_delete(batch, "key1", 4), STATUS_OK);
+    ASSERT_EQ(storage_write_batch_put(batch, "key3", 4, "value3", 6), STATUS_OK);
+    ASSERT_EQ(storage_write_batch_count(batch), 3);
+    ASSERT_EQ(storage_write(db, batch), STATUS_OK);
+
+    char* val;
+    size_t val_len;
+    ASSERT_EQ(storage_get(db, "key1", 4, &val, &val_len), STATUS_NOT_FOUND);
+    ASSERT_EQ(storage_get(db, "key3", 4, &val, &val_len), STATUS_OK);
+    ASSERT_STR_EQ(val, "value3", 6);
+    free(val);
+
+    // A second batch that is torn on disk must disappear entirely
+    storage_write_batch_clear(batch);
+    ASSERT_EQ(storage_write_batch_count(batch), 0);
+    ASSERT_EQ(storage_write_batch_put(batch, "key4", 4, "value4", 6), STATUS_OK);
+    ASSERT_EQ(storage_write_batch_delete(batch, "key0", 4), STATUS_OK);
+    ASSERT_EQ(storage_write(db, batch), STATUS_OK);
+    storage_write_batch_destroy(batch);
+    storage_close(db);
+
+    char wal_path[256];
+    snprintf(wal_path, sizeof(wal_path), "%s/wal.log", db_path);
+    struct stat st;
+    ASSERT_EQ(stat(wal_path, &st), 0);
+    ASSERT_EQ(truncate(wal_path, st.st_size - 1), 0);
+
+    db = storage_open(db_path, NULL);
+    ASSERT_NE(db, NULL);
+
+    // First batch replayed as a whole
+    ASSERT_EQ(storage_get(db, "key1", 4, &val, &val_len), STATUS_NOT_FOUND);
+    ASSERT_EQ(storage_get(db, "key2", 4, &val, &val_len), STATUS_OK);
+    ASSERT_STR_EQ(val, "value2", 6);
+    free(val);
+
+    // Torn batch: neither its put nor its delete is applied
+    ASSERT_EQ(storage_get(db, "key4", 4, &val, &val_len), STATUS_NOT_FOUND);
+    ASSERT_EQ(storage_get(db, "key0", 4, &val, &val_len), STATUS_OK);
+    ASSERT_STR_EQ(val, "value0", 6);
+    free(val);
+
+    storage_close(db);
+    remove_dir(db_path);
+}
+
+// Concurrent writer thread for storage_concurrent_sync_writes
+#define SYNC_WRITERS 8
+#define SYNC_WRITES_PER_THREAD 50
+
+typedef struct {
+    storage_t* db;
+    int id;
+    int failures;
+} writer_arg_t;
+
+static void* sync_writer(void* arg) {
+    writer_arg_t* w = arg;
+    for (int i = 0; i < SYNC_WRITES_PER_THREAD; i++) {
+        char key[32], val[32];
+        snprintf(key, sizeof(key), "t%d_key%03d", w->id, i);
+        snprintf(val, sizeof(val), "t%d_val%03d", w->id, i);
+        if (storage_put(w->db, key, strlen(key), val, strlen(val)) != STATUS_OK) {
+            w->failures++;
+        }
+    }
+    return NULL;
+}
+
+TEST(storage_concurrent_sync_writes) {
+    const char* db_path = "test_storage_group";
+    remove_dir(db_path);
+
+    storage_opts_t opts = STORAGE_OPTS_DEFAULT;
+    opts.sync_writes = true;
+    storage_t* db = storage_open(db_path, &opts);
+    ASSERT_NE(db, NULL);
+
+    // Writers queue up behind each other's fsync and get committed in groups
+    pthread_t threads[SYNC_WRITERS];
+    writer_arg_t args[SYNC_WRITERS];
+    for (int t = 0; t < SYNC_WRITERS; t++) {
+        args[t].db = db;
+        args[t].id = t;
+        args[t].failures = 0;
+        ASSERT_EQ(pthread_create(&threads[t], NULL, sync_writer, &args[t]), 0);
+    }
+    for (int t = 0; t < SYNC_WRITERS; t++) {
+        pthread_join(threads[t], NULL);
+        ASSERT_EQ(args[t].failures, 0);
+    }
+    ASSERT_EQ(storage_count(db), (size_t)(SYNC_WRITERS * SYNC_WRITES_PER_THREAD));
+    storage_close(db);
+
+    // Every acknowledged write is in the WAL
+    db = storage_open(db_path, &opts);
+    ASSERT_NE(db, NULL);
+    for (int t = 0; t < SYNC_WRITERS; t++) {
+        for (int i = 0; i < SYNC_WRITES_PER_THREAD; i++) {
+            char key[32], expected[32];
+            snprintf(key, sizeof(key), "t%d_key%03d", t, i);
+            snprintf(expected, sizeof(expected), "t%d_val%03d", t, i);
+
+            char* val;
+            size_t val_len;
+            ASSERT_EQ(storage_get(db, key, strlen(key), &val, &val_len), STATUS_OK);
+            ASSERT_EQ(val_len, strlen(expected));
+            ASSERT_STR_EQ(val, expected, val_len);
+            free(val);
+        }
+    }
+
+    storage_close(db);
+    remove_dir(db_path);
+}
+
 // ============================================================
 // Main
 // ============================================================
@@ -246,16 +461,21 @@ int main(void) {
     printf("CRC32 Tests:\n");
     RUN_TEST(crc32_basic);
     RUN_TEST(crc32_incremental);
+    RUN_TEST(crc32c_known_values);
 
     printf("\nWAL Tests:\n");
     RUN_TEST(wal_open_close);
     RUN_TEST(wal_write_put);
     RUN_TEST(wal_write_delete);
     RUN_TEST(wal_recover);
+    RUN_TEST(wal_recover_crc32_records);
+    RUN_TEST(wal_write_group);
 
     printf("\nStorage Persistence Tests:\n");
     RUN_TEST(storage_persistence);
     RUN_TEST(storage_crash_recovery);
+    RUN_TEST(storage_write_batch);
+    RUN_TEST(storage_concurrent_sync_writes);
 
     printf("\n================================================\n");
     printf("Results: %d passed, %d failed\n", tests_passed, tests_failed);
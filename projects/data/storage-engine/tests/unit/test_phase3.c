@@ -4,9 +4,13 @@
 #include <assert.h>
 #include <unistd.h>
 #include <sys/stat.h>
+#include <pthread.h>
 #include "../../src/bloom.h"
 #include "../../src/sstable.h"
 #include "../../src/storage.h"
+#include "../../src/compact.h"
+#include "../../src/cache.h"
+#include "../../src/lz4.h"
 
 static int tests_passed = 0;
 static int tests_failed = 0;
@@ -121,6 +125,54 @@ TEST(bloom_serialize) {
     bloom_destroy(bf2);
 }
 
+TEST(bloom_blocked_format) {
+    char key[32];
+    for (int format = BLOOM_FORMAT_LEGACY; format <= BLOOM_FORMAT_BLOCKED; format++) {
+        bloom_filter_t* bf = bloom_create_format(10000, (uint8_t)format);
+        ASSERT_NE(bf, NULL);
+        ASSERT_EQ(bf->format, format);
+
+        for (int i = 0; i < 10000; i++) {
+            snprintf(key, sizeof(key), "key%d", i);
+            bloom_add(bf, key, strlen(key));
+        }
+
+        // Round trip through the on-disk format
+        size_t size = bloom_serialized_size(bf);
+        uint8_t* buf = malloc(size);
+        ASSERT_NE(buf, NULL);
+        ASSERT_EQ(bloom_serialize(bf, buf, size), STATUS_OK);
+        bloom_filter_t* bf2 = bloom_deserialize(buf, size);
+        ASSERT_NE(bf2, NULL);
+        ASSERT_EQ(bf2->format, format);
+
+        // No false negatives; the SIMD probe agrees with the scalar one
+        int false_positives = 0;
+        for (int i = 0; i < 20000; i++) {
+            snprintf(key, sizeof(key), "key%d", i);
+            bool hit = bloom_may_contain(bf2, key, strlen(key));
+            ASSERT_EQ(hit, bloom_may_contain_scalar(bf2, key, strlen(key)));
+            if (i < 10000) {
+                ASSERT(hit);
+            } else if (hit) {
+                false_positives++;
+            }
+        }
+        // ~1% expected at 10 bits/key; blocking costs a little accuracy
+        ASSERT(false_positives < 300);
+
+        // Unknown blocked format versions are rejected
+        if (format == BLOOM_FORMAT_BLOCKED) {
+            buf[8] = BLOOM_BLOCKED_VERSION + 1;
+            ASSERT_EQ(bloom_deserialize(buf, size), NULL);
+        }
+
+        free(buf);
+        bloom_destroy(bf);
+        bloom_destroy(bf2);
+    }
+}
+
 // ============================================================
 // SSTable Tests
 // ============================================================
@@ -276,6 +328,534 @@ TEST(sstable_not_found) {
     unlink(path);
 }
 
+TEST(sstable_mmap_reader) {
+    const char* path = "test_sstable_mmap.sst";
+    unlink(path);
+
+    sstable_writer_t* writer = sstable_writer_create(path, 1000, NULL);
+    ASSERT_NE(writer, NULL);
+
+    char key[32], val[64];
+    for (int i = 0; i < 1000; i++) {
+        snprintf(key, sizeof(key), "key%05d", i);
+        snprintf(val, sizeof(val), "value%05d", i);
+        ASSERT_EQ(sstable_writer_add(writer, key, strlen(key), val, strlen(val), i == 7), STATUS_OK);
+    }
+    ASSERT_EQ(sstable_writer_finish(writer), STATUS_OK);
+
+    sstable_reader_t* reader = sstable_reader_open_ex(path, NULL, SSTABLE_OPEN_MMAP);
+    ASSERT_NE(reader, NULL);
+    ASSERT(sstable_reader_is_mapped(reader));
+
+    // Copying lookups behave exactly like the read() path
+    char* value;
+    size_t value_len;
+    bool deleted;
+    ASSERT_EQ(sstable_reader_get(reader, "key00500", 8, &value, &value_len, &deleted), STATUS_OK);
+    ASSERT_STR_EQ(value, "value00500", 10);
+    free(value);
+
+    // Zero-copy lookups return slices of the mapping
+    const char* ref;
+    for (int i = 0; i < 1000; i += 37) {
+        snprintf(key, sizeof(key), "key%05d", i);
+        snprintf(val, sizeof(val), "value%05d", i);
+        ASSERT_EQ(sstable_reader_get_ref(reader, key, strlen(key), &ref, &value_len, &deleted), STATUS_OK);
+        ASSERT_EQ(deleted, false);
+        ASSERT_EQ(value_len, strlen(val));
+        ASSERT_STR_EQ(ref, val, value_len);
+        ASSERT((const uint8_t*)ref >= reader->map &&
+               (const uint8_t*)ref + value_len <= reader->map + reader->map_size);
+    }
+
+    ASSERT_EQ(sstable_reader_get_ref(reader, "key00007", 8, &ref, &value_len, &deleted), STATUS_OK);
+    ASSERT_EQ(deleted, true);
+    ASSERT_EQ(sstable_reader_get_ref(reader, "key99999", 8, &ref, &value_len, &deleted), STATUS_NOT_FOUND);
+
+    sstable_reader_close(reader);
+
+    // Unmapped readers refuse zero-copy lookups
+    reader = sstable_reader_open(path, NULL);
+    ASSERT_NE(reader, NULL);
+    ASSERT_EQ(sstable_reader_get_ref(reader, "key00500", 8, &ref, &value_len, &deleted), STATUS_INVALID_ARG);
+    sstable_reader_close(reader);
+
+    // A damaged data block is still caught by its CRC
+    FILE* f = fopen(path, "r+b");
+    ASSERT_NE(f, NULL);
+    fseek(f, 10, SEEK_SET);
+    fputc('X', f);
+    fclose(f);
+
+    reader = sstable_reader_open_ex(path, NULL, SSTABLE_OPEN_MMAP);
+    ASSERT_NE(reader, NULL);
+    ASSERT_EQ(sstable_reader_get_ref(reader, "key00000", 8, &ref, &value_len, &deleted), STATUS_CORRUPTION);
+    sstable_reader_close(reader);
+
+    unlink(path);
+}
+
+// Helper: reverse bytewise order (a comparator the hash index can't serve)
+static int reverse_compare(const char* a, size_t a_len, const char* b, size_t b_len) {
+    return default_compare(b, b_len, a, a_len);
+}
+
+TEST(sstable_block_hash_index) {
+    const char* path = "test_sstable_hash.sst";
+
+    for (int mode = 0; mode < 3; mode++) {
+        unlink(path);
+        compare_fn cmp = (mode == 2) ? reverse_compare : NULL;
+
+        sstable_writer_t* writer = sstable_writer_create(path, 1000, cmp);
+        ASSERT_NE(writer, NULL);
+        if (mode == 1) sstable_writer_set_hash_index(writer, false);
+
+        // Even keys only, so odd keys fall inside blocks but are absent
+        char key[32], val[32];
+        for (int j = 0; j < 1000; j++) {
+            int i = (mode == 2) ? 999 - j : j;
+            snprintf(key, sizeof(key), "key%05d", i * 2);
+            snprintf(val, sizeof(val), "value%05d", i * 2);
+            ASSERT_EQ(sstable_writer_add(writer, key, strlen(key), val, strlen(val), false), STATUS_OK);
+        }
+        ASSERT_EQ(sstable_writer_finish(writer), STATUS_OK);
+
+        sstable_reader_t* reader = sstable_reader_open(path, cmp);
+        ASSERT_NE(reader, NULL);
+        ASSERT(reader->index_count > 1);
+
+        // Only the default comparator with the index enabled gets buckets
+        sstable_block_t block;
+        sstable_block_layout_t layout;
+        ASSERT_EQ(sstable_reader_read_block(reader, 0, &block), STATUS_OK);
+        ASSERT_EQ(sstable_block_layout(block.data, block.size, &layout), STATUS_OK);
+        ASSERT_EQ(layout.buckets != NULL, mode == 0);
+        ASSERT(layout.num_restarts > 1);
+        sstable_block_release(&block);
+
+        char* value;
+        size_t value_len;
+        bool deleted;
+        for (int i = 0; i < 2000; i++) {
+            snprintf(key, sizeof(key), "key%05d", i);
+            status_t status = sstable_reader_get(reader, key, strlen(key), &value, &value_len, &deleted);
+            if (i % 2 == 0) {
+                snprintf(val, sizeof(val), "value%05d", i);
+                ASSERT_EQ(status, STATUS_OK);
+                ASSERT_EQ(value_len, strlen(val));
+                ASSERT_STR_EQ(value, val, value_len);
+                free(value);
+            } else {
+                ASSERT_EQ(status, STATUS_NOT_FOUND);
+            }
+        }
+
+        sstable_reader_close(reader);
+    }
+
+    unlink(path);
+}
+
+// Helper: key i is 200 + 5 * i bytes of 'p' ending in a 6-digit counter
+static size_t long_key(char* key, int i) {
+    size_t len = 200 + (size_t)i * 5;
+    char digits[16];
+    snprintf(digits, sizeof(digits), "%06d", i);
+    memset(key, 'p', len - 6);
+    memcpy(key + len - 6, digits, 6);
+    return len;
+}
+
+TEST(sstable_long_keys) {
+    const char* path = "test_sstable_long.sst";
+    unlink(path);
+
+    // Keys longer than the scan's stack buffer, sharing long prefixes
+    char key[1200];
+    char val[16];
+    sstable_writer_t* writer = sstable_writer_create(path, 200, NULL);
+    ASSERT_NE(writer, NULL);
+    for (int i = 0; i < 200; i++) {
+        size_t len = long_key(key, i);
+        snprintf(val, sizeof(val), "v%d", i);
+        ASSERT_EQ(sstable_writer_add(writer, key, len, val, strlen(val), false), STATUS_OK);
+    }
+    ASSERT_EQ(sstable_writer_finish(writer), STATUS_OK);
+
+    sstable_reader_t* reader = sstable_reader_open(path, NULL);
+    ASSERT_NE(reader, NULL);
+
+    for (int i = 0; i < 200; i++) {
+        size_t len = long_key(key, i);
+        snprintf(val, sizeof(val), "v%d", i);
+
+        char* value;
+        size_t value_len;
+        bool deleted;
+        ASSERT_EQ(sstable_reader_get(reader, key, len, &value, &value_len, &deleted), STATUS_OK);
+        ASSERT_EQ(value_len, strlen(val));
+        ASSERT_STR_EQ(value, val, value_len);
+        free(value);
+    }
+
+    // The iterator rebuilds the same keys in its reused buffer
+    sstable_iter_t* it = sstable_iter_create(reader);
+    ASSERT_NE(it, NULL);
+    int n = 0;
+    for (sstable_iter_seek_to_first(it); sstable_iter_valid(it); sstable_iter_next(it), n++) {
+        size_t len = long_key(key, n);
+        size_t key_len;
+        const char* k = sstable_iter_key(it, &key_len);
+        ASSERT_EQ(key_len, len);
+        ASSERT(memcmp(k, key, len) == 0);
+    }
+    ASSERT_EQ(n, 200);
+    sstable_iter_destroy(it);
+
+    sstable_reader_close(reader);
+    unlink(path);
+}
+
+// Concurrent reader test threads
+#define SHARED_READER_KEYS 2000
+
+typedef struct {
+    sstable_reader_t* reader;
+    unsigned seed;
+    int errors;
+} shared_reader_arg_t;
+
+static void* shared_reader_thread(void* p) {
+    shared_reader_arg_t* arg = p;
+    char key[32], expected[32];
+    for (int i = 0; i < 5000; i++) {
+        int k = (int)(rand_r(&arg->seed) % SHARED_READER_KEYS);
+        snprintf(key, sizeof(key), "key%05d", k);
+        snprintf(expected, sizeof(expected), "value%05d", k);
+
+        char* value = NULL;
+        size_t value_len;
+        bool deleted;
+        if (sstable_reader_get(arg->reader, key, strlen(key), &value, &value_len, &deleted) != STATUS_OK ||
+            value_len != strlen(expected) || memcmp(value, expected, value_len) != 0) {
+            arg->errors++;
+        }
+        free(value);
+    }
+    return NULL;
+}
+
+TEST(sstable_shared_reader) {
+    const char* path = "test_sstable_shared.sst";
+    unlink(path);
+
+    sstable_writer_t* writer = sstable_writer_create(path, SHARED_READER_KEYS, NULL);
+    ASSERT_NE(writer, NULL);
+
+    char key[32], val[32];
+    for (int i = 0; i < SHARED_READER_KEYS; i++) {
+        snprintf(key, sizeof(key), "key%05d", i);
+        snprintf(val, sizeof(val), "value%05d", i);
+        ASSERT_EQ(sstable_writer_add(writer, key, strlen(key), val, strlen(val), false), STATUS_OK);
+    }
+    ASSERT_EQ(sstable_writer_finish(writer), STATUS_OK);
+
+    // No block cache: every lookup goes to the file through the shared fd
+    sstable_reader_t* reader = sstable_reader_open(path, NULL);
+    ASSERT_NE(reader, NULL);
+
+    pthread_t threads[4];
+    shared_reader_arg_t args[4];
+    for (int t = 0; t < 4; t++) {
+        args[t].reader = reader;
+        args[t].seed = (unsigned)t + 1;
+        args[t].errors = 0;
+        ASSERT_EQ(pthread_create(&threads[t], NULL, shared_reader_thread, &args[t]), 0);
+    }
+    for (int t = 0; t < 4; t++) {
+        pthread_join(threads[t], NULL);
+        ASSERT_EQ(args[t].errors, 0);
+    }
+
+    sstable_reader_close(reader);
+    unlink(path);
+}
+
+#define PARTITIONED_KEYS 50000
+
+// Helper: check lookups, misses, a full scan and seeks on a partitioned table
+static bool check_partitioned(sstable_reader_t* reader) {
+    char key[32], val[32];
+    char* value;
+    size_t value_len;
+    bool deleted;
+    for (int i = 0; i < PARTITIONED_KEYS; i += 997) {
+        snprintf(key, sizeof(key), "key%06d", i);
+        snprintf(val, sizeof(val), "value%06d", i);
+        if (sstable_reader_get(reader, key, strlen(key), &value, &value_len, &deleted) != STATUS_OK) return false;
+        bool match = value_len == strlen(val) && memcmp(value, val, value_len) == 0;
+        free(value);
+        if (!match) return false;
+    }
+    if (sstable_reader_get(reader, "key0000005", 10, &value, &value_len, &deleted) != STATUS_NOT_FOUND) return false;
+    if (sstable_reader_get(reader, "zzz", 3, &value, &value_len, &deleted) != STATUS_NOT_FOUND) return false;
+
+    sstable_iter_t* it = sstable_iter_create(reader);
+    if (!it) return false;
+    int count = 0;
+    for (sstable_iter_seek_to_first(it); sstable_iter_valid(it); sstable_iter_next(it)) count++;
+
+    size_t key_len;
+    sstable_iter_seek(it, "key031415x", 10);
+    const char* found = sstable_iter_valid(it) ? sstable_iter_key(it, &key_len) : NULL;
+    bool seek_ok = found && key_len == 9 && memcmp(found, "key031416", 9) == 0;
+    sstable_iter_seek(it, "zzz", 3);
+    seek_ok = seek_ok && !sstable_iter_valid(it);
+    sstable_iter_destroy(it);
+
+    return count == PARTITIONED_KEYS && seek_ok;
+}
+
+TEST(sstable_partitioned) {
+    const char* flat_path = "test_sstable_flat.sst";
+    const char* path = "test_sstable_partitioned.sst";
+    unlink(flat_path);
+    unlink(path);
+
+    // Same contents, flat and partitioned layouts
+    for (int partitioned = 0; partitioned < 2; partitioned++) {
+        sstable_writer_t* writer = sstable_writer_create(partitioned ? path : flat_path,
+                                                         PARTITIONED_KEYS, NULL);
+        ASSERT_NE(writer, NULL);
+        ASSERT_EQ(sstable_writer_set_partitioned(writer, partitioned), STATUS_OK);
+
+        char key[32], val[32];
+        for (int i = 0; i < PARTITIONED_KEYS; i++) {
+            snprintf(key, sizeof(key), "key%06d", i);
+            snprintf(val, sizeof(val), "value%06d", i);
+            ASSERT_EQ(sstable_writer_add(writer, key, strlen(key), val, strlen(val), false), STATUS_OK);
+        }
+        ASSERT_EQ(sstable_writer_set_partitioned(writer, partitioned), STATUS_INVALID_ARG);
+        ASSERT_EQ(sstable_writer_finish(writer), STATUS_OK);
+    }
+
+    sstable_reader_t* flat = sstable_reader_open(flat_path, NULL);
+    ASSERT_NE(flat, NULL);
+    ASSERT(!sstable_reader_is_partitioned(flat));
+
+    // pread, no cache: partitions are re-read on every use
+    sstable_reader_t* reader = sstable_reader_open(path, NULL);
+    ASSERT_NE(reader, NULL);
+    ASSERT(sstable_reader_is_partitioned(reader));
+    ASSERT(reader->part_count > 1);
+    ASSERT(check_partitioned(reader));
+
+    // Only the top-level index is resident
+    ASSERT(sstable_reader_resident_bytes(reader) * 10 < sstable_reader_resident_bytes(flat));
+    sstable_reader_close(flat);
+
+    // pread with a block cache: partitions are cached like data blocks
+    block_cache_t* cache = cache_create(4 * 1024 * 1024);
+    ASSERT_NE(cache, NULL);
+    sstable_reader_set_cache(reader, cache, 1);
+    ASSERT(check_partitioned(reader));
+    ASSERT(check_partitioned(reader));
+    sstable_reader_close(reader);
+    cache_destroy(cache);
+
+    // Mapped
+    reader = sstable_reader_open_ex(path, NULL, SSTABLE_OPEN_MMAP);
+    ASSERT_NE(reader, NULL);
+    ASSERT(check_partitioned(reader));
+    sstable_reader_close(reader);
+
+    unlink(flat_path);
+    unlink(path);
+}
+
+#define COMPRESSION_KEYS 5000
+
+// Helper: JSON-like value, compressible the way real documents are
+static size_t json_value(char* buf, size_t cap, int i) {
+    return (size_t)snprintf(buf, cap,
+                            "{\"id\":%d,\"name\":\"user%d\",\"email\":\"user%d@example.com\","
+                            "\"active\":true,\"tags\":[\"alpha\",\"beta\"]}", i, i, i);
+}
+
+// Helper: write COMPRESSION_KEYS entries with the given codec; returns file size
+static long write_compressed_table(const char* path, compression_t compression, bool random) {
+    sstable_writer_t* writer = sstable_writer_create(path, COMPRESSION_KEYS, NULL);
+    if (!writer || sstable_writer_set_compression(writer, compression) != STATUS_OK) return -1;
+
+    char key[32], val[128];
+    unsigned seed = 7;
+    for (int i = 0; i < COMPRESSION_KEYS; i++) {
+        snprintf(key, sizeof(key), "key%06d", i);
+        size_t len = json_value(val, sizeof(val), i);
+        if (random) {
+            for (size_t j = 0; j < len; j++) val[j] = (char)rand_r(&seed);
+        }
+        if (sstable_writer_add(writer, key, strlen(key), val, len, false) != STATUS_OK) {
+            sstable_writer_abort(writer);
+            return -1;
+        }
+    }
+    if (sstable_writer_finish(writer) != STATUS_OK) return -1;
+
+    struct stat st;
+    return stat(path, &st) == 0 ? (long)st.st_size : -1;
+}
+
+TEST(sstable_compression) {
+    const char* raw_path = "test_sstable_raw.sst";
+    const char* path = "test_sstable_lz4.sst";
+
+    // Codec round trip, and a damaged stream is rejected rather than overrun
+    char src[256], dst[256];
+    uint8_t packed[512];
+    size_t src_len = json_value(src, sizeof(src), 42);
+    size_t packed_len = lz4_compress((const uint8_t*)src, src_len, packed, sizeof(packed));
+    ASSERT(packed_len > 0 && packed_len < src_len);
+    ASSERT_EQ(lz4_decompress(packed, packed_len, (uint8_t*)dst, src_len), STATUS_OK);
+    ASSERT(memcmp(src, dst, src_len) == 0);
+    ASSERT_EQ(lz4_decompress(packed, packed_len, (uint8_t*)dst, src_len - 1), STATUS_CORRUPTION);
+    ASSERT_EQ(lz4_decompress(packed, packed_len - 3, (uint8_t*)dst, src_len), STATUS_CORRUPTION);
+
+    long raw_size = write_compressed_table(raw_path, COMPRESSION_NONE, false);
+    long lz4_size = write_compressed_table(path, COMPRESSION_LZ4, false);
+    ASSERT(raw_size > 0 && lz4_size > 0);
+    ASSERT(lz4_size * 2 < raw_size);
+
+    // Lookups and scans see the original bytes on every read path
+    block_cache_t* cache = cache_create(1024 * 1024);
+    ASSERT_NE(cache, NULL);
+    for (int mode = 0; mode < 3; mode++) {
+        sstable_reader_t* reader = sstable_reader_open_ex(path, NULL,
+                                                          mode == 2 ? SSTABLE_OPEN_MMAP : 0);
+        ASSERT_NE(reader, NULL);
+        if (mode == 1) sstable_reader_set_cache(reader, cache, 1);
+
+        char key[32], val[128];
+        char* value;
+        size_t value_len;
+        bool deleted;
+        for (int i = 0; i < COMPRESSION_KEYS; i += 101) {
+            snprintf(key, sizeof(key), "key%06d", i);
+            size_t len = json_value(val, sizeof(val), i);
+            ASSERT_EQ(sstable_reader_get(reader, key, strlen(key), &value, &value_len, &deleted), STATUS_OK);
+            ASSERT_EQ(value_len, len);
+            ASSERT(memcmp(value, val, len) == 0);
+            free(value);
+        }
+
+        sstable_iter_t* it = sstable_iter_create(reader);
+        ASSERT_NE(it, NULL);
+        int count = 0;
+        for (sstable_iter_seek_to_first(it); sstable_iter_valid(it); sstable_iter_next(it)) count++;
+        sstable_iter_destroy(it);
+        ASSERT_EQ(count, COMPRESSION_KEYS);
+
+        // Decompressed blocks are not slices of the mapping
+        if (mode == 2) {
+            const char* ref;
+            ASSERT_EQ(sstable_reader_get_ref(reader, "key000000", 9, &ref, &value_len, &deleted),
+                      STATUS_INVALID_ARG);
+        }
+        sstable_reader_close(reader);
+    }
+    cache_destroy(cache);
+
+    // Incompressible blocks fall back to raw
+    ASSERT(write_compressed_table(path, COMPRESSION_LZ4, true) > 0);
+    sstable_reader_t* reader = sstable_reader_open(path, NULL);
+    ASSERT_NE(reader, NULL);
+    ASSERT_EQ(reader->footer.flags & SSTABLE_FLAG_COMPRESSED, 0);
+    sstable_reader_close(reader);
+
+    unlink(raw_path);
+    unlink(path);
+}
+
+#define PREFIX_USERS 2000
+#define PREFIX_ITEMS 25
+
+// Helper: "user00042" is the prefix of "user00042:007"
+static size_t user_prefix(const char* key, size_t key_len) {
+    (void)key;
+    return key_len < 9 ? key_len : 9;
+}
+
+// Helper: count the absent users the prefix filter lets through (-1 if
+// a present one is ruled out)
+static int prefix_false_positives(sstable_reader_t* reader) {
+    char key[32];
+    int false_positives = 0;
+    for (int u = 0; u < 2 * PREFIX_USERS; u++) {
+        snprintf(key, sizeof(key), "user%05d:%03d", u, u % PREFIX_ITEMS);
+        bool may_match = sstable_reader_prefix_may_match(reader, key, strlen(key));
+        if (u % 2 == 0 && !may_match) return -1;
+        if (u % 2 == 1 && may_match) false_positives++;
+    }
+    return false_positives;
+}
+
+TEST(sstable_prefix_filter) {
+    const char* path = "test_sstable_prefix.sst";
+
+    // Even users only; flat and partitioned filters
+    for (int partitioned = 0; partitioned < 2; partitioned++) {
+        unlink(path);
+        sstable_writer_t* writer = sstable_writer_create(path, PREFIX_USERS * PREFIX_ITEMS, NULL);
+        ASSERT_NE(writer, NULL);
+        ASSERT_EQ(sstable_writer_set_partitioned(writer, partitioned), STATUS_OK);
+        ASSERT_EQ(sstable_writer_set_prefix_extractor(writer, user_prefix, "user9"), STATUS_OK);
+
+        char key[32];
+        for (int u = 0; u < 2 * PREFIX_USERS; u += 2) {
+            for (int i = 0; i < PREFIX_ITEMS; i++) {
+                snprintf(key, sizeof(key), "user%05d:%03d", u, i);
+                ASSERT_EQ(sstable_writer_add(writer, key, strlen(key), "v", 1, false), STATUS_OK);
+            }
+        }
+        ASSERT_EQ(sstable_writer_finish(writer), STATUS_OK);
+
+        sstable_reader_t* reader = sstable_reader_open(path, NULL);
+        ASSERT_NE(reader, NULL);
+        ASSERT(reader->footer.flags & SSTABLE_FLAG_PREFIX);
+        ASSERT_EQ(sstable_reader_is_partitioned(reader), partitioned);
+        ASSERT(!partitioned || reader->part_count > 1);
+
+        ASSERT(reader->footer.flags & SSTABLE_FLAG_PREFIX_NAME);
+        ASSERT_NE(sstable_reader_prefix_name(reader), NULL);
+        ASSERT_STR_EQ(sstable_reader_prefix_name(reader), "user9", 6);
+
+        // Without the extractor, or under another name, the filters are not
+        // consulted
+        ASSERT(sstable_reader_prefix_may_match(reader, "user00001:000", 13));
+        sstable_reader_set_prefix_extractor(reader, user_prefix, "user8");
+        ASSERT(sstable_reader_prefix_may_match(reader, "user00001:000", 13));
+        sstable_reader_set_prefix_extractor(reader, user_prefix, NULL);
+        ASSERT(sstable_reader_prefix_may_match(reader, "user00001:000", 13));
+
+        sstable_reader_set_prefix_extractor(reader, user_prefix, "user9");
+        int false_positives = prefix_false_positives(reader);
+        ASSERT(false_positives >= 0 && false_positives < PREFIX_USERS / 20);
+
+        // Full keys still go through the filters for point lookups
+        char* value;
+        size_t value_len;
+        bool deleted;
+        ASSERT_EQ(sstable_reader_get(reader, "user00042:007", 13, &value, &value_len, &deleted), STATUS_OK);
+        free(value);
+        ASSERT_EQ(sstable_reader_get(reader, "user00042:099", 13, &value, &value_len, &deleted),
+                  STATUS_NOT_FOUND);
+        sstable_reader_close(reader);
+    }
+
+    unlink(path);
+}
+
 // ============================================================
 // Storage Integration Tests
 // ============================================================
@@ -387,6 +967,84 @@ TEST(storage_multiple_flushes) {
     remove_dir(db_path);
 }
 
+TEST(storage_mmap_reads) {
+    const char* db_path = "test_storage_mmap";
+    remove_dir(db_path);
+
+    storage_opts_t opts = STORAGE_OPTS_DEFAULT;
+    opts.use_mmap_reads = true;
+
+    storage_t* db = storage_open(db_path, &opts);
+    ASSERT_NE(db, NULL);
+
+    ASSERT_EQ(storage_put(db, "key1", 4, "value1", 6), STATUS_OK);
+    ASSERT_EQ(storage_put(db, "key2", 4, "value2", 6), STATUS_OK);
+    ASSERT_EQ(storage_flush(db), STATUS_OK);
+    ASSERT_EQ(storage_delete(db, "key1", 4), STATUS_OK);
+    ASSERT_EQ(storage_flush(db), STATUS_OK);
+
+    storage_close(db);
+
+    // Reopen: SSTables recovered from the MANIFEST are mapped as well
+    db = storage_open(db_path, &opts);
+    ASSERT_NE(db, NULL);
+
+    char* val;
+    size_t val_len;
+    ASSERT_EQ(storage_get(db, "key1", 4, &val, &val_len), STATUS_NOT_FOUND);
+    ASSERT_EQ(storage_get(db, "key2", 4, &val, &val_len), STATUS_OK);
+    ASSERT_STR_EQ(val, "value2", 6);
+    free(val);
+
+    level_lock_shared(db->levels);
+    ASSERT(db->levels->levels[0].file_count > 0);
+    ASSERT(sstable_reader_is_mapped(db->levels->levels[0].files[0].reader));
+    level_unlock(db->levels);
+
+    storage_close(db);
+    remove_dir(db_path);
+}
+
+TEST(storage_compression) {
+    const char* db_path = "test_storage_lz4";
+    remove_dir(db_path);
+
+    storage_opts_t opts = STORAGE_OPTS_DEFAULT;
+    opts.compression = COMPRESSION_LZ4;
+
+    storage_t* db = storage_open(db_path, &opts);
+    ASSERT_NE(db, NULL);
+
+    char key[32], val[128];
+    for (int i = 0; i < 500; i++) {
+        snprintf(key, sizeof(key), "key%05d", i);
+        size_t len = json_value(val, sizeof(val), i);
+        ASSERT_EQ(storage_put(db, key, strlen(key), val, len), STATUS_OK);
+    }
+    ASSERT_EQ(storage_flush(db), STATUS_OK);
+    storage_close(db);
+
+    // Reopen with default options: compressed tables remain readable
+    db = storage_open(db_path, NULL);
+    ASSERT_NE(db, NULL);
+
+    char* value;
+    size_t value_len;
+    size_t len = json_value(val, sizeof(val), 123);
+    ASSERT_EQ(storage_get(db, "key00123", 8, &value, &value_len), STATUS_OK);
+    ASSERT_EQ(value_len, len);
+    ASSERT(memcmp(value, val, len) == 0);
+    free(value);
+
+    level_lock_shared(db->levels);
+    ASSERT(db->levels->levels[0].file_count > 0);
+    ASSERT(db->levels->levels[0].files[0].reader->footer.flags & SSTABLE_FLAG_COMPRESSED);
+    level_unlock(db->levels);
+
+    storage_close(db);
+    remove_dir(db_path);
+}
+
 // ============================================================
 // Main
 // ============================================================
@@ -399,17 +1057,27 @@ int main(void) {
     RUN_TEST(bloom_basic);
     RUN_TEST(bloom_false_positive);
     RUN_TEST(bloom_serialize);
+    RUN_TEST(bloom_blocked_format);
 
     printf("\nSSTable Tests:\n");
     RUN_TEST(sstable_write_read);
     RUN_TEST(sstable_many_entries);
     RUN_TEST(sstable_tombstones);
     RUN_TEST(sstable_not_found);
+    RUN_TEST(sstable_mmap_reader);
+    RUN_TEST(sstable_block_hash_index);
+    RUN_TEST(sstable_long_keys);
+    RUN_TEST(sstable_shared_reader);
+    RUN_TEST(sstable_partitioned);
+    RUN_TEST(sstable_compression);
+    RUN_TEST(sstable_prefix_filter);
 
     printf("\nStorage Integration Tests:\n");
     RUN_TEST(storage_flush);
     RUN_TEST(storage_query_after_flush);
     RUN_TEST(storage_multiple_flushes);
+    RUN_TEST(storage_mmap_reads);
+    RUN_TEST(storage_compression);
 
     printf("\n====================================================\n");
     printf("Results: %d passed, %d failed\n", tests_passed, tests_failed);
@@ -108,7 +108,7 @@ static int test_level_basic(void) {
         return 0;
     }
 
-    if (strcmp(value, "value0050") != 0) {
+    if (value_len != 9 || memcmp(value, "value0050", 9) != 0) {
         free(value);
         level_manager_destroy(lm);
         return 0;
@@ -164,7 +164,7 @@ static int test_level_l0_overlap(void) {
     }
 
     // key0075 exists in both files, should get from newer (r2)
-    if (strcmp(value, "value0075") != 0) {
+    if (value_len != 9 || memcmp(value, "value0075", 9) != 0) {
         free(value);
         level_manager_destroy(lm);
         return 0;
@@ -476,7 +476,7 @@ static int test_storage_with_levels(void) {
         return 0;
     }
 
-    if (strcmp(value, "value0050") != 0) {
+    if (value_len != 9 || memcmp(value, "value0050", 9) != 0) {
         free(value);
         storage_close(db);
         return 0;
@@ -535,6 +535,1202 @@ static int test_manifest_recovery(void) {
     return 1;
 }
 
+// ============================================================
+// Test: Manifest edits apply all or none
+// ============================================================
+static int test_manifest_edit(void) {
+    remove_dir(TEST_DIR);
+    mkdir(TEST_DIR, 0755);
+    manifest_create(TEST_DIR);
+
+    char path[256];
+    snprintf(path, sizeof(path), "%s/000001.sst", TEST_DIR);
+    sstable_reader_t* reader = create_test_sstable(path, "key", 0, 50);
+    if (!reader) return 0;
+    sstable_reader_close(reader);
+
+    // Add to L0, then move to L1 in one edit
+    manifest_log_add_file(TEST_DIR, 0, 1);
+    manifest_edit_t edit = {0};
+    manifest_edit_add_file(&edit, 1, 1);
+    manifest_edit_remove_file(&edit, 0, 1);
+    manifest_edit_next_file_num(&edit, 2);
+    int ok = manifest_log_edit(TEST_DIR, &edit) == STATUS_OK;
+    manifest_edit_free(&edit);
+
+    // A second move whose record is torn by a crash
+    manifest_edit_add_file(&edit, 2, 1);
+    manifest_edit_remove_file(&edit, 1, 1);
+    manifest_edit_next_file_num(&edit, 3);
+    ok = ok && manifest_log_edit(TEST_DIR, &edit) == STATUS_OK;
+    manifest_edit_free(&edit);
+
+    char manifest[256];
+    snprintf(manifest, sizeof(manifest), "%s/MANIFEST", TEST_DIR);
+    struct stat st;
+    ok = ok && stat(manifest, &st) == 0 && truncate(manifest, st.st_size - 10) == 0;
+
+    level_manager_t* lm = level_manager_create(TEST_DIR, NULL);
+    if (!lm) return 0;
+    ok = ok && manifest_recover(TEST_DIR, lm) == STATUS_OK &&
+         level_file_count(lm, 0) == 0 && level_file_count(lm, 1) == 1 &&
+         level_file_count(lm, 2) == 0 && level_next_file_number(lm) == 2;
+
+    level_manager_destroy(lm);
+    remove_dir(TEST_DIR);
+    return ok;
+}
+
+// ============================================================
+// Test: Storage iterator merges memtable and all levels
+// ============================================================
+static int test_storage_iter_merged(void) {
+    remove_dir(TEST_DIR);
+
+    storage_t* db = storage_open(TEST_DIR, NULL);
+    if (!db) return 0;
+
+    // 8 flushes of the same keys: the first 4 compact into L1, the next 4
+    // are merged with L1 again, so newer L0 values must win over L1
+    char key[32], value[32];
+    for (int round = 0; round < 8; round++) {
+        for (int i = 0; i < 50; i++) {
+            snprintf(key, sizeof(key), "key%04d", i);
+            snprintf(value, sizeof(value), "round%d_%04d", round, i);
+            storage_put(db, key, strlen(key), value, strlen(value));
+        }
+        if (storage_flush(db) != STATUS_OK) {
+            storage_close(db);
+            return 0;
+        }
+    }
+    if (storage_compact(db) != STATUS_OK ||
+        level_file_count(db->levels, 1) == 0) {
+        storage_close(db);
+        return 0;
+    }
+
+    // Memtable-only changes on top of flushed data
+    storage_delete(db, "key0010", 7);
+    storage_put(db, "key0020", 7, "mem", 3);
+    storage_put(db, "key0050", 7, "new", 3);
+
+    int ok = 1;
+    char* got = NULL;
+    size_t got_len = 0;
+    if (storage_get(db, "key0005", 7, &got, &got_len) != STATUS_OK ||
+        got_len != 11 || memcmp(got, "round7_0005", 11) != 0) {
+        ok = 0;
+    }
+    free(got);
+
+    // Full scan: sorted, deduplicated, tombstone hidden
+    storage_iter_t* iter = storage_iter_create(db);
+    if (!iter) {
+        storage_close(db);
+        return 0;
+    }
+
+    int count = 0;
+    char prev[32] = "";
+    storage_iter_seek_to_first(iter);
+    while (storage_iter_valid(iter)) {
+        size_t klen, vlen;
+        const char* k = storage_iter_key(iter, &klen);
+        const char* v = storage_iter_value(iter, &vlen);
+        char cur[32];
+        snprintf(cur, sizeof(cur), "%.*s", (int)klen, k);
+
+        if (count > 0 && strcmp(prev, cur) >= 0) ok = 0;
+        if (strcmp(cur, "key0010") == 0) ok = 0;
+        if (strcmp(cur, "key0020") == 0 && (vlen != 3 || memcmp(v, "mem", 3) != 0)) ok = 0;
+        if (strcmp(cur, "key0030") == 0 &&
+            (vlen != 11 || memcmp(v, "round7_0030", 11) != 0)) ok = 0;
+
+        strcpy(prev, cur);
+        count++;
+        storage_iter_next(iter);
+    }
+    if (count != 50) ok = 0;
+
+    // Seek lands on the first key >= target across sources
+    storage_iter_seek(iter, "key0009z", 8);
+    size_t klen;
+    const char* k = storage_iter_valid(iter) ? storage_iter_key(iter, &klen) : NULL;
+    if (!k || klen != 7 || memcmp(k, "key0011", 7) != 0) ok = 0;
+
+    storage_iter_destroy(iter);
+    storage_close(db);
+    remove_dir(TEST_DIR);
+    return ok;
+}
+
+// ============================================================
+// Test: Background flush and compaction
+// ============================================================
+
+// Helper: check key%05d values after the background test's writes
+static int check_background_keys(storage_t* db, int n) {
+    for (int i = 0; i < n; i++) {
+        char key[32], expected[64];
+        snprintf(key, sizeof(key), "key%05d", i);
+        snprintf(expected, sizeof(expected), "value%05d_padding_padding", i);
+
+        char* value = NULL;
+        size_t value_len = 0;
+        status_t status = storage_get(db, key, strlen(key), &value, &value_len);
+        if (i == 100) {
+            // Deleted after it was flushed: the tombstone must win
+            free(value);
+            if (status != STATUS_NOT_FOUND) return 0;
+            continue;
+        }
+        int ok = status == STATUS_OK && value_len == strlen(expected) &&
+                 memcmp(value, expected, value_len) == 0;
+        free(value);
+        if (!ok) return 0;
+    }
+    return 1;
+}
+
+static int test_storage_background_flush(void) {
+    remove_dir(TEST_DIR);
+
+    // Small memtable so plain puts keep switching memtables
+    storage_opts_t opts = STORAGE_OPTS_DEFAULT;
+    opts.memtable_size = 16 * 1024;
+
+    storage_t* db = storage_open(TEST_DIR, &opts);
+    if (!db) return 0;
+
+    const int n = 4000;
+    for (int i = 0; i < n; i++) {
+        char key[32], value[64];
+        snprintf(key, sizeof(key), "key%05d", i);
+        snprintf(value, sizeof(value), "value%05d_padding_padding", i);
+        if (storage_put(db, key, strlen(key), value, strlen(value)) != STATUS_OK) {
+            storage_close(db);
+            return 0;
+        }
+    }
+    storage_delete(db, "key00100", 8);
+
+    // Reads are correct while the worker is still busy
+    if (!check_background_keys(db, n)) {
+        storage_close(db);
+        return 0;
+    }
+
+    // Puts alone must have produced SSTables, and compaction drains L0
+    if (storage_compact(db) != STATUS_OK ||
+        level_file_count(db->levels, 1) == 0 ||
+        level_file_count(db->levels, 0) >= L0_COMPACTION_TRIGGER) {
+        storage_close(db);
+        return 0;
+    }
+    storage_close(db);
+
+    // Compaction results and the unflushed tail survive a reopen
+    db = storage_open(TEST_DIR, &opts);
+    if (!db) return 0;
+    int ok = check_background_keys(db, n);
+    storage_close(db);
+
+    remove_dir(TEST_DIR);
+    return ok;
+}
+
+// ============================================================
+// Test: Subcompactions split a large compaction into key ranges
+// ============================================================
+
+// Helper: one version of keys 0..n-1 (round 0 goes to L1), logged to the
+// manifest; the last round deletes every tenth key
+static int add_round_sstable(level_manager_t* lm, int level, uint64_t file_num,
+                             int round, int n, bool deletes) {
+    char path[256], key[32], value[128];
+    snprintf(path, sizeof(path), "%s/%06llu.sst", TEST_DIR, (unsigned long long)file_num);
+    sstable_writer_t* writer = sstable_writer_create(path, n, NULL);
+    if (!writer) return 0;
+    for (int i = 0; i < n; i++) {
+        snprintf(key, sizeof(key), "key%06d", i);
+        snprintf(value, sizeof(value), "round%d_%06d_%080d", round, i, 0);
+        bool deleted = deletes && i % 10 == 0;
+        sstable_writer_add(writer, key, strlen(key), value, deleted ? 0 : strlen(value), deleted);
+    }
+    if (sstable_writer_finish(writer) != STATUS_OK) return 0;
+
+    sstable_reader_t* reader = sstable_reader_open(path, NULL);
+    if (!reader) return 0;
+    if (level_add_sstable(lm, level, file_num, path, reader) != STATUS_OK) {
+        sstable_reader_close(reader);
+        return 0;
+    }
+    return manifest_log_add_file(TEST_DIR, level, file_num) == STATUS_OK &&
+           manifest_log_next_file_num(TEST_DIR, file_num + 1) == STATUS_OK;
+}
+
+// Helper: L1 files sorted, disjoint, and every key at its newest version
+static int check_compacted_l1(level_manager_t* lm, int n) {
+    level_t* l1 = &lm->levels[1];
+    for (size_t i = 1; i < l1->file_count; i++) {
+        if (lm->cmp(l1->files[i - 1].max_key, l1->files[i - 1].max_key_len,
+                    l1->files[i].min_key, l1->files[i].min_key_len) >= 0) {
+            return 0;
+        }
+    }
+
+    uint64_t entries = 0;
+    for (size_t i = 0; i < l1->file_count; i++) {
+        entries += sstable_reader_num_entries(l1->files[i].reader);
+    }
+    if (entries != (uint64_t)n) return 0;   // Tombstones stay above the bottom
+
+    char key[32], expected[128];
+    for (int i = 0; i < n; i++) {
+        snprintf(key, sizeof(key), "key%06d", i);
+        snprintf(expected, sizeof(expected), "round4_%06d_%080d", i, 0);
+        char* value = NULL;
+        size_t value_len = 0;
+        bool deleted = false;
+        status_t status = level_get(lm, key, strlen(key), &value, &value_len, &deleted);
+        int ok = status == STATUS_OK &&
+                 (i % 10 == 0 ? deleted
+                              : !deleted && value_len == strlen(expected) &&
+                                memcmp(value, expected, value_len) == 0);
+        free(value);
+        if (!ok) return 0;
+    }
+    return 1;
+}
+
+static int test_subcompactions(void) {
+    remove_dir(TEST_DIR);
+    mkdir(TEST_DIR, 0755);
+    manifest_create(TEST_DIR);
+
+    level_manager_t* lm = level_manager_create(TEST_DIR, NULL);
+    if (!lm) return 0;
+    level_set_max_subcompactions(lm, 4);
+
+    // Four L0 files and one L1 file over the same keys: enough blocks for
+    // several ranges
+    const int n = 3000;
+    int ok = add_round_sstable(lm, 1, 1, 0, n, false);
+    for (int round = 1; round <= 4 && ok; round++) {
+        ok = add_round_sstable(lm, 0, 1 + round, round, n, round == 4);
+    }
+    if (!ok || compact_level(lm, 0) != STATUS_OK) {
+        level_manager_destroy(lm);
+        return 0;
+    }
+
+    // One output per range, installed together
+    if (level_file_count(lm, 0) != 0 || level_file_count(lm, 1) < 2 ||
+        !check_compacted_l1(lm, n)) {
+        level_manager_destroy(lm);
+        return 0;
+    }
+    size_t l1_files = level_file_count(lm, 1);
+    level_manager_destroy(lm);
+
+    // The manifest lists exactly the outputs
+    lm = level_manager_create(TEST_DIR, NULL);
+    if (!lm) return 0;
+    ok = manifest_recover(TEST_DIR, lm) == STATUS_OK &&
+         level_file_count(lm, 0) == 0 && level_file_count(lm, 1) == l1_files &&
+         check_compacted_l1(lm, n);
+    level_manager_destroy(lm);
+
+    remove_dir(TEST_DIR);
+    return ok;
+}
+
+// ============================================================
+// Test: Compaction output is split at the target file size
+// ============================================================
+static int test_compaction_file_size(void) {
+    remove_dir(TEST_DIR);
+    mkdir(TEST_DIR, 0755);
+    manifest_create(TEST_DIR);
+
+    level_manager_t* lm = level_manager_create(TEST_DIR, NULL);
+    if (!lm) return 0;
+    level_set_max_subcompactions(lm, 1);
+    level_set_target_file_size(lm, 32 * 1024);
+    if (level_target_file_size(lm, 1) != 32 * 1024 ||
+        level_target_file_size(lm, 2) != 32 * 1024 * TARGET_FILE_SIZE_MULTIPLIER) {
+        level_manager_destroy(lm);
+        return 0;
+    }
+
+    const int n = 3000;
+    int ok = add_round_sstable(lm, 1, 1, 0, n, false);
+    for (int round = 1; round <= 4 && ok; round++) {
+        ok = add_round_sstable(lm, 0, 1 + round, round, n, round == 4);
+    }
+    if (!ok || compact_level(lm, 0) != STATUS_OK || !check_compacted_l1(lm, n)) {
+        level_manager_destroy(lm);
+        return 0;
+    }
+
+    // Files stop at the first block past the target (plus index and filter)
+    level_t* l1 = &lm->levels[1];
+    if (l1->file_count < 8) ok = 0;
+    for (size_t i = 0; i < l1->file_count; i++) {
+        if (l1->files[i].file_size > 32 * 1024 + 8 * SSTABLE_BLOCK_SIZE) ok = 0;
+    }
+
+    // Compacting one L1 file touches only that file's key range
+    size_t l1_files = l1->file_count;
+    if (ok && (compact_level(lm, 1) != STATUS_OK ||
+               level_file_count(lm, 1) != l1_files - 1 ||
+               level_file_count(lm, 2) != 1)) {
+        ok = 0;
+    }
+    level_manager_destroy(lm);
+
+    remove_dir(TEST_DIR);
+    return ok;
+}
+
+// ============================================================
+// Test: Score-based level pick and round-robin file pick
+// ============================================================
+
+// Helper: create an SSTable and add it to a level
+static int add_test_sstable(level_manager_t* lm, int level, uint64_t file_num,
+                            const char* prefix, int start, int count) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%06llu.sst", TEST_DIR, (unsigned long long)file_num);
+    sstable_reader_t* reader = create_test_sstable(path, prefix, start, count);
+    if (!reader) return 0;
+    if (level_add_sstable(lm, level, file_num, path, reader) != STATUS_OK) {
+        sstable_reader_close(reader);
+        return 0;
+    }
+    return 1;
+}
+
+static int test_compaction_picker(void) {
+    remove_dir(TEST_DIR);
+    mkdir(TEST_DIR, 0755);
+
+    // Level scores: L0 by file count, L1 by bytes (sizes set by hand)
+    level_manager_t* lm = level_manager_create(TEST_DIR, NULL);
+    if (!lm) return 0;
+    int ok = 1;
+    for (int i = 0; i < 6 && ok; i++) {
+        ok = add_test_sstable(lm, 0, 1 + i, "key", i * 10, 10);
+    }
+    lm->levels[1].total_bytes = 3 * level_max_bytes_for_level(1);
+    if (!ok || compact_pick_level(lm) != 1) ok = 0;     // 3.0 beats L0's 1.5
+    lm->levels[1].total_bytes = level_max_bytes_for_level(1) * 11 / 10;
+    if (compact_pick_level(lm) != 0) ok = 0;            // 1.5 beats 1.1
+    lm->levels[1].total_bytes = 0;
+    level_manager_destroy(lm);
+    remove_dir(TEST_DIR);
+    if (!ok) return 0;
+
+    // L1 files a, b, c, d; L2 holds a large file under a only
+    mkdir(TEST_DIR, 0755);
+    manifest_create(TEST_DIR);
+    lm = level_manager_create(TEST_DIR, NULL);
+    if (!lm) return 0;
+    const char* prefixes[] = { "a", "b", "c", "d" };
+    for (int i = 0; i < 4 && ok; i++) {
+        ok = add_test_sstable(lm, 1, 1 + i, prefixes[i], 0, 100);
+    }
+    if (ok) ok = add_test_sstable(lm, 2, 5, "a", 0, 1000);
+
+    // Least overlap first (b), then on around the level: c, d, and only
+    // then back to a
+    const char* expected[] = { "b", "c", "d", "a" };
+    for (int round = 0; round < 4 && ok; round++) {
+        level_t* l1 = &lm->levels[1];
+        size_t pick = level_pick_compaction_file(lm, 1);
+        if (pick >= l1->file_count || l1->files[pick].min_key[0] != expected[round][0] ||
+            compact_level(lm, 1) != STATUS_OK ||
+            level_file_count(lm, 1) != (size_t)(3 - round)) {
+            ok = 0;
+        }
+    }
+    level_manager_destroy(lm);
+
+    remove_dir(TEST_DIR);
+    return ok;
+}
+
+// ============================================================
+// Test: Trivial move for inputs with nothing to merge
+// ============================================================
+static int test_trivial_move(void) {
+    remove_dir(TEST_DIR);
+    mkdir(TEST_DIR, 0755);
+    manifest_create(TEST_DIR);
+
+    level_manager_t* lm = level_manager_create(TEST_DIR, NULL);
+    if (!lm) return 0;
+
+    // Sequential ingest: disjoint L0 files after everything in L1
+    const char* prefixes[] = { "a", "b", "c", "d", "e" };
+    int ok = 1;
+    for (int i = 0; i < 5 && ok; i++) {
+        ok = add_test_sstable(lm, i == 0 ? 1 : 0, 1 + i, prefixes[i], 0, 100) &&
+             manifest_log_add_file(TEST_DIR, i == 0 ? 1 : 0, 1 + i) == STATUS_OK;
+    }
+    uint64_t next_file = level_next_file_number(lm);
+
+    // Files 2-5 change level untouched: no new file numbers, same paths
+    if (!ok || compact_level(lm, 0) != STATUS_OK ||
+        level_file_count(lm, 0) != 0 || level_file_count(lm, 1) != 5 ||
+        level_next_file_number(lm) != next_file) {
+        level_manager_destroy(lm);
+        return 0;
+    }
+    for (int i = 0; i < 5; i++) {
+        sstable_meta_t* meta = &lm->levels[1].files[i];
+        char path[256];
+        snprintf(path, sizeof(path), "%s/%06d.sst", TEST_DIR, 1 + i);
+        if (meta->file_number != (uint64_t)(1 + i) || strcmp(meta->path, path) != 0 ||
+            access(path, F_OK) != 0) {
+            ok = 0;
+        }
+    }
+
+    // L1 -> L2 with an empty L2 moves a single file
+    if (compact_level(lm, 1) != STATUS_OK || level_file_count(lm, 1) != 4 ||
+        level_file_count(lm, 2) != 1 || level_next_file_number(lm) != next_file) {
+        ok = 0;
+    }
+
+    char* value = NULL;
+    size_t value_len = 0;
+    bool deleted = false;
+    if (level_get(lm, "c0042", 5, &value, &value_len, &deleted) != STATUS_OK ||
+        value_len != 9 || memcmp(value, "value0042", 9) != 0) {
+        ok = 0;
+    }
+    free(value);
+    level_manager_destroy(lm);
+
+    // The manifest agrees
+    lm = level_manager_create(TEST_DIR, NULL);
+    if (!lm) return 0;
+    if (manifest_recover(TEST_DIR, lm) != STATUS_OK || level_file_count(lm, 0) != 0 ||
+        level_file_count(lm, 1) != 4 || level_file_count(lm, 2) != 1) {
+        ok = 0;
+    }
+    level_manager_destroy(lm);
+
+    remove_dir(TEST_DIR);
+    return ok;
+}
+
+// ============================================================
+// Test: Large values are stored in blob files
+// ============================================================
+
+#define BLOB_VALUE_SIZE 2000
+
+// Helper: value of key i written in a round; large for even i unless all
+static size_t make_blob_test_value(char* buf, int i, int round, bool all_large) {
+    size_t len = (all_large || i % 2 == 0) ? BLOB_VALUE_SIZE : 40;
+    memset(buf, 'a' + (i + round) % 26, len);
+    int n = snprintf(buf, len, "round%d_key%04d_", round, i);
+    buf[n] = '_';
+    return len;
+}
+
+// Helper: count blob files in the test directory
+static int count_blob_files(void) {
+    DIR* dir = opendir(TEST_DIR);
+    if (!dir) return -1;
+    int count = 0;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        size_t len = strlen(entry->d_name);
+        if (len > 5 && strcmp(entry->d_name + len - 5, ".blob") == 0) count++;
+    }
+    closedir(dir);
+    return count;
+}
+
+// Helper: count this process's descriptors on deleted blob files
+static int count_deleted_blob_fds(void) {
+    DIR* dir = opendir("/proc/self/fd");
+    if (!dir) return -1;
+    int count = 0;
+    struct dirent* entry;
+    char link[512], target[512];
+    while ((entry = readdir(dir)) != NULL) {
+        snprintf(link, sizeof(link), "/proc/self/fd/%s", entry->d_name);
+        ssize_t n = readlink(link, target, sizeof(target) - 1);
+        if (n <= 0) continue;
+        target[n] = '\0';
+        if (strstr(target, ".blob (deleted)")) count++;
+    }
+    closedir(dir);
+    return count;
+}
+
+// Helper: key i reads back as written in round (get and iterator)
+static int check_blob_key(storage_t* db, int i, int round, bool all_large) {
+    char key[32], expected[BLOB_VALUE_SIZE];
+    snprintf(key, sizeof(key), "key%04d", i);
+    size_t expected_len = make_blob_test_value(expected, i, round, all_large);
+
+    char* value = NULL;
+    size_t value_len = 0;
+    int ok = storage_get(db, key, strlen(key), &value, &value_len) == STATUS_OK &&
+             value_len == expected_len && memcmp(value, expected, value_len) == 0;
+    free(value);
+    if (!ok) return 0;
+
+    storage_iter_t* iter = storage_iter_create(db);
+    if (!iter) return 0;
+    storage_iter_seek(iter, key, strlen(key));
+    size_t key_len;
+    const char* it_key = storage_iter_key(iter, &key_len);
+    const char* it_value = storage_iter_value(iter, &value_len);
+    ok = storage_iter_valid(iter) && key_len == strlen(key) &&
+         memcmp(it_key, key, key_len) == 0 && it_value &&
+         value_len == expected_len && memcmp(it_value, expected, value_len) == 0;
+    storage_iter_destroy(iter);
+    return ok;
+}
+
+static int test_blob_separation(void) {
+    remove_dir(TEST_DIR);
+
+    storage_opts_t opts = STORAGE_OPTS_DEFAULT;
+    opts.blob_min_size = 1024;
+    storage_t* db = storage_open(TEST_DIR, &opts);
+    if (!db) return 0;
+
+    const int n = 50;
+    char key[32], value[BLOB_VALUE_SIZE];
+    for (int i = 0; i < n; i++) {
+        snprintf(key, sizeof(key), "key%04d", i);
+        size_t len = make_blob_test_value(value, i, 0, false);
+        if (storage_put(db, key, strlen(key), value, len) != STATUS_OK) {
+            storage_close(db);
+            return 0;
+        }
+    }
+    if (storage_flush(db) != STATUS_OK) {
+        storage_close(db);
+        return 0;
+    }
+
+    // Only the large values left the SSTable
+    int ok = count_blob_files() == 1 &&
+             level_file_count(db->levels, 0) == 1 &&
+             db->levels->levels[0].files[0].file_size < (uint64_t)n / 2 * BLOB_VALUE_SIZE;
+    for (int i = 0; i < n && ok; i++) {
+        ok = check_blob_key(db, i, 0, false);
+    }
+    storage_close(db);
+    if (!ok) return 0;
+
+    // The blob file is found again through the manifest
+    db = storage_open(TEST_DIR, &opts);
+    if (!db) return 0;
+    for (int i = 0; i < n && ok; i++) {
+        ok = check_blob_key(db, i, 0, false);
+    }
+    storage_close(db);
+
+    remove_dir(TEST_DIR);
+    return ok;
+}
+
+// ============================================================
+// Test: Compaction collects blob garbage
+// ============================================================
+
+// Helper: write keys [0, count) in one round and flush them to L0
+static int put_blob_round(storage_t* db, int count, int round) {
+    char key[32], value[BLOB_VALUE_SIZE];
+    for (int i = 0; i < count; i++) {
+        snprintf(key, sizeof(key), "key%04d", i);
+        size_t len = make_blob_test_value(value, i, round, true);
+        if (storage_put(db, key, strlen(key), value, len) != STATUS_OK) return 0;
+    }
+    return storage_flush(db) == STATUS_OK;
+}
+
+// Helper: keys [0, n) at their newest round (see test_blob_gc)
+static int check_blob_rounds(storage_t* db, int n) {
+    for (int i = 0; i < n; i++) {
+        int round = i < 5 ? 7 : (i < 10 ? 3 : 0);
+        if (!check_blob_key(db, i, round, true)) return 0;
+    }
+    return 1;
+}
+
+static int test_blob_gc(void) {
+    remove_dir(TEST_DIR);
+
+    storage_opts_t opts = STORAGE_OPTS_DEFAULT;
+    opts.blob_min_size = 1024;
+    opts.max_subcompactions = 1;
+    storage_t* db = storage_open(TEST_DIR, &opts);
+    if (!db) return 0;
+
+    // Round 0 writes 20 keys, rounds 1-3 overwrite the first 10. The L0
+    // compaction drops every version in rounds 1 and 2 (files deleted) and
+    // half of round 0.
+    int ok = put_blob_round(db, 20, 0);
+    for (int round = 1; round <= 3 && ok; round++) {
+        ok = put_blob_round(db, 10, round);
+    }
+    // Each flush numbers its SSTable first, so round 0's blob file is 2
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%06d.blob", TEST_DIR, 2);
+    if (!ok || storage_compact(db) != STATUS_OK || count_blob_files() != 2 ||
+        access(path, F_OK) != 0) {
+        storage_close(db);
+        return 0;
+    }
+
+    // Rounds 4-7 overwrite the first 5. This compaction also rewrites L1:
+    // round 0's file is half garbage, so its live values are relocated and
+    // the file goes away; round 3's file stays, rounds 4-6 go, and round 7
+    // plus the relocation target are new.
+    // An iterator opened before it keeps reading round 0's file, which
+    // is closed when the iterator goes
+    storage_iter_t* iter = storage_iter_create(db);
+    if (!iter || count_deleted_blob_fds() != 0) {
+        storage_iter_destroy(iter);
+        storage_close(db);
+        return 0;
+    }
+    for (int round = 4; round <= 7 && ok; round++) {
+        ok = put_blob_round(db, 5, round);
+    }
+    ok = ok && storage_compact(db) == STATUS_OK && count_blob_files() == 3 &&
+         access(path, F_OK) != 0 && check_blob_rounds(db, 20) &&
+         count_deleted_blob_fds() == 1;
+    if (ok) {
+        char expected[BLOB_VALUE_SIZE];
+        size_t expected_len = make_blob_test_value(expected, 15, 0, true);
+        size_t value_len = 0;
+        storage_iter_seek(iter, "key0015", 7);
+        const char* value = storage_iter_valid(iter) ? storage_iter_value(iter, &value_len) : NULL;
+        ok = value && value_len == expected_len && memcmp(value, expected, value_len) == 0;
+    }
+    storage_iter_destroy(iter);
+    if (!ok || count_deleted_blob_fds() != 0) {
+        storage_close(db);
+        return 0;
+    }
+    storage_close(db);
+
+    // The garbage counts survive a reopen
+    db = storage_open(TEST_DIR, &opts);
+    if (!db) return 0;
+    ok = check_blob_rounds(db, 20) && count_blob_files() == 3;
+    storage_close(db);
+
+    remove_dir(TEST_DIR);
+    return ok;
+}
+
+// ============================================================
+// Test: Range deletes across memtable, L0 and L1
+// ============================================================
+
+// Helper: put keys [start, end) with a versioned value
+static int put_range_keys(storage_t* db, int start, int end, const char* version) {
+    char key[32], value[32];
+    for (int i = start; i < end; i++) {
+        snprintf(key, sizeof(key), "key%03d", i);
+        snprintf(value, sizeof(value), "%s%03d", version, i);
+        if (storage_put(db, key, strlen(key), value, strlen(value)) != STATUS_OK) return 0;
+    }
+    return 1;
+}
+
+// Helper: after delete_range(key020, key080) and a newer put of key030,
+// the keys below key110 are 0-19 ("new"), 30 ("newer"), 80-99 ("old")
+// and 100-109
+static int check_range_deleted(storage_t* db) {
+    for (int i = 0; i < 110; i++) {
+        char key[32], expected[32];
+        snprintf(key, sizeof(key), "key%03d", i);
+        if (i < 20) snprintf(expected, sizeof(expected), "new%03d", i);
+        else if (i == 30) snprintf(expected, sizeof(expected), "newer%03d", i);
+        else if (i < 100) snprintf(expected, sizeof(expected), "old%03d", i);
+        else snprintf(expected, sizeof(expected), "mem%03d", i);
+        bool live = i < 20 || i == 30 || i >= 80;
+
+        char* value = NULL;
+        size_t value_len = 0;
+        status_t status = storage_get(db, key, strlen(key), &value, &value_len);
+        int ok = live ? status == STATUS_OK && value_len == strlen(expected) &&
+                        memcmp(value, expected, value_len) == 0
+                      : status == STATUS_NOT_FOUND;
+        free(value);
+        if (!ok) return 0;
+    }
+
+    storage_iter_t* iter = storage_iter_create(db);
+    if (!iter) return 0;
+    int count = 0;
+    for (storage_iter_seek_to_first(iter); storage_iter_valid(iter); storage_iter_next(iter)) {
+        size_t key_len;
+        const char* key = storage_iter_key(iter, &key_len);
+        if (key_len == 6 && memcmp(key, "key110", 6) >= 0) break;
+        count++;
+    }
+    size_t key_len = 0;
+    storage_iter_seek(iter, "key020", 6);
+    const char* first = storage_iter_valid(iter) ? storage_iter_key(iter, &key_len) : NULL;
+    int ok = count == 51 && first && key_len == 6 && memcmp(first, "key030", 6) == 0;
+    storage_iter_destroy(iter);
+    return ok;
+}
+
+static int test_delete_range(void) {
+    remove_dir(TEST_DIR);
+
+    storage_opts_t opts = STORAGE_OPTS_DEFAULT;
+    storage_t* db = storage_open(TEST_DIR, &opts);
+    if (!db) return 0;
+
+    // L1: keys 0-99, plus fillers to reach the L0 trigger
+    int ok = put_range_keys(db, 0, 100, "old") && storage_flush(db) == STATUS_OK;
+    for (int i = 0; i < L0_COMPACTION_TRIGGER - 1 && ok; i++) {
+        ok = put_range_keys(db, 200 + i, 201 + i, "fill") && storage_flush(db) == STATUS_OK;
+    }
+    ok = ok && storage_compact(db) == STATUS_OK && level_file_count(db->levels, 0) == 0;
+
+    // L0: keys 0-49; memtable: keys 100-109, the range delete, key030
+    ok = ok && put_range_keys(db, 0, 50, "new") && storage_flush(db) == STATUS_OK &&
+         put_range_keys(db, 100, 110, "mem") &&
+         storage_delete_range(db, "key020", 6, "key080", 6) == STATUS_OK &&
+         put_range_keys(db, 30, 31, "newer");
+    if (!ok || storage_delete_range(db, "key080", 6, "key020", 6) != STATUS_INVALID_ARG ||
+        storage_delete_range(db, "key050", 6, "key050", 6) != STATUS_OK ||
+        !check_range_deleted(db)) {
+        storage_close(db);
+        return 0;
+    }
+
+    // Batches are checked the same way: a reversed range fails the whole
+    // batch, an empty one is dropped
+    storage_write_batch_t* batch = storage_write_batch_create();
+    ok = batch && storage_write_batch_put(batch, "key300", 6, "v", 1) == STATUS_OK &&
+         storage_write_batch_delete_range(batch, "key090", 6, "key010", 6) == STATUS_OK &&
+         storage_write(db, batch) == STATUS_INVALID_ARG;
+    char* value = NULL;
+    size_t value_len = 0;
+    ok = ok && storage_get(db, "key300", 6, &value, &value_len) == STATUS_NOT_FOUND;
+    storage_write_batch_clear(batch);
+    ok = ok && storage_write_batch_delete_range(batch, "key300", 6, "key300", 6) == STATUS_OK &&
+         storage_write(db, batch) == STATUS_OK &&
+         storage_write_batch_put(batch, "key300", 6, "v", 1) == STATUS_OK &&
+         storage_write(db, batch) == STATUS_OK &&
+         storage_get(db, "key300", 6, &value, &value_len) == STATUS_OK;
+    free(value);
+    storage_write_batch_destroy(batch);
+    storage_close(db);
+
+    // Nor do SSTables take an inverted tombstone
+    char path[256];
+    snprintf(path, sizeof(path), "%s/reversed.sst", TEST_DIR);
+    sstable_writer_t* writer = sstable_writer_create(path, 1, NULL);
+    range_tombstone_t reversed = { "key080", 6, "key020", 6 };
+    ok = ok && writer && sstable_writer_add_range_tombstone(writer, &reversed) == STATUS_INVALID_ARG;
+    sstable_writer_abort(writer);
+    if (!ok) return 0;
+
+    // Recovered from the WAL, then flushed to L0 and compacted into L1
+    db = storage_open(TEST_DIR, &opts);
+    if (!db) return 0;
+    ok = check_range_deleted(db) && storage_flush(db) == STATUS_OK && check_range_deleted(db);
+    for (int i = 0; i < L0_COMPACTION_TRIGGER - 2 && ok; i++) {
+        ok = put_range_keys(db, 210 + i, 211 + i, "fill") && storage_flush(db) == STATUS_OK;
+    }
+    ok = ok && storage_compact(db) == STATUS_OK && level_file_count(db->levels, 0) == 0 &&
+         check_range_deleted(db);
+    storage_close(db);
+
+    db = storage_open(TEST_DIR, &opts);
+    if (!db) return 0;
+    ok = ok && check_range_deleted(db);
+    storage_close(db);
+
+    remove_dir(TEST_DIR);
+    return ok;
+}
+
+// ============================================================
+// Test: Compaction carries range tombstones and cuts files around them
+// ============================================================
+
+// Helper: L0 table holding only range tombstones
+static int add_range_del_sstable(level_manager_t* lm, uint64_t file_num,
+                                 const int (*ranges)[2], size_t count) {
+    char path[256], begin[32], end[32];
+    snprintf(path, sizeof(path), "%s/%06llu.sst", TEST_DIR, (unsigned long long)file_num);
+    sstable_writer_t* writer = sstable_writer_create(path, 1, NULL);
+    if (!writer) return 0;
+    for (size_t i = 0; i < count; i++) {
+        snprintf(begin, sizeof(begin), "key%06d", ranges[i][0]);
+        snprintf(end, sizeof(end), "key%06d", ranges[i][1]);
+        range_tombstone_t t = { begin, strlen(begin), end, strlen(end) };
+        if (sstable_writer_add_range_tombstone(writer, &t) != STATUS_OK) {
+            sstable_writer_abort(writer);
+            return 0;
+        }
+    }
+    if (sstable_writer_finish(writer) != STATUS_OK) return 0;
+
+    sstable_reader_t* reader = sstable_reader_open(path, NULL);
+    if (!reader) return 0;
+    if (level_add_sstable(lm, 0, file_num, path, reader) != STATUS_OK) {
+        sstable_reader_close(reader);
+        return 0;
+    }
+    return manifest_log_add_file(TEST_DIR, 0, file_num) == STATUS_OK &&
+           manifest_log_next_file_num(TEST_DIR, file_num + 1) == STATUS_OK;
+}
+
+static int test_range_del_compaction(void) {
+    remove_dir(TEST_DIR);
+    mkdir(TEST_DIR, 0755);
+    manifest_create(TEST_DIR);
+
+    level_manager_t* lm = level_manager_create(TEST_DIR, NULL);
+    if (!lm) return 0;
+    level_set_max_subcompactions(lm, 4);
+    level_set_target_file_size(lm, 32 * 1024);
+
+    // L1: round 0 of keys 0-2999; L0: tombstones over 500-2499, then round 1
+    // of the first 1000 keys (newer, so 500-999 come back)
+    const int n = 3000;
+    const int ranges[][2] = { { 1400, 2500 }, { 500, 1500 } };
+    int ok = add_round_sstable(lm, 1, 1, 0, n, false) &&
+             add_range_del_sstable(lm, 2, ranges, 2) &&
+             add_round_sstable(lm, 0, 3, 1, 1000, false);
+    if (!ok || compact_level(lm, 0) != STATUS_OK) {
+        level_manager_destroy(lm);
+        return 0;
+    }
+
+    // Several disjoint L1 files, one of them carrying the tombstones
+    level_t* l1 = &lm->levels[1];
+    size_t carried = 0;
+    for (size_t i = 0; i < l1->file_count; i++) {
+        carried += sstable_reader_range_dels(l1->files[i].reader)->count;
+        if (i > 0 && lm->cmp(l1->files[i - 1].max_key, l1->files[i - 1].max_key_len,
+                             l1->files[i].min_key, l1->files[i].min_key_len) >= 0) {
+            ok = 0;
+        }
+    }
+    if (l1->file_count < 4 || carried != 2) ok = 0;
+
+    char key[32], expected[128];
+    for (int i = 0; i < n && ok; i++) {
+        snprintf(key, sizeof(key), "key%06d", i);
+        snprintf(expected, sizeof(expected), "round%d_%06d_%080d", i < 1000 ? 1 : 0, i, 0);
+        char* value = NULL;
+        size_t value_len = 0;
+        bool deleted = false;
+        status_t status = level_get(lm, key, strlen(key), &value, &value_len, &deleted);
+        bool live = i < 1000 || i >= 2500;
+        ok = live ? status == STATUS_OK && !deleted && value_len == strlen(expected) &&
+                    memcmp(value, expected, value_len) == 0
+                  : status == STATUS_NOT_FOUND || (status == STATUS_OK && deleted);
+        free(value);
+    }
+    level_manager_destroy(lm);
+
+    remove_dir(TEST_DIR);
+    return ok;
+}
+
+// ============================================================
+// Test: Prefix seek stays within the target's prefix
+// ============================================================
+
+// Helper: "user042" is the prefix of "user042:07"
+static size_t user_prefix(const char* key, size_t key_len) {
+    (void)key;
+    return key_len < 7 ? key_len : 7;
+}
+
+// Helper: prefix-seek to user's item and return the items seen until the
+// iterator stops (-1 on a key outside the prefix)
+static int prefix_scan(storage_t* db, int user, int item) {
+    char target[32], prefix[16];
+    snprintf(target, sizeof(target), "user%03d:%02d", user, item);
+    snprintf(prefix, sizeof(prefix), "user%03d", user);
+
+    storage_iter_t* iter = storage_iter_create_ex(db, STORAGE_ITER_PREFIX);
+    if (!iter) return -1;
+    int count = 0;
+    for (storage_iter_seek(iter, target, strlen(target)); storage_iter_valid(iter);
+         storage_iter_next(iter)) {
+        size_t key_len;
+        const char* key = storage_iter_key(iter, &key_len);
+        if (key_len != 10 || memcmp(key, prefix, 7) != 0) count = -1;
+        if (count < 0) break;
+        count++;
+    }
+    storage_iter_destroy(iter);
+    return count;
+}
+
+// Helper: "user01" is the prefix of "user012:07", covering users 10-19
+static size_t group_prefix(const char* key, size_t key_len) {
+    (void)key;
+    return key_len < 6 ? key_len : 6;
+}
+
+// Helper: count the keys a prefix seek to "user01" visits
+static int group_scan(storage_t* db) {
+    storage_iter_t* iter = storage_iter_create_ex(db, STORAGE_ITER_PREFIX);
+    if (!iter) return -1;
+    int count = 0;
+    for (storage_iter_seek(iter, "user01", 6); storage_iter_valid(iter); storage_iter_next(iter)) {
+        count++;
+    }
+    storage_iter_destroy(iter);
+    return count;
+}
+
+// Helper: after the puts and deletes of test_prefix_seek
+static int check_prefix_seek(storage_t* db) {
+    // Users 0-39 (even only) hold items 0-9; user 0 lost item 3, user 12
+    // gained item 10
+    if (prefix_scan(db, 0, 0) != 9 || prefix_scan(db, 12, 0) != 11 ||
+        prefix_scan(db, 38, 0) != 10 || prefix_scan(db, 20, 4) != 6) {
+        return 0;
+    }
+    // Absent users: nothing, rather than the next user's keys
+    if (prefix_scan(db, 13, 0) != 0 || prefix_scan(db, 99, 0) != 0) return 0;
+
+    // seek_to_first is not bounded
+    storage_iter_t* iter = storage_iter_create_ex(db, STORAGE_ITER_PREFIX);
+    if (!iter) return 0;
+    int count = 0;
+    for (storage_iter_seek_to_first(iter); storage_iter_valid(iter); storage_iter_next(iter)) {
+        count++;
+    }
+    storage_iter_destroy(iter);
+    return count == 20 * 10;
+}
+
+static int test_prefix_seek(void) {
+    remove_dir(TEST_DIR);
+
+    storage_opts_t opts = STORAGE_OPTS_DEFAULT;
+    opts.prefix_extractor = user_prefix;
+    opts.prefix_extractor_name = "user7";
+    storage_t* db = storage_open(TEST_DIR, &opts);
+    if (!db) return 0;
+
+    // Three L0 files of disjoint users, and a memtable on top
+    char key[32];
+    int ok = 1;
+    for (int f = 0; f < 3 && ok; f++) {
+        for (int u = f * 14; u < (f + 1) * 14 && u < 40 && ok; u += 2) {
+            for (int i = 0; i < 10 && ok; i++) {
+                snprintf(key, sizeof(key), "user%03d:%02d", u, i);
+                ok = storage_put(db, key, strlen(key), "v", 1) == STATUS_OK;
+            }
+        }
+        ok = ok && storage_flush(db) == STATUS_OK;
+    }
+    ok = ok && storage_delete(db, "user000:03", 10) == STATUS_OK &&
+         storage_put(db, "user012:10", 10, "v", 1) == STATUS_OK &&
+         level_file_count(db->levels, 0) == 3 && check_prefix_seek(db);
+
+    // Again from L1
+    ok = ok && storage_flush(db) == STATUS_OK && storage_compact(db) == STATUS_OK &&
+         level_file_count(db->levels, 0) == 0 && check_prefix_seek(db);
+    storage_close(db);
+
+    // Filters of another extractor are not used: the 7-byte ones would
+    // rule out "user01"
+    opts.prefix_extractor = group_prefix;
+    opts.prefix_extractor_name = "user6";
+    db = storage_open(TEST_DIR, &opts);
+    if (!db) return 0;
+    ok = ok && group_scan(db) == 5 * 10 + 1;
+    storage_close(db);
+
+    // Nor are those of an ingested table
+    const char* path = "test_prefix_ingest.sst";
+    sstable_writer_t* writer = sstable_writer_create(path, 10, NULL);
+    if (!writer) return 0;
+    sstable_writer_set_prefix_extractor(writer, group_prefix, "user6");
+    for (int i = 0; i < 10 && ok; i++) {
+        snprintf(key, sizeof(key), "user041:%02d", i);
+        ok = sstable_writer_add(writer, key, strlen(key), "v", 1, false) == STATUS_OK;
+    }
+    ok = ok && sstable_writer_finish(writer) == STATUS_OK;
+    opts.prefix_extractor = user_prefix;
+    opts.prefix_extractor_name = "user7";
+    db = storage_open(TEST_DIR, &opts);
+    if (!db) return 0;
+    ok = ok && storage_ingest_files(db, &path, 1) == STATUS_OK &&
+         prefix_scan(db, 41, 0) == 10 && prefix_scan(db, 12, 0) == 11;
+    storage_close(db);
+    unlink(path);
+
+    // An extractor needs a name
+    opts.prefix_extractor_name = NULL;
+    ok = ok && storage_open(TEST_DIR, &opts) == NULL;
+
+    // Without an extractor the flag does nothing
+    db = storage_open(TEST_DIR, NULL);
+    if (!db) return 0;
+    ok = ok && prefix_scan(db, 13, 0) == -1;
+    storage_close(db);
+
+    remove_dir(TEST_DIR);
+    return ok;
+}
+
+// ============================================================
+// Test: Ingested SSTables land in the deepest level they fit in
+// ============================================================
+
+// Helper: external table of keys [start, end)
+static int write_external_table(const char* path, int start, int end, const char* version) {
+    sstable_writer_t* writer = sstable_writer_create(path, (size_t)(end - start), NULL);
+    if (!writer) return 0;
+    char key[32], value[32];
+    for (int i = start; i < end; i++) {
+        snprintf(key, sizeof(key), "key%03d", i);
+        snprintf(value, sizeof(value), "%s%03d", version, i);
+        if (sstable_writer_add(writer, key, strlen(key), value, strlen(value), false) != STATUS_OK) {
+            sstable_writer_abort(writer);
+            return 0;
+        }
+    }
+    return sstable_writer_finish(writer) == STATUS_OK;
+}
+
+// Helper: check key's value has the given version
+static int check_version(storage_t* db, int i, const char* version) {
+    char key[32], expected[32];
+    snprintf(key, sizeof(key), "key%03d", i);
+    snprintf(expected, sizeof(expected), "%s%03d", version, i);
+    char* value = NULL;
+    size_t value_len = 0;
+    int ok = storage_get(db, key, strlen(key), &value, &value_len) == STATUS_OK &&
+             value_len == strlen(expected) && memcmp(value, expected, value_len) == 0;
+    free(value);
+    return ok;
+}
+
+// Helper: keys 0-49 and 60-99 "old", 50-59 and 200-309 "ing"
+static int check_ingested(storage_t* db) {
+    for (int i = 0; i < 100; i++) {
+        if (!check_version(db, i, i >= 50 && i < 60 ? "ing" : "old")) return 0;
+    }
+    for (int i = 200; i < 310; i++) {
+        if (!check_version(db, i, "ing")) return 0;
+    }
+    return 1;
+}
+
+static int test_ingest_files(void) {
+    remove_dir(TEST_DIR);
+    const char* paths[] = {"test_ingest_a.sst", "test_ingest_b.sst", "test_ingest_c.sst"};
+
+    storage_opts_t opts = STORAGE_OPTS_DEFAULT;
+    storage_t* db = storage_open(TEST_DIR, &opts);
+    if (!db) return 0;
+
+    // L0: keys 0-99; memtable: key300
+    int ok = put_range_keys(db, 0, 100, "old") && storage_flush(db) == STATUS_OK &&
+             put_range_keys(db, 300, 301, "old");
+
+    // Overlapping tables are refused, and nothing is added
+    ok = ok && write_external_table(paths[0], 400, 420, "ing") &&
+         write_external_table(paths[1], 410, 430, "ing") &&
+         storage_ingest_files(db, paths, 2) == STATUS_INVALID_ARG &&
+         level_file_count(db->levels, 0) == 1 && level_file_count(db->levels, MAX_LEVELS - 1) == 0;
+
+    // a overlaps nothing: bottom level; b overlaps L0; c overlaps the
+    // memtable, which is flushed below it
+    ok = ok && write_external_table(paths[0], 200, 300, "ing") &&
+         write_external_table(paths[1], 50, 60, "ing") &&
+         write_external_table(paths[2], 300, 310, "ing") &&
+         storage_ingest_files(db, paths, 3) == STATUS_OK &&
+         level_file_count(db->levels, MAX_LEVELS - 1) == 1 && check_ingested(db);
+    for (int i = 0; i < 3; i++) unlink(paths[i]);
+    storage_close(db);
+
+    // From the manifest, then compacted
+    db = storage_open(TEST_DIR, &opts);
+    if (!db) return 0;
+    ok = ok && check_ingested(db) && storage_compact(db) == STATUS_OK &&
+         level_file_count(db->levels, 0) == 0 && check_ingested(db);
+    storage_close(db);
+
+    remove_dir(TEST_DIR);
+    return ok;
+}
+
+// ============================================================
+// Test: Pinned values outlive the memtable and files they came from
+// ============================================================
+
+// Helper: check a pinned value
+static int pinned_is(const storage_pinned_t* pinned, const char* expected) {
+    return pinned->size == strlen(expected) && memcmp(pinned->data, expected, pinned->size) == 0;
+}
+
+static int test_get_pinned(void) {
+    // Block cache, mapped reads, private blocks, blob values
+    for (int mode = 0; mode < 4; mode++) {
+        remove_dir(TEST_DIR);
+        storage_opts_t opts = STORAGE_OPTS_DEFAULT;
+        if (mode == 1) opts.use_mmap_reads = true;
+        if (mode == 2) opts.block_cache_size = 0;
+        if (mode == 3) opts.blob_min_size = 4;
+        storage_t* db = storage_open(TEST_DIR, &opts);
+        if (!db) return 0;
+
+        // From the memtable, kept through an overwrite and a flush
+        storage_pinned_t mem, table;
+        int ok = put_range_keys(db, 0, 10, "old") &&
+                 storage_get_pinned(db, "key005", 6, &mem) == STATUS_OK &&
+                 put_range_keys(db, 0, 10, "new") && storage_flush(db) == STATUS_OK &&
+                 pinned_is(&mem, "old005");
+        storage_pinned_release(&mem);
+
+        // From a table, kept through the compaction that deletes it
+        ok = ok && storage_get_pinned(db, "key005", 6, &table) == STATUS_OK &&
+             pinned_is(&table, "new005");
+        for (int i = 0; i < L0_COMPACTION_TRIGGER - 1 && ok; i++) {
+            ok = put_range_keys(db, 0, 10, "newer") && storage_flush(db) == STATUS_OK;
+        }
+        ok = ok && storage_compact(db) == STATUS_OK && level_file_count(db->levels, 0) == 0 &&
+             pinned_is(&table, "new005");
+        storage_pinned_release(&table);
+
+        // Misses leave nothing to release
+        ok = ok && storage_delete(db, "key005", 6) == STATUS_OK &&
+             storage_get_pinned(db, "key005", 6, &mem) == STATUS_NOT_FOUND && mem.data == NULL &&
+             storage_get_pinned(db, "key099", 6, &mem) == STATUS_NOT_FOUND &&
+             storage_get_pinned(db, "key006", 6, &mem) == STATUS_OK && pinned_is(&mem, "newer006");
+        storage_pinned_release(&mem);
+        storage_close(db);
+        if (!ok) return 0;
+    }
+
+    remove_dir(TEST_DIR);
+    return 1;
+}
+
 // ============================================================
 // Main
 // ============================================================
@@ -551,6 +1747,20 @@ int main(void) {
     TEST(find_overlapping);
     TEST(storage_with_levels);
     TEST(manifest_recovery);
+    TEST(manifest_edit);
+    TEST(storage_iter_merged);
+    TEST(storage_background_flush);
+    TEST(subcompactions);
+    TEST(compaction_file_size);
+    TEST(compaction_picker);
+    TEST(trivial_move);
+    TEST(blob_separation);
+    TEST(blob_gc);
+    TEST(delete_range);
+    TEST(range_del_compaction);
+    TEST(prefix_seek);
+    TEST(ingest_files);
+    TEST(get_pinned);
 
     printf("\n==============================================\n");
     printf("Results: %d/%d tests passed\n", tests_passed, tests_run);
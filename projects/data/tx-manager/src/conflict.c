@@ -18,7 +18,7 @@ tx_status_t get_latest_commit_ts(tx_manager_t* tm,
     *commit_ts = 0;
 
     /* Create iterator and seek to the key prefix */
-    storage_iter_t* iter = storage_iter_create(tm->storage);
+    storage_iter_t* iter = storage_iter_create_ex(tm->storage, STORAGE_ITER_PREFIX);
     if (!iter) return TX_IO_ERROR;
 
     /* Encode key with max timestamp to find latest version */
@@ -39,8 +39,11 @@ tx_manager_t* tx_manager_open(const char* path, tx_manager_opts_t* opts) {
         default_opts(&tm->opts);
     }
 
-    /* Open underlying storage */
-    tm->storage = storage_open(path, NULL);
+    /* Open underlying storage; lookups prefix-seek to one key's versions */
+    storage_opts_t storage_opts = STORAGE_OPTS_DEFAULT;
+    storage_opts.prefix_extractor = version_key_prefix;
+    storage_opts.prefix_extractor_name = VERSION_KEY_PREFIX_NAME;
+    tm->storage = storage_open(path, &storage_opts);
     if (!tm->storage) {
         free(tm->path);
         free(tm);
@@ -193,7 +196,13 @@ tx_status_t tx_commit(tx_manager_t* tm, tx_t* tx) {
     uint64_t commit_ts = tm->next_ts++;
     tx->commit_ts = commit_ts;
 
-    /* Apply all writes to storage with versioned keys */
+    /* Apply all writes to storage with versioned keys, as one atomic batch */
+    storage_write_batch_t* batch = storage_write_batch_create();
+    if (!batch) {
+        pthread_mutex_unlock(&tm->mutex);
+        return TX_NO_MEMORY;
+    }
+
     for (size_t i = 0; i < tx->write_count; i++) {
         write_entry_t* w = &tx->write_set[i];
 
@@ -202,6 +211,7 @@ tx_status_t tx_commit(tx_manager_t* tm, tx_t* tx) {
         tx_status_t st = version_encode_key(w->key, w->key_len, commit_ts,
                                             &versioned_key, &versioned_len);
         if (st != TX_OK) {
+            storage_write_batch_destroy(batch);
             pthread_mutex_unlock(&tm->mutex);
             return st;
         }
@@ -209,20 +219,28 @@ tx_status_t tx_commit(tx_manager_t* tm, tx_t* tx) {
         status_t sst;
         if (w->is_delete) {
             /* Write tombstone (empty value) for MVCC delete */
-            sst = storage_put(tm->storage, versioned_key, versioned_len,
-                              "", 0);
+            sst = storage_write_batch_put(batch, versioned_key, versioned_len,
+                                          "", 0);
         } else {
-            sst = storage_put(tm->storage, versioned_key, versioned_len,
-                              w->value, w->value_len);
+            sst = storage_write_batch_put(batch, versioned_key, versioned_len,
+                                          w->value, w->value_len);
         }
         free(versioned_key);
 
         if (sst != STATUS_OK) {
+            storage_write_batch_destroy(batch);
             pthread_mutex_unlock(&tm->mutex);
-            return TX_IO_ERROR;
+            return TX_NO_MEMORY;
         }
     }
 
+    status_t sst = storage_write(tm->storage, batch);
+    storage_write_batch_destroy(batch);
+    if (sst != STATUS_OK) {
+        pthread_mutex_unlock(&tm->mutex);
+        return TX_IO_ERROR;
+    }
+
     tx->state = TX_STATE_COMMITTED;
     remove_active_tx(tm, tx);
 
@@ -279,7 +297,7 @@ tx_status_t tx_get(tx_manager_t* tm, tx_t* tx,
 
     /* Search storage for visible version */
     /* Phase 1: Simple approach - scan for key with version <= start_ts */
-    storage_iter_t* iter = storage_iter_create(tm->storage);
+    storage_iter_t* iter = storage_iter_create_ex(tm->storage, STORAGE_ITER_PREFIX);
     if (!iter) return TX_IO_ERROR;
 
     /* Build prefix to seek to */
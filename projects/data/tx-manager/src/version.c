@@ -69,6 +69,12 @@ tx_status_t version_decode_key(const char* versioned_key, size_t versioned_len,
     return TX_OK;
 }
 
+size_t version_key_prefix(const char* versioned_key, size_t versioned_len) {
+    (void)versioned_key;
+    /* Too short to be versioned: the whole key */
+    return versioned_len >= 10 ? versioned_len - 8 : versioned_len;
+}
+
 int version_compare_keys(const char* key1, size_t len1,
                          const char* key2, size_t len2) {
     size_t min_len = len1 < len2 ? len1 : len2;
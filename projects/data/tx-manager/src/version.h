@@ -47,4 +47,11 @@ tx_status_t version_decode_key(const char* versioned_key, size_t versioned_len,
 int version_compare_keys(const char* key1, size_t len1,
                          const char* key2, size_t len2);
 
+/**
+ * Prefix extractor for the storage engine: every version of a key shares
+ * the prefix key + \0, so prefix seeks only visit that key's versions
+ */
+size_t version_key_prefix(const char* versioned_key, size_t versioned_len);
+#define VERSION_KEY_PREFIX_NAME "tx.version_key"
+
 #endif /* TX_VERSION_H */
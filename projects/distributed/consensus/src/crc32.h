@@ -2,6 +2,8 @@
  * crc32.h - CRC32 checksum for data integrity
  *
  * Provides CRC32 calculation for verifying data integrity in storage.
+ * CRC-32C is used for new records; CRC-32 remains for reading files written
+ * before format version 2.
  */
 
 #ifndef RAFT_CRC32_H
@@ -11,7 +13,7 @@
 #include <stddef.h>
 
 /**
- * Calculate CRC32 checksum for data
+ * Calculate CRC32 checksum for data (IEEE, polynomial 0xEDB88320)
  */
 uint32_t crc32(const void* data, size_t len);
 
@@ -20,4 +22,26 @@ uint32_t crc32(const void* data, size_t len);
  */
 uint32_t crc32_update(uint32_t crc, const void* data, size_t len);
 
+/**
+ * Calculate CRC32C checksum for data (Castagnoli, polynomial 0x82F63B78).
+ * Uses the SSE4.2 crc32 instruction when the CPU has it, slicing-by-8
+ * tables otherwise.
+ */
+uint32_t crc32c(const void* data, size_t len);
+
+/**
+ * Update CRC32C incrementally (for streaming data)
+ */
+uint32_t crc32c_update(uint32_t crc, const void* data, size_t len);
+
+/**
+ * Portable slicing-by-8 CRC32C; the SSE4.2 path must agree with it
+ */
+uint32_t crc32c_update_portable(uint32_t crc, const void* data, size_t len);
+
+/**
+ * Implementation picked at runtime: "sse4.2" or "slicing-by-8"
+ */
+const char* crc32c_impl(void);
+
 #endif /* RAFT_CRC32_H */
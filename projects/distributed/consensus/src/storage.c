@@ -6,6 +6,9 @@
  * - raft_log.dat: Header + Entry records
  *   Header: | magic(4) | version(4) | base_index(8) | base_term(8) |
  *   Entry:  | record_len(4) | crc32(4) | term(8) | index(8) | cmd_len(4) | command(var) |
+ *
+ * The version selects the checksum: CRC32C from version 2, CRC-32 before.
+ * A log keeps the version it was created with, so all its entries agree.
  */
 
 #include "storage.h"
@@ -53,9 +56,20 @@ struct raft_storage {
     char* data_dir;
     bool sync_writes;
     int log_fd;           /* File descriptor for log file */
+    uint32_t log_version; /* Format version from the log header */
     uint64_t log_entries; /* Number of entries in log */
 };
 
+/* Checksum of a record of the given format version */
+static uint32_t record_crc(uint32_t version, uint32_t crc, const void* data, size_t len) {
+    return version >= RAFT_STORAGE_VERSION ? crc32c_update(crc, data, len)
+                                           : crc32_update(crc, data, len);
+}
+
+static bool version_supported(uint32_t version) {
+    return version == RAFT_STORAGE_VERSION || version == RAFT_STORAGE_VERSION_CRC32;
+}
+
 static char* make_path(const char* dir, const char* file) {
     size_t len = strlen(dir) + strlen(file) + 2;
     char* path = malloc(len);
@@ -177,6 +191,18 @@ raft_storage_t* raft_storage_open(const char* data_dir, bool sync_writes) {
         if (sync_writes) fsync(storage->log_fd);
     }
 
+    /* Entries appended later use the log's own checksum */
+    log_header_t header;
+    if (pread(storage->log_fd, &header, sizeof(header), 0) != sizeof(header) ||
+        !version_supported(header.version)) {
+        close(storage->log_fd);
+        free(log_path);
+        free(storage->data_dir);
+        free(storage);
+        return NULL;
+    }
+    storage->log_version = header.version;
+
     storage->log_entries = count_log_entries(storage->log_fd);
     free(log_path);
     return storage;
@@ -205,7 +231,8 @@ raft_status_t raft_storage_save_state(raft_storage_t* storage,
     };
 
     /* Calculate CRC over term and voted_for */
-    state.crc32 = crc32(&state.current_term, sizeof(state.current_term) + sizeof(state.voted_for));
+    state.crc32 = record_crc(state.version, 0, &state.current_term,
+                             sizeof(state.current_term) + sizeof(state.voted_for));
 
     char* path = make_path(storage->data_dir, STATE_FILE);
     if (!path) return RAFT_NO_MEMORY;
@@ -236,11 +263,11 @@ raft_status_t raft_storage_load_state(raft_storage_t* storage,
 
     if (n != sizeof(state)) return RAFT_IO_ERROR;
     if (state.magic != RAFT_STATE_MAGIC) return RAFT_CORRUPTION;
-    if (state.version != RAFT_STORAGE_VERSION) return RAFT_CORRUPTION;
+    if (!version_supported(state.version)) return RAFT_CORRUPTION;
 
     /* Verify CRC */
-    uint32_t expected_crc = crc32(&state.current_term,
-                                   sizeof(state.current_term) + sizeof(state.voted_for));
+    uint32_t expected_crc = record_crc(state.version, 0, &state.current_term,
+                                       sizeof(state.current_term) + sizeof(state.voted_for));
     if (state.crc32 != expected_crc) return RAFT_CORRUPTION;
 
     *current_term = state.current_term;
@@ -265,9 +292,10 @@ raft_status_t raft_storage_append_entry(raft_storage_t* storage,
     };
 
     /* Calculate CRC over term, index, cmd_len, and command */
-    uint32_t crc = crc32(&rec.term, sizeof(rec.term) + sizeof(rec.index) + sizeof(rec.cmd_len));
+    uint32_t crc = record_crc(storage->log_version, 0, &rec.term,
+                              sizeof(rec.term) + sizeof(rec.index) + sizeof(rec.cmd_len));
     if (entry->command && entry->command_len > 0) {
-        crc = crc32_update(crc, entry->command, entry->command_len);
+        crc = record_crc(storage->log_version, crc, entry->command, entry->command_len);
     }
     rec.crc32 = crc;
 
@@ -385,9 +413,10 @@ raft_status_t raft_storage_iterate_log(raft_storage_t* storage,
         }
 
         /* Verify CRC */
-        uint32_t crc = crc32(&rec.term, sizeof(rec.term) + sizeof(rec.index) + sizeof(rec.cmd_len));
+        uint32_t crc = record_crc(storage->log_version, 0, &rec.term,
+                                  sizeof(rec.term) + sizeof(rec.index) + sizeof(rec.cmd_len));
         if (cmd_len > 0) {
-            crc = crc32_update(crc, cmd_buf, cmd_len);
+            crc = record_crc(storage->log_version, crc, cmd_buf, cmd_len);
         }
         if (crc != rec.crc32) {
             free(cmd_buf);
@@ -13,7 +13,8 @@
 
 #define RAFT_STATE_MAGIC    0x52414654  /* "RAFT" */
 #define RAFT_LOG_MAGIC      0x524C4F47  /* "RLOG" */
-#define RAFT_STORAGE_VERSION 1
+#define RAFT_STORAGE_VERSION 2          /* CRC32C checksums */
+#define RAFT_STORAGE_VERSION_CRC32 1    /* CRC-32 checksums (still readable) */
 
 typedef struct raft_storage raft_storage_t;
 
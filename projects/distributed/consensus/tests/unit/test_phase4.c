@@ -334,6 +334,99 @@ TEST(test_phase3_regression) {
     raft_destroy(node);
 }
 
+/* Test 11: CRC32C checksums, version 1 (CRC-32) files still readable */
+static raft_status_t count_entries_fn(void* ctx, uint64_t term, uint64_t index,
+                                      const char* command, size_t command_len) {
+    (void)term; (void)index; (void)command; (void)command_len;
+    (*(int*)ctx)++;
+    return RAFT_OK;
+}
+
+TEST(test_crc32c_format_version) {
+    /* Standard check values for "123456789" */
+    assert(crc32("123456789", 9) == 0xCBF43926u);
+    assert(crc32c("123456789", 9) == 0xE3069283u);
+    assert(crc32c_update_portable(0, "123456789", 9) == 0xE3069283u);
+    char buf[100];
+    for (int i = 0; i < 100; i++) buf[i] = (char)(i * 37);
+    for (int len = 0; len <= 99; len += 11) {
+        assert(crc32c(buf + 1, len) == crc32c_update_portable(0, buf + 1, len));
+    }
+
+    /* Hand-written version 1 state and log: magic, version, CRC-32 */
+    char* dir = make_test_dir();
+    char path[256];
+    uint8_t state[28] = {0};
+    uint32_t magic = RAFT_STATE_MAGIC, version = RAFT_STORAGE_VERSION_CRC32;
+    uint64_t term = 7;
+    int32_t voted_for = 2;
+    memcpy(state, &magic, 4);
+    memcpy(state + 4, &version, 4);
+    memcpy(state + 12, &term, 8);
+    memcpy(state + 20, &voted_for, 4);
+    uint32_t crc = crc32(state + 12, 12);
+    memcpy(state + 8, &crc, 4);
+    snprintf(path, sizeof(path), "%s/raft_state.dat", dir);
+    FILE* f = fopen(path, "wb");
+    assert(f != NULL);
+    fwrite(state, 1, sizeof(state), f);
+    fclose(f);
+
+    uint8_t log[24 + 28 + 3] = {0};
+    magic = RAFT_LOG_MAGIC;
+    memcpy(log, &magic, 4);
+    memcpy(log + 4, &version, 4);
+    uint32_t record_len = 28 + 3, cmd_len = 3;
+    uint64_t index = 1;
+    memcpy(log + 24, &record_len, 4);
+    memcpy(log + 32, &term, 8);
+    memcpy(log + 40, &index, 8);
+    memcpy(log + 48, &cmd_len, 4);
+    memcpy(log + 48 + 4, "old", 3);
+    crc = crc32(log + 32, 20 + 3);
+    memcpy(log + 28, &crc, 4);
+    snprintf(path, sizeof(path), "%s/raft_log.dat", dir);
+    f = fopen(path, "wb");
+    assert(f != NULL);
+    fwrite(log, 1, sizeof(log), f);
+    fclose(f);
+
+    raft_storage_t* storage = raft_storage_open(dir, true);
+    assert(storage != NULL);
+    uint64_t loaded_term;
+    int32_t loaded_vote;
+    assert(raft_storage_load_state(storage, &loaded_term, &loaded_vote) == RAFT_OK);
+    assert(loaded_term == 7 && loaded_vote == 2);
+
+    /* Appends to a version 1 log keep its checksum */
+    raft_entry_t entry = { .term = 7, .index = 2, .command = "new", .command_len = 3 };
+    assert(raft_storage_append_entry(storage, &entry) == RAFT_OK);
+    int count = 0;
+    assert(raft_storage_iterate_log(storage, count_entries_fn, &count) == RAFT_OK);
+    assert(count == 2);
+
+    /* The state file is rewritten in the current version */
+    assert(raft_storage_save_state(storage, 8, 1) == RAFT_OK);
+    raft_storage_close(storage);
+
+    snprintf(path, sizeof(path), "%s/raft_state.dat", dir);
+    f = fopen(path, "rb");
+    assert(f != NULL);
+    assert(fread(state, 1, sizeof(state), f) == sizeof(state));
+    fclose(f);
+    memcpy(&version, state + 4, 4);
+    assert(version == RAFT_STORAGE_VERSION);
+
+    storage = raft_storage_open(dir, true);
+    assert(storage != NULL);
+    assert(raft_storage_load_state(storage, &loaded_term, &loaded_vote) == RAFT_OK);
+    assert(loaded_term == 8 && loaded_vote == 1);
+    raft_storage_close(storage);
+
+    remove_dir(dir);
+    free(dir);
+}
+
 int main(void) {
     printf("Phase 4: Persistence and Recovery Tests\n");
     printf("========================================\n\n");
@@ -348,6 +441,7 @@ int main(void) {
     RUN_TEST(test_multiple_restarts);
     RUN_TEST(test_log_truncation);
     RUN_TEST(test_phase3_regression);
+    RUN_TEST(test_crc32c_format_version);
 
     printf("\n========================================\n");
     printf("Results: %d/%d tests passed\n", tests_passed, tests_run);